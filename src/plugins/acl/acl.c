@@ -39,6 +39,7 @@
 
 #include "fa_node.h"
 #include "public_inlines.h"
+#include "dtree_lookup.h"
 
 acl_main_t acl_main;
 
@@ -2580,6 +2581,23 @@ acl_set_aclplugin_fn (vlib_main_t * vm,
       am->use_hash_acl_matching = (val != 0);
       goto done;
     }
+  if (unformat (input, "decision-tree"))
+    {
+      u32 lc_index;
+      if (unformat (input, "default %u", &val))
+	am->use_decision_tree = (val != 0);
+      else if (unformat (input, "lc-index %u %u", &lc_index, &val))
+	{
+	  if (acl_dtree_lc_enable_disable (am, lc_index, val))
+	    error = clib_error_return (0, "lookup context %u does not exist",
+				       lc_index);
+	}
+      else
+	error = clib_error_return (0,
+				   "expecting default <0|1> or lc-index <n> <0|1>, got `%U`",
+				   format_unformat_error, input);
+      goto done;
+    }
   if (unformat (input, "l4-match-nonfirst-fragment %u", &val))
     {
       am->l4_match_nonfirst_fragment = (val != 0);
@@ -3476,6 +3494,7 @@ acl_show_aclplugin_tables_fn (vlib_main_t * vm,
   int show_applied_info = 0;
   int show_mask_type = 0;
   int show_bihash = 0;
+  int show_dtree = 0;
   u32 show_bihash_verbose = 0;
 
   if (unformat (input, "acl"))
@@ -3499,16 +3518,22 @@ acl_show_aclplugin_tables_fn (vlib_main_t * vm,
       show_bihash = 1;
       unformat (input, "verbose %u", &show_bihash_verbose);
     }
+  else if (unformat (input, "decision-tree"))
+    {
+      show_dtree = 1;
+      unformat (input, "lc_index %u", &lc_index);
+    }
 
   if (!
       (show_mask_type || show_acl_hash_info || show_applied_info
-       || show_bihash))
+       || show_bihash || show_dtree))
     {
       /* if no qualifiers specified, show all */
       show_mask_type = 1;
       show_acl_hash_info = 1;
       show_applied_info = 1;
       show_bihash = 1;
+      show_dtree = 1;
     }
   vlib_cli_output (vm, "Stats counters enabled for interface ACLs: %d",
 		   acl_main.interface_acl_counters_enabled);
@@ -3522,6 +3547,8 @@ acl_show_aclplugin_tables_fn (vlib_main_t * vm,
     acl_plugin_show_tables_applied_info (lc_index);
   if (show_bihash)
     acl_plugin_show_tables_bihash (show_bihash_verbose);
+  if (show_dtree)
+    acl_plugin_show_tables_dtree (lc_index);
 
   return error;
 }
@@ -3588,7 +3615,7 @@ VLIB_CLI_COMMAND (aclplugin_show_sessions_command, static) = {
 
 VLIB_CLI_COMMAND (aclplugin_show_tables_command, static) = {
     .path = "show acl-plugin tables",
-    .short_help = "show acl-plugin tables [ acl [index N] | applied [ lc_index N ] | mask | hash [verbose N] ]",
+    .short_help = "show acl-plugin tables [ acl [index N] | applied [ lc_index N ] | mask | hash [verbose N] | decision-tree [ lc_index N ] ]",
     .function = acl_show_aclplugin_tables_fn,
 };
 
@@ -3682,6 +3709,7 @@ acl_plugin_config (vlib_main_t * vm, unformat_input_t * input)
   u32 reclassify_sessions;
   u32 use_tuple_merge;
   u32 tuple_merge_split_threshold;
+  u32 use_decision_tree;
 
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
     {
@@ -3724,6 +3752,8 @@ acl_plugin_config (vlib_main_t * vm, unformat_input_t * input)
 	    (input, "tuple merge split threshold %d",
 	     &tuple_merge_split_threshold))
 	am->tuple_merge_split_threshold = tuple_merge_split_threshold;
+      else if (unformat (input, "use decision tree %d", &use_decision_tree))
+	am->use_decision_tree = use_decision_tree;
 
       else if (unformat (input, "reclassify sessions %d",
 			 &reclassify_sessions))
@@ -32,6 +32,7 @@
 #include "types.h"
 #include "fa_node.h"
 #include "hash_lookup_types.h"
+#include "dtree_lookup_types.h"
 #include "lookup_context.h"
 
 #define  ACL_PLUGIN_VERSION_MAJOR 1
@@ -183,6 +184,11 @@ typedef struct {
 #define TM_SPLIT_THRESHOLD 39
   int tuple_merge_split_threshold;
 
+  /* Do new lookup contexts use the decision tree instead of TupleMerge */
+  int use_decision_tree;
+  /* decision tree per lc_index, if enabled for it */
+  acl_dtree_t **dtree_by_lc_index;
+
   /* a pool of all mask types present in all ACEs */
   ace_mask_type_entry_t *ace_mask_type_pool;
 
@@ -319,6 +319,103 @@ acl_fa_node_common_prepare_fn (vlib_main_t * vm,
 }
 
 
+#define ACL_PLUGIN_SESSION_BUCKET_PREFETCH 8
+#define ACL_PLUGIN_SESSION_DATA_PREFETCH 4
+#define ACL_PLUGIN_SESSION_PREFETCH 4
+
+/*
+ * Look up the sessions for the whole frame, prefetching the bihash
+ * buckets and then the data ahead so the lookups overlap.
+ */
+always_inline void
+acl_fa_node_find_sessions_fn (acl_main_t * am, acl_fa_per_worker_data_t * pw,
+			      int is_ip6, u32 n_vectors)
+{
+  u64 *hash = pw->hashes;
+  u32 i;
+
+  for (i = 0; i < clib_min (n_vectors, ACL_PLUGIN_SESSION_BUCKET_PREFETCH);
+       i++)
+    acl_fa_prefetch_session_bucket_for_hash (am, is_ip6, hash[i]);
+
+  for (i = 0; i < n_vectors; i++)
+    {
+      if (i + ACL_PLUGIN_SESSION_BUCKET_PREFETCH < n_vectors)
+	acl_fa_prefetch_session_bucket_for_hash (am, is_ip6,
+						 hash[i +
+						      ACL_PLUGIN_SESSION_BUCKET_PREFETCH]);
+      if (i + ACL_PLUGIN_SESSION_DATA_PREFETCH < n_vectors)
+	acl_fa_prefetch_session_data_for_hash (am, is_ip6,
+					       hash[i +
+						    ACL_PLUGIN_SESSION_DATA_PREFETCH]);
+      acl_fa_find_session_with_hash (am, is_ip6, pw->sw_if_indices[i],
+				     hash[i], &pw->fa_5tuples[i],
+				     &pw->sess_ids[i]);
+    }
+}
+
+/* the ACL lookup for the packet is left to the inner loop */
+#define ACL_FA_MATCH_INDEX_NOT_DONE (~0)
+
+always_inline void
+acl_fa_node_match_batch (acl_main_t * am, acl_fa_per_worker_data_t * pw,
+			 int is_ip6, fa_5tuple_t ** batch, u32 * pkt_index,
+			 u32 n_batch)
+{
+  u32 match_index[ACL_MATCH_BATCH_SIZE];
+  u32 i;
+
+  multi_acl_match_get_applied_ace_index_xN (am, is_ip6, batch, n_batch,
+					    match_index);
+  for (i = 0; i < n_batch; i++)
+    pw->match_indices[pkt_index[i]] = match_index[i];
+}
+
+/*
+ * Run the hash ACL lookups of the packets without a session in batches.
+ * The non-first fragments and the lookup contexts using a decision tree
+ * are matched one by one in the inner loop, as before.
+ */
+always_inline void
+acl_fa_node_match_misses_fn (acl_main_t * am, acl_fa_per_worker_data_t * pw,
+			     int is_ip6, int is_input,
+			     int with_stateful_datapath, u32 n_vectors)
+{
+  u32 *lc_index_by_sw_if_index = is_input ?
+    am->input_lc_index_by_sw_if_index : am->output_lc_index_by_sw_if_index;
+  fa_5tuple_t *batch[ACL_MATCH_BATCH_SIZE];
+  u32 pkt_index[ACL_MATCH_BATCH_SIZE];
+  u32 i, n_batch = 0;
+
+  for (i = 0; i < n_vectors; i++)
+    {
+      fa_5tuple_t *fa_5tuple = &pw->fa_5tuples[i];
+      u32 lc_index;
+
+      pw->match_indices[i] = ACL_FA_MATCH_INDEX_NOT_DONE;
+      if (!am->use_hash_acl_matching)
+	continue;
+      if (with_stateful_datapath && pw->sess_ids[i] != ~0ULL)
+	continue;
+      if (PREDICT_FALSE (fa_5tuple->pkt.is_nonfirst_fragment))
+	continue;
+      lc_index = lc_index_by_sw_if_index[pw->sw_if_indices[i]];
+      if (acl_lc_get_dtree (am, lc_index))
+	continue;
+
+      fa_5tuple->pkt.lc_index = lc_index;
+      batch[n_batch] = fa_5tuple;
+      pkt_index[n_batch] = i;
+      if (++n_batch == ACL_MATCH_BATCH_SIZE)
+	{
+	  acl_fa_node_match_batch (am, pw, is_ip6, batch, pkt_index, n_batch);
+	  n_batch = 0;
+	}
+    }
+  if (n_batch)
+    acl_fa_node_match_batch (am, pw, is_ip6, batch, pkt_index, n_batch);
+}
+
 always_inline uword
 acl_fa_inner_node_fn (vlib_main_t * vm,
 		      vlib_node_runtime_t * node, vlib_frame_t * frame,
@@ -343,6 +440,10 @@ acl_fa_inner_node_fn (vlib_main_t * vm,
   u32 *sw_if_index;
   fa_5tuple_t *fa_5tuple;
   u64 *hash;
+  u64 *sess_id;
+  u32 *match_index;
+  /* low bits of the hashes of the sessions added in this frame */
+  uword added_session_hashes[256 / BITS (uword)] = { 0 };
   /* for the delayed counters */
   u32 saved_matched_acl_index = 0;
   u32 saved_matched_ace_index = 0;
@@ -353,27 +454,24 @@ acl_fa_inner_node_fn (vlib_main_t * vm,
   no_error_existing_session =
     error_node->errors[ACL_FA_ERROR_ACL_EXIST_SESSION];
 
+  /*
+   * The session lookups for the whole frame first, then the ACL lookups
+   * of the packets without a session, so that the cache misses of
+   * different packets overlap. The sessions and the ACL results are then
+   * consumed in order below.
+   */
+  if (with_stateful_datapath)
+    acl_fa_node_find_sessions_fn (am, pw, is_ip6, frame->n_vectors);
+  acl_fa_node_match_misses_fn (am, pw, is_ip6, is_input,
+			       with_stateful_datapath, frame->n_vectors);
+
   b = pw->bufs;
   next = pw->nexts;
   sw_if_index = pw->sw_if_indices;
   fa_5tuple = pw->fa_5tuples;
   hash = pw->hashes;
-
-  /*
-   * Now the "hard" work of session lookups and ACL lookups for new sessions.
-   * Due to the complexity, do it for the time being in single loop with
-   * the pipeline of three prefetches:
-   *    1) bucket for the session bihash
-   *    2) data for the session bihash
-   *    3) worker session record
-   */
-
-  fa_full_session_id_t f_sess_id_next = {.as_u64 = ~0ULL };
-
-  /* find the "next" session so we can kickstart the pipeline */
-  if (with_stateful_datapath)
-    acl_fa_find_session_with_hash (am, is_ip6, sw_if_index[0], hash[0],
-				   &fa_5tuple[0], &f_sess_id_next.as_u64);
+  sess_id = pw->sess_ids;
+  match_index = pw->match_indices;
 
   n_left = frame->n_vectors;
   while (n_left > 0)
@@ -391,191 +489,191 @@ acl_fa_inner_node_fn (vlib_main_t * vm,
 
       if (with_stateful_datapath)
 	{
-	  fa_full_session_id_t f_sess_id = f_sess_id_next;
-	  switch (n_left)
+	  fa_full_session_id_t f_sess_id = {.as_u64 = sess_id[0] };
+
+	  if (n_left > ACL_PLUGIN_SESSION_PREFETCH
+	      && sess_id[ACL_PLUGIN_SESSION_PREFETCH] != ~0ULL)
 	    {
-	    default:
-	      acl_fa_prefetch_session_bucket_for_hash (am, is_ip6, hash[5]);
-	      /* fallthrough */
-	    case 5:
-	    case 4:
-	      acl_fa_prefetch_session_data_for_hash (am, is_ip6, hash[3]);
-	      /* fallthrough */
-	    case 3:
-	    case 2:
-	      acl_fa_find_session_with_hash (am, is_ip6, sw_if_index[1],
-					     hash[1], &fa_5tuple[1],
-					     &f_sess_id_next.as_u64);
-	      if (f_sess_id_next.as_u64 != ~0ULL)
+	      fa_full_session_id_t f_sess_id_ahead = {
+		.as_u64 = sess_id[ACL_PLUGIN_SESSION_PREFETCH]
+	      };
+	      prefetch_session_entry (am, f_sess_id_ahead);
+	    }
+
+	  /*
+	   * The session lookup happened before the earlier packets of the
+	   * frame were processed, which may have deleted the session found
+	   * or added the missing one. Look again in these cases.
+	   */
+	  if (f_sess_id.as_u64 != ~0ULL)
+	    {
+	      fa_session_t *sess =
+		get_session_ptr_no_check (am, f_sess_id.thread_index,
+					  f_sess_id.session_index);
+	      if (PREDICT_FALSE (sess->deleted))
+		acl_fa_find_session_with_hash (am, is_ip6, sw_if_index[0],
+					       hash[0], &fa_5tuple[0],
+					       &f_sess_id.as_u64);
+	    }
+	  else if (PREDICT_FALSE (clib_bitmap_get_no_check
+				  (added_session_hashes, hash[0] & 255)))
+	    acl_fa_find_session_with_hash (am, is_ip6, sw_if_index[0],
+					   hash[0], &fa_5tuple[0],
+					   &f_sess_id.as_u64);
+
+	  if (f_sess_id.as_u64 != ~0ULL)
+	    {
+	      if (node_trace_on)
 		{
-		  prefetch_session_entry (am, f_sess_id_next);
+		  trace_bitmap |= 0x80000000;
 		}
-	      /* fallthrough */
-	    case 1:
-	      if (f_sess_id.as_u64 != ~0ULL)
+	      ASSERT (f_sess_id.thread_index < vlib_get_n_threads ());
+	      b[0]->error = no_error_existing_session;
+	      acl_check_needed = 0;
+	      pkts_exist_session += 1;
+	      action =
+		process_established_session (vm, am, node->node_index,
+					     is_input, now, f_sess_id,
+					     &sw_if_index[0],
+					     &fa_5tuple[0],
+					     b[0]->current_length,
+					     node_trace_on, &trace_bitmap);
+
+	      /* expose the session id to the tracer */
+	      if (node_trace_on)
 		{
-		  if (node_trace_on)
-		    {
-		      trace_bitmap |= 0x80000000;
-		    }
-		  ASSERT (f_sess_id.thread_index < vlib_get_n_threads ());
-		  b[0]->error = no_error_existing_session;
-		  acl_check_needed = 0;
-		  pkts_exist_session += 1;
-		  action =
-		    process_established_session (vm, am, node->node_index,
-						 is_input, now, f_sess_id,
-						 &sw_if_index[0],
-						 &fa_5tuple[0],
-						 b[0]->current_length,
-						 node_trace_on,
-						 &trace_bitmap);
-
-		  /* expose the session id to the tracer */
-		  if (node_trace_on)
-		    {
-		      match_rule_index = f_sess_id.session_index;
-		    }
+		  match_rule_index = f_sess_id.session_index;
+		}
 
-		  if (reclassify_sessions)
+	      if (reclassify_sessions)
+		{
+		  if (PREDICT_FALSE
+		      (stale_session_deleted
+		       (am, is_input, pw, now, sw_if_index[0], f_sess_id)))
 		    {
-		      if (PREDICT_FALSE
-			  (stale_session_deleted
-			   (am, is_input, pw, now, sw_if_index[0],
-			    f_sess_id)))
+		      acl_check_needed = 1;
+		      if (node_trace_on)
 			{
-			  acl_check_needed = 1;
-			  if (node_trace_on)
-			    {
-			      trace_bitmap |= 0x40000000;
-			    }
-			  /*
-			   * If we have just deleted the session, and the next
-			   * buffer is the same 5-tuple, that session prediction
-			   * is wrong, correct it.
-			   */
-			  if ((f_sess_id_next.as_u64 != ~0ULL)
-			      && 0 == memcmp (&fa_5tuple[1], &fa_5tuple[0],
-					      sizeof (fa_5tuple[1])))
-			    f_sess_id_next.as_u64 = ~0ULL;
+			  trace_bitmap |= 0x40000000;
 			}
 		    }
 		}
 	    }
+	}
 
-	  if (acl_check_needed)
+      if (acl_check_needed)
+	{
+	  int is_match;
+
+	  if (is_input)
+	    lc_index0 = am->input_lc_index_by_sw_if_index[sw_if_index[0]];
+	  else
+	    lc_index0 = am->output_lc_index_by_sw_if_index[sw_if_index[0]];
+
+	  action = 0;		/* deny by default */
+	  if (match_index[0] != ACL_FA_MATCH_INDEX_NOT_DONE)
+	    is_match = applied_ace_match_result (am, lc_index0, match_index[0],
+						 &action, &match_acl_pos,
+						 &match_acl_in_index,
+						 &match_rule_index);
+	  else
+	    is_match = acl_plugin_match_5tuple_inline (am, lc_index0,
+						       (fa_5tuple_opaque_t *) &
+						       fa_5tuple[0], is_ip6,
+						       &action,
+						       &match_acl_pos,
+						       &match_acl_in_index,
+						       &match_rule_index,
+						       &trace_bitmap);
+	  if (PREDICT_FALSE (is_match && am->interface_acl_counters_enabled))
 	    {
-	      if (is_input)
-		lc_index0 = am->input_lc_index_by_sw_if_index[sw_if_index[0]];
-	      else
-		lc_index0 =
-		  am->output_lc_index_by_sw_if_index[sw_if_index[0]];
-
-	      action = 0;	/* deny by default */
-	      int is_match = acl_plugin_match_5tuple_inline (am, lc_index0,
-							     (fa_5tuple_opaque_t *) & fa_5tuple[0], is_ip6,
-							     &action,
-							     &match_acl_pos,
-							     &match_acl_in_index,
-							     &match_rule_index,
-							     &trace_bitmap);
-	      if (PREDICT_FALSE
-		  (is_match && am->interface_acl_counters_enabled))
-		{
-		  u32 buf_len = vlib_buffer_length_in_chain (vm, b[0]);
-		  vlib_increment_combined_counter (am->combined_acl_counters +
-						   saved_matched_acl_index,
-						   thread_index,
-						   saved_matched_ace_index,
-						   saved_packet_count,
-						   saved_byte_count);
-		  saved_matched_acl_index = match_acl_in_index;
-		  saved_matched_ace_index = match_rule_index;
-		  saved_packet_count = 1;
-		  saved_byte_count = buf_len;
-		  /* prefetch the counter that we are going to increment */
-		  vlib_prefetch_combined_counter (am->combined_acl_counters +
-						  saved_matched_acl_index,
-						  thread_index,
-						  saved_matched_ace_index);
-		}
+	      u32 buf_len = vlib_buffer_length_in_chain (vm, b[0]);
+	      vlib_increment_combined_counter (am->combined_acl_counters +
+					       saved_matched_acl_index,
+					       thread_index,
+					       saved_matched_ace_index,
+					       saved_packet_count,
+					       saved_byte_count);
+	      saved_matched_acl_index = match_acl_in_index;
+	      saved_matched_ace_index = match_rule_index;
+	      saved_packet_count = 1;
+	      saved_byte_count = buf_len;
+	      /* prefetch the counter that we are going to increment */
+	      vlib_prefetch_combined_counter (am->combined_acl_counters +
+					      saved_matched_acl_index,
+					      thread_index,
+					      saved_matched_ace_index);
+	    }
 
-	      b[0]->error = error_node->errors[action];
+	  b[0]->error = error_node->errors[action];
 
-	      if (1 == action)
-		pkts_acl_permit++;
+	  if (1 == action)
+	    pkts_acl_permit++;
 
-	      if (2 == action)
-		{
-		  if (!acl_fa_can_add_session (am, is_input, sw_if_index[0]))
-		    acl_fa_try_recycle_session (am, is_input,
-						thread_index,
-						sw_if_index[0], now);
+	  if (2 == action && with_stateful_datapath)
+	    {
+	      if (!acl_fa_can_add_session (am, is_input, sw_if_index[0]))
+		acl_fa_try_recycle_session (am, is_input,
+					    thread_index,
+					    sw_if_index[0], now);
 
-		  if (acl_fa_can_add_session (am, is_input, sw_if_index[0]))
-		    {
-		      u16 current_policy_epoch =
-			get_current_policy_epoch (am, is_input,
-						  sw_if_index[0]);
-		      fa_full_session_id_t f_sess_id =
-			acl_fa_add_session (am, is_input, is_ip6,
-					    sw_if_index[0],
-					    now, &fa_5tuple[0],
-					    current_policy_epoch);
-
-		      /* perform the accounting for the newly added session */
-		      process_established_session (vm, am,
-						   node->node_index,
-						   is_input, now,
-						   f_sess_id,
-						   &sw_if_index[0],
-						   &fa_5tuple[0],
-						   b[0]->current_length,
-						   node_trace_on,
-						   &trace_bitmap);
-		      pkts_new_session++;
-		      /*
-		       * If the next 5tuple is the same and we just added the session,
-		       * the f_sess_id_next can not be ~0. Correct it.
-		       */
-		      if ((f_sess_id_next.as_u64 == ~0ULL)
-			  && 0 == memcmp (&fa_5tuple[1], &fa_5tuple[0],
-					  sizeof (fa_5tuple[1])))
-			f_sess_id_next = f_sess_id;
-		    }
-		  else
-		    {
-		      action = 0;
-		      b[0]->error =
-			error_node->errors
-			[ACL_FA_ERROR_ACL_TOO_MANY_SESSIONS];
-		    }
+	      if (acl_fa_can_add_session (am, is_input, sw_if_index[0]))
+		{
+		  u16 current_policy_epoch =
+		    get_current_policy_epoch (am, is_input,
+					      sw_if_index[0]);
+		  fa_full_session_id_t f_sess_id =
+		    acl_fa_add_session (am, is_input, is_ip6,
+					sw_if_index[0],
+					now, &fa_5tuple[0],
+					current_policy_epoch);
+
+		  /* perform the accounting for the newly added session */
+		  process_established_session (vm, am,
+					       node->node_index,
+					       is_input, now,
+					       f_sess_id,
+					       &sw_if_index[0],
+					       &fa_5tuple[0],
+					       b[0]->current_length,
+					       node_trace_on, &trace_bitmap);
+		  pkts_new_session++;
+		  /* the later packets of this flow need to look again */
+		  clib_bitmap_set_no_check (added_session_hashes,
+					    hash[0] & 255, 1);
+		}
+	      else
+		{
+		  action = 0;
+		  b[0]->error =
+		    error_node->errors[ACL_FA_ERROR_ACL_TOO_MANY_SESSIONS];
 		}
-
 	    }
+	}
 
-	  {
-	    /* speculatively get the next0 */
-	    vnet_feature_next_u16 (&next[0], b[0]);
-	    /* if the action is not deny - then use that next */
-	    next[0] = action ? next[0] : 0;
-	  }
-
-	  if (node_trace_on)	// PREDICT_FALSE (node->flags & VLIB_NODE_FLAG_TRACE))
-	    {
-	      maybe_trace_buffer (vm, node, b[0], sw_if_index[0], lc_index0,
-				  next[0], match_acl_in_index,
-				  match_rule_index, &fa_5tuple[0], action,
-				  trace_bitmap);
-	    }
+      {
+	/* speculatively get the next0 */
+	vnet_feature_next_u16 (&next[0], b[0]);
+	/* if the action is not deny - then use that next */
+	next[0] = action ? next[0] : 0;
+      }
 
-	  next++;
-	  b++;
-	  fa_5tuple++;
-	  sw_if_index++;
-	  hash++;
-	  n_left -= 1;
+      if (node_trace_on)	// PREDICT_FALSE (node->flags & VLIB_NODE_FLAG_TRACE))
+	{
+	  maybe_trace_buffer (vm, node, b[0], sw_if_index[0], lc_index0,
+			      next[0], match_acl_in_index,
+			      match_rule_index, &fa_5tuple[0], action,
+			      trace_bitmap);
 	}
+
+      next++;
+      b++;
+      fa_5tuple++;
+      sw_if_index++;
+      hash++;
+      sess_id++;
+      match_index++;
+      n_left -= 1;
     }
 
   /*
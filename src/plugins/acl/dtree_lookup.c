@@ -0,0 +1,692 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+/*
+ * A HiCuts style decision tree over the rules applied to a lookup context.
+ *
+ * Each node cuts its region into a power of two number of equal slices
+ * along the dimension which best splits the rules, until a node holds
+ * few enough rules to be matched linearly. The lookup is then a handful
+ * of shift-and-mask steps plus a short scan of the leaf, independent
+ * of the number of distinct masks in the ruleset, which is what
+ * makes TupleMerge slow on rulesets with many port ranges and prefix lengths.
+ */
+
+#include <vlib/vlib.h>
+#include <vppinfra/random.h>
+
+#include "acl.h"
+#include "public_inlines.h"
+#include "dtree_lookup.h"
+
+/* stop cutting a node with at most this many rules */
+#define ACL_DTREE_LEAF_RULES 8
+/* at most 2^8 children per node */
+#define ACL_DTREE_MAX_CUT_BITS 8
+#define ACL_DTREE_MAX_DEPTH 16
+/* how many times the rules of a node may get replicated by a cut */
+#define ACL_DTREE_SPACE_FACTOR 4
+#define ACL_DTREE_MAX_NODES (4 << 20)
+
+typedef struct
+{
+  u64 lo[ACL_DTREE_N_DIMS];
+  u64 hi[ACL_DTREE_N_DIMS];
+} acl_dtree_box_t;
+
+typedef struct
+{
+  acl_dtree_t *t;
+  /* the region covered by each rule, indexed like t->rules */
+  acl_dtree_box_t *boxes;
+} acl_dtree_build_ctx_t;
+
+/* width of the root region in each dimension, for IPv4 and IPv6 */
+static const u8 acl_dtree_dim_bits[2][ACL_DTREE_N_DIMS] = {
+  {32, 32, 16, 16, 8},
+  {64, 64, 16, 16, 8},
+};
+
+static_always_inline u64
+acl_dtree_width_mask (u8 width)
+{
+  return width == 64 ? ~0ULL : ((1ULL << width) - 1);
+}
+
+static void
+acl_dtree_prefix_range (u64 addr, u8 width, u8 len, u64 * lo, u64 * hi)
+{
+  u64 all = acl_dtree_width_mask (width);
+  u64 mask = len ? ((~0ULL << (width - len)) & all) : 0;
+
+  *lo = addr & mask;
+  *hi = *lo | (all & ~mask);
+}
+
+/* returns 0 if the rule can never match */
+static int
+acl_dtree_rule_box (acl_rule_t * r, acl_dtree_box_t * b)
+{
+  if (r->is_ipv6)
+    {
+      acl_dtree_prefix_range (clib_net_to_host_u64 (r->src.ip6.as_u64[0]),
+			      64, clib_min (r->src_prefixlen, 64),
+			      &b->lo[ACL_DTREE_DIM_SRC_ADDR],
+			      &b->hi[ACL_DTREE_DIM_SRC_ADDR]);
+      acl_dtree_prefix_range (clib_net_to_host_u64 (r->dst.ip6.as_u64[0]),
+			      64, clib_min (r->dst_prefixlen, 64),
+			      &b->lo[ACL_DTREE_DIM_DST_ADDR],
+			      &b->hi[ACL_DTREE_DIM_DST_ADDR]);
+    }
+  else
+    {
+      acl_dtree_prefix_range (clib_net_to_host_u32 (r->src.ip4.as_u32),
+			      32, clib_min (r->src_prefixlen, 32),
+			      &b->lo[ACL_DTREE_DIM_SRC_ADDR],
+			      &b->hi[ACL_DTREE_DIM_SRC_ADDR]);
+      acl_dtree_prefix_range (clib_net_to_host_u32 (r->dst.ip4.as_u32),
+			      32, clib_min (r->dst_prefixlen, 32),
+			      &b->lo[ACL_DTREE_DIM_DST_ADDR],
+			      &b->hi[ACL_DTREE_DIM_DST_ADDR]);
+    }
+
+  if (r->proto)
+    {
+      b->lo[ACL_DTREE_DIM_PROTO] = b->hi[ACL_DTREE_DIM_PROTO] = r->proto;
+      b->lo[ACL_DTREE_DIM_SRC_PORT] = r->src_port_or_type_first;
+      b->hi[ACL_DTREE_DIM_SRC_PORT] = r->src_port_or_type_last;
+      b->lo[ACL_DTREE_DIM_DST_PORT] = r->dst_port_or_code_first;
+      b->hi[ACL_DTREE_DIM_DST_PORT] = r->dst_port_or_code_last;
+    }
+  else
+    {
+      /* the ports are not looked at if the protocol is a wildcard */
+      b->lo[ACL_DTREE_DIM_PROTO] = 0;
+      b->hi[ACL_DTREE_DIM_PROTO] = 255;
+      b->lo[ACL_DTREE_DIM_SRC_PORT] = b->lo[ACL_DTREE_DIM_DST_PORT] = 0;
+      b->hi[ACL_DTREE_DIM_SRC_PORT] = b->hi[ACL_DTREE_DIM_DST_PORT] = 65535;
+    }
+
+  return (b->lo[ACL_DTREE_DIM_SRC_PORT] <= b->hi[ACL_DTREE_DIM_SRC_PORT]
+	  && b->lo[ACL_DTREE_DIM_DST_PORT] <= b->hi[ACL_DTREE_DIM_DST_PORT]);
+}
+
+/* the first and the last of the 2^n_bits slices of a region a rule overlaps */
+static_always_inline void
+acl_dtree_slices (acl_dtree_box_t * b, u32 dim, u64 region_lo,
+		  u8 region_bits, u8 n_bits, u32 * first, u32 * last)
+{
+  u64 region_hi = region_lo + acl_dtree_width_mask (region_bits);
+  u64 lo = clib_max (b->lo[dim], region_lo);
+  u64 hi = clib_min (b->hi[dim], region_hi);
+  u8 shift = region_bits - n_bits;
+
+  *first = (lo - region_lo) >> shift;
+  *last = (hi - region_lo) >> shift;
+}
+
+/*
+ * Whether the subtree built for the previous slice can be used for this one:
+ * the rules must be the same and look the same relative to both slices.
+ */
+static int
+acl_dtree_can_share (acl_dtree_build_ctx_t * ctx, u32 * prev_rules,
+		     u32 * rules, u32 dim, u64 prev_lo, u64 hi)
+{
+  u32 *ri;
+
+  if (vec_len (prev_rules) != vec_len (rules))
+    return 0;
+  if (vec_len (rules) == 0)
+    return 1;
+  if (memcmp (prev_rules, rules, vec_len (rules) * sizeof (rules[0])))
+    return 0;
+  /* small enough to become a leaf, which does not depend on the region */
+  if (vec_len (rules) <= ACL_DTREE_LEAF_RULES)
+    return 1;
+
+  vec_foreach (ri, rules)
+  {
+    acl_dtree_box_t *b = ctx->boxes + ri[0];
+    if (b->lo[dim] > prev_lo || b->hi[dim] < hi)
+      return 0;
+  }
+  return 1;
+}
+
+static void
+acl_dtree_build_node (acl_dtree_build_ctx_t * ctx, u32 node_index,
+		      u64 * region_lo, u8 * region_bits, u32 * rules,
+		      u32 depth)
+{
+  acl_dtree_t *t = ctx->t;
+  acl_dtree_node_t *n;
+  u32 n_rules = vec_len (rules);
+  u32 best_dim = ~0, best_bits = 0, best_max = n_rules, best_sum = ~0;
+  u64 child_lo[ACL_DTREE_N_DIMS];
+  u8 child_bits[ACL_DTREE_N_DIMS];
+  u32 **child_rules = 0;
+  u32 first, last, n_slices, d, c, i, *ri;
+  i32 *counts = 0;
+  u8 shift;
+
+  t->max_depth = clib_max (t->max_depth, depth);
+
+  if (n_rules > ACL_DTREE_LEAF_RULES && depth < ACL_DTREE_MAX_DEPTH
+      && vec_len (t->nodes) < ACL_DTREE_MAX_NODES)
+    {
+      for (d = 0; d < ACL_DTREE_N_DIMS; d++)
+	for (c = 1; c <= clib_min (region_bits[d], ACL_DTREE_MAX_CUT_BITS);
+	     c++)
+	  {
+	    u32 max = 0, sum = 0;
+	    i32 in_slice = 0;
+
+	    n_slices = 1 << c;
+	    vec_validate (counts, n_slices);
+	    clib_memset (counts, 0, (n_slices + 1) * sizeof (counts[0]));
+	    vec_foreach (ri, rules)
+	    {
+	      acl_dtree_slices (ctx->boxes + ri[0], d, region_lo[d],
+				region_bits[d], c, &first, &last);
+	      counts[first]++;
+	      counts[last + 1]--;
+	    }
+	    for (i = 0; i < n_slices; i++)
+	      {
+		in_slice += counts[i];
+		max = clib_max (max, in_slice);
+		sum += in_slice;
+	      }
+	    /* the finer cuts of this dimension only replicate more */
+	    if (sum > ACL_DTREE_SPACE_FACTOR * n_rules + n_slices)
+	      break;
+	    if (max < best_max || (max == best_max && sum < best_sum))
+	      {
+		best_dim = d;
+		best_bits = c;
+		best_max = max;
+		best_sum = sum;
+	      }
+	  }
+      vec_free (counts);
+    }
+
+  if (best_dim == ~0)
+    {
+      n = vec_elt_at_index (t->nodes, node_index);
+      n->n_bits = 0;
+      n->index = vec_len (t->leaf_rules);
+      n->n_rules = n_rules;
+      vec_append (t->leaf_rules, rules);
+      t->n_leaves++;
+      t->max_leaf_rules = clib_max (t->max_leaf_rules, n_rules);
+      return;
+    }
+
+  n_slices = 1 << best_bits;
+  shift = region_bits[best_dim] - best_bits;
+
+  vec_validate (child_rules, n_slices - 1);
+  vec_foreach (ri, rules)
+  {
+    acl_dtree_slices (ctx->boxes + ri[0], best_dim, region_lo[best_dim],
+		      region_bits[best_dim], best_bits, &first, &last);
+    for (i = first; i <= last; i++)
+      vec_add1 (child_rules[i], ri[0]);
+  }
+
+  /* the children are contiguous, so a child is found by adding the slice */
+  u32 first_child = vec_len (t->nodes);
+  vec_validate (t->nodes, first_child + n_slices - 1);
+  n = vec_elt_at_index (t->nodes, node_index);
+  n->n_bits = best_bits;
+  n->dim = best_dim;
+  n->shift = shift;
+  n->index = first_child;
+  n->n_rules = n_rules;
+
+  clib_memcpy_fast (child_lo, region_lo, sizeof (child_lo));
+  clib_memcpy_fast (child_bits, region_bits, sizeof (child_bits));
+  child_bits[best_dim] = shift;
+
+  for (i = 0; i < n_slices; i++)
+    {
+      u64 slice_size = 1ULL << shift;
+
+      child_lo[best_dim] = region_lo[best_dim] + i * slice_size;
+      if (i > 0
+	  && acl_dtree_can_share (ctx, child_rules[i - 1], child_rules[i],
+				  best_dim, child_lo[best_dim] - slice_size,
+				  child_lo[best_dim] + slice_size - 1))
+	{
+	  t->nodes[first_child + i] = t->nodes[first_child + i - 1];
+	  continue;
+	}
+      acl_dtree_build_node (ctx, first_child + i, child_lo, child_bits,
+			    child_rules[i], depth + 1);
+    }
+
+  for (i = 0; i < n_slices; i++)
+    vec_free (child_rules[i]);
+  vec_free (child_rules);
+}
+
+acl_dtree_t *
+acl_dtree_build (acl_rule_t * rules)
+{
+  acl_dtree_build_ctx_t ctx = { 0 };
+  acl_dtree_t *t;
+  u32 *family_rules[2] = { 0 };
+  u64 region_lo[ACL_DTREE_N_DIMS];
+  u8 region_bits[ACL_DTREE_N_DIMS];
+  f64 start = vlib_time_now (vlib_get_main ());
+  u32 i;
+  int is_ip6;
+
+  t = clib_mem_alloc (sizeof (*t));
+  clib_memset (t, 0, sizeof (*t));
+  t->rules = vec_dup (rules);
+  /* the two roots */
+  vec_validate (t->nodes, 1);
+  vec_validate (ctx.boxes, vec_len (rules));
+  ctx.t = t;
+
+  vec_foreach_index (i, rules)
+  {
+    if (acl_dtree_rule_box (&rules[i], &ctx.boxes[i]))
+      vec_add1 (family_rules[rules[i].is_ipv6 != 0], i);
+  }
+
+  for (is_ip6 = 0; is_ip6 < 2; is_ip6++)
+    {
+      clib_memset (region_lo, 0, sizeof (region_lo));
+      clib_memcpy_fast (region_bits, acl_dtree_dim_bits[is_ip6],
+			sizeof (region_bits));
+      acl_dtree_build_node (&ctx, is_ip6, region_lo, region_bits,
+			    family_rules[is_ip6], 0);
+      vec_free (family_rules[is_ip6]);
+    }
+
+  vec_free (ctx.boxes);
+  t->build_time = vlib_time_now (vlib_get_main ()) - start;
+  return t;
+}
+
+void
+acl_dtree_free (acl_dtree_t * t)
+{
+  vec_free (t->nodes);
+  vec_free (t->leaf_rules);
+  vec_free (t->rules);
+  clib_mem_free (t);
+}
+
+void
+acl_dtree_lc_rebuild (acl_main_t * am, u32 lc_index)
+{
+  acl_lookup_context_t *acontext =
+    pool_elt_at_index (am->acl_lookup_contexts, lc_index);
+  acl_dtree_t *old_tree, *new_tree = 0;
+  applied_hash_ace_entry_t *pae;
+  acl_rule_t *rules = 0;
+
+  if (acontext->use_decision_tree
+      && lc_index < vec_len (am->hash_entry_vec_by_lc_index))
+    {
+      /* the applied entries are in the priority order */
+      vec_foreach (pae, am->hash_entry_vec_by_lc_index[lc_index])
+      {
+	acl_list_t *acl = pool_elt_at_index (am->acls, pae->acl_index);
+	vec_add1 (rules, acl->rules[pae->ace_index]);
+      }
+      if (vec_len (rules))
+	new_tree = acl_dtree_build (rules);
+      vec_free (rules);
+    }
+
+  /*
+   * The lookup contexts are only modified with the workers stopped,
+   * so the old tree can be freed right after the swap.
+   */
+  vec_validate (am->dtree_by_lc_index, lc_index);
+  old_tree = am->dtree_by_lc_index[lc_index];
+  am->dtree_by_lc_index[lc_index] = new_tree;
+  if (old_tree)
+    acl_dtree_free (old_tree);
+}
+
+void
+acl_dtree_lc_free (acl_main_t * am, u32 lc_index)
+{
+  if (lc_index < vec_len (am->dtree_by_lc_index)
+      && am->dtree_by_lc_index[lc_index])
+    {
+      acl_dtree_free (am->dtree_by_lc_index[lc_index]);
+      am->dtree_by_lc_index[lc_index] = 0;
+    }
+}
+
+int
+acl_dtree_lc_enable_disable (acl_main_t * am, u32 lc_index, int enable)
+{
+  acl_lookup_context_t *acontext;
+
+  if (pool_is_free_index (am->acl_lookup_contexts, lc_index))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+  acontext = pool_elt_at_index (am->acl_lookup_contexts, lc_index);
+  acontext->use_decision_tree = (enable != 0);
+  acl_dtree_lc_rebuild (am, lc_index);
+  return 0;
+}
+
+static u8 *
+format_acl_dtree (u8 * s, va_list * args)
+{
+  acl_dtree_t *t = va_arg (*args, acl_dtree_t *);
+
+  s = format (s, "rules %u nodes %u leaves %u max depth %u "
+	      "max leaf rules %u memory %U build time %.6fs",
+	      vec_len (t->rules), vec_len (t->nodes), t->n_leaves,
+	      t->max_depth, t->max_leaf_rules, format_memory_size,
+	      vec_bytes (t->nodes) + vec_bytes (t->leaf_rules) +
+	      vec_bytes (t->rules), t->build_time);
+  return s;
+}
+
+void
+acl_plugin_show_tables_dtree (u32 lc_index)
+{
+  acl_main_t *am = &acl_main;
+  vlib_main_t *vm = am->vlib_main;
+  acl_lookup_context_t *acontext;
+
+  vlib_cli_output (vm, "Use decision tree for new lookup contexts: %d",
+		   am->use_decision_tree);
+  pool_foreach (acontext, am->acl_lookup_contexts)
+    {
+      u32 curr_lc_index = acontext - am->acl_lookup_contexts;
+      acl_dtree_t *t = 0;
+
+      if ((lc_index != ~0) && (curr_lc_index != lc_index))
+	continue;
+      if (curr_lc_index < vec_len (am->dtree_by_lc_index))
+	t = am->dtree_by_lc_index[curr_lc_index];
+      if (t)
+	vlib_cli_output (vm, "  lc_index %d: %U", curr_lc_index,
+			 format_acl_dtree, t);
+      else
+	vlib_cli_output (vm, "  lc_index %d: decision tree %s",
+			 curr_lc_index,
+			 acontext->use_decision_tree ? "empty" : "disabled");
+    }
+}
+
+/*
+ * A synthetic ruleset in the spirit of ClassBench: addresses clustered
+ * under a few prefixes, a mix of prefix lengths, exact ports and port ranges.
+ */
+static void
+acl_dtree_test_rule (u32 * seed, int is_ip6, acl_rule_t * r)
+{
+  static const u8 ip4_lens[] = { 0, 8, 16, 20, 24, 24, 28, 32, 32 };
+  static const u8 ip6_lens[] = { 0, 32, 48, 56, 64, 64, 96, 128 };
+  static const u8 protos[] = { 0, 6, 6, 6, 17, 17, 1 };
+  ip6_address_t mask;
+  int i;
+
+  clib_memset (r, 0, sizeof (*r));
+  r->is_permit = random_u32 (seed) & 1;
+  r->is_ipv6 = is_ip6;
+
+  if (is_ip6)
+    {
+      for (i = 0; i < 4; i++)
+	{
+	  r->src.ip6.as_u32[i] = random_u32 (seed);
+	  r->dst.ip6.as_u32[i] = random_u32 (seed);
+	}
+      /* a handful of /16 clusters */
+      r->src.ip6.as_u16[0] = clib_host_to_net_u16 (0x2001 + (r->src.ip6.as_u16[1] & 7));
+      r->dst.ip6.as_u16[0] = clib_host_to_net_u16 (0x2001 + (r->dst.ip6.as_u16[1] & 7));
+      r->src_prefixlen = ip6_lens[random_u32 (seed) % ARRAY_LEN (ip6_lens)];
+      r->dst_prefixlen = ip6_lens[random_u32 (seed) % ARRAY_LEN (ip6_lens)];
+      ip6_address_mask_from_width (&mask, r->src_prefixlen);
+      ip6_address_mask (&r->src.ip6, &mask);
+      ip6_address_mask_from_width (&mask, r->dst_prefixlen);
+      ip6_address_mask (&r->dst.ip6, &mask);
+    }
+  else
+    {
+      u32 src = random_u32 (seed), dst = random_u32 (seed);
+
+      /* a handful of /8 clusters */
+      src = (src & 0x00ffffff) | ((10 + (src >> 29)) << 24);
+      dst = (dst & 0x00ffffff) | ((10 + (dst >> 29)) << 24);
+      r->src_prefixlen = ip4_lens[random_u32 (seed) % ARRAY_LEN (ip4_lens)];
+      r->dst_prefixlen = ip4_lens[random_u32 (seed) % ARRAY_LEN (ip4_lens)];
+      src &= r->src_prefixlen ? ~0U << (32 - r->src_prefixlen) : 0;
+      dst &= r->dst_prefixlen ? ~0U << (32 - r->dst_prefixlen) : 0;
+      r->src.ip4.as_u32 = clib_host_to_net_u32 (src);
+      r->dst.ip4.as_u32 = clib_host_to_net_u32 (dst);
+    }
+
+  r->proto = protos[random_u32 (seed) % ARRAY_LEN (protos)];
+  if (r->proto == 6 || r->proto == 17)
+    {
+      u16 port = random_u32 (seed);
+
+      r->src_port_or_type_first = 0;
+      r->src_port_or_type_last = 65535;
+      if ((random_u32 (seed) % 8) == 0)
+	r->src_port_or_type_first = r->src_port_or_type_last = port;
+
+      switch (random_u32 (seed) % 4)
+	{
+	case 0:
+	  r->dst_port_or_code_first = 0;
+	  r->dst_port_or_code_last = 65535;
+	  break;
+	case 1:
+	  r->dst_port_or_code_first = r->dst_port_or_code_last = port % 1024;
+	  break;
+	case 2:
+	  r->dst_port_or_code_first = 1024;
+	  r->dst_port_or_code_last = 65535;
+	  break;
+	default:
+	  r->dst_port_or_code_first = port;
+	  r->dst_port_or_code_last =
+	    clib_min (65535, port + random_u32 (seed) % 4096);
+	  break;
+	}
+    }
+  else if (r->proto)
+    {
+      r->src_port_or_type_first = r->src_port_or_type_last =
+	random_u32 (seed) % 16;
+      r->dst_port_or_code_first = 0;
+      r->dst_port_or_code_last = 255;
+    }
+}
+
+/* a packet within a random rule, or a fully random one */
+static void
+acl_dtree_test_packet (u32 * seed, acl_rule_t * rules, int is_ip6,
+		       fa_5tuple_t * pkt)
+{
+  acl_rule_t *r = &rules[random_u32 (seed) % vec_len (rules)];
+  int random_pkt = (random_u32 (seed) % 4) == 0;
+  ip6_address_t mask;
+  int i;
+
+  clib_memset (pkt, 0, sizeof (*pkt));
+  pkt->pkt.is_ip6 = is_ip6;
+  pkt->pkt.l4_valid = 1;
+
+  if (is_ip6)
+    {
+      for (i = 0; i < 4; i++)
+	{
+	  pkt->ip6_addr[0].as_u32[i] = random_u32 (seed);
+	  pkt->ip6_addr[1].as_u32[i] = random_u32 (seed);
+	}
+      if (!random_pkt)
+	{
+	  ip6_address_mask_from_width (&mask, r->src_prefixlen);
+	  for (i = 0; i < 2; i++)
+	    pkt->ip6_addr[0].as_u64[i] = (pkt->ip6_addr[0].as_u64[i] &
+					  ~mask.as_u64[i]) |
+	      r->src.ip6.as_u64[i];
+	  ip6_address_mask_from_width (&mask, r->dst_prefixlen);
+	  for (i = 0; i < 2; i++)
+	    pkt->ip6_addr[1].as_u64[i] = (pkt->ip6_addr[1].as_u64[i] &
+					  ~mask.as_u64[i]) |
+	      r->dst.ip6.as_u64[i];
+	}
+    }
+  else
+    {
+      pkt->ip4_addr[0].as_u32 = random_u32 (seed);
+      pkt->ip4_addr[1].as_u32 = random_u32 (seed);
+      if (!random_pkt)
+	{
+	  u32 src_mask = r->src_prefixlen ?
+	    clib_host_to_net_u32 (~0U << (32 - r->src_prefixlen)) : 0;
+	  u32 dst_mask = r->dst_prefixlen ?
+	    clib_host_to_net_u32 (~0U << (32 - r->dst_prefixlen)) : 0;
+	  pkt->ip4_addr[0].as_u32 = (pkt->ip4_addr[0].as_u32 & ~src_mask) |
+	    r->src.ip4.as_u32;
+	  pkt->ip4_addr[1].as_u32 = (pkt->ip4_addr[1].as_u32 & ~dst_mask) |
+	    r->dst.ip4.as_u32;
+	}
+    }
+
+  pkt->l4.port[0] = random_u32 (seed);
+  pkt->l4.port[1] = random_u32 (seed);
+  pkt->l4.proto = (random_u32 (seed) & 1) ? 6 : 17;
+  if (!random_pkt && r->proto)
+    {
+      pkt->l4.proto = r->proto;
+      pkt->l4.port[0] = r->src_port_or_type_first +
+	random_u32 (seed) % (1 + r->src_port_or_type_last -
+			     r->src_port_or_type_first);
+      pkt->l4.port[1] = r->dst_port_or_code_first +
+	random_u32 (seed) % (1 + r->dst_port_or_code_last -
+			     r->dst_port_or_code_first);
+    }
+}
+
+static u32
+acl_dtree_test_linear_match (acl_rule_t * rules, int is_ip6,
+			     fa_5tuple_t * pkt)
+{
+  u32 i;
+
+  vec_foreach_index (i, rules)
+  {
+    if (single_rule_match_5tuple (&rules[i], is_ip6, pkt))
+      return i;
+  }
+  return ~0;
+}
+
+static clib_error_t *
+acl_dtree_test_fn (vlib_main_t * vm, unformat_input_t * input,
+		   vlib_cli_command_t * cmd)
+{
+  u32 n_rules = 1000, n_lookups = 100000, n_verify = 1000;
+  u32 seed = 0xdeadbeef, i, n_matches = 0, n_mismatches = 0;
+  acl_rule_t *rules = 0;
+  fa_5tuple_t *pkts = 0;
+  acl_dtree_t *t;
+  int is_ip6 = 0;
+  u64 t0, dtree_clocks, linear_clocks;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "rules %u", &n_rules))
+	;
+      else if (unformat (input, "lookups %u", &n_lookups))
+	;
+      else if (unformat (input, "verify %u", &n_verify))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else if (unformat (input, "ip6"))
+	is_ip6 = 1;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (n_rules == 0 || n_lookups == 0)
+    return clib_error_return (0, "rules and lookups must be non-zero");
+  n_verify = clib_min (n_verify, n_lookups);
+
+  vec_validate (rules, n_rules - 1);
+  vec_foreach_index (i, rules)
+    acl_dtree_test_rule (&seed, is_ip6, &rules[i]);
+  vec_validate (pkts, n_lookups - 1);
+  vec_foreach_index (i, pkts)
+    acl_dtree_test_packet (&seed, rules, is_ip6, &pkts[i]);
+
+  t = acl_dtree_build (rules);
+  vlib_cli_output (vm, "%U", format_acl_dtree, t);
+
+  t0 = clib_cpu_time_now ();
+  vec_foreach_index (i, pkts)
+    n_matches += acl_dtree_match (t, is_ip6, &pkts[i]) != ~0;
+  dtree_clocks = clib_cpu_time_now () - t0;
+
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_verify; i++)
+    if (acl_dtree_test_linear_match (rules, is_ip6, &pkts[i]) !=
+	acl_dtree_match (t, is_ip6, &pkts[i]))
+      n_mismatches++;
+  linear_clocks = clib_cpu_time_now () - t0;
+
+  vlib_cli_output (vm, "%u lookups, %u matched: %.1f clocks/lookup",
+		   n_lookups, n_matches, (f64) dtree_clocks / n_lookups);
+  if (n_verify)
+    vlib_cli_output (vm, "%u verified against linear lookup: "
+		     "%u mismatches, %.1f clocks/lookup (both)",
+		     n_verify, n_mismatches, (f64) linear_clocks / n_verify);
+
+  acl_dtree_free (t);
+  vec_free (rules);
+  vec_free (pkts);
+
+  if (n_mismatches)
+    return clib_error_return (0, "decision tree lookup mismatches");
+  return 0;
+}
+
+/*?
+ * Build a decision tree over a synthetic ruleset and compare its lookups
+ * with a linear match over the same rules.
+ *
+ * @cliexpar
+ * @cliexcmd{test acl-plugin decision-tree rules 10000 lookups 1000000}
+?*/
+VLIB_CLI_COMMAND (acl_dtree_test_command, static) = {
+  .path = "test acl-plugin decision-tree",
+  .short_help = "test acl-plugin decision-tree [rules <n>] [lookups <n>] "
+    "[verify <n>] [seed <n>] [ip6]",
+  .function = acl_dtree_test_fn,
+};
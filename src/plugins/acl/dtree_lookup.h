@@ -0,0 +1,40 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#ifndef _ACL_DTREE_LOOKUP_H_
+#define _ACL_DTREE_LOOKUP_H_
+
+#include "acl.h"
+
+/*
+ * Build a decision tree over a vector of rules given in priority order.
+ * The rule indices returned by the lookup are the indices in this vector.
+ */
+acl_dtree_t *acl_dtree_build (acl_rule_t * rules);
+void acl_dtree_free (acl_dtree_t * t);
+
+/*
+ * (Re)build the tree of a lookup context from its applied entries,
+ * or release it if the context does not use the decision tree.
+ * Must be called with the workers stopped.
+ */
+void acl_dtree_lc_rebuild (acl_main_t * am, u32 lc_index);
+void acl_dtree_lc_free (acl_main_t * am, u32 lc_index);
+int acl_dtree_lc_enable_disable (acl_main_t * am, u32 lc_index,
+				 int enable);
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+#ifndef _ACL_DTREE_LOOKUP_TYPES_H_
+#define _ACL_DTREE_LOOKUP_TYPES_H_
+
+#include "types.h"
+
+/*
+ * The dimensions the decision tree cuts on. The IPv6 addresses are
+ * cut on their upper 64 bits, the rules in the leaves are matched in full.
+ */
+typedef enum {
+  ACL_DTREE_DIM_SRC_ADDR,
+  ACL_DTREE_DIM_DST_ADDR,
+  ACL_DTREE_DIM_SRC_PORT,
+  ACL_DTREE_DIM_DST_PORT,
+  ACL_DTREE_DIM_PROTO,
+  ACL_DTREE_N_DIMS,
+} acl_dtree_dim_t;
+
+/*
+ * A node either cuts the region it covers into 2^n_bits equal slices
+ * along one dimension, or is a leaf with the rules overlapping its region.
+ * The regions are aligned power of two blocks, so the child for a key
+ * is found by a shift and a mask.
+ */
+typedef struct {
+  /* 0 for a leaf */
+  u8 n_bits;
+  u8 dim;
+  u8 shift;
+  u8 reserved;
+  /* cut: index of the first child node; leaf: offset in leaf_rules */
+  u32 index;
+  /* leaf: number of rules */
+  u32 n_rules;
+} acl_dtree_node_t;
+
+typedef struct {
+  /* nodes, the roots of the IPv4 and IPv6 trees are at index 0 and 1 */
+  acl_dtree_node_t *nodes;
+  /* rule indices of the leaves, each leaf's in priority order */
+  u32 *leaf_rules;
+  /* copies of the rules, in priority order */
+  acl_rule_t *rules;
+
+  /* build statistics */
+  u32 n_leaves;
+  u32 max_depth;
+  u32 max_leaf_rules;
+  f64 build_time;
+} acl_dtree_t;
+
+#endif
@@ -230,6 +230,10 @@ typedef struct {
   u32 sw_if_indices[VLIB_FRAME_SIZE];
   fa_5tuple_t fa_5tuples[VLIB_FRAME_SIZE];
   u64 hashes[VLIB_FRAME_SIZE];
+  /* session found by the frame-wide session lookup, ~0 if none */
+  u64 sess_ids[VLIB_FRAME_SIZE];
+  /* applied ACE index found by the batched ACL lookup for the misses */
+  u32 match_indices[VLIB_FRAME_SIZE];
   u16 nexts[VLIB_FRAME_SIZE];
 
 } acl_fa_per_worker_data_t;
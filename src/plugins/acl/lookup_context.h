@@ -36,6 +36,8 @@ typedef struct {
   u32 user_val1;
   /* per-instance user value 2 */
   u32 user_val2;
+  /* match with the decision tree rather than TupleMerge */
+  int use_decision_tree;
 } acl_lookup_context_t;
 
 void acl_plugin_lookup_context_notify_acl_change(u32 acl_num);
@@ -48,6 +50,7 @@ void acl_plugin_show_tables_mask_type (void);
 void acl_plugin_show_tables_acl_hash_info (u32 acl_index);
 void acl_plugin_show_tables_applied_info (u32 sw_if_index);
 void acl_plugin_show_tables_bihash (u32 show_bihash_verbose);
+void acl_plugin_show_tables_dtree (u32 lc_index);
 
 #endif
 
@@ -531,18 +531,77 @@ single_rule_match_5tuple (acl_rule_t * r, int is_ip6, fa_5tuple_t * pkt_5tuple)
   return 1;
 }
 
+always_inline void
+multi_acl_match_make_key (acl_main_t * am, fa_5tuple_t * match,
+                          int mask_type_index, clib_bihash_kv_48_8_t * kv)
+{
+  fa_5tuple_t *kv_key = (fa_5tuple_t *) kv->key;
+  u64 *pmatch = (u64 *) match;
+  u64 *pmask;
+  u64 *pkey;
+
+  ace_mask_type_entry_t *mte =
+    vec_elt_at_index (am->ace_mask_type_pool, mask_type_index);
+  pmask = (u64 *) & mte->mask;
+  pkey = (u64 *) kv->key;
+  /*
+   * unrolling the below loop results in a noticeable performance increase.
+   int i;
+   for(i=0; i<6; i++) {
+   kv.key[i] = pmatch[i] & pmask[i];
+   }
+   */
+
+  *pkey++ = *pmatch++ & *pmask++;
+  *pkey++ = *pmatch++ & *pmask++;
+  *pkey++ = *pmatch++ & *pmask++;
+  *pkey++ = *pmatch++ & *pmask++;
+  *pkey++ = *pmatch++ & *pmask++;
+  *pkey++ = *pmatch++ & *pmask++;
+
+  /*
+   * The use of temporary variable convinces the compiler
+   * to make a u64 write, avoiding the stall on crc32 operation
+   * just a bit later.
+   */
+  fa_packet_info_t tmp_pkt = kv_key->pkt;
+  tmp_pkt.mask_type_index_lsb = mask_type_index;
+  kv_key->pkt.as_u64 = tmp_pkt.as_u64;
+}
+
+/* There is a hit in the hash, so check the collision vector */
+always_inline u32
+multi_acl_match_check_collisions (applied_hash_ace_entry_t * applied_hash_aces,
+                                  clib_bihash_kv_48_8_t * result, int is_ip6,
+                                  fa_5tuple_t * match, u32 curr_match_index)
+{
+  hash_acl_lookup_value_t *result_val =
+    (hash_acl_lookup_value_t *) & result->value;
+  u32 curr_index = result_val->applied_entry_index;
+  applied_hash_ace_entry_t *pae =
+    vec_elt_at_index (applied_hash_aces, curr_index);
+  collision_match_rule_t *crs = pae->colliding_rules;
+  int i;
+  for (i = 0; i < vec_len (crs); i++)
+    {
+      if (crs[i].applied_entry_index >= curr_match_index)
+        {
+          continue;
+        }
+      if (single_rule_match_5tuple (&crs[i].rule, is_ip6, match))
+        {
+          curr_match_index = crs[i].applied_entry_index;
+        }
+    }
+  return curr_match_index;
+}
+
 always_inline u32
 multi_acl_match_get_applied_ace_index (acl_main_t * am, int is_ip6, fa_5tuple_t * match)
 {
   clib_bihash_kv_48_8_t kv;
   clib_bihash_kv_48_8_t result;
-  fa_5tuple_t *kv_key = (fa_5tuple_t *) kv.key;
-  hash_acl_lookup_value_t *result_val =
-    (hash_acl_lookup_value_t *) & result.value;
-  u64 *pmatch = (u64 *) match;
-  u64 *pmask;
-  u64 *pkey;
-  int mask_type_index, order_index;
+  int order_index;
   u32 curr_match_index = (~0 - 1);
 
 
@@ -557,7 +616,8 @@ multi_acl_match_get_applied_ace_index (acl_main_t * am, int is_ip6, fa_5tuple_t
   hash_applied_mask_info_t *minfo;
 
   DBG ("TRYING TO MATCH: %016llx %016llx %016llx %016llx %016llx %016llx",
-       pmatch[0], pmatch[1], pmatch[2], pmatch[3], pmatch[4], pmatch[5]);
+       ((u64 *) match)[0], ((u64 *) match)[1], ((u64 *) match)[2],
+       ((u64 *) match)[3], ((u64 *) match)[4], ((u64 *) match)[5]);
 
   for (order_index = 0; order_index < vec_len ((*hash_applied_mask_info_vec));
        order_index++)
@@ -569,72 +629,99 @@ multi_acl_match_get_applied_ace_index (acl_main_t * am, int is_ip6, fa_5tuple_t
 	  break;
 	}
 
-      mask_type_index = minfo->mask_type_index;
-      ace_mask_type_entry_t *mte =
-	vec_elt_at_index (am->ace_mask_type_pool, mask_type_index);
-      pmatch = (u64 *) match;
-      pmask = (u64 *) & mte->mask;
-      pkey = (u64 *) kv.key;
-      /*
-       * unrolling the below loop results in a noticeable performance increase.
-       int i;
-       for(i=0; i<6; i++) {
-       kv.key[i] = pmatch[i] & pmask[i];
-       }
-       */
-
-      *pkey++ = *pmatch++ & *pmask++;
-      *pkey++ = *pmatch++ & *pmask++;
-      *pkey++ = *pmatch++ & *pmask++;
-      *pkey++ = *pmatch++ & *pmask++;
-      *pkey++ = *pmatch++ & *pmask++;
-      *pkey++ = *pmatch++ & *pmask++;
-
-      /*
-       * The use of temporary variable convinces the compiler
-       * to make a u64 write, avoiding the stall on crc32 operation
-       * just a bit later.
-       */
-      fa_packet_info_t tmp_pkt = kv_key->pkt;
-      tmp_pkt.mask_type_index_lsb = mask_type_index;
-      kv_key->pkt.as_u64 = tmp_pkt.as_u64;
+      multi_acl_match_make_key (am, match, minfo->mask_type_index, &kv);
 
       int res =
 	clib_bihash_search_inline_2_48_8 (&am->acl_lookup_hash, &kv, &result);
 
       if (res == 0)
-	{
-	  /* There is a hit in the hash, so check the collision vector */
-	  u32 curr_index = result_val->applied_entry_index;
-	  applied_hash_ace_entry_t *pae =
-	    vec_elt_at_index ((*applied_hash_aces), curr_index);
-	  collision_match_rule_t *crs = pae->colliding_rules;
-	  int i;
-	  for (i = 0; i < vec_len (crs); i++)
-	    {
-	      if (crs[i].applied_entry_index >= curr_match_index)
-		{
-		  continue;
-		}
-	      if (single_rule_match_5tuple (&crs[i].rule, is_ip6, match))
-		{
-		  curr_match_index = crs[i].applied_entry_index;
-		}
-	    }
-	}
+	curr_match_index =
+	  multi_acl_match_check_collisions (*applied_hash_aces, &result,
+					    is_ip6, match, curr_match_index);
     }
   DBG ("MATCH-RESULT: %d", curr_match_index);
   return curr_match_index;
 }
 
+#define ACL_MATCH_BATCH_SIZE 16
+
+/*
+ * Same as above for a batch of packets, which may belong to different
+ * lookup contexts. The partitions are walked in lockstep, so the keys
+ * of all the packets still looking get hashed and their buckets prefetched
+ * before any of them is searched.
+ */
+always_inline void
+multi_acl_match_get_applied_ace_index_xN (acl_main_t * am, int is_ip6,
+                                          fa_5tuple_t ** matches, u32 n_matches,
+                                          u32 * match_indices)
+{
+  clib_bihash_kv_48_8_t kv[ACL_MATCH_BATCH_SIZE];
+  clib_bihash_kv_48_8_t result;
+  u64 hash[ACL_MATCH_BATCH_SIZE];
+  u8 active[ACL_MATCH_BATCH_SIZE];
+  int order_index = 0, n_active = n_matches;
+  u32 i;
+
+  ASSERT (n_matches <= ACL_MATCH_BATCH_SIZE);
+  for (i = 0; i < n_matches; i++)
+    {
+      match_indices[i] = (~0 - 1);
+      active[i] = 1;
+    }
+
+  while (n_active)
+    {
+      n_active = 0;
+      for (i = 0; i < n_matches; i++)
+        {
+          u32 lc_index = matches[i]->pkt.lc_index;
+          hash_applied_mask_info_t *minfo_vec =
+            am->hash_applied_mask_info_vec_by_lc_index[lc_index];
+
+          if (!active[i])
+            continue;
+          if (order_index >= vec_len (minfo_vec)
+              || minfo_vec[order_index].first_rule_index > match_indices[i])
+            {
+              active[i] = 0;
+              continue;
+            }
+          multi_acl_match_make_key (am, matches[i],
+                                    minfo_vec[order_index].mask_type_index,
+                                    &kv[i]);
+          hash[i] = clib_bihash_hash_48_8 (&kv[i]);
+          clib_bihash_prefetch_bucket_48_8 (&am->acl_lookup_hash, hash[i]);
+          n_active++;
+        }
+
+      for (i = 0; i < n_matches; i++)
+        {
+          if (!active[i])
+            continue;
+          if (clib_bihash_search_inline_2_with_hash_48_8
+              (&am->acl_lookup_hash, hash[i], &kv[i], &result) == 0)
+            {
+              u32 lc_index = matches[i]->pkt.lc_index;
+              match_indices[i] = multi_acl_match_check_collisions
+                (am->hash_entry_vec_by_lc_index[lc_index], &result, is_ip6,
+                 matches[i], match_indices[i]);
+            }
+        }
+      order_index++;
+    }
+}
+
+/*
+ * Fill in the results for an index returned by the above functions,
+ * returns 0 if it is not a match.
+ */
 always_inline int
-hash_multi_acl_match_5tuple (void *p_acl_main, u32 lc_index, fa_5tuple_t * pkt_5tuple,
-                       int is_ip6, u8 *action, u32 *acl_pos_p, u32 * acl_match_p,
-                       u32 * rule_match_p, u32 * trace_bitmap)
+applied_ace_match_result (acl_main_t * am, u32 lc_index, u32 match_index,
+                          u8 * action, u32 * acl_pos_p, u32 * acl_match_p,
+                          u32 * rule_match_p)
 {
-  acl_main_t *am = p_acl_main;
   applied_hash_ace_entry_t **applied_hash_aces = vec_elt_at_index(am->hash_entry_vec_by_lc_index, lc_index);
-  u32 match_index = multi_acl_match_get_applied_ace_index(am, is_ip6, pkt_5tuple);
   if (match_index < vec_len((*applied_hash_aces))) {
     applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), match_index);
     pae->hitcount++;
@@ -647,6 +734,74 @@ hash_multi_acl_match_5tuple (void *p_acl_main, u32 lc_index, fa_5tuple_t * pkt_5
   return 0;
 }
 
+always_inline int
+hash_multi_acl_match_5tuple (void *p_acl_main, u32 lc_index, fa_5tuple_t * pkt_5tuple,
+                       int is_ip6, u8 *action, u32 *acl_pos_p, u32 * acl_match_p,
+                       u32 * rule_match_p, u32 * trace_bitmap)
+{
+  acl_main_t *am = p_acl_main;
+  u32 match_index = multi_acl_match_get_applied_ace_index(am, is_ip6, pkt_5tuple);
+  return applied_ace_match_result(am, lc_index, match_index, action,
+                                  acl_pos_p, acl_match_p, rule_match_p);
+}
+
+
+
+/*
+ * Walk the decision tree down to a leaf and match its rules in order.
+ * Returns the index of the highest priority matching rule, or ~0.
+ */
+always_inline u32
+acl_dtree_match (acl_dtree_t * t, int is_ip6, fa_5tuple_t * match)
+{
+  u64 key[ACL_DTREE_N_DIMS];
+  acl_dtree_node_t *n;
+  u32 i, *ri;
+
+  if (is_ip6)
+    {
+      key[ACL_DTREE_DIM_SRC_ADDR] = clib_net_to_host_u64 (match->ip6_addr[0].as_u64[0]);
+      key[ACL_DTREE_DIM_DST_ADDR] = clib_net_to_host_u64 (match->ip6_addr[1].as_u64[0]);
+    }
+  else
+    {
+      key[ACL_DTREE_DIM_SRC_ADDR] = clib_net_to_host_u32 (match->ip4_addr[0].as_u32);
+      key[ACL_DTREE_DIM_DST_ADDR] = clib_net_to_host_u32 (match->ip4_addr[1].as_u32);
+    }
+  key[ACL_DTREE_DIM_SRC_PORT] = match->l4.port[0];
+  key[ACL_DTREE_DIM_DST_PORT] = match->l4.port[1];
+  key[ACL_DTREE_DIM_PROTO] = match->l4.proto;
+
+  n = vec_elt_at_index (t->nodes, is_ip6);
+  while (n->n_bits)
+    n = t->nodes + n->index + ((key[n->dim] >> n->shift) & pow2_mask (n->n_bits));
+
+  ri = t->leaf_rules + n->index;
+  for (i = 0; i < n->n_rules; i++)
+    if (single_rule_match_5tuple (&t->rules[ri[i]], is_ip6, match))
+      return ri[i];
+  return ~0;
+}
+
+always_inline acl_dtree_t *
+acl_lc_get_dtree (acl_main_t * am, u32 lc_index)
+{
+  if (lc_index < vec_len (am->dtree_by_lc_index))
+    return am->dtree_by_lc_index[lc_index];
+  return 0;
+}
+
+always_inline int
+dtree_multi_acl_match_5tuple (void *p_acl_main, acl_dtree_t * t, u32 lc_index, fa_5tuple_t * pkt_5tuple,
+                       int is_ip6, u8 *action, u32 *acl_pos_p, u32 * acl_match_p,
+                       u32 * rule_match_p, u32 * trace_bitmap)
+{
+  acl_main_t *am = p_acl_main;
+  /* the tree rules are indexed the same as the applied entries */
+  u32 match_index = acl_dtree_match(t, is_ip6, pkt_5tuple);
+  return applied_ace_match_result(am, lc_index, match_index, action,
+                                  acl_pos_p, acl_match_p, rule_match_p);
+}
 
 
 always_inline int
@@ -672,6 +827,10 @@ acl_plugin_match_5tuple_inline (void *p_acl_main, u32 lc_index,
       return linear_multi_acl_match_5tuple(p_acl_main, lc_index, pkt_5tuple_internal, is_ip6, r_action,
                                  r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
     } else {
+      acl_dtree_t *t = acl_lc_get_dtree(am, lc_index);
+      if (t)
+        return dtree_multi_acl_match_5tuple(p_acl_main, t, lc_index, pkt_5tuple_internal, is_ip6, r_action,
+                                 r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
       return hash_multi_acl_match_5tuple(p_acl_main, lc_index, pkt_5tuple_internal, is_ip6, r_action,
                                  r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
     }
@@ -707,7 +866,12 @@ acl_plugin_match_5tuple_inline_and_count (void *p_acl_main, u32 lc_index,
       ret = linear_multi_acl_match_5tuple(p_acl_main, lc_index, pkt_5tuple_internal, is_ip6, r_action,
                                  r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
     } else {
-      ret = hash_multi_acl_match_5tuple(p_acl_main, lc_index, pkt_5tuple_internal, is_ip6, r_action,
+      acl_dtree_t *t = acl_lc_get_dtree(am, lc_index);
+      if (t)
+        ret = dtree_multi_acl_match_5tuple(p_acl_main, t, lc_index, pkt_5tuple_internal, is_ip6, r_action,
+                                 r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
+      else
+        ret = hash_multi_acl_match_5tuple(p_acl_main, lc_index, pkt_5tuple_internal, is_ip6, r_action,
                                  r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
     }
   } else {
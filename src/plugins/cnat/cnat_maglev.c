@@ -10,6 +10,13 @@ cnat_maglev_perm_compare (void *_a, void *_b)
   return *(u64 *) _b - *(u64 *) _a;
 }
 
+static_always_inline u32
+cnat_maglev_next (u32 c, u32 skip, u32 M)
+{
+  c += skip;
+  return (c >= M ? c - M : c);
+}
+
 /**
  * Maglev algorithm implementation. This takes permutation as input,
  * with the values of offset & skip for the backends.
@@ -20,7 +27,7 @@ static void
 cnat_maglev_shuffle (cnat_maglev_perm_t *permutation, u32 *buckets)
 {
   u32 N, M, i, done = 0;
-  u32 *next = 0;
+  u32 *pos = 0;
 
   N = vec_len (permutation);
   if (N == 0)
@@ -31,27 +38,29 @@ cnat_maglev_shuffle (cnat_maglev_perm_t *permutation, u32 *buckets)
     return;
   vec_set (buckets, -1);
 
-  vec_validate (next, N - 1);
-  vec_zero (next);
+  /* pos[i] is (offset + j * skip) % M for the j-th preference of backend
+   * i. As offset < M and skip < M, it is advanced with an add and a
+   * conditional subtract instead of a division per probe. */
+  vec_validate (pos, N - 1);
+  for (i = 0; i < N; i++)
+    pos[i] = permutation[i].offset;
 
   while (1)
     {
       for (i = 0; i < N; i++)
 	{
-	  u32 c = (permutation[i].offset + next[i] * permutation[i].skip) % M;
+	  u32 c = pos[i];
+	  u32 skip = permutation[i].skip;
 	  while (buckets[c] != (u32) -1)
-	    {
-	      next[i]++;
-	      c = (permutation[i].offset + next[i] * permutation[i].skip) % M;
-	    }
+	    c = cnat_maglev_next (c, skip, M);
 
 	  buckets[c] = permutation[i].index;
-	  next[i]++;
+	  pos[i] = cnat_maglev_next (c, skip, M);
 	  done++;
 
 	  if (done == M)
 	    {
-	      vec_free (next);
+	      vec_free (pos);
 	      return;
 	    }
 	}
@@ -23,12 +23,18 @@ cnat_scanner_process (vlib_main_t * vm,
   uword event_type, *event_data = 0;
   cnat_main_t *cm = &cnat_main;
   f64 start_time;
-  int enabled = 0, i = 0;
+  int enabled = 0;
+  u64 cursor = 0;
 
   while (1)
     {
+      /* an interrupted scan is resumed shortly, rather than after a full
+       * scanner timeout, so that a pass over a large DB does not take
+       * much longer than the session lifetimes */
       if (enabled)
-	vlib_process_wait_for_event_or_clock (vm, cm->scanner_timeout);
+	vlib_process_wait_for_event_or_clock (
+	  vm, cursor ? clib_min (cm->scanner_timeout, CNAT_SCANNER_SLICE_PAUSE) :
+		       cm->scanner_timeout);
       else
 	vlib_process_wait_for_event (vm);
 
@@ -53,7 +59,7 @@ cnat_scanner_process (vlib_main_t * vm,
 	}
 
       cnat_client_throttle_pool_process ();
-      i = cnat_session_scan (vm, start_time, i);
+      cursor = cnat_session_scan (vm, start_time, cursor);
     }
   return 0;
 }
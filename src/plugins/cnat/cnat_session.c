@@ -202,19 +202,24 @@ cnat_reverse_session_free (cnat_session_t *session)
 }
 
 u64
-cnat_session_scan (vlib_main_t * vm, f64 start_time, int i)
+cnat_session_scan (vlib_main_t *vm, f64 start_time, u64 cursor)
 {
   BVT (clib_bihash) * h = &cnat_session_db;
-  int j, k;
+  /* the cursor is the bucket and the entry within it to resume from */
+  u32 i = cursor >> 32, kvp = (u32) cursor;
+  u32 n_kvp, n_visited = 0;
 
   if (alloc_arena (h) == 0)
     return 0;
 
-  for ( /* caller saves starting point */ ; i < h->nbuckets; i++)
+  for (; i < h->nbuckets; i++, kvp = 0)
     {
-      /* allow no more than 100us without a pause */
-      if ((vlib_time_now (vm) - start_time) > 10e-5)
-	return (i);
+      /* allow no more than CNAT_SCANNER_SLICE_TIME without a pause. Large
+       * buckets are interrupted as well, so the time is also checked
+       * between entries */
+      if (!(++n_visited % CNAT_SCANNER_CHECK_INTERVAL) &&
+	  (vlib_time_now (vm) - start_time) > CNAT_SCANNER_SLICE_TIME)
+	return ((u64) i << 32 | kvp);
 
       if (i < (h->nbuckets - 3))
 	{
@@ -234,36 +239,37 @@ cnat_session_scan (vlib_main_t * vm, f64 start_time, int i)
       if (BV (clib_bihash_bucket_is_empty) (b))
 	continue;
       BVT (clib_bihash_value) * v = BV (clib_bihash_get_value) (h, b->offset);
-      for (j = 0; j < (1 << b->log2_pages); j++)
+      n_kvp = (1 << b->log2_pages) * BIHASH_KVP_PER_PAGE;
+      for (; kvp < n_kvp; kvp++)
 	{
-	  for (k = 0; k < BIHASH_KVP_PER_PAGE; k++)
+	  BVT (clib_bihash_kv) *kv =
+	    &v[kvp / BIHASH_KVP_PER_PAGE].kvp[kvp % BIHASH_KVP_PER_PAGE];
+
+	  if (!(++n_visited % CNAT_SCANNER_CHECK_INTERVAL) &&
+	      (vlib_time_now (vm) - start_time) > CNAT_SCANNER_SLICE_TIME)
+	    return ((u64) i << 32 | kvp);
+
+	  if (kv->key[0] == ~0ULL && kv->value[0] == ~0ULL)
+	    continue;
+
+	  cnat_session_t *session = (cnat_session_t *) kv;
+
+	  if (start_time > cnat_timestamp_exp (session->value.cs_ts_index))
 	    {
-	      if (v->kvp[k].key[0] == ~0ULL && v->kvp[k].value[0] == ~0ULL)
-		continue;
-
-	      cnat_session_t *session = (cnat_session_t *) & v->kvp[k];
-
-	      if (start_time >
-		  cnat_timestamp_exp (session->value.cs_ts_index))
-		{
-		  /* age it */
-		  cnat_reverse_session_free (session);
-		  /* this should be last as deleting the session memset it to
-		   * 0xff */
-		  cnat_session_free (session);
-
-		  /*
-		   * Note: we may have just freed the bucket's backing
-		   * storage, so check right here...
-		   */
-		  if (BV (clib_bihash_bucket_is_empty) (b))
-		    goto doublebreak;
-		}
+	      /* age it */
+	      cnat_reverse_session_free (session);
+	      /* this should be last as deleting the session memset it to
+	       * 0xff */
+	      cnat_session_free (session);
+
+	      /*
+	       * Note: we may have just freed the bucket's backing
+	       * storage, so check right here...
+	       */
+	      if (BV (clib_bihash_bucket_is_empty) (b))
+		break;
 	    }
-	  v++;
 	}
-    doublebreak:
-      ;
     }
 
   /* start again */
@@ -174,9 +174,11 @@ typedef walk_rc_t (*cnat_session_walk_cb_t) (const cnat_session_t *
 extern void cnat_session_walk (cnat_session_walk_cb_t cb, void *ctx);
 
 /**
- * Scan the session DB for expired sessions
+ * Scan the session DB for expired sessions, for at most
+ * CNAT_SCANNER_SLICE_TIME. Returns the cursor to resume from,
+ * or 0 once the whole DB has been scanned.
  */
-extern u64 cnat_session_scan (vlib_main_t * vm, f64 start_time, int i);
+extern u64 cnat_session_scan (vlib_main_t *vm, f64 start_time, u64 cursor);
 
 /**
  * Purge all the sessions
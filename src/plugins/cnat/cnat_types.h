@@ -33,6 +33,11 @@
 /* lifetime of TCP conn NAT sessions after RST/FIN (seconds) */
 #define CNAT_DEFAULT_TCP_RST_TIMEOUT 5
 #define CNAT_DEFAULT_SCANNER_TIMEOUT (1.0)
+/* time the scanner may run in one go, and pause before resuming the scan */
+#define CNAT_SCANNER_SLICE_TIME	 (100e-6)
+#define CNAT_SCANNER_SLICE_PAUSE (10e-3)
+/* number of buckets & entries visited between two checks of the time */
+#define CNAT_SCANNER_CHECK_INTERVAL 64
 
 #define CNAT_DEFAULT_SESSION_BUCKETS     1024
 #define CNAT_DEFAULT_TRANSLATION_BUCKETS 1024
@@ -44,7 +44,7 @@ typedef struct
 {
   CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
   crypto_sw_scheduler_queue_t queue[CRYPTO_SW_SCHED_QUEUE_N_TYPES];
-  u32 last_serve_lcore_id;
+  u32 numa_node;
   u8 last_serve_encrypt;
   u8 last_return_queue;
   vnet_crypto_op_t *crypto_ops;
@@ -55,16 +55,33 @@ typedef struct
   u8 self_crypto_enabled;
 } crypto_sw_scheduler_per_thread_data_t;
 
+/* frames processed by a worker, by where they were taken from */
+#define foreach_crypto_sw_scheduler_counter                                   \
+  _ (OWN, "own", "own-frames")                                                \
+  _ (STOLEN_LOCAL, "stolen-local", "stolen-local-frames")                     \
+  _ (STOLEN_REMOTE, "stolen-remote", "stolen-remote-frames")
+
+typedef enum
+{
+#define _(sym, str, stat) CRYPTO_SW_SCHEDULER_COUNTER_##sym,
+  foreach_crypto_sw_scheduler_counter
+#undef _
+    CRYPTO_SW_SCHEDULER_N_COUNTERS,
+} crypto_sw_scheduler_counter_t;
+
 typedef struct
 {
   u32 crypto_engine_index;
   crypto_sw_scheduler_per_thread_data_t *per_thread_data;
   vnet_crypto_key_t *keys;
+  vlib_simple_counter_main_t counters[CRYPTO_SW_SCHEDULER_N_COUNTERS];
 } crypto_sw_scheduler_main_t;
 
 extern crypto_sw_scheduler_main_t crypto_sw_scheduler_main;
 
 extern int crypto_sw_scheduler_set_worker_crypto (u32 worker_idx, u8 enabled);
+extern int crypto_sw_scheduler_set_worker_numa (u32 worker_idx,
+						u32 numa_node);
 
 extern clib_error_t *crypto_sw_scheduler_api_init (vlib_main_t * vm);
 
@@ -50,6 +50,19 @@ crypto_sw_scheduler_set_worker_crypto (u32 worker_idx, u8 enabled)
   return 0;
 }
 
+int
+crypto_sw_scheduler_set_worker_numa (u32 worker_idx, u32 numa_node)
+{
+  crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
+
+  if (worker_idx >= vlib_num_workers ())
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  cm->per_thread_data[vlib_get_worker_thread_index (worker_idx)].numa_node =
+    numa_node;
+  return 0;
+}
+
 static void
 crypto_sw_scheduler_key_handler (vlib_main_t * vm, vnet_crypto_key_op_t kop,
 				 vnet_crypto_key_index_t idx)
@@ -446,6 +459,85 @@ crypto_sw_scheduler_process_aead (vlib_main_t *vm,
       return -1;
     }
 
+    static_always_inline vnet_crypto_async_frame_t *
+    crypto_sw_scheduler_claim_frame (crypto_sw_scheduler_queue_t *q)
+    {
+      vnet_crypto_async_frame_t *f;
+      u32 tail = q->tail, head = q->head, j;
+
+      /* Skip this queue unless tail < head or head has overflowed
+       * and tail has not. At the point where tail overflows (== 0),
+       * the largest possible value of head is (queue size - 1).
+       * Prior to that, the largest possible value of head is
+       * (queue size - 2).
+       */
+      if ((tail > head) && (head >= CRYPTO_SW_SCHEDULER_QUEUE_MASK))
+	return 0;
+
+      for (j = tail; j != head; j++)
+	{
+	  f = q->jobs[j & CRYPTO_SW_SCHEDULER_QUEUE_MASK];
+
+	  if (!f)
+	    continue;
+
+	  if (clib_atomic_bool_cmp_and_swap (
+		&f->state, VNET_CRYPTO_FRAME_STATE_PENDING,
+		VNET_CRYPTO_FRAME_STATE_WORK_IN_PROGRESS))
+	    return f;
+	}
+
+      return 0;
+    }
+
+    /* Claim a frame from a peer on the same (or another) numa node. The
+     * peer with the most queued frames is tried first; if its frames are
+     * all taken already, fall back to any other peer with a backlog. */
+    static_always_inline vnet_crypto_async_frame_t *
+    crypto_sw_scheduler_steal (crypto_sw_scheduler_main_t *cm,
+			       crypto_sw_scheduler_per_thread_data_t *ptd,
+			       u32 thread_index, u32 q_type, int same_numa)
+    {
+      crypto_sw_scheduler_per_thread_data_t *st;
+      vnet_crypto_async_frame_t *f;
+      u32 i, load, max_load = 0, victim = ~0;
+
+      vec_foreach_index (i, cm->per_thread_data)
+	{
+	  st = cm->per_thread_data + i;
+	  if (i == thread_index ||
+	      (st->numa_node == ptd->numa_node) != same_numa)
+	    continue;
+	  load = st->queue[q_type].head - st->queue[q_type].tail;
+	  if (load > max_load)
+	    {
+	      max_load = load;
+	      victim = i;
+	    }
+	}
+
+      if (victim == ~0)
+	return 0;
+
+      st = cm->per_thread_data + victim;
+      if ((f = crypto_sw_scheduler_claim_frame (&st->queue[q_type])))
+	return f;
+
+      vec_foreach_index (i, cm->per_thread_data)
+	{
+	  st = cm->per_thread_data + i;
+	  if (i == thread_index || i == victim ||
+	      (st->numa_node == ptd->numa_node) != same_numa)
+	    continue;
+	  if (st->queue[q_type].head == st->queue[q_type].tail)
+	    continue;
+	  if ((f = crypto_sw_scheduler_claim_frame (&st->queue[q_type])))
+	    return f;
+	}
+
+      return 0;
+    }
+
     static_always_inline vnet_crypto_async_frame_t *
     crypto_sw_scheduler_dequeue (vlib_main_t *vm, u32 *nb_elts_processed,
 				 u32 *enqueue_thread_idx)
@@ -455,70 +547,41 @@ crypto_sw_scheduler_process_aead (vlib_main_t *vm,
 	cm->per_thread_data + vm->thread_index;
       vnet_crypto_async_frame_t *f = 0;
       crypto_sw_scheduler_queue_t *current_queue = 0;
-      u32 tail, head;
+      u32 tail;
       u8 found = 0;
 
       /* get a pending frame to process */
       if (ptd->self_crypto_enabled)
 	{
-	  u32 i = ptd->last_serve_lcore_id + 1;
-
-	  while (1)
+	  u32 q_type = ptd->last_serve_encrypt ?
+			 CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT :
+			 CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT;
+	  u32 kind = CRYPTO_SW_SCHEDULER_COUNTER_OWN;
+
+	  /* our own frames first, their buffers are still warm in cache */
+	  f = crypto_sw_scheduler_claim_frame (&ptd->queue[q_type]);
+	  if (!f)
 	    {
-	      crypto_sw_scheduler_per_thread_data_t *st;
-	      u32 j;
-
-	      if (i >= vec_len (cm->per_thread_data))
-		i = 0;
+	      kind = CRYPTO_SW_SCHEDULER_COUNTER_STOLEN_LOCAL;
+	      f = crypto_sw_scheduler_steal (cm, ptd, vm->thread_index, q_type,
+					     1 /* same numa */);
+	    }
+	  if (!f)
+	    {
+	      kind = CRYPTO_SW_SCHEDULER_COUNTER_STOLEN_REMOTE;
+	      f = crypto_sw_scheduler_steal (cm, ptd, vm->thread_index, q_type,
+					     0 /* same numa */);
+	    }
 
-	      st = cm->per_thread_data + i;
+	  CLIB_MEMORY_STORE_BARRIER ();
+	  ptd->last_serve_encrypt = !ptd->last_serve_encrypt;
 
-	      if (ptd->last_serve_encrypt)
-		current_queue = &st->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT];
-	      else
-		current_queue = &st->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_ENCRYPT];
-
-	      tail = current_queue->tail;
-	      head = current_queue->head;
-
-	      /* Skip this queue unless tail < head or head has overflowed
-	       * and tail has not. At the point where tail overflows (== 0),
-	       * the largest possible value of head is (queue size - 1).
-	       * Prior to that, the largest possible value of head is
-	       * (queue size - 2).
-	       */
-	      if ((tail > head) && (head >= CRYPTO_SW_SCHEDULER_QUEUE_MASK))
-		goto skip_queue;
-
-	      for (j = tail; j != head; j++)
-		{
-
-		  f = current_queue->jobs[j & CRYPTO_SW_SCHEDULER_QUEUE_MASK];
-
-		  if (!f)
-		    continue;
-
-		  if (clib_atomic_bool_cmp_and_swap (
-			&f->state, VNET_CRYPTO_FRAME_STATE_PENDING,
-			VNET_CRYPTO_FRAME_STATE_WORK_IN_PROGRESS))
-		    {
-		      found = 1;
-		      break;
-		    }
-		}
-
-	    skip_queue:
-	      if (found || i == ptd->last_serve_lcore_id)
-		{
-		  CLIB_MEMORY_STORE_BARRIER ();
-		  ptd->last_serve_encrypt = !ptd->last_serve_encrypt;
-		  break;
-		}
-
-	      i++;
+	  if (f)
+	    {
+	      found = 1;
+	      vlib_increment_simple_counter (&cm->counters[kind],
+					     vm->thread_index, 0, 1);
 	    }
-
-	  ptd->last_serve_lcore_id = i;
 	}
 
       if (found)
@@ -576,8 +639,8 @@ sw_scheduler_set_worker_crypto (vlib_main_t * vm, unformat_input_t * input,
 				vlib_cli_command_t * cmd)
 {
   unformat_input_t _line_input, *line_input = &_line_input;
-  u32 worker_index;
-  u8 crypto_enable;
+  u32 worker_index = ~0, numa_node = ~0;
+  i8 crypto_enable = -1;
   int rv;
 
   /* Get a line of input. */
@@ -599,6 +662,8 @@ sw_scheduler_set_worker_crypto (vlib_main_t * vm, unformat_input_t * input,
 					   format_unformat_error,
 					   line_input));
 	    }
+	  else if (unformat (line_input, "numa %u", &numa_node))
+	    ;
 	  else
 	    return (clib_error_return (0, "unknown input '%U'",
 				       format_unformat_error, line_input));
@@ -608,20 +673,31 @@ sw_scheduler_set_worker_crypto (vlib_main_t * vm, unformat_input_t * input,
 				   format_unformat_error, line_input));
     }
 
-  rv = crypto_sw_scheduler_set_worker_crypto (worker_index, crypto_enable);
-  if (rv == VNET_API_ERROR_INVALID_VALUE)
-    {
-      return (clib_error_return (0, "invalid worker idx: %d", worker_index));
-    }
-  else if (rv == VNET_API_ERROR_INVALID_VALUE_2)
+  if (crypto_enable != -1)
     {
-      return (clib_error_return (0, "cannot disable all crypto workers"));
+      rv = crypto_sw_scheduler_set_worker_crypto (worker_index, crypto_enable);
+      if (rv == VNET_API_ERROR_INVALID_VALUE)
+	{
+	  return (
+	    clib_error_return (0, "invalid worker idx: %d", worker_index));
+	}
+      else if (rv == VNET_API_ERROR_INVALID_VALUE_2)
+	{
+	  return (clib_error_return (0, "cannot disable all crypto workers"));
+	}
     }
+
+  if (numa_node != ~0 &&
+      crypto_sw_scheduler_set_worker_numa (worker_index, numa_node))
+    return (clib_error_return (0, "invalid worker idx: %d", worker_index));
+
   return 0;
 }
 
 /*?
- * This command sets if worker will do crypto processing.
+ * This command sets if worker will do crypto processing, and the numa
+ * node it is treated as running on when it steals frames of other
+ * workers. The node is learnt when the worker starts.
  *
  * @cliexpar
  * Example of how to set worker crypto processing off:
@@ -631,7 +707,8 @@ sw_scheduler_set_worker_crypto (vlib_main_t * vm, unformat_input_t * input,
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (cmd_set_sw_scheduler_worker_crypto, static) = {
   .path = "set sw_scheduler",
-  .short_help = "set sw_scheduler worker <idx> crypto <on|off>",
+  .short_help = "set sw_scheduler worker <idx> [crypto <on|off>] "
+		"[numa <node>]",
   .function = sw_scheduler_set_worker_crypto,
   .is_mp_safe = 1,
 };
@@ -642,15 +719,21 @@ sw_scheduler_show_workers (vlib_main_t * vm, unformat_input_t * input,
 			   vlib_cli_command_t * cmd)
 {
   crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
+  vlib_simple_counter_main_t *sm = cm->counters;
   u32 i;
 
-  vlib_cli_output (vm, "%-7s%-20s%-8s", "ID", "Name", "Crypto");
+  vlib_cli_output (vm, "%-7s%-20s%-8s%-6s%-14s%-14s%-14s", "ID", "Name",
+		   "Crypto", "Numa", "Own", "Stolen-local", "Stolen-remote");
   for (i = 1; i < vlib_thread_main.n_vlib_mains; i++)
     {
-      vlib_cli_output (vm, "%-7d%-20s%-8s", vlib_get_worker_index (i),
-		       (vlib_worker_threads + i)->name,
-		       cm->
-		       per_thread_data[i].self_crypto_enabled ? "on" : "off");
+      vlib_cli_output (
+	vm, "%-7d%-20s%-8s%-6u%-14lu%-14lu%-14lu", vlib_get_worker_index (i),
+	(vlib_worker_threads + i)->name,
+	cm->per_thread_data[i].self_crypto_enabled ? "on" : "off",
+	cm->per_thread_data[i].numa_node,
+	sm[CRYPTO_SW_SCHEDULER_COUNTER_OWN].counters[i][0],
+	sm[CRYPTO_SW_SCHEDULER_COUNTER_STOLEN_LOCAL].counters[i][0],
+	sm[CRYPTO_SW_SCHEDULER_COUNTER_STOLEN_REMOTE].counters[i][0]);
     }
 
   return 0;
@@ -689,13 +772,27 @@ crypto_sw_scheduler_init (vlib_main_t * vm)
   vlib_thread_main_t *tm = vlib_get_thread_main ();
   clib_error_t *error = 0;
   crypto_sw_scheduler_per_thread_data_t *ptd;
+  u32 i;
 
   vec_validate_aligned (cm->per_thread_data, tm->n_vlib_mains - 1,
 			CLIB_CACHE_LINE_BYTES);
 
+#define _(sym, str, stat)                                                     \
+  cm->counters[CRYPTO_SW_SCHEDULER_COUNTER_##sym].name = str;                 \
+  cm->counters[CRYPTO_SW_SCHEDULER_COUNTER_##sym].stat_segment_name =         \
+    "/crypto/sw_scheduler/" stat;
+  foreach_crypto_sw_scheduler_counter
+#undef _
+
+  for (i = 0; i < CRYPTO_SW_SCHEDULER_N_COUNTERS; i++)
+    vlib_validate_simple_counter (&cm->counters[i], 0);
+
   vec_foreach (ptd, cm->per_thread_data)
   {
     ptd->self_crypto_enabled = 1;
+    /* workers refine it when they start, see
+     * crypto_sw_scheduler_worker_init */
+    ptd->numa_node = vm->numa_node;
 
     ptd->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT].head = 0;
     ptd->queue[CRYPTO_SW_SCHED_QUEUE_TYPE_DECRYPT].tail = 0;
@@ -755,6 +852,25 @@ crypto_sw_scheduler_init (vlib_main_t * vm)
   return error;
 }
 
+/*
+ * Learn the numa node of a worker as soon as it starts, so that peers do
+ * not steal its frames as if it were on the main thread's node before its
+ * first dequeue.
+ */
+static clib_error_t *
+crypto_sw_scheduler_worker_init (vlib_main_t *vm)
+{
+  crypto_sw_scheduler_main_t *cm = &crypto_sw_scheduler_main;
+
+  if (vm->thread_index < vec_len (cm->per_thread_data))
+    cm->per_thread_data[vm->thread_index].numa_node =
+      clib_get_current_numa_node ();
+
+  return 0;
+}
+
+VLIB_WORKER_INIT_FUNCTION (crypto_sw_scheduler_worker_init);
+
 /* *INDENT-OFF* */
 VLIB_INIT_FUNCTION (crypto_sw_scheduler_init) = {
   .runs_after = VLIB_INITS ("vnet_crypto_init"),
@@ -113,6 +113,9 @@ dpdk_device_setup (dpdk_device_t * xd)
   if (xd->conf.enable_lro)
     rxo |= RTE_ETH_RX_OFFLOAD_TCP_LRO;
 
+  if (xd->conf.enable_rx_hash)
+    rxo |= RTE_ETH_RX_OFFLOAD_RSS_HASH;
+
   /* per-device offload config */
   if (xd->conf.enable_tso)
     txo |= RTE_ETH_TX_OFFLOAD_TCP_CKSUM | RTE_ETH_TX_OFFLOAD_TCP_TSO |
@@ -264,6 +267,8 @@ retry:
 			rxo & RTE_ETH_RX_OFFLOAD_IPV4_CKSUM);
   dpdk_device_flag_set (xd, DPDK_DEVICE_FLAG_MAYBE_MULTISEG,
 			rxo & RTE_ETH_RX_OFFLOAD_SCATTER);
+  dpdk_device_flag_set (xd, DPDK_DEVICE_FLAG_RX_HASH,
+			rxo & RTE_ETH_RX_OFFLOAD_RSS_HASH);
   dpdk_device_flag_set (
     xd, DPDK_DEVICE_FLAG_TX_OFFLOAD,
     (txo & (RTE_ETH_TX_OFFLOAD_TCP_CKSUM | RTE_ETH_TX_OFFLOAD_UDP_CKSUM)) ==
@@ -58,7 +58,8 @@ typedef uint16_t dpdk_portid_t;
   _ (11, RX_FLOW_OFFLOAD, "rx-flow-offload")                                  \
   _ (12, RX_IP4_CKSUM, "rx-ip4-cksum")                                        \
   _ (13, INT_SUPPORTED, "int-supported")                                      \
-  _ (14, INT_UNMASKABLE, "int-unmaskable")
+  _ (14, INT_UNMASKABLE, "int-unmaskable")                                   \
+  _ (15, RX_HASH, "rx-hash")
 
 typedef enum
 {
@@ -136,6 +137,7 @@ typedef union
     u16 disable_tx_checksum_offload : 1;
     u16 disable_rss : 1;
     u16 disable_rx_scatter : 1;
+    u16 enable_rx_hash : 1;
     u16 n_rx_queues;
     u16 n_tx_queues;
     u16 n_rx_desc;
@@ -251,6 +253,7 @@ typedef struct
 #undef _
     clib_bitmap_t * workers;
   u8 tso;
+  u8 rx_hash;
   u8 *devargs;
   clib_bitmap_t *rss_queues;
 
@@ -197,6 +197,7 @@ dpdk_update_counters (dpdk_device_t * xd, f64 now)
 #define RTE_ETH_RX_OFFLOAD_IPV4_CKSUM	    DEV_RX_OFFLOAD_IPV4_CKSUM
 #define RTE_ETH_RX_OFFLOAD_SCATTER	    DEV_RX_OFFLOAD_SCATTER
 #define RTE_ETH_RX_OFFLOAD_TCP_LRO	    DEV_RX_OFFLOAD_TCP_LRO
+#define RTE_ETH_RX_OFFLOAD_RSS_HASH	    DEV_RX_OFFLOAD_RSS_HASH
 #define RTE_ETH_MQ_RX_RSS		    ETH_MQ_RX_RSS
 #define RTE_ETH_RX_OFFLOAD_TCP_CKSUM	    DEV_RX_OFFLOAD_TCP_CKSUM
 #define RTE_ETH_RX_OFFLOAD_UDP_CKSUM	    DEV_RX_OFFLOAD_UDP_CKSUM
@@ -504,6 +504,15 @@ dpdk_lib_init (dpdk_main_t * dm)
       if (devconf->max_lro_pkt_size)
 	xd->conf.max_lro_pkt_size = devconf->max_lro_pkt_size;
 
+      if (devconf->rx_hash)
+	{
+	  if ((di.rx_offload_capa & RTE_ETH_RX_OFFLOAD_RSS_HASH) == 0)
+	    dpdk_log_warn ("[%u] RSS hash delivery not supported by device",
+			   xd->port_id);
+	  else
+	    xd->conf.enable_rx_hash = 1;
+	}
+
       dpdk_device_setup (xd);
 
       /* rss queues should be configured after dpdk_device_setup() */
@@ -901,6 +910,8 @@ dpdk_device_config (dpdk_config_main_t *conf, void *addr,
 	{
 	  devconf->tso = DPDK_DEVICE_TSO_OFF;
 	}
+      else if (unformat (input, "rx-hash"))
+	devconf->rx_hash = 1;
       else if (unformat (input, "devargs %s", &devconf->devargs))
 	;
       else if (unformat (input, "rss-queues %U",
@@ -1242,6 +1253,9 @@ dpdk_config (vlib_main_t * vm, unformat_input_t * input)
       /* copy tso config from default device */
       _ (devargs)
 
+      /* copy rx_hash config from default device */
+      _ (rx_hash)
+
       /* copy rss_queues config from default device */
       _ (rss_queues)
 
@@ -38,7 +38,8 @@ static char *dpdk_error_strings[] = {
 
 /* make sure all flags we need are stored in lower 32 bits */
 STATIC_ASSERT ((u64) (RTE_MBUF_F_RX_IP_CKSUM_BAD | RTE_MBUF_F_RX_L4_CKSUM_BAD |
-		      RTE_MBUF_F_RX_FDIR | RTE_MBUF_F_RX_LRO) < (1ULL << 32),
+		      RTE_MBUF_F_RX_FDIR | RTE_MBUF_F_RX_LRO |
+		      RTE_MBUF_F_RX_RSS_HASH) < (1ULL << 32),
 	       "dpdk flags not in lower word, fix needed");
 
 STATIC_ASSERT (RTE_MBUF_F_RX_L4_CKSUM_BAD == (1ULL << 3),
@@ -280,6 +281,22 @@ dpdk_process_flow_offload (dpdk_device_t * xd, dpdk_per_thread_data_t * ptd,
     }
 }
 
+static_always_inline void
+dpdk_process_rx_hash (dpdk_per_thread_data_t *ptd, uword n_rx_packets)
+{
+  vlib_buffer_t *b0;
+  uword n;
+
+  for (n = 0; n < n_rx_packets; n++)
+    {
+      if ((ptd->flags[n] & RTE_MBUF_F_RX_RSS_HASH) == 0)
+	continue;
+
+      b0 = vlib_buffer_from_rte_mbuf (ptd->mbufs[n]);
+      vnet_buffer_rx_hash_set (b0, ptd->mbufs[n]->hash.rss);
+    }
+}
+
 static_always_inline u16
 dpdk_lro_find_l4_hdr_sz (vlib_buffer_t *b)
 {
@@ -406,6 +423,11 @@ dpdk_device_input (vlib_main_t * vm, dpdk_main_t * dm, dpdk_device_t * xd,
   if (PREDICT_FALSE ((or_flags & RTE_MBUF_F_RX_LRO)))
     dpdk_process_lro_offload (xd, ptd, n_rx_packets);
 
+  /* store RSS hash so that ECMP can use it instead of hashing again */
+  if ((xd->flags & DPDK_DEVICE_FLAG_RX_HASH) &&
+      (or_flags & RTE_MBUF_F_RX_RSS_HASH))
+    dpdk_process_rx_hash (ptd, n_rx_packets);
+
   if (PREDICT_FALSE ((or_flags & RTE_MBUF_F_RX_L4_CKSUM_BAD) &&
 		     (xd->buffer_flags & VNET_BUFFER_F_L4_CHECKSUM_CORRECT)))
     {
@@ -465,24 +465,24 @@ flowprobe_create_state_tables (u32 active_timer)
   /* Decide how many worker threads we have */
   num_threads = 1 /* main thread */  + tm->n_threads;
 
-  /* Hash table per worker */
-  fm->ht_log2len = FLOWPROBE_LOG2_HASHSIZE;
-
   /* Init per worker flow state and timer wheels */
   if (active_timer)
     {
       vec_validate (fm->timers_per_worker, num_threads - 1);
       vec_validate (fm->expired_passive_per_worker, num_threads - 1);
-      vec_validate (fm->hash_per_worker, num_threads - 1);
+      vec_validate (fm->buckets_per_worker, num_threads - 1);
       vec_validate (fm->pool_per_worker, num_threads - 1);
 
       for (i = 0; i < num_threads; i++)
 	{
-	  int j;
+	  flowprobe_bucket_t *b;
 	  pool_alloc (fm->pool_per_worker[i], 1 << fm->ht_log2len);
-	  vec_resize (fm->hash_per_worker[i], 1 << fm->ht_log2len);
-	  for (j = 0; j < (1 << fm->ht_log2len); j++)
-	    fm->hash_per_worker[i][j] = ~0;
+	  vec_validate_aligned (
+	    fm->buckets_per_worker[i],
+	    (1 << (fm->ht_log2len - FLOWPROBE_LOG2_BUCKET_WAYS)) - 1,
+	    CLIB_CACHE_LINE_BYTES);
+	  vec_foreach (b, fm->buckets_per_worker[i])
+	    clib_memset_u32 (b->index, ~0, FLOWPROBE_BUCKET_WAYS);
 	  fm->timers_per_worker[i] =
 	    clib_mem_alloc (sizeof (TWT (tw_timer_wheel)));
 	  tw_timer_wheel_init_2t_1w_2048sl (fm->timers_per_worker[i],
@@ -518,6 +518,41 @@ validate_feature_on_interface (flowprobe_main_t * fm, u32 sw_if_index,
     return 1;
 }
 
+/**
+ * @brief sample 1 in interval packets recorded on an interface
+ * @param fm flowprobe_main_t * fm
+ * @param sw_if_index u32 the desired interface
+ * @param interval u32 sampling interval, 0 or 1 to record every packet
+ */
+static void
+flowprobe_interface_set_sampling (flowprobe_main_t *fm, u32 sw_if_index,
+				  u32 interval)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  u32 i, old;
+
+  interval = clib_max (interval, 1);
+  vec_validate_init_empty (fm->sampling_per_interface, sw_if_index, 1);
+  vec_validate_init_empty (fm->sampling_threshold_per_interface, sw_if_index,
+			   ~0);
+
+  /* workers do not get a seeded random buffer of their own */
+  if (interval > 1 && !fm->random_per_worker)
+    {
+      vec_validate_aligned (fm->random_per_worker, tm->n_threads,
+			    CLIB_CACHE_LINE_BYTES);
+      for (i = 0; i <= tm->n_threads; i++)
+	clib_random_buffer_init (&fm->random_per_worker[i],
+				 vlib_get_main ()->random_seed + i);
+    }
+
+  old = fm->sampling_per_interface[sw_if_index];
+  fm->n_sampling_interfaces += (interval > 1) - (old > 1);
+  fm->sampling_per_interface[sw_if_index] = interval;
+  fm->sampling_threshold_per_interface[sw_if_index] =
+    (1ULL << 32) / interval - 1;
+}
+
 /**
  * @brief configure / deconfigure the IPFIX flow-per-packet
  * @param fm flowprobe_main_t * fm
@@ -637,6 +672,9 @@ flowprobe_interface_add_del_feature (flowprobe_main_t *fm, u32 sw_if_index,
 				     sw_if_index, is_add, 0, 0);
     }
 
+  if (!is_add)
+    flowprobe_interface_set_sampling (fm, sw_if_index, 1);
+
   /* Stateful flow collection */
   if (is_add && !fm->initialized)
     {
@@ -770,6 +808,34 @@ out:
   REPLY_MACRO (VL_API_FLOWPROBE_INTERFACE_ADD_DEL_REPLY);
 }
 
+void
+vl_api_flowprobe_interface_set_sampling_t_handler (
+  vl_api_flowprobe_interface_set_sampling_t *mp)
+{
+  flowprobe_main_t *fm = &flowprobe_main;
+  vl_api_flowprobe_interface_set_sampling_reply_t *rmp;
+  u32 sw_if_index;
+  int rv = 0;
+
+  VALIDATE_SW_IF_INDEX (mp);
+
+  sw_if_index = ntohl (mp->sw_if_index);
+  if (sw_if_index >= vec_len (fm->flow_per_interface) ||
+      fm->flow_per_interface[sw_if_index] == (u8) ~0)
+    {
+      clib_warning ("Interface has no variant enabled");
+      rv = VNET_API_ERROR_NO_SUCH_ENTRY;
+      goto out;
+    }
+
+  flowprobe_interface_set_sampling (fm, sw_if_index, ntohl (mp->interval));
+
+out:
+  BAD_SW_IF_INDEX_LABEL;
+
+  REPLY_MACRO (VL_API_FLOWPROBE_INTERFACE_SET_SAMPLING_REPLY);
+}
+
 static void
 send_flowprobe_interface_details (u32 sw_if_index, u8 which, u8 direction,
 				  vl_api_registration_t *reg, u32 context)
@@ -1077,12 +1143,15 @@ flowprobe_show_stats_fn (vlib_main_t * vm,
   vlib_cli_output (vm, "IPFIX table statistics");
   vlib_cli_output (vm, "Flow entry size: %d\n", sizeof (flowprobe_entry_t));
   vlib_cli_output (vm, "Flow pool size per thread: %d\n",
-		   0x1 << FLOWPROBE_LOG2_HASHSIZE);
+		   0x1 << fm->ht_log2len);
+  vlib_cli_output (vm, "Flow cache buckets per thread: %d of %d ways\n",
+		   0x1 << (fm->ht_log2len - FLOWPROBE_LOG2_BUCKET_WAYS),
+		   FLOWPROBE_BUCKET_WAYS);
 
   for (i = 0; i < vec_len (fm->pool_per_worker); i++)
     vlib_cli_output (vm, "Pool utilisation thread %d is %d%%\n", i,
 		     (100 * pool_elts (fm->pool_per_worker[i])) /
-		     (0x1 << FLOWPROBE_LOG2_HASHSIZE));
+		     (0x1 << fm->ht_log2len));
   return 0;
 }
 
@@ -1096,12 +1165,15 @@ flowprobe_interface_add_del_feature_command_fn (vlib_main_t *vm,
   int is_add = 1;
   u8 which = FLOW_VARIANT_IP4;
   flowprobe_direction_t direction = FLOW_DIRECTION_TX;
+  u32 sampling = 1;
   int rv;
 
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
     {
       if (unformat (input, "disable"))
 	is_add = 0;
+      else if (unformat (input, "sampling %u", &sampling))
+	;
       else if (unformat (input, "%U", unformat_vnet_sw_interface,
 			 fm->vnet_main, &sw_if_index));
       else if (unformat (input, "ip4"))
@@ -1150,6 +1222,8 @@ flowprobe_interface_add_del_feature_command_fn (vlib_main_t *vm,
   switch (rv)
     {
     case 0:
+      if (is_add)
+	flowprobe_interface_set_sampling (fm, sw_if_index, sampling);
       break;
 
     case VNET_API_ERROR_INVALID_SW_IF_INDEX:
@@ -1175,7 +1249,7 @@ flowprobe_show_feature_command_fn (vlib_main_t * vm,
 {
   flowprobe_main_t *fm = &flowprobe_main;
   u8 *which;
-  u32 sw_if_index;
+  u32 sw_if_index, sampling;
 
   vec_foreach (which, fm->flow_per_interface)
   {
@@ -1183,10 +1257,14 @@ flowprobe_show_feature_command_fn (vlib_main_t * vm,
       continue;
 
     sw_if_index = which - fm->flow_per_interface;
-    vlib_cli_output (vm, " %U %U %U", format_vnet_sw_if_index_name,
-		     vnet_get_main (), sw_if_index, format_flowprobe_feature,
-		     which, format_flowprobe_direction,
-		     &fm->direction_per_interface[sw_if_index]);
+    sampling = sw_if_index < vec_len (fm->sampling_per_interface) ?
+		 fm->sampling_per_interface[sw_if_index] :
+		 1;
+    vlib_cli_output (vm, " %U %U %U sampling 1/%u",
+		     format_vnet_sw_if_index_name, vnet_get_main (),
+		     sw_if_index, format_flowprobe_feature, which,
+		     format_flowprobe_direction,
+		     &fm->direction_per_interface[sw_if_index], sampling);
   }
   return 0;
 }
@@ -1258,6 +1336,9 @@ flowprobe_show_params_command_fn (vlib_main_t * vm,
  * To enable per-packet IPFIX flow-record generation on an interface:
  * @cliexcmd{flowprobe feature add-del GigabitEthernet2/0/0}
  *
+ * To record one packet in 1000 on average:
+ * @cliexcmd{flowprobe feature add-del GigabitEthernet2/0/0 sampling 1000}
+ *
  * To disable per-packet IPFIX flow-record generation on an interface:
  * @cliexcmd{flowprobe feature add-del GigabitEthernet2/0/0 disable}
  * @cliexend
@@ -1267,7 +1348,7 @@ flowprobe_show_params_command_fn (vlib_main_t * vm,
 VLIB_CLI_COMMAND (flowprobe_enable_disable_command, static) = {
   .path = "flowprobe feature add-del",
   .short_help = "flowprobe feature add-del <interface-name> [(l2|ip4|ip6)] "
-		"[(rx|tx|both)] [disable]",
+		"[(rx|tx|both)] [sampling <n>] [disable]",
   .function = flowprobe_interface_add_del_feature_command_fn,
 };
 VLIB_CLI_COMMAND (flowprobe_params_command, static) = {
@@ -1404,12 +1485,38 @@ flowprobe_init (vlib_main_t * vm)
 
   fm->active_timer = FLOWPROBE_TIMER_ACTIVE;
   fm->passive_timer = FLOWPROBE_TIMER_PASSIVE;
+  fm->ht_log2len = FLOWPROBE_LOG2_HASHSIZE;
 
   return error;
 }
 
 VLIB_INIT_FUNCTION (flowprobe_init);
 
+static clib_error_t *
+flowprobe_config (vlib_main_t *vm, unformat_input_t *input)
+{
+  flowprobe_main_t *fm = &flowprobe_main;
+  u32 log2len;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "cache-size-log2 %u", &log2len))
+	{
+	  if (log2len < FLOWPROBE_LOG2_BUCKET_WAYS || log2len > 24)
+	    return clib_error_return (0, "cache-size-log2 must be in [%u, 24]",
+				      FLOWPROBE_LOG2_BUCKET_WAYS);
+	  fm->ht_log2len = log2len;
+	}
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  return 0;
+}
+
+VLIB_CONFIG_FUNCTION (flowprobe_config, "flowprobe");
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
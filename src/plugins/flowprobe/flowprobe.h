@@ -26,12 +26,17 @@
 #include <vnet/ipfix-export/flow_report.h>
 #include <vnet/ipfix-export/flow_report_classify.h>
 #include <vppinfra/tw_timer_2t_1w_2048sl.h>
+#include <vppinfra/random_buffer.h>
 
 /* Default timers in seconds */
 #define FLOWPROBE_TIMER_ACTIVE   (15)
 #define FLOWPROBE_TIMER_PASSIVE  120	// XXXX: FOR TESTING (30*60)
 #define FLOWPROBE_LOG2_HASHSIZE  (18)
 
+/* Flow cache buckets hold 2^3 flows, signatures and indices in a line */
+#define FLOWPROBE_LOG2_BUCKET_WAYS (3)
+#define FLOWPROBE_BUCKET_WAYS	   (1 << FLOWPROBE_LOG2_BUCKET_WAYS)
+
 typedef enum
 {
   FLOW_RECORD_L2 = 1 << 0,
@@ -121,6 +126,19 @@ typedef struct
   } prot;
 } flowprobe_entry_t;
 
+/**
+ * Set-associative flow cache bucket. A flow can live in any way of the
+ * bucket selected by its hash, the full hash is kept as signature so
+ * that keys are only compared on signature match. Free ways have an
+ * index of ~0.
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u32 sig[FLOWPROBE_BUCKET_WAYS];
+  u32 index[FLOWPROBE_BUCKET_WAYS];
+} flowprobe_bucket_t;
+
 /**
  * @file
  * @brief flow-per-packet plugin header file
@@ -139,8 +157,8 @@ typedef struct
   f64 vlib_time_0;
 
   /** Per CPU flow-state */
-  u8 ht_log2len;		/* Hash table size is 2^log2len */
-  u32 **hash_per_worker;
+  u8 ht_log2len;		/* Flow cache size is 2^log2len */
+  flowprobe_bucket_t **buckets_per_worker;
   flowprobe_entry_t **pool_per_worker;
   /* *INDENT-OFF* */
   TWT (tw_timer_wheel) ** timers_per_worker;
@@ -159,6 +177,15 @@ typedef struct
   u8 *flow_per_interface;
   u8 *direction_per_interface;
 
+  /** 1-in-N packet sampling per interface, 1 records every packet */
+  u32 *sampling_per_interface;
+  /** random value up to which a packet is sampled, per interface */
+  u32 *sampling_threshold_per_interface;
+  /** number of interfaces with sampling */
+  u32 n_sampling_interfaces;
+  /** random numbers for sampling, per worker thread */
+  clib_random_buffer_t *random_per_worker;
+
   /** convenience vlib_main_t pointer */
   vlib_main_t *vlib_main;
   /** convenience vnet_main_t pointer */
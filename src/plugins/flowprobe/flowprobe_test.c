@@ -149,6 +149,52 @@ api_flowprobe_interface_add_del (vat_main_t *vam)
   return ret;
 }
 
+static int
+api_flowprobe_interface_set_sampling (vat_main_t *vam)
+{
+  unformat_input_t *i = vam->input;
+  vl_api_flowprobe_interface_set_sampling_t *mp;
+  u32 sw_if_index = ~0;
+  u32 interval = ~0;
+  int ret;
+
+  while (unformat_check_input (i) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (i, "%U", unformat_sw_if_index, vam, &sw_if_index))
+	;
+      else if (unformat (i, "sw_if_index %d", &sw_if_index))
+	;
+      else if (unformat (i, "interval %u", &interval))
+	;
+      else
+	break;
+    }
+
+  if (sw_if_index == ~0)
+    {
+      errmsg ("Missing interface name / explicit sw_if_index number\n");
+      return -99;
+    }
+
+  if (interval == ~0)
+    {
+      errmsg ("Missing sampling interval\n");
+      return -99;
+    }
+
+  /* Construct the API message */
+  M (FLOWPROBE_INTERFACE_SET_SAMPLING, mp);
+  mp->sw_if_index = ntohl (sw_if_index);
+  mp->interval = ntohl (interval);
+
+  /* Send it... */
+  S (mp);
+
+  /* Wait for a reply... */
+  W (ret);
+  return ret;
+}
+
 static int
 api_flowprobe_interface_dump (vat_main_t *vam)
 {
@@ -111,7 +111,8 @@ vlib_node_registration_t flowprobe_output_l2_node;
 _(COLLISION, "Hash table collisions")		\
 _(BUFFER, "Buffer allocation error")		\
 _(EXPORTED_PACKETS, "Exported packets")		\
-_(INPATH, "Exported packets in path")
+_(INPATH, "Exported packets in path")		\
+_(SAMPLED_OUT, "Packets not sampled")
 
 typedef enum
 {
@@ -295,7 +296,6 @@ flowprobe_l4_add (vlib_buffer_t * to_b, flowprobe_entry_t * e, u16 offset)
 static inline u32
 flowprobe_hash (flowprobe_key_t * k)
 {
-  flowprobe_main_t *fm = &flowprobe_main;
   u32 h = 0;
 
 #ifdef clib_crc32c_uses_intrinsics
@@ -309,29 +309,61 @@ flowprobe_hash (flowprobe_key_t * k)
   h = clib_xxhash (tmp);
 #endif
 
-  return h >> (32 - fm->ht_log2len);
+  return h;
+}
+
+static_always_inline flowprobe_bucket_t *
+flowprobe_get_bucket (flowprobe_main_t *fm, u32 my_cpu_number, u32 h)
+{
+  u32 log2_n_buckets = fm->ht_log2len - FLOWPROBE_LOG2_BUCKET_WAYS;
+  return fm->buckets_per_worker[my_cpu_number] + (h >> (32 - log2_n_buckets));
+}
+
+/* ways of the bucket with a matching signature, 4 bits per way */
+static_always_inline u32
+flowprobe_bucket_match (flowprobe_bucket_t *b, u32 h)
+{
+#if defined(CLIB_HAVE_VEC256)
+  u32x8 sig = u32x8_load_unaligned (b->sig);
+  return u8x32_msb_mask ((u8x32) (sig == u32x8_splat (h)));
+#elif defined(CLIB_HAVE_VEC128) && defined(CLIB_HAVE_VEC128_MSB_MASK)
+  u32x4 lo = u32x4_load_unaligned (b->sig);
+  u32x4 hi = u32x4_load_unaligned (b->sig + 4);
+  u32x4 splat = u32x4_splat (h);
+  return u8x16_msb_mask ((u8x16) (lo == splat)) |
+	 (u32) u8x16_msb_mask ((u8x16) (hi == splat)) << 16;
+#else
+  u32 i, bmp = 0;
+  for (i = 0; i < FLOWPROBE_BUCKET_WAYS; i++)
+    if (b->sig[i] == h)
+      bmp |= 0xf << (4 * i);
+  return bmp;
+#endif
 }
 
 flowprobe_entry_t *
-flowprobe_lookup (u32 my_cpu_number, flowprobe_key_t * k, u32 * poolindex,
-		  bool * collision)
+flowprobe_lookup (u32 my_cpu_number, flowprobe_key_t *k, u32 h,
+		  u32 *poolindex)
 {
   flowprobe_main_t *fm = &flowprobe_main;
+  flowprobe_bucket_t *b = flowprobe_get_bucket (fm, my_cpu_number, h);
   flowprobe_entry_t *e;
-  u32 h;
-
-  h = (fm->active_timer) ? flowprobe_hash (k) : 0;
+  u32 bmp, way;
 
-  /* Lookup in the flow state pool */
-  *poolindex = fm->hash_per_worker[my_cpu_number][h];
-  if (*poolindex != ~0)
+  bmp = flowprobe_bucket_match (b, h);
+  while (bmp)
     {
-      e = pool_elt_at_index (fm->pool_per_worker[my_cpu_number], *poolindex);
-      if (e)
+      way = count_trailing_zeros (bmp) / 4;
+      bmp &= ~(0xf << (4 * way));
+      if (b->index[way] == ~0)
+	continue;
+
+      /* Signatures match, verify key */
+      e = pool_elt_at_index (fm->pool_per_worker[my_cpu_number],
+			     b->index[way]);
+      if (!memcmp (k, &e->key, sizeof (flowprobe_key_t)))
 	{
-	  /* Verify key or report collision */
-	  if (memcmp (k, &e->key, sizeof (flowprobe_key_t)))
-	    *collision = true;
+	  *poolindex = b->index[way];
 	  return e;
 	}
     }
@@ -339,20 +371,46 @@ flowprobe_lookup (u32 my_cpu_number, flowprobe_key_t * k, u32 * poolindex,
   return 0;
 }
 
+/*
+ * Create an entry in a free way of the flow bucket. When the bucket is
+ * full the least recently updated flow of the bucket is returned for
+ * reuse, the caller is expected to flush it.
+ */
 flowprobe_entry_t *
-flowprobe_create (u32 my_cpu_number, flowprobe_key_t * k, u32 * poolindex)
+flowprobe_create (u32 my_cpu_number, flowprobe_key_t *k, u32 h,
+		  u32 *poolindex, bool *evicted)
 {
   flowprobe_main_t *fm = &flowprobe_main;
-  u32 h;
+  flowprobe_bucket_t *b = flowprobe_get_bucket (fm, my_cpu_number, h);
+  flowprobe_entry_t *e, *victim = 0;
+  u32 way, victim_way = 0;
 
-  flowprobe_entry_t *e;
+  for (way = 0; way < FLOWPROBE_BUCKET_WAYS; way++)
+    if (b->index[way] == ~0)
+      break;
 
-  /* Get my index */
-  h = (fm->active_timer) ? flowprobe_hash (k) : 0;
+  if (PREDICT_FALSE (way == FLOWPROBE_BUCKET_WAYS))
+    {
+      for (way = 0; way < FLOWPROBE_BUCKET_WAYS; way++)
+	{
+	  e = pool_elt_at_index (fm->pool_per_worker[my_cpu_number],
+				 b->index[way]);
+	  if (!victim || e->last_updated < victim->last_updated)
+	    {
+	      victim = e;
+	      victim_way = way;
+	    }
+	}
+      *poolindex = b->index[victim_way];
+      b->sig[victim_way] = h;
+      *evicted = true;
+      return victim;
+    }
 
-  pool_get (fm->pool_per_worker[my_cpu_number], e);
+  pool_get_zero (fm->pool_per_worker[my_cpu_number], e);
   *poolindex = e - fm->pool_per_worker[my_cpu_number];
-  fm->hash_per_worker[my_cpu_number][h] = *poolindex;
+  b->sig[way] = h;
+  b->index[way] = *poolindex;
 
   e->key = *k;
 
@@ -366,19 +424,13 @@ flowprobe_create (u32 my_cpu_number, flowprobe_key_t * k, u32 * poolindex)
 }
 
 static inline void
-add_to_flow_record_state (vlib_main_t *vm, vlib_node_runtime_t *node,
-			  flowprobe_main_t *fm, vlib_buffer_t *b,
-			  timestamp_nsec_t timestamp, u16 length,
-			  flowprobe_variant_t which,
-			  flowprobe_direction_t direction,
-			  flowprobe_trace_t *t)
+flowprobe_key_from_buffer (flowprobe_main_t *fm, vlib_buffer_t *b,
+			   flowprobe_variant_t which,
+			   flowprobe_direction_t direction, flowprobe_key_t *kp,
+			   u16 *octetsp, u8 *tcp_flagsp)
 {
-  if (fm->disabled)
-    return;
-
   ASSERT (direction == FLOW_DIRECTION_RX || direction == FLOW_DIRECTION_TX);
 
-  u32 my_cpu_number = vm->thread_index;
   u16 octets = 0;
 
   flowprobe_record_t flags = fm->context[which].flags;
@@ -475,6 +527,20 @@ add_to_flow_record_state (vlib_main_t *vm, vlib_node_runtime_t *node,
       tcp_flags = tcp->flags;
     }
 
+  *kp = k;
+  *octetsp = octets;
+  *tcp_flagsp = tcp_flags;
+}
+
+static inline void
+flowprobe_update_flow (vlib_main_t *vm, vlib_node_runtime_t *node,
+		       flowprobe_main_t *fm, flowprobe_key_t *kp, u32 h,
+		       u16 octets, u8 tcp_flags, timestamp_nsec_t timestamp,
+		       flowprobe_trace_t *t)
+{
+  u32 my_cpu_number = vm->thread_index;
+  flowprobe_key_t k = *kp;
+
   if (t)
     {
       t->rx_sw_if_index = k.rx_sw_if_index;
@@ -495,22 +561,22 @@ add_to_flow_record_state (vlib_main_t *vm, vlib_node_runtime_t *node,
   if (fm->active_timer > 0)
     {
       u32 poolindex = ~0;
-      bool collision = false;
+      bool evicted = false;
 
-      e = flowprobe_lookup (my_cpu_number, &k, &poolindex, &collision);
-      if (collision)
-	{
-	  /* Flush data and clean up entry for reuse. */
-	  if (e->packetcount)
-	    flowprobe_export_entry (vm, e);
-	  e->key = k;
-	  e->flow_start = timestamp;
-	  vlib_node_increment_counter (vm, node->node_index,
-				       FLOWPROBE_ERROR_COLLISION, 1);
-	}
+      e = flowprobe_lookup (my_cpu_number, &k, h, &poolindex);
       if (!e)			/* Create new entry */
 	{
-	  e = flowprobe_create (my_cpu_number, &k, &poolindex);
+	  e = flowprobe_create (my_cpu_number, &k, h, &poolindex, &evicted);
+	  if (evicted)
+	    {
+	      /* Flush data and clean up entry for reuse. */
+	      if (e->packetcount)
+		flowprobe_export_entry (vm, e);
+	      e->key = k;
+	      e->prot.tcp.flags = 0;
+	      vlib_node_increment_counter (vm, node->node_index,
+					   FLOWPROBE_ERROR_COLLISION, 1);
+	    }
 	  e->last_exported = now;
 	  e->flow_start = timestamp;
 	}
@@ -535,6 +601,45 @@ add_to_flow_record_state (vlib_main_t *vm, vlib_node_runtime_t *node,
     }
 }
 
+static inline void
+add_to_flow_record_state (vlib_main_t *vm, vlib_node_runtime_t *node,
+			  flowprobe_main_t *fm, vlib_buffer_t *b,
+			  timestamp_nsec_t timestamp, u16 length,
+			  flowprobe_variant_t which,
+			  flowprobe_direction_t direction,
+			  flowprobe_trace_t *t)
+{
+  flowprobe_key_t k;
+  u16 octets;
+  u8 tcp_flags;
+  u32 h = 0;
+
+  if (fm->disabled)
+    return;
+
+  flowprobe_key_from_buffer (fm, b, which, direction, &k, &octets,
+			     &tcp_flags);
+  if (fm->active_timer > 0)
+    h = flowprobe_hash (&k);
+  flowprobe_update_flow (vm, node, fm, &k, h, octets, tcp_flags, timestamp,
+			 t);
+}
+
+/* 1-in-N sampling on the interface the packet is recorded on */
+static_always_inline bool
+flowprobe_is_sampled (flowprobe_main_t *fm, vlib_buffer_t *b,
+		      flowprobe_direction_t direction, u32 random)
+{
+  u32 sw_if_index;
+
+  sw_if_index = direction == FLOW_DIRECTION_RX ?
+		  vnet_buffer (b)->sw_if_index[VLIB_RX] :
+		  vnet_buffer (b)->sw_if_index[VLIB_TX];
+  if (sw_if_index >= vec_len (fm->sampling_threshold_per_interface))
+    return true;
+  return random <= fm->sampling_threshold_per_interface[sw_if_index];
+}
+
 static u16
 flowprobe_get_headersize (void)
 {
@@ -753,6 +858,7 @@ flowprobe_node_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
   flowprobe_next_t next_index;
   flowprobe_main_t *fm = &flowprobe_main;
   timestamp_nsec_t timestamp;
+  u32 *random = 0, n_sampled_out = 0;
 
   unix_time_now_nsec_fraction (&timestamp.sec, &timestamp.nsec);
 
@@ -760,6 +866,11 @@ flowprobe_node_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
   n_left_from = frame->n_vectors;
   next_index = node->cached_next_index;
 
+  /* one random number per packet of the frame when sampling */
+  if (PREDICT_FALSE (fm->n_sampling_interfaces))
+    random = clib_random_buffer_get_data (
+      &fm->random_per_worker[vm->thread_index], n_left_from * sizeof (u32));
+
   while (n_left_from > 0)
     {
       u32 n_left_to_next;
@@ -770,9 +881,13 @@ flowprobe_node_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
 	{
 	  u32 next0 = FLOWPROBE_NEXT_DROP;
 	  u32 next1 = FLOWPROBE_NEXT_DROP;
-	  u16 len0, len1;
 	  u32 bi0, bi1;
 	  vlib_buffer_t *b0, *b1;
+	  flowprobe_key_t k0, k1;
+	  u16 octets0, octets1;
+	  u8 tcp_flags0, tcp_flags1;
+	  u32 h0 = 0, h1 = 0;
+	  bool flow0, flow1;
 
 	  /* Prefetch next iteration. */
 	  {
@@ -802,27 +917,71 @@ flowprobe_node_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  vnet_feature_next (&next0, b0);
 	  vnet_feature_next (&next1, b1);
 
-	  len0 = vlib_buffer_length_in_chain (vm, b0);
 	  ethernet_header_t *eh0 = vlib_buffer_get_current (b0);
 	  u16 ethertype0 = clib_net_to_host_u16 (eh0->type);
 
-	  if (PREDICT_TRUE ((b0->flags & VNET_BUFFER_F_FLOW_REPORT) == 0))
-	    add_to_flow_record_state (
-	      vm, node, fm, b0, timestamp, len0,
-	      flowprobe_get_variant (which, fm->context[which].flags,
-				     ethertype0),
-	      direction, 0);
-
-	  len1 = vlib_buffer_length_in_chain (vm, b1);
 	  ethernet_header_t *eh1 = vlib_buffer_get_current (b1);
 	  u16 ethertype1 = clib_net_to_host_u16 (eh1->type);
 
-	  if (PREDICT_TRUE ((b1->flags & VNET_BUFFER_F_FLOW_REPORT) == 0))
-	    add_to_flow_record_state (
-	      vm, node, fm, b1, timestamp, len1,
-	      flowprobe_get_variant (which, fm->context[which].flags,
-				     ethertype1),
-	      direction, 0);
+	  /*
+	   * Extract and hash both keys first, so that the flow buckets are
+	   * fetched while the other packet is parsed.
+	   */
+	  flow0 = !fm->disabled &&
+		  (b0->flags & VNET_BUFFER_F_FLOW_REPORT) == 0;
+	  flow1 = !fm->disabled &&
+		  (b1->flags & VNET_BUFFER_F_FLOW_REPORT) == 0;
+	  if (PREDICT_FALSE (random != 0))
+	    {
+	      if (flow0 &&
+		  !flowprobe_is_sampled (fm, b0, direction, random[0]))
+		{
+		  flow0 = false;
+		  n_sampled_out++;
+		}
+	      if (flow1 &&
+		  !flowprobe_is_sampled (fm, b1, direction, random[1]))
+		{
+		  flow1 = false;
+		  n_sampled_out++;
+		}
+	      random += 2;
+	    }
+	  if (PREDICT_TRUE (flow0))
+	    {
+	      flowprobe_key_from_buffer (
+		fm, b0,
+		flowprobe_get_variant (which, fm->context[which].flags,
+				       ethertype0),
+		direction, &k0, &octets0, &tcp_flags0);
+	      if (fm->active_timer > 0)
+		{
+		  h0 = flowprobe_hash (&k0);
+		  clib_prefetch_load (
+		    flowprobe_get_bucket (fm, vm->thread_index, h0));
+		}
+	    }
+	  if (PREDICT_TRUE (flow1))
+	    {
+	      flowprobe_key_from_buffer (
+		fm, b1,
+		flowprobe_get_variant (which, fm->context[which].flags,
+				       ethertype1),
+		direction, &k1, &octets1, &tcp_flags1);
+	      if (fm->active_timer > 0)
+		{
+		  h1 = flowprobe_hash (&k1);
+		  clib_prefetch_load (
+		    flowprobe_get_bucket (fm, vm->thread_index, h1));
+		}
+	    }
+
+	  if (PREDICT_TRUE (flow0))
+	    flowprobe_update_flow (vm, node, fm, &k0, h0, octets0, tcp_flags0,
+				   timestamp, 0);
+	  if (PREDICT_TRUE (flow1))
+	    flowprobe_update_flow (vm, node, fm, &k1, h1, octets1, tcp_flags1,
+				   timestamp, 0);
 
 	  /* verify speculative enqueues, maybe switch current next frame */
 	  vlib_validate_buffer_enqueue_x2 (vm, node, next_index,
@@ -853,7 +1012,10 @@ flowprobe_node_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  ethernet_header_t *eh0 = vlib_buffer_get_current (b0);
 	  u16 ethertype0 = clib_net_to_host_u16 (eh0->type);
 
-	  if (PREDICT_TRUE ((b0->flags & VNET_BUFFER_F_FLOW_REPORT) == 0))
+	  if (PREDICT_FALSE (random != 0) &&
+	      !flowprobe_is_sampled (fm, b0, direction, *random++))
+	    n_sampled_out++;
+	  else if (PREDICT_TRUE ((b0->flags & VNET_BUFFER_F_FLOW_REPORT) == 0))
 	    {
 	      flowprobe_trace_t *t = 0;
 	      if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
@@ -875,6 +1037,10 @@ flowprobe_node_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
 
       vlib_put_next_frame (vm, node, next_index, n_left_to_next);
     }
+
+  if (n_sampled_out)
+    vlib_node_increment_counter (vm, node->node_index,
+				 FLOWPROBE_ERROR_SAMPLED_OUT, n_sampled_out);
   return frame->n_vectors;
 }
 
@@ -960,16 +1126,21 @@ static void
 flowprobe_delete_by_index (u32 my_cpu_number, u32 poolindex)
 {
   flowprobe_main_t *fm = &flowprobe_main;
+  flowprobe_bucket_t *b;
   flowprobe_entry_t *e;
-  u32 h;
+  u32 way;
 
   e = pool_elt_at_index (fm->pool_per_worker[my_cpu_number], poolindex);
 
-  /* Get my index */
-  h = flowprobe_hash (&e->key);
-
-  /* Reset hash */
-  fm->hash_per_worker[my_cpu_number][h] = ~0;
+  /* Free the way holding the entry */
+  b = flowprobe_get_bucket (fm, my_cpu_number, flowprobe_hash (&e->key));
+  for (way = 0; way < FLOWPROBE_BUCKET_WAYS; way++)
+    if (b->index[way] == poolindex)
+      {
+	b->sig[way] = 0;
+	b->index[way] = ~0;
+	break;
+      }
 
   pool_put_index (fm->pool_per_worker[my_cpu_number], poolindex);
 }
@@ -327,6 +327,7 @@ geneve_input (vlib_main_t * vm,
 
 	  /* Set packet input sw_if_index to unicast GENEVE tunnel for learning */
 	  vnet_buffer (b0)->sw_if_index[VLIB_RX] = sw_if_index0;
+	  vnet_buffer_reset_rx_hash (b0);
 	  sw_if_index0 = (mt0) ? mt0->sw_if_index : sw_if_index0;
 
 	  pkts_decapsulated++;
@@ -496,6 +497,7 @@ geneve_input (vlib_main_t * vm,
 
 	  /* Set packet input sw_if_index to unicast GENEVE tunnel for learning */
 	  vnet_buffer (b1)->sw_if_index[VLIB_RX] = sw_if_index1;
+	  vnet_buffer_reset_rx_hash (b1);
 	  sw_if_index1 = (mt1) ? mt1->sw_if_index : sw_if_index1;
 
 	  pkts_decapsulated++;
@@ -732,6 +734,7 @@ geneve_input (vlib_main_t * vm,
 
 	  /* Set packet input sw_if_index to unicast GENEVE tunnel for learning */
 	  vnet_buffer (b0)->sw_if_index[VLIB_RX] = sw_if_index0;
+	  vnet_buffer_reset_rx_hash (b0);
 	  sw_if_index0 = (mt0) ? mt0->sw_if_index : sw_if_index0;
 
 	  pkts_decapsulated++;
@@ -291,6 +291,7 @@ gtpu_input (vlib_main_t * vm,
 
           /* Set packet input sw_if_index to unicast GTPU tunnel for learning */
           vnet_buffer(b0)->sw_if_index[VLIB_RX] = sw_if_index0;
+          vnet_buffer_reset_rx_hash(b0);
 	  sw_if_index0 = (mt0) ? mt0->sw_if_index : sw_if_index0;
 
           pkts_decapsulated ++;
@@ -451,6 +452,7 @@ gtpu_input (vlib_main_t * vm,
 
           /* Set packet input sw_if_index to unicast GTPU tunnel for learning */
           vnet_buffer(b1)->sw_if_index[VLIB_RX] = sw_if_index1;
+          vnet_buffer_reset_rx_hash(b1);
 	  sw_if_index1 = (mt1) ? mt1->sw_if_index : sw_if_index1;
 
           pkts_decapsulated ++;
@@ -664,6 +666,7 @@ gtpu_input (vlib_main_t * vm,
 
           /* Set packet input sw_if_index to unicast GTPU tunnel for learning */
           vnet_buffer(b0)->sw_if_index[VLIB_RX] = sw_if_index0;
+          vnet_buffer_reset_rx_hash(b0);
 	  sw_if_index0 = (mt0) ? mt0->sw_if_index : sw_if_index0;
 
           pkts_decapsulated ++;
@@ -1458,6 +1461,7 @@ gtpu_flow_input (vlib_main_t * vm,
 
           /* Set packet input sw_if_index to unicast GTPU tunnel for learning */
           vnet_buffer(b0)->sw_if_index[VLIB_RX] = sw_if_index0;
+          vnet_buffer_reset_rx_hash(b0);
 
           pkts_decapsulated ++;
           stats_n_packets += 1;
@@ -1545,6 +1549,7 @@ trace0:
 
           /* Set packet input sw_if_index to unicast GTPU tunnel for learning */
           vnet_buffer(b1)->sw_if_index[VLIB_RX] = sw_if_index1;
+          vnet_buffer_reset_rx_hash(b1);
 
           pkts_decapsulated ++;
           stats_n_packets += 1;
@@ -1668,6 +1673,7 @@ trace1:
 
           /* Set packet input sw_if_index to unicast GTPU tunnel for learning */
           vnet_buffer(b0)->sw_if_index[VLIB_RX] = sw_if_index0;
+          vnet_buffer_reset_rx_hash(b0);
 
           pkts_decapsulated ++;
           stats_n_packets += 1;
@@ -413,6 +413,87 @@ static void vl_api_lb_add_del_intf_nat6_t_handler
   REPLY_MACRO (VL_API_LB_ADD_DEL_INTF_NAT6_REPLY);
 }
 
+static void send_lb_sticky_details
+  (vl_api_registration_t * reg, u32 context, u32 thread_index,
+   lb_hash_bucket_t * b, u32 i, u32 now)
+{
+  vl_api_lb_sticky_details_t *rmp;
+  lb_main_t *lbm = &lb_main;
+
+  rmp = vl_msg_api_alloc (sizeof (*rmp));
+  clib_memset (rmp, 0, sizeof (*rmp));
+  rmp->_vl_msg_id = htons (VL_API_LB_STICKY_DETAILS + lbm->msg_id_base);
+  rmp->context = context;
+  rmp->thread_index = htonl (thread_index);
+  rmp->flow_hash = htonl (b->hash[i]);
+  rmp->vip_index = htonl (b->vip[i]);
+  ip_address_encode (&lbm->ass[b->value[i]].address, IP46_TYPE_ANY,
+                     &rmp->app_srv);
+  rmp->timeout = htonl (b->timeout[i] - now);
+
+  vl_api_send_msg (reg, (u8 *) rmp);
+}
+
+/*
+ * Streams the bindings of the sticky tables, a bucket at a time, and
+ * returns where to continue once the client queue fills or the time
+ * allowed in the handler is over.
+ */
+static void
+vl_api_lb_sticky_get_t_handler (vl_api_lb_sticky_get_t * mp)
+{
+  lb_main_t *lbm = &lb_main;
+  vlib_main_t *vm = vlib_get_main ();
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vl_api_lb_sticky_get_reply_t *rmp;
+  vl_api_registration_t *reg;
+  u32 thread_index = ntohl (mp->thread_index);
+  u32 cursor = ntohl (mp->cursor);
+  u32 vip_index = ntohl (mp->vip_index);
+  u32 now = lb_hash_time_now (vm);
+  f64 start = vlib_time_now (vm);
+  lb_hash_bucket_t *b;
+  lb_hash_t *h;
+  int rv = 0;
+  u32 i;
+
+  reg = vl_api_client_index_to_registration (mp->client_index);
+  if (!reg)
+    return;
+
+  lb_sticky_grow_finish ();
+
+  for (; thread_index < tm->n_vlib_mains; thread_index++, cursor = 0)
+    {
+      h = lbm->per_cpu[thread_index].sticky_ht;
+      if (!h)
+        continue;
+
+      while (cursor < lb_hash_nbuckets (h))
+        {
+          b = &h->buckets[cursor++];
+          for (i = 0; i < LBHASH_ENTRY_PER_BUCKET; i++)
+            if (!clib_u32_loop_gt (now, b->timeout[i])
+                && (vip_index == ~0 || b->vip[i] == vip_index))
+              send_lb_sticky_details (reg, mp->context, thread_index, b, i,
+                                      now);
+
+          if (vl_api_process_may_suspend (vm, reg, start))
+            {
+              rv = VNET_API_ERROR_EAGAIN;
+              goto done;
+            }
+        }
+    }
+
+done:
+  REPLY_MACRO2 (VL_API_LB_STICKY_GET_REPLY,
+  ({
+    rmp->thread_index = htonl (thread_index);
+    rmp->cursor = htonl (cursor);
+  }));
+}
+
 #include <lb/lb.api.c>
 static clib_error_t * lb_api_init (vlib_main_t * vm)
 {
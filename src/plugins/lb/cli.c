@@ -312,6 +312,7 @@ lb_conf_command_fn (vlib_main_t * vm,
   ip6_address_t ip6 = lbm->ip6_src_address;
   u32 per_cpu_sticky_buckets = lbm->per_cpu_sticky_buckets;
   u32 per_cpu_sticky_buckets_log2 = 0;
+  u32 per_cpu_sticky_buckets_max = lbm->per_cpu_sticky_buckets_max;
   u32 flow_timeout = lbm->flow_timeout;
   int ret;
   clib_error_t *error = 0;
@@ -331,7 +332,10 @@ lb_conf_command_fn (vlib_main_t * vm,
       if (per_cpu_sticky_buckets_log2 >= 32)
         return clib_error_return (0, "buckets-log2 value is too high");
       per_cpu_sticky_buckets = 1 << per_cpu_sticky_buckets_log2;
-    } else if (unformat(line_input, "timeout %d", &flow_timeout))
+    } else if (unformat(line_input, "max-buckets %d",
+                        &per_cpu_sticky_buckets_max))
+      ;
+    else if (unformat(line_input, "timeout %d", &flow_timeout))
       ;
     else {
       error = clib_error_return (0, "parse error: '%U'",
@@ -347,6 +351,11 @@ lb_conf_command_fn (vlib_main_t * vm,
     goto done;
   }
 
+  if ((ret = lb_conf_sticky_max(per_cpu_sticky_buckets_max))) {
+    error = clib_error_return (0, "lb_conf error %d", ret);
+    goto done;
+  }
+
 done:
   unformat_free (line_input);
 
@@ -356,7 +365,7 @@ done:
 VLIB_CLI_COMMAND (lb_conf_command, static) =
 {
   .path = "lb conf",
-  .short_help = "lb conf [ip4-src-address <addr>] [ip6-src-address <addr>] [buckets <n>] [timeout <s>]",
+  .short_help = "lb conf [ip4-src-address <addr>] [ip6-src-address <addr>] [buckets <n>] [max-buckets <n>] [timeout <s>]",
   .function = lb_conf_command_fn,
 };
 
@@ -364,6 +373,7 @@ static clib_error_t *
 lb_show_command_fn (vlib_main_t * vm,
               unformat_input_t * input, vlib_cli_command_t * cmd)
 {
+  lb_sticky_grow_finish ();
   vlib_cli_output(vm, "%U", format_lb_main);
   return NULL;
 }
@@ -409,6 +419,62 @@ VLIB_CLI_COMMAND (lb_show_vips_command, static) =
   .function = lb_show_vips_command_fn,
 };
 
+static clib_error_t *
+lb_show_sticky_command_fn (vlib_main_t * vm,
+              unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main();
+  lb_main_t *lbm = &lb_main;
+  u32 now = lb_hash_time_now(vm);
+  u32 vip_index = ~0, thread = ~0, max = 1000, n = 0;
+  u32 thread_index, i;
+  lb_hash_bucket_t *b;
+  lb_hash_t *h;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+  {
+    if (unformat(input, "vip %d", &vip_index))
+      ;
+    else if (unformat(input, "thread %d", &thread))
+      ;
+    else if (unformat(input, "max %d", &max))
+      ;
+    else
+      return clib_error_return (0, "parse error: '%U'",
+                                format_unformat_error, input);
+  }
+
+  lb_sticky_grow_finish ();
+
+  /* Flows are identified by their hash, the only key the table stores */
+  for(thread_index = 0; thread_index < tm->n_vlib_mains; thread_index++ ) {
+    if (thread != ~0 && thread != thread_index)
+      continue;
+    h = lbm->per_cpu[thread_index].sticky_ht;
+    if (!h)
+      continue;
+    lb_hash_foreach_valid_entry(h, b, i, now) {
+      if (vip_index != ~0 && b->vip[i] != vip_index)
+        continue;
+      if (n++ >= max)
+        return NULL;
+      vlib_cli_output(vm, "[%d] hash 0x%08x vip %d as %U timeout %ds",
+                      thread_index, b->hash[i], b->vip[i],
+                      format_lb_as, &lbm->ass[b->value[i]],
+                      b->timeout[i] - now);
+    }
+  }
+
+  return NULL;
+}
+
+VLIB_CLI_COMMAND (lb_show_sticky_command, static) =
+{
+  .path = "show lb sticky",
+  .short_help = "show lb sticky [vip <index>] [thread <n>] [max <n>]",
+  .function = lb_show_sticky_command_fn,
+};
+
 static clib_error_t *
 lb_set_interface_nat_command_fn (vlib_main_t * vm,
                                  unformat_input_t * input,
@@ -187,6 +187,9 @@ u8 *format_lb_main (u8 * s, va_list * args)
       s = format(s, "core %d\n", thread_index);
       s = format(s, "  timeout: %ds\n", h->timeout);
       s = format(s, "  usage: %d / %d\n", lb_hash_elts(h, lb_hash_time_now(vlib_get_main())),  lb_hash_size(h));
+      s = format(s, "  buckets: %d grown: %lu full: %lu\n", lb_hash_nbuckets(h),
+                 lbm->sticky_counters[LB_STICKY_COUNTER_GROWN].counters[thread_index][0],
+                 lbm->sticky_counters[LB_STICKY_COUNTER_FULL].counters[thread_index][0]);
     }
   }
 
@@ -370,6 +373,10 @@ static void lb_vip_garbage_collection(lb_vip_t *vip)
   lb_snat_mapping_t *m = 0;
   CLIB_SPINLOCK_ASSERT_LOCKED (&lbm->writer_lock);
 
+  //The current flow table may still point to removed ASs
+  if (vip->flags & LB_VIP_FLAGS_FLOW_TABLE_PENDING)
+    return;
+
   u32 now = (u32) vlib_time_now(vlib_get_main());
   if (!clib_u32_loop_gt(now, vip->last_garbage_collection + LB_GARBAGE_RUN))
     return;
@@ -454,10 +461,12 @@ void lb_garbage_collection()
   lb_put_writer_lock();
 }
 
-static void lb_vip_update_new_flow_table(lb_vip_t *vip)
+/**
+ * Computes the MagLev new flow table of the VIP, without installing it.
+ */
+static lb_new_flow_entry_t *lb_vip_build_new_flow_table(lb_vip_t *vip)
 {
   lb_main_t *lbm = &lb_main;
-  lb_new_flow_entry_t *old_table;
   u32 i, *as_index;
   lb_new_flow_entry_t *new_flow_table = 0;
   lb_as_t *as;
@@ -542,16 +551,185 @@ out:
 
 finished:
   vec_free(sort_arr);
+  return new_flow_table;
+}
+
+static void lb_vip_update_new_flow_table(lb_vip_t *vip)
+{
+  lb_main_t *lbm = &lb_main;
+  lb_new_flow_entry_t *old_table;
+
+  CLIB_SPINLOCK_ASSERT_LOCKED (&lbm->writer_lock); // We must have the lock
 
   old_table = vip->new_flow_table;
-  vip->new_flow_table = new_flow_table;
+  vip->new_flow_table = lb_vip_build_new_flow_table(vip);
   vec_free(old_table);
 }
 
+extern vlib_node_registration_t lb_flow_table_process_node;
+
+/**
+ * Allocates the grown sticky tables the workers asked for. A failed
+ * allocation drops the request, the worker asks again if its table
+ * keeps overflowing.
+ */
+static void lb_sticky_grow_alloc (void)
+{
+  lb_main_t *lbm = &lb_main;
+  lb_per_cpu_t *per_cpu;
+  u32 n_buckets;
+
+  vec_foreach(per_cpu, lbm->per_cpu) {
+      n_buckets = clib_atomic_load_acq_n(&per_cpu->sticky_grow_buckets);
+      if (!n_buckets)
+        continue;
+
+      clib_atomic_store_rel_n(&per_cpu->sticky_ht_grown,
+                              lb_hash_alloc_grown(n_buckets,
+                                                  lbm->flow_timeout));
+      clib_atomic_store_rel_n(&per_cpu->sticky_grow_buckets, 0);
+  }
+}
+
+void lb_sticky_grow_request (u32 thread_index, u32 n_buckets)
+{
+  lb_per_cpu_t *per_cpu = &lb_main.per_cpu[thread_index];
+
+  clib_atomic_store_rel_n(&per_cpu->sticky_grow_buckets, n_buckets);
+  vlib_process_signal_event_mt(vlib_get_main(),
+                               lb_flow_table_process_node.index, 0, 0);
+}
+
+/**
+ * Recomputes the new flow tables of the VIPs flagged as pending, and
+ * allocates the sticky tables the workers grow into.
+ * This runs outside of the worker barrier: the new table is built while
+ * workers keep using the current one, then atomically swapped in. The old
+ * table is freed once every worker went through one more loop.
+ * Sticky entries of ASs deleted with flush are only removed after that
+ * loop, otherwise workers could still pin new flows to them through the
+ * old table.
+ */
+static uword
+lb_flow_table_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
+                       vlib_frame_t * f)
+{
+  lb_main_t *lbm = &lb_main;
+  lb_new_flow_entry_t **old_tables = 0, **old;
+  lb_vip_t *vip;
+  u64 *flush;
+
+  while (1)
+    {
+      vlib_process_wait_for_event (vm);
+      vlib_process_get_events (vm, 0);
+
+      lb_sticky_grow_alloc();
+
+      lb_get_writer_lock();
+      pool_foreach (vip, lbm->vips) {
+          if (!(vip->flags & LB_VIP_FLAGS_FLOW_TABLE_PENDING))
+            continue;
+
+          vec_add1(old_tables, vip->new_flow_table);
+          clib_atomic_store_rel_n(&vip->new_flow_table,
+                                  lb_vip_build_new_flow_table(vip));
+          vip->flags &= ~LB_VIP_FLAGS_FLOW_TABLE_PENDING;
+      }
+      lb_put_writer_lock();
+
+      if (vec_len(old_tables))
+        vlib_worker_wait_one_loop();
+
+      if (vec_len(lbm->pending_as_flushes))
+        {
+          vlib_worker_thread_barrier_sync(vm);
+          lb_get_writer_lock();
+          vec_foreach(flush, lbm->pending_as_flushes)
+            lb_flush_vip_as(*flush >> 32, (u32) *flush);
+          vec_reset_length(lbm->pending_as_flushes);
+          lb_put_writer_lock();
+          vlib_worker_thread_barrier_release(vm);
+        }
+
+      if (vec_len(old_tables))
+        {
+          vec_foreach(old, old_tables)
+            vec_free(*old);
+          vec_reset_length(old_tables);
+        }
+    }
+
+  return 0;
+}
+
+VLIB_REGISTER_NODE (lb_flow_table_process_node) =
+{
+  .function = lb_flow_table_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "lb-flow-table-process",
+};
+
+/**
+ * Asks the flow table process to recompute the new flow table of the VIP,
+ * so that AS changes do not stall the workers while the table is built.
+ */
+static void lb_vip_schedule_new_flow_table(lb_vip_t *vip)
+{
+  lb_main_t *lbm = &lb_main;
+
+  CLIB_SPINLOCK_ASSERT_LOCKED (&lbm->writer_lock); // We must have the lock
+
+  vip->flags |= LB_VIP_FLAGS_FLOW_TABLE_PENDING;
+  vlib_process_signal_event(vlib_get_main(),
+                            lb_flow_table_process_node.index, 0, 0);
+}
+
+static void lb_as_update_encap_template(lb_as_t *as)
+{
+  lb_main_t *lbm = &lb_main;
+  lb_vip_t *vip = &lbm->vips[as->vip_index];
+  gre_header_t *gre;
+  u16 protocol;
+
+  clib_memset(&as->encap_template, 0, sizeof(as->encap_template));
+  protocol = lb_vip_is_ip4(vip->type) ? 0x0800 : 0x86DD;
+
+  if (vip->type == LB_VIP_TYPE_IP4_GRE4 || vip->type == LB_VIP_TYPE_IP6_GRE4)
+    {
+      ip4_header_t *ip4 = &as->encap_template.gre4.ip4;
+      ip4->ip_version_and_header_length = 0x45;
+      ip4->ttl = 128;
+      ip4->protocol = IP_PROTOCOL_GRE;
+      ip4->src_address = lbm->ip4_src_address;
+      ip4->dst_address = as->address.ip4;
+      //Checksum of the header with a null length, see the encap node
+      ip4->checksum = ip4_header_checksum(ip4);
+      gre = &as->encap_template.gre4.gre;
+    }
+  else if (vip->type == LB_VIP_TYPE_IP4_GRE6 ||
+           vip->type == LB_VIP_TYPE_IP6_GRE6)
+    {
+      ip6_header_t *ip6 = &as->encap_template.gre6.ip6;
+      ip6->ip_version_traffic_class_and_flow_label =
+          clib_host_to_net_u32 (0x6 << 28);
+      ip6->hop_limit = 128;
+      ip6->protocol = IP_PROTOCOL_GRE;
+      ip6->src_address = lbm->ip6_src_address;
+      ip6->dst_address = as->address.ip6;
+      gre = &as->encap_template.gre6.gre;
+    }
+  else
+    return;
+
+  gre->protocol = clib_host_to_net_u16(protocol);
+}
+
 int lb_conf(ip4_address_t *ip4_address, ip6_address_t *ip6_address,
            u32 per_cpu_sticky_buckets, u32 flow_timeout)
 {
   lb_main_t *lbm = &lb_main;
+  lb_as_t *as;
 
   if (!is_pow2(per_cpu_sticky_buckets))
     return VNET_API_ERROR_INVALID_MEMORY_SIZE;
@@ -561,6 +739,25 @@ int lb_conf(ip4_address_t *ip4_address, ip6_address_t *ip6_address,
   lbm->ip6_src_address = *ip6_address;
   lbm->per_cpu_sticky_buckets = per_cpu_sticky_buckets;
   lbm->flow_timeout = flow_timeout;
+
+  //Source addresses are part of the encap templates
+  pool_foreach (as, lbm->ass) {
+    if (as->vip_index != ~0 && !pool_is_free_index(lbm->vips, as->vip_index))
+      lb_as_update_encap_template(as);
+  }
+  lb_put_writer_lock();
+  return 0;
+}
+
+int lb_conf_sticky_max(u32 sticky_buckets_max)
+{
+  lb_main_t *lbm = &lb_main;
+
+  if (sticky_buckets_max && !is_pow2(sticky_buckets_max))
+    return VNET_API_ERROR_INVALID_MEMORY_SIZE;
+
+  lb_get_writer_lock();
+  lbm->per_cpu_sticky_buckets_max = sticky_buckets_max;
   lb_put_writer_lock();
   return 0;
 }
@@ -712,6 +909,7 @@ next:
   //Update reused ASs
   vec_foreach(ip, to_be_updated) {
     lbm->ass[*ip].flags = LB_AS_FLAGS_USED;
+    lb_as_update_encap_template(&lbm->ass[*ip]);
   }
   vec_free(to_be_updated);
 
@@ -723,6 +921,7 @@ next:
     as->address = addresses[*ip];
     as->flags = LB_AS_FLAGS_USED;
     as->vip_index = vip_index;
+    lb_as_update_encap_template(as);
     pool_get(vip->as_indexes, as_index);
     *as_index = as - lbm->ass;
 
@@ -824,7 +1023,7 @@ next:
   vec_free(to_be_added);
 
   //Recompute flows
-  lb_vip_update_new_flow_table(vip);
+  lb_vip_schedule_new_flow_table(vip);
 
   //Garbage collection maybe
   lb_vip_garbage_collection(vip);
@@ -833,6 +1032,38 @@ next:
   return 0;
 }
 
+void
+lb_sticky_grow_continue (u32 thread_index, u32 n_buckets)
+{
+  lb_per_cpu_t *per_cpu = &lb_main.per_cpu[thread_index];
+  lb_hash_t *old = per_cpu->sticky_ht_old;
+
+  if (!old)
+    return;
+
+  n_buckets = clib_min (n_buckets,
+                        lb_hash_nbuckets (old) - per_cpu->sticky_grow_next);
+  lb_hash_grow_buckets (old, per_cpu->sticky_ht, per_cpu->sticky_grow_next,
+                        n_buckets);
+  per_cpu->sticky_grow_next += n_buckets;
+
+  if (per_cpu->sticky_grow_next == lb_hash_nbuckets (old))
+    {
+      lb_hash_free (old);
+      per_cpu->sticky_ht_old = NULL;
+    }
+}
+
+void
+lb_sticky_grow_finish (void)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main();
+  u32 thread_index;
+
+  for(thread_index = 0; thread_index < tm->n_vlib_mains; thread_index++)
+    lb_sticky_grow_continue (thread_index, ~0);
+}
+
 int
 lb_flush_vip_as (u32 vip_index, u32 as_index)
 {
@@ -840,6 +1071,8 @@ lb_flush_vip_as (u32 vip_index, u32 as_index)
   vlib_thread_main_t *tm = vlib_get_thread_main();
   lb_main_t *lbm = &lb_main;
 
+  lb_sticky_grow_finish ();
+
   for(thread_index = 0; thread_index < tm->n_vlib_mains; thread_index++ ) {
     lb_hash_t *h = lbm->per_cpu[thread_index].sticky_ht;
     if (h != NULL) {
@@ -912,13 +1145,13 @@ next:
 
       if(flush)
         {
-          /* flush flow table for deleted ASs*/
-          lb_flush_vip_as(vip_index, *ip);
+          /* flush flow table for deleted ASs once the table is swapped */
+          vec_add1(lbm->pending_as_flushes, ((u64) vip_index << 32) | *ip);
         }
     }
 
     //Recompute flows
-    lb_vip_update_new_flow_table(vip);
+    lb_vip_schedule_new_flow_table(vip);
   }
 
   vec_free(indexes);
@@ -1578,6 +1811,14 @@ lb_init (vlib_main_t * vm)
   lb_foreach_vip_counter
 #undef _
 
+#define _(a,b,c)                                         \
+  lbm->sticky_counters[c].name = b;                      \
+  lbm->sticky_counters[c].stat_segment_name = b;         \
+  vlib_validate_simple_counter(&lbm->sticky_counters[c], 0); \
+  vlib_zero_simple_counter(&lbm->sticky_counters[c], 0);
+  lb_foreach_sticky_counter
+#undef _
+
   lb_fib_src = fib_source_allocate("lb",
                                    FIB_SOURCE_PRIORITY_HI,
                                    FIB_SOURCE_BH_SIMPLE);
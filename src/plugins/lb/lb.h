@@ -35,6 +35,7 @@
 
 #include <vnet/vnet.h>
 #include <vnet/ip/ip.h>
+#include <vnet/gre/packet.h>
 #include <vnet/dpo/dpo.h>
 #include <vnet/fib/fib_table.h>
 #include <vppinfra/hash.h>
@@ -45,6 +46,10 @@
 
 #define LB_DEFAULT_PER_CPU_STICKY_BUCKETS 1 << 10
 #define LB_DEFAULT_FLOW_TIMEOUT 40
+/* A sticky table grows when 1/2^n of its buckets overflowed in a timeout */
+#define LB_STICKY_GROW_SHIFT 6
+/* Buckets a worker moves per frame to its grown sticky table */
+#define LB_STICKY_GROW_BUCKETS_PER_FRAME 256
 #define LB_MAPPING_BUCKETS  1024
 #define LB_MAPPING_MEMORY_SIZE  64<<20
 
@@ -160,6 +165,22 @@ typedef struct {
    */
   dpo_id_t dpo;
 
+  /**
+   * Outer IP and GRE headers prepended by the GRE encap nodes.
+   * Built when the AS is created and when the source addresses change,
+   * so that only the length (and IPv4 checksum) are set per packet.
+   */
+  union {
+    CLIB_PACKED (struct {
+      ip4_header_t ip4;
+      gre_header_t gre;
+    }) gre4;
+    CLIB_PACKED (struct {
+      ip6_header_t ip6;
+      gre_header_t gre;
+    }) gre6;
+  } encap_template;
+
 } lb_as_t;
 
 format_function_t format_lb_as;
@@ -181,6 +202,18 @@ typedef enum {
   LB_N_VIP_COUNTERS
 } lb_vip_counter_t;
 
+#define lb_foreach_sticky_counter \
+ _(FULL, "/lb/sticky/full", 0) \
+ _(GROWN, "/lb/sticky/grown", 1) \
+ _(BUCKETS, "/lb/sticky/buckets", 2)
+
+typedef enum {
+#define _(a,b,c) LB_STICKY_COUNTER_##a = c,
+  lb_foreach_sticky_counter
+#undef _
+  LB_N_STICKY_COUNTERS
+} lb_sticky_counter_t;
+
 typedef enum {
   LB_ENCAP_TYPE_GRE4,
   LB_ENCAP_TYPE_GRE6,
@@ -321,10 +354,13 @@ typedef struct {
    * When it is not set, the VIP in the process of being removed.
    * We cannot immediately remove a VIP because the VIP index still may be stored
    * in the adjacency index.
+   * LB_VIP_FLAGS_FLOW_TABLE_PENDING means the new flow table is being
+   * recomputed by the flow table process.
    */
   u8 flags;
 #define LB_VIP_FLAGS_USED 0x1
 #define LB_VIP_FLAGS_SRC_IP_STICKY 0x2
+#define LB_VIP_FLAGS_FLOW_TABLE_PENDING 0x4
 
   /**
    * Pool of AS indexes used for this VIP.
@@ -523,6 +559,30 @@ typedef struct {
    * One single table is used for all VIPs.
    */
   lb_hash_t *sticky_ht;
+
+  /**
+   * Number of new flows which found their sticky bucket full
+   * since sticky_full_time. Used to decide when to grow the table.
+   */
+  u32 sticky_full;
+  u32 sticky_full_time;
+
+  /**
+   * Table the sticky entries are being moved from while sticky_ht grows,
+   * a few buckets per frame. Its buckets below sticky_grow_next were
+   * moved, the other ones are still in use.
+   */
+  lb_hash_t *sticky_ht_old;
+  u32 sticky_grow_next;
+
+  /**
+   * Growing a table allocates up to hundreds of MB, which is left to the
+   * main thread. The worker asks for sticky_grow_buckets buckets, the main
+   * thread then publishes the table in sticky_ht_grown and clears the
+   * request. The worker takes the table on its next frame.
+   */
+  u32 sticky_grow_buckets;
+  lb_hash_t *sticky_ht_grown;
 } lb_per_cpu_t;
 
 typedef struct {
@@ -579,6 +639,13 @@ typedef struct {
    */
   u32 per_cpu_sticky_buckets;
 
+  /**
+   * Number of buckets the per-cpu sticky tables may grow to when too
+   * many new flows find their bucket full. No growth when not above
+   * per_cpu_sticky_buckets.
+   */
+  u32 per_cpu_sticky_buckets_max;
+
   /**
    * Flow timeout in seconds.
    */
@@ -589,6 +656,11 @@ typedef struct {
    */
   vlib_simple_counter_main_t vip_counters[LB_N_VIP_COUNTERS];
 
+  /**
+   * Per thread sticky table counters
+   */
+  vlib_simple_counter_main_t sticky_counters[LB_N_STICKY_COUNTERS];
+
   /**
    * DPO used to send packet from IP4/6 lookup to LB node.
    */
@@ -630,6 +702,12 @@ typedef struct {
 
   clib_spinlock_t writer_lock;
 
+  /**
+   * VIP and AS index pairs (vip << 32 | as) whose sticky entries are
+   * flushed once the pending new flow tables have been swapped in.
+   */
+  u64 *pending_as_flushes;
+
   /* convenience */
   vlib_main_t *vlib_main;
   vnet_main_t *vnet_main;
@@ -666,6 +744,13 @@ extern vlib_node_registration_t lb_nat6_in2out_node;
 int lb_conf(ip4_address_t *ip4_address, ip6_address_t *ip6_address,
             u32 sticky_buckets, u32 flow_timeout);
 
+/**
+ * Set the number of buckets the per-cpu sticky tables may grow to.
+ * @param sticky_buckets_max power of 2, 0 disables growth
+ * @return 0 on success. VNET_LB_ERR_XXX on error
+ */
+int lb_conf_sticky_max(u32 sticky_buckets_max);
+
 int lb_vip_add(lb_vip_add_args_t args, u32 *vip_index);
 
 int lb_vip_del(u32 vip_index);
@@ -679,6 +764,24 @@ int lb_vip_add_ass(u32 vip_index, ip46_address_t *addresses, u32 n);
 int lb_vip_del_ass(u32 vip_index, ip46_address_t *addresses, u32 n, u8 flush);
 int lb_flush_vip_as (u32 vip_index, u32 as_index);
 
+/**
+ * Asks the main thread for a sticky table of n_buckets buckets to grow the
+ * table of thread_index into. Called by the worker owning the table.
+ */
+void lb_sticky_grow_request (u32 thread_index, u32 n_buckets);
+
+/**
+ * Moves up to n_buckets buckets of a growing sticky table to the new one.
+ * Must run on the table's thread, or under the barrier.
+ */
+void lb_sticky_grow_continue (u32 thread_index, u32 n_buckets);
+
+/**
+ * Completes the growth of every sticky table, under the barrier, before
+ * the tables are walked from the main thread.
+ */
+void lb_sticky_grow_finish (void);
+
 u32 lb_hash_time_now(vlib_main_t * vm);
 
 void lb_garbage_collection();
@@ -543,4 +543,49 @@ static int api_lb_as_dump (vat_main_t * vam)
   return ret;
 }
 
+static void vl_api_lb_sticky_details_t_handler
+  (vl_api_lb_sticky_details_t * mp)
+{
+  vat_main_t *vam = &vat_main;
+
+  print (vam->ofp, "[%d] hash 0x%08x vip %d as %U timeout %ds",
+         ntohl (mp->thread_index), ntohl (mp->flow_hash),
+         ntohl (mp->vip_index), format_vl_api_address_t, &mp->app_srv, 0,
+         ntohl (mp->timeout));
+}
+
+static void vl_api_lb_sticky_get_reply_t_handler
+  (vl_api_lb_sticky_get_reply_t * mp)
+{
+  vat_main_t *vam = &vat_main;
+
+  vam->retval = ntohl (mp->retval);
+  vam->result_ready = 1;
+}
+
+static int api_lb_sticky_get (vat_main_t * vam)
+{
+  unformat_input_t *line_input = vam->input;
+  vl_api_lb_sticky_get_t *mp;
+  u32 vip_index = ~0;
+  int ret;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+  {
+    if (unformat(line_input, "vip %d", &vip_index))
+      ;
+    else {
+        errmsg ("invalid arguments\n");
+        return -99;
+    }
+  }
+
+  M(LB_STICKY_GET, mp);
+  mp->vip_index = htonl (vip_index);
+
+  S(mp);
+  W (ret);
+  return ret;
+}
+
 #include <lb/lb.api_test.c>
@@ -84,12 +84,11 @@ lb_hash_t *lb_hash_alloc(u32 buckets, u32 timeout)
     return NULL;
 
   // Allocate 1 more bucket for prefetch
-  u32 size = ((uword)&((lb_hash_t *)(0))->buckets[0]) +
+  uword size = ((uword)&((lb_hash_t *)(0))->buckets[0]) +
       sizeof(lb_hash_bucket_t) * (buckets + 1);
-  u8 *mem = 0;
   lb_hash_t *h;
-  vec_validate_aligned (mem, size - 1, CLIB_CACHE_LINE_BYTES);
-  h = (lb_hash_t *)mem;
+  h = clib_mem_alloc_aligned (size, CLIB_CACHE_LINE_BYTES);
+  clib_memset (h, 0, size);
   h->buckets_mask = (buckets - 1);
   h->timeout = timeout;
   return h;
@@ -98,8 +97,7 @@ lb_hash_t *lb_hash_alloc(u32 buckets, u32 timeout)
 static_always_inline
 void lb_hash_free(lb_hash_t *h)
 {
-  u8 *mem = (u8 *)h;
-  vec_free(mem);
+  clib_mem_free(h);
 }
 
 static_always_inline
@@ -181,6 +179,56 @@ void lb_hash_put(lb_hash_t *h, u32 hash, u32 value, u32 vip,
   bucket->vip[available_index] = vip;
 }
 
+/*
+ * @brief Allocates a table with twice the buckets of the table it grows,
+ * to be filled by lb_hash_grow_buckets(). Its buckets are left
+ * uninitialized, each one is written when the bucket it comes from is
+ * moved. Returns NULL when the memory is not available.
+ */
+static_always_inline
+lb_hash_t *lb_hash_alloc_grown(u32 buckets, u32 timeout)
+{
+  uword size = ((uword)&((lb_hash_t *)(0))->buckets[0]) +
+      sizeof(lb_hash_bucket_t) * (buckets + 1);
+  lb_hash_t *n;
+  n = clib_mem_alloc_aligned_or_null (size, CLIB_CACHE_LINE_BYTES);
+  if (!n)
+    return NULL;
+  n->buckets_mask = (buckets - 1);
+  n->timeout = timeout;
+  return n;
+}
+
+/*
+ * @brief Moves count buckets of h, starting at first, into the table n
+ * allocated by lb_hash_alloc_grown() with twice its buckets. Entries of
+ * bucket i go to bucket i or i + lb_hash_nbuckets(h) of n, so none is
+ * lost, and both are entirely written. h is left untouched.
+ */
+static_always_inline
+void lb_hash_grow_buckets(lb_hash_t *h, lb_hash_t *n, u32 first, u32 count)
+{
+  lb_hash_bucket_t *bucket, *nb[2];
+  u32 i, j, used[2];
+
+  for (bucket = &h->buckets[first]; bucket < &h->buckets[first + count];
+       bucket++) {
+    nb[0] = &n->buckets[bucket - h->buckets];
+    nb[1] = nb[0] + lb_hash_nbuckets(h);
+    clib_memset (nb[0], 0, sizeof (*nb[0]));
+    clib_memset (nb[1], 0, sizeof (*nb[1]));
+    used[0] = used[1] = 0;
+    for (i = 0; i < LBHASH_ENTRY_PER_BUCKET; i++) {
+      j = (bucket->hash[i] & n->buckets_mask) > h->buckets_mask;
+      nb[j]->hash[used[j]] = bucket->hash[i];
+      nb[j]->timeout[used[j]] = bucket->timeout[i];
+      nb[j]->vip[used[j]] = bucket->vip[i];
+      nb[j]->value[used[j]] = bucket->value[i];
+      used[j]++;
+    }
+  }
+}
+
 static_always_inline
 u32 lb_hash_elts(lb_hash_t *h, u32 time_now)
 {
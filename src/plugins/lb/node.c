@@ -127,14 +127,20 @@ lb_hash_t *
 lb_get_sticky_table (u32 thread_index)
 {
   lb_main_t *lbm = &lb_main;
-  lb_hash_t *sticky_ht = lbm->per_cpu[thread_index].sticky_ht;
-  //Check if size changed
+  lb_per_cpu_t *per_cpu = &lbm->per_cpu[thread_index];
+  lb_hash_t *sticky_ht = per_cpu->sticky_ht;
+  lb_hash_t *grown;
+  u32 max_buckets = clib_max (lbm->per_cpu_sticky_buckets,
+                              lbm->per_cpu_sticky_buckets_max);
+  //Check if size changed. A table which grew is kept while within bounds.
   if (PREDICT_FALSE(
-      sticky_ht && (lbm->per_cpu_sticky_buckets != lb_hash_nbuckets(sticky_ht))))
+      sticky_ht && (lb_hash_nbuckets(sticky_ht) < lbm->per_cpu_sticky_buckets
+                    || lb_hash_nbuckets(sticky_ht) > max_buckets)))
     {
       //Dereference everything in there
       lb_hash_bucket_t *b;
       u32 i;
+      lb_sticky_grow_continue (thread_index, ~0);
       lb_hash_foreach_entry(sticky_ht, b, i)
         {
           vlib_refcount_add (&lbm->as_refcount, thread_index, b->value[i], -1);
@@ -152,12 +158,81 @@ lb_get_sticky_table (u32 thread_index)
           lbm->per_cpu_sticky_buckets, lbm->flow_timeout);
       sticky_ht = lbm->per_cpu[thread_index].sticky_ht;
       clib_warning("Regenerated sticky table %p", sticky_ht);
+      vlib_set_simple_counter (
+          &lbm->sticky_counters[LB_STICKY_COUNTER_BUCKETS], thread_index, 0,
+          lb_hash_nbuckets (sticky_ht));
+      per_cpu->sticky_full = 0;
+      per_cpu->sticky_full_time = lb_hash_time_now (vlib_get_main ());
     }
 
   ASSERT(sticky_ht);
 
+  //Keep moving the entries of a growing table
+  if (PREDICT_FALSE(per_cpu->sticky_ht_old != NULL))
+    lb_sticky_grow_continue (thread_index, LB_STICKY_GROW_BUCKETS_PER_FRAME);
+
+  //Start moving the entries to the table the main thread allocated.
+  //It is dropped if this table was replaced in the meantime.
+  grown = clib_atomic_load_acq_n (&per_cpu->sticky_ht_grown);
+  if (PREDICT_FALSE(grown != NULL))
+    {
+      per_cpu->sticky_ht_grown = NULL;
+      if (per_cpu->sticky_ht_old == NULL
+          && lb_hash_nbuckets (grown) == lb_hash_nbuckets (sticky_ht) << 1)
+        {
+          per_cpu->sticky_ht_old = sticky_ht;
+          per_cpu->sticky_grow_next = 0;
+          per_cpu->sticky_ht = grown;
+          sticky_ht = grown;
+          vlib_increment_simple_counter (
+              &lbm->sticky_counters[LB_STICKY_COUNTER_GROWN], thread_index, 0,
+              1);
+          vlib_set_simple_counter (
+              &lbm->sticky_counters[LB_STICKY_COUNTER_BUCKETS], thread_index,
+              0, lb_hash_nbuckets (sticky_ht));
+        }
+      else
+        lb_hash_free (grown);
+    }
+
+  //Grow if too many new flows found their bucket full within a timeout.
+  //Entries keep their AS, so established flows are not remapped.
+  //The main thread allocates the new table, then the entries are moved
+  //over the next frames, not all at once.
+  if (PREDICT_FALSE(per_cpu->sticky_full >=
+                    clib_max (1, lb_hash_nbuckets(sticky_ht)
+                                 >> LB_STICKY_GROW_SHIFT)))
+    {
+      u32 now = lb_hash_time_now (vlib_get_main ());
+      if (!clib_u32_loop_gt (now, per_cpu->sticky_full_time + sticky_ht->timeout)
+          && lb_hash_nbuckets (sticky_ht) < max_buckets
+          && per_cpu->sticky_ht_old == NULL
+          && clib_atomic_load_acq_n (&per_cpu->sticky_grow_buckets) == 0
+          && clib_atomic_load_acq_n (&per_cpu->sticky_ht_grown) == NULL)
+        lb_sticky_grow_request (thread_index,
+                                lb_hash_nbuckets (sticky_ht) << 1);
+      per_cpu->sticky_full = 0;
+      per_cpu->sticky_full_time = now;
+    }
+
   //Update timeout
   sticky_ht->timeout = lbm->flow_timeout;
+  if (PREDICT_FALSE(per_cpu->sticky_ht_old != NULL))
+    per_cpu->sticky_ht_old->timeout = lbm->flow_timeout;
+  return sticky_ht;
+}
+
+//While the sticky table grows, the buckets not moved yet are still used
+//in the old table
+static_always_inline lb_hash_t *
+lb_sticky_table_for_hash (lb_per_cpu_t *per_cpu, lb_hash_t *sticky_ht,
+                          u32 hash)
+{
+  lb_hash_t *old = per_cpu->sticky_ht_old;
+
+  if (PREDICT_FALSE(old != NULL)
+      && (hash & old->buckets_mask) >= per_cpu->sticky_grow_next)
+    return old;
   return sticky_ht;
 }
 
@@ -283,6 +358,7 @@ lb_node_fn (vlib_main_t * vm,
   u32 lb_time = lb_hash_time_now (vm);
 
   lb_hash_t *sticky_ht = lb_get_sticky_table (thread_index);
+  lb_per_cpu_t *per_cpu = &lbm->per_cpu[thread_index];
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
   next_index = node->cached_next_index;
@@ -307,6 +383,7 @@ lb_node_fn (vlib_main_t * vm,
           u32 asindex0 = 0;
           u16 len0;
           u32 available_index0;
+          lb_hash_t *ht0;
           u8 counter = 0;
           u32 hash0 = nexthash0;
           u32 vip_index0 = next_vip_idx0;
@@ -319,7 +396,9 @@ lb_node_fn (vlib_main_t * vm,
               lb_node_get_hash (lbm, p1, is_input_v4,
                                 &nexthash0, &next_vip_idx0,
                                 per_port_vip, src_ip_sticky);
-              lb_hash_prefetch_bucket (sticky_ht, nexthash0);
+              lb_hash_prefetch_bucket (
+                  lb_sticky_table_for_hash (per_cpu, sticky_ht, nexthash0),
+                  nexthash0);
               //Prefetch for encap, next
               CLIB_PREFETCH(vlib_buffer_get_current (p1) - 64, 64, STORE);
             }
@@ -357,7 +436,8 @@ lb_node_fn (vlib_main_t * vm,
                   + sizeof(ip6_header_t);
             }
 
-          lb_hash_get (sticky_ht, hash0,
+          ht0 = lb_sticky_table_for_hash (per_cpu, sticky_ht, hash0);
+          lb_hash_get (ht0, hash0,
                        vip_index0, lb_time,
                        &available_index0, &asindex0);
 
@@ -380,14 +460,14 @@ lb_node_fn (vlib_main_t * vm,
               //Dereference previously used
               vlib_refcount_add (
                   &lbm->as_refcount, thread_index,
-                  lb_hash_available_value (sticky_ht, hash0, available_index0),
+                  lb_hash_available_value (ht0, hash0, available_index0),
                   -1);
               vlib_refcount_add (&lbm->as_refcount, thread_index, asindex0, 1);
 
               //Add sticky entry
               //Note that when there is no AS configured, an entry is configured anyway.
               //But no configured AS is not something that should happen
-              lb_hash_put (sticky_ht, hash0, asindex0,
+              lb_hash_put (ht0, hash0, asindex0,
                            vip_index0,
                            available_index0, lb_time);
             }
@@ -397,6 +477,10 @@ lb_node_fn (vlib_main_t * vm,
               asindex0 =
                   vip0->new_flow_table[hash0 & vip0->new_flow_table_mask].as_index;
               counter = LB_VIP_COUNTER_UNTRACKED_PACKET;
+              per_cpu->sticky_full++;
+              vlib_increment_simple_counter (
+                  &lbm->sticky_counters[LB_STICKY_COUNTER_FULL], thread_index,
+                  0, 1);
             }
 
           vlib_increment_simple_counter (
@@ -408,24 +492,25 @@ lb_node_fn (vlib_main_t * vm,
           if ((encap_type == LB_ENCAP_TYPE_GRE4)
               || (encap_type == LB_ENCAP_TYPE_GRE6))
             {
-              gre_header_t *gre0;
+              lb_as_t *as0 = &lbm->ass[asindex0];
               if (encap_type == LB_ENCAP_TYPE_GRE4) /* encap GRE4*/
                 {
                   ip4_header_t *ip40;
+                  ip_csum_t csum;
+                  u16 length0;
                   vlib_buffer_advance (
                       p0, -sizeof(ip4_header_t) - sizeof(gre_header_t));
                   ip40 = vlib_buffer_get_current (p0);
-                  gre0 = (gre_header_t *) (ip40 + 1);
-                  ip40->src_address = lbm->ip4_src_address;
-                  ip40->dst_address = lbm->ass[asindex0].address.ip4;
-                  ip40->ip_version_and_header_length = 0x45;
-                  ip40->ttl = 128;
-                  ip40->fragment_id = 0;
-                  ip40->flags_and_fragment_offset = 0;
-                  ip40->length = clib_host_to_net_u16 (
+                  clib_memcpy_fast (ip40, &as0->encap_template.gre4,
+                                    sizeof(as0->encap_template.gre4));
+                  //The template checksum was computed with a null length
+                  length0 = clib_host_to_net_u16 (
                       len0 + sizeof(gre_header_t) + sizeof(ip4_header_t));
-                  ip40->protocol = IP_PROTOCOL_GRE;
-                  ip40->checksum = ip4_header_checksum (ip40);
+                  csum = ip40->checksum;
+                  csum = ip_csum_update (csum, 0, length0, ip4_header_t,
+                                         length /* changed member */);
+                  ip40->checksum = ip_csum_fold (csum);
+                  ip40->length = length0;
                 }
               else /* encap GRE6*/
                 {
@@ -433,22 +518,11 @@ lb_node_fn (vlib_main_t * vm,
                   vlib_buffer_advance (
                       p0, -sizeof(ip6_header_t) - sizeof(gre_header_t));
                   ip60 = vlib_buffer_get_current (p0);
-                  gre0 = (gre_header_t *) (ip60 + 1);
-                  ip60->dst_address = lbm->ass[asindex0].address.ip6;
-                  ip60->src_address = lbm->ip6_src_address;
-                  ip60->hop_limit = 128;
-                  ip60->ip_version_traffic_class_and_flow_label =
-                      clib_host_to_net_u32 (0x6 << 28);
+                  clib_memcpy_fast (ip60, &as0->encap_template.gre6,
+                                    sizeof(as0->encap_template.gre6));
                   ip60->payload_length = clib_host_to_net_u16 (
                       len0 + sizeof(gre_header_t));
-                  ip60->protocol = IP_PROTOCOL_GRE;
                 }
-
-              gre0->flags_and_version = 0;
-              gre0->protocol =
-                  (is_input_v4) ?
-                      clib_host_to_net_u16 (0x0800) :
-                      clib_host_to_net_u16 (0x86DD);
             }
           else if (encap_type == LB_ENCAP_TYPE_L3DSR) /* encap L3DSR*/
             {
@@ -456,6 +530,7 @@ lb_node_fn (vlib_main_t * vm,
               ip_csum_t csum;
               u32 old_dst, new_dst;
               u8 old_tos, new_tos;
+              int l4_csum0;
 
               ip40 = vlib_buffer_get_current (p0);
               old_dst = ip40->dst_address.as_u32;
@@ -475,20 +550,45 @@ lb_node_fn (vlib_main_t * vm,
                                      dst_address /* changed member */);
               ip40->checksum = ip_csum_fold (csum);
 
-              /* Recomputing L4 checksum after dst-IP modifying */
-              if (ip40->protocol == IP_PROTOCOL_TCP)
+              /*
+               * The L4 checksum only covers the destination address through
+               * the pseudo header, so update it incrementally. Leave it alone
+               * when it is offloaded, it is computed on the way out anyway,
+               * and on non-first fragments which do not carry it.
+               */
+              if ((p0->flags & VNET_BUFFER_F_OFFLOAD) &&
+                  (vnet_buffer (p0)->oflags &
+                   (VNET_BUFFER_OFFLOAD_F_TCP_CKSUM |
+                    VNET_BUFFER_OFFLOAD_F_UDP_CKSUM)))
+                l4_csum0 = 0;
+              else
+                l4_csum0 = (ip4_get_fragment_offset (ip40) == 0);
+
+              if (l4_csum0 && ip40->protocol == IP_PROTOCOL_TCP)
                 {
                   tcp_header_t *th0;
                   th0 = ip4_next_header (ip40);
-                  th0->checksum = 0;
-                  th0->checksum = ip4_tcp_udp_compute_checksum (vm, p0, ip40);
+                  csum = th0->checksum;
+                  csum = ip_csum_update (csum, old_dst, new_dst,
+                                         ip4_header_t,
+                                         dst_address /* changed member */);
+                  th0->checksum = ip_csum_fold (csum);
                 }
-              else if (ip40->protocol == IP_PROTOCOL_UDP)
+              else if (l4_csum0 && ip40->protocol == IP_PROTOCOL_UDP)
                 {
                   udp_header_t *uh0;
                   uh0 = ip4_next_header (ip40);
-                  uh0->checksum = 0;
-                  uh0->checksum = ip4_tcp_udp_compute_checksum (vm, p0, ip40);
+                  if (uh0->checksum != 0)
+                    {
+                      csum = uh0->checksum;
+                      csum = ip_csum_update (csum, old_dst, new_dst,
+                                             ip4_header_t,
+                                             dst_address /* changed member */);
+                      uh0->checksum = ip_csum_fold (csum);
+                      /* 0 means no checksum for UDP */
+                      if (uh0->checksum == 0)
+                        uh0->checksum = 0xffff;
+                    }
                 }
             }
           else if ((encap_type == LB_ENCAP_TYPE_NAT4)
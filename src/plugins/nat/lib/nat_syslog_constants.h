@@ -25,14 +25,18 @@
 
 #define SADD_SDEL_SEVERITY     SYSLOG_SEVERITY_INFORMATIONAL
 #define APMADD_APMDEL_SEVERITY SYSLOG_SEVERITY_INFORMATIONAL
+#define PBADD_PBDEL_SEVERITY   SYSLOG_SEVERITY_INFORMATIONAL
 
 #define SADD_MSGID   "SADD"
 #define SDEL_MSGID   "SDEL"
 #define APMADD_MSGID "APMADD"
 #define APMDEL_MSGID "APMDEL"
+#define PBADD_MSGID  "PBADD"
+#define PBDEL_MSGID  "PBDEL"
 
 #define NSESS_SDID  "nsess"
 #define NAPMAP_SDID "napmap"
+#define NPBMAP_SDID "npbmap"
 
 #define SSUBIX_SDPARAM_NAME "SSUBIX"
 #define SVLAN_SDPARAM_NAME  "SVLAN"
@@ -44,6 +48,7 @@
 #define XATYP_SDPARAM_NAME  "XATYP"
 #define XSADDR_SDPARAM_NAME "XSADDR"
 #define XSPORT_SDPARAM_NAME "XSPORT"
+#define XEPORT_SDPARAM_NAME "XEPORT"
 #define XDADDR_SDPARAM_NAME "XDADDR"
 #define XDPORT_SDPARAM_NAME "XDPORT"
 #define PROTO_SDPARAM_NAME  "PROTO"
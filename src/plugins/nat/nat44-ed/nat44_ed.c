@@ -22,6 +22,7 @@
 #include <vnet/ip/reass/ip4_sv_reass.h>
 #include <vnet/fib/fib_table.h>
 #include <vnet/fib/ip4_fib.h>
+#include <vnet/interface/rx_queue_funcs.h>
 #include <vnet/plugin/plugin.h>
 #include <vppinfra/bihash_16_8.h>
 
@@ -209,6 +210,9 @@ nat44_ed_free_session_data (snat_main_t *sm, snat_session_t *s,
 {
   per_vrf_sessions_unregister_session (s, thread_index);
 
+  if (!is_ha)
+    nat44_ed_ha_sdel (s, thread_index);
+
   if (nat_ed_ses_i2o_flow_hash_add_del (sm, thread_index, s, 0))
     nat_elog_warn (sm, "flow hash del failed");
 
@@ -224,6 +228,13 @@ nat44_ed_free_session_data (snat_main_t *sm, snat_session_t *s,
     nat_affinity_unlock (s->ext_host_addr, s->out2in.addr, s->proto,
 			 s->out2in.port);
 
+  /* port block sessions are logged per block instead */
+  if (nat44_ed_is_port_block_session (s))
+    {
+      nat44_ed_port_block_unref (sm, s, thread_index);
+      return;
+    }
+
   if (!is_ha)
     nat_syslog_nat44_sdel (0, s->in2out.fib_index, &s->in2out.addr,
 			   s->in2out.port, &s->ext_host_nat_addr,
@@ -536,6 +547,9 @@ nat44_ed_add_address (ip4_address_t *addr, u32 vrf_id, u8 twice_nat)
   ap->addr_len = ~0;
   ap->fib_index = ~0;
   ap->addr = *addr;
+  /* sized here so that workers only ever touch their own bitmap */
+  ap->busy_port_blocks = 0;
+  vec_validate (ap->busy_port_blocks, vlib_get_n_threads () - 1);
 
   if (vrf_id != ~0)
     {
@@ -613,6 +627,9 @@ nat44_ed_del_address (ip4_address_t addr, u8 twice_nat)
       fib_table_unlock (a->fib_index, FIB_PROTOCOL_IP4, sm->fib_src_low);
     }
 
+  nat44_ed_port_block_address_reset (a);
+  vec_free (a->busy_port_blocks);
+
   if (!twice_nat)
     {
       vec_del1 (sm->addresses, j);
@@ -758,6 +775,11 @@ get_thread_idx_by_port (u16 e_port)
 {
   snat_main_t *sm = &snat_main;
   u32 thread_idx = sm->num_workers;
+
+  /* ports aren't partitioned, no session means nobody owns the packet */
+  if (sm->rss_port_selection)
+    return vlib_get_thread_index ();
+
   if (sm->num_workers > 1)
     {
       thread_idx = sm->first_worker_index +
@@ -2137,6 +2159,70 @@ snat_set_workers (uword * bitmap)
   return 0;
 }
 
+int
+nat44_ed_set_rss_port_selection (int enable, u32 sw_if_index, u8 *key,
+				 u32 reta_size, u32 *queue_workers)
+{
+  snat_main_t *sm = &snat_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  vnet_hw_interface_t *hw = 0;
+  u32 *qi, *w;
+
+  if (!enable)
+    {
+      sm->rss_port_selection = 0;
+      return 0;
+    }
+
+  if (sm->num_workers < 2)
+    return VNET_API_ERROR_FEATURE_DISABLED;
+
+  /* port blocks fix the port range of every session */
+  if (sm->port_block_size)
+    return VNET_API_ERROR_UNSUPPORTED;
+
+  /* the hash input is 12 bytes and the key must be 4 bytes longer */
+  if (!is_pow2 (reta_size) || (key && vec_len (key) < 16))
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  vec_foreach (w, queue_workers)
+    if (*w >= sm->num_workers)
+      return VNET_API_ERROR_INVALID_WORKER;
+
+  if (!queue_workers)
+    {
+      hw = vnet_get_sup_hw_interface_api_visible_or_null (vnm, sw_if_index);
+      if (!hw)
+	return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+      if (vec_len (hw->rx_queue_indices) == 0)
+	return VNET_API_ERROR_INVALID_INTERFACE;
+    }
+
+  sm->rss_port_selection = 0;
+
+  vec_reset_length (sm->rss_thread_by_queue);
+  if (queue_workers)
+    vec_foreach (w, queue_workers)
+      vec_add1 (sm->rss_thread_by_queue, vlib_get_worker_thread_index (*w));
+  else
+    vec_foreach (qi, hw->rx_queue_indices)
+      {
+	vnet_hw_if_rx_queue_t *rxq = vnet_hw_if_get_rx_queue (vnm, *qi);
+	vec_validate (sm->rss_thread_by_queue, rxq->queue_id);
+	sm->rss_thread_by_queue[rxq->queue_id] = rxq->thread_index;
+      }
+
+  if (sm->rss_key)
+    clib_toeplitz_hash_key_free (sm->rss_key);
+  /* no key means the default one most NICs ship with */
+  sm->rss_key = clib_toeplitz_hash_key_init (key, vec_len (key));
+  sm->rss_reta_size = reta_size;
+  sm->rss_port_selection = 1;
+
+  return 0;
+}
+
 int
 nat44_ed_set_frame_queue_nelts (u32 frame_queue_nelts)
 {
@@ -2355,6 +2441,13 @@ nat_init (vlib_main_t * vm)
 
   nat_init_simple_counter (sm->total_sessions, "total-sessions",
 			   "/nat44-ed/total-sessions");
+  nat_init_simple_counter (sm->aging_expired_sessions,
+			   "aging-expired-sessions",
+			   "/nat44-ed/aging/expired-sessions");
+  nat_init_simple_counter (sm->port_blocks_allocated, "port-blocks-allocated",
+			   "/nat44-ed/port-block/allocated");
+  nat_init_simple_counter (sm->port_blocks_released, "port-blocks-released",
+			   "/nat44-ed/port-block/released");
   sm->max_cfg_sessions_gauge =
     vlib_stats_add_gauge ("/nat44-ed/max-cfg-sessions");
 
@@ -2417,6 +2510,7 @@ nat_init (vlib_main_t * vm)
 			 FIB_SOURCE_BH_SIMPLE);
 
   nat_affinity_init (vm);
+  nat44_ed_ha_init (vm, num_threads);
   test_key_calc_split ();
 
   return nat44_api_hookup (vm);
@@ -2431,8 +2525,16 @@ nat44_plugin_enable (nat44_config_t c)
 
   fail_if_enabled ();
 
+  if (c.port_block_size > sm->port_per_thread)
+    return VNET_API_ERROR_INVALID_VALUE;
+
   sm->forwarding_enabled = 0;
   sm->mss_clamping = 0;
+  sm->clock_aging = c.clock_aging;
+  sm->port_block_size = c.port_block_size;
+  sm->port_blocks_per_user = c.port_blocks_per_user ?
+			       c.port_blocks_per_user :
+			       NAT44_ED_PORT_BLOCKS_PER_USER_DEFAULT;
 
   if (!c.sessions)
     c.sessions = 63 * 1024;
@@ -2460,6 +2562,9 @@ nat44_plugin_enable (nat44_config_t c)
   nat_reset_timeouts (&sm->timeouts);
 
   vlib_zero_simple_counter (&sm->total_sessions, 0);
+  vlib_zero_simple_counter (&sm->aging_expired_sessions, 0);
+  vlib_zero_simple_counter (&sm->port_blocks_allocated, 0);
+  vlib_zero_simple_counter (&sm->port_blocks_released, 0);
 
   if (!sm->frame_queue_nelts)
     {
@@ -2494,6 +2599,8 @@ nat44_plugin_enable (nat44_config_t c)
   sm->enabled = 1;
   sm->rconfig = c;
 
+  nat44_ed_aging_enable (vlib_get_main ());
+
   return 0;
 }
 
@@ -2700,7 +2807,11 @@ nat44_plugin_disable ()
 
   nat_affinity_disable ();
 
+  nat44_ed_ha_disable (vlib_get_main ());
+
   sm->forwarding_enabled = 0;
+  sm->clock_aging = 0;
+  sm->port_block_size = 0;
   sm->enabled = 0;
 
   return error;
@@ -3041,6 +3152,20 @@ nat44_ed_get_in2out_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
 	    ed_value_get_session_index (&value16);
 	  goto out;
 	}
+
+      /* new dynamic sessions stay on the receiving worker, their outside
+       * port is picked so that the return traffic comes back here too;
+       * static mappings keep the worker their sessions are looked up on */
+      if (sm->rss_port_selection &&
+	  (!pool_elts (sm->static_mappings) ||
+	   (!nat44_ed_sm_i2o_lookup (sm, ip->src_address, 0, fib_index, 0) &&
+	    !nat44_ed_sm_i2o_lookup (sm, ip->src_address,
+				     vnet_buffer (b)->ip.reass.l4_src_port,
+				     fib_index, ip->protocol))))
+	{
+	  next_worker_index = vlib_get_thread_index ();
+	  goto out;
+	}
     }
 
   hash = ip->src_address.as_u32 + (ip->src_address.as_u32 >> 8) +
@@ -3277,7 +3402,11 @@ nat44_ed_worker_db_init (snat_main_per_thread_data_t *tsm, u32 translations)
 
   pool_alloc (tsm->per_vrf_sessions_pool, translations);
   pool_alloc (tsm->sessions, translations);
-  pool_alloc (tsm->lru_pool, translations);
+  nat44_ed_port_block_db_init (tsm);
+  /* with clock aging only the list heads are allocated */
+  if (!snat_main.clock_aging)
+    pool_alloc (tsm->lru_pool, translations);
+  tsm->aging_cursor = 0;
 
   pool_get (tsm->lru_pool, head);
   tsm->tcp_trans_lru_head_index = head - tsm->lru_pool;
@@ -3331,6 +3460,7 @@ nat44_ed_worker_db_free (snat_main_per_thread_data_t *tsm)
   pool_free (tsm->lru_pool);
   pool_free (tsm->sessions);
   pool_free (tsm->per_vrf_sessions_pool);
+  nat44_ed_port_block_db_free (tsm);
 }
 
 static void
@@ -3346,12 +3476,18 @@ nat44_ed_db_free ()
 {
   snat_main_t *sm = &snat_main;
   snat_main_per_thread_data_t *tsm;
+  snat_address_t *a;
 
   vec_foreach (tsm, sm->per_thread_data)
     {
       nat44_ed_worker_db_free (tsm);
     }
 
+  vec_foreach (a, sm->addresses)
+    {
+      nat44_ed_port_block_address_reset (a);
+    }
+
   nat44_ed_flow_hash_free ();
 }
 
@@ -3638,6 +3774,11 @@ nat44_ed_del_session (snat_main_t *sm, ip4_address_t *addr, u16 port,
       return VNET_API_ERROR_NO_SUCH_ENTRY;
     }
 
+  /* sessions live on the worker which saw their first packet */
+  if (sm->rss_port_selection)
+    tsm = vec_elt_at_index (sm->per_thread_data,
+			    ed_value_get_thread_index (&value));
+
   if (pool_is_free_index (tsm->sessions, ed_value_get_session_index (&value)))
     return VNET_API_ERROR_UNSPECIFIED;
   s = pool_elt_at_index (tsm->sessions, ed_value_get_session_index (&value));
@@ -4103,6 +4244,53 @@ nat_syslog_nat44_sdel (u32 ssubix, u32 sfibix, ip4_address_t *isaddr,
 			 is_twicenat);
 }
 
+static_always_inline void
+nat_syslog_nat44_pb (u32 sfibix, ip4_address_t *isaddr, ip4_address_t *xsaddr,
+		     u16 xsport, u16 xeport, u8 is_add)
+{
+  syslog_msg_t syslog_msg;
+  fib_table_t *fib;
+
+  if (!syslog_is_enabled ())
+    return;
+
+  if (syslog_severity_filter_block (PBADD_PBDEL_SEVERITY))
+    return;
+
+  fib = fib_table_get (sfibix, FIB_PROTOCOL_IP4);
+
+  syslog_msg_init (&syslog_msg, NAT_FACILITY, PBADD_PBDEL_SEVERITY,
+		   NAT_APPNAME, is_add ? PBADD_MSGID : PBDEL_MSGID);
+
+  syslog_msg_sd_init (&syslog_msg, NPBMAP_SDID);
+  syslog_msg_add_sd_param (&syslog_msg, SVLAN_SDPARAM_NAME, "%d",
+			   fib->ft_table_id);
+  syslog_msg_add_sd_param (&syslog_msg, IATYP_SDPARAM_NAME, IATYP_IPV4);
+  syslog_msg_add_sd_param (&syslog_msg, ISADDR_SDPARAM_NAME, "%U",
+			   format_ip4_address, isaddr);
+  syslog_msg_add_sd_param (&syslog_msg, XATYP_SDPARAM_NAME, IATYP_IPV4);
+  syslog_msg_add_sd_param (&syslog_msg, XSADDR_SDPARAM_NAME, "%U",
+			   format_ip4_address, xsaddr);
+  syslog_msg_add_sd_param (&syslog_msg, XSPORT_SDPARAM_NAME, "%d", xsport);
+  syslog_msg_add_sd_param (&syslog_msg, XEPORT_SDPARAM_NAME, "%d", xeport);
+
+  syslog_msg_send (&syslog_msg);
+}
+
+void
+nat_syslog_nat44_pbadd (u32 sfibix, ip4_address_t *isaddr,
+			ip4_address_t *xsaddr, u16 xsport, u16 xeport)
+{
+  nat_syslog_nat44_pb (sfibix, isaddr, xsaddr, xsport, xeport, 1);
+}
+
+void
+nat_syslog_nat44_pbdel (u32 sfibix, ip4_address_t *isaddr,
+			ip4_address_t *xsaddr, u16 xsport, u16 xeport)
+{
+  nat_syslog_nat44_pb (sfibix, isaddr, xsaddr, xsport, xeport, 0);
+}
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -28,6 +28,7 @@
 #include <vppinfra/hash.h>
 #include <vppinfra/dlist.h>
 #include <vppinfra/error.h>
+#include <vppinfra/vector/toeplitz.h>
 #include <vlibapi/api.h>
 
 #include <nat/lib/lib.h>
@@ -41,11 +42,37 @@
  * as if there were no free ports available to conserve resources */
 #define ED_PORT_ALLOC_ATTEMPTS (10)
 
+/* with RSS aware port selection, number of candidate ports rejected because
+ * the return traffic would hash to another worker before settling for one
+ * which needs handoff */
+#define ED_RSS_PORT_ALLOC_ATTEMPTS (256)
+
+/* with port block allocation, number of consecutive ports of one block
+ * probed before trying the next block */
+#define ED_PORT_BLOCK_ALLOC_ATTEMPTS (64)
+
 /* system ports range is 0-1023, first user port is 1024 per
  * https://www.rfc-editor.org/rfc/rfc6335#section-6
  */
 #define ED_USER_PORT_OFFSET 1024
 
+/* with clock aging, interval between two sweep slices on each thread */
+#define NAT44_ED_AGING_INTERVAL (100e-3)
+
+/* with clock aging, time in which every session of a thread is visited */
+#define NAT44_ED_AGING_SWEEP_PERIOD (10.0)
+
+/* with clock aging, minimum number of sessions visited by one slice */
+#define NAT44_ED_AGING_MIN_BATCH (256)
+
+/* with clock aging, number of sessions visited looking for an expired one
+ * when the session table is full */
+#define NAT44_ED_AGING_ALLOC_BATCH (256)
+
+/* with port block allocation, default number of port blocks a subscriber
+ * may hold on one thread */
+#define NAT44_ED_PORT_BLOCKS_PER_USER_DEFAULT (4)
+
 /* NAT buffer flags */
 #define SNAT_FLAG_HAIRPINNING (1 << 0)
 
@@ -68,6 +95,13 @@ typedef struct
   u32 inside_vrf;
   u32 outside_vrf;
   u32 sessions;
+  /* age sessions by a clock sweep instead of LRU lists */
+  u8 clock_aging;
+  /* allocate outside ports in per subscriber blocks of this size, 0 to
+   * allocate ports individually */
+  u16 port_block_size;
+  /* max port blocks held by one subscriber on one thread */
+  u16 port_blocks_per_user;
 } nat44_config_t;
 
 typedef enum
@@ -169,6 +203,8 @@ format_function_t format_nat44_ed_tcp_state;
 #define SNAT_SESSION_FLAG_AFFINITY	     (1 << 6)
 #define SNAT_SESSION_FLAG_EXACT_ADDRESS	     (1 << 7)
 #define SNAT_SESSION_FLAG_HAIRPINNING	     (1 << 8)
+#define SNAT_SESSION_FLAG_HA_SYNCED	     (1 << 9)
+#define SNAT_SESSION_FLAG_PORT_BLOCK	     (1 << 10)
 
 /* NAT interface flags */
 #define NAT_INTERFACE_FLAG_IS_INSIDE 1
@@ -336,6 +372,10 @@ typedef CLIB_PACKED(struct
   /* per vrf sessions index */
   u32 per_vrf_sessions_index;
 
+  /* port block the outside port belongs to, if SNAT_SESSION_FLAG_PORT_BLOCK
+   * is set */
+  u32 port_block_index;
+
   u32 thread_index;
 }) snat_session_t;
 
@@ -346,6 +386,8 @@ typedef struct
   u32 sw_if_index;
   u32 fib_index;
   u32 addr_len;
+  /* allocated port blocks, bitmap by thread index */
+  uword **busy_port_blocks;
 } snat_address_t;
 
 typedef struct
@@ -447,6 +489,30 @@ typedef struct
   ip4_address_t addr;
 } snat_fib_entry_reg_t;
 
+/* block of consecutive outside ports owned by one subscriber */
+typedef struct
+{
+  /* outside address */
+  ip4_address_t addr;
+  /* first port of the block, host byte order */
+  u16 start_port;
+  /* bit in the address' busy_port_blocks bitmap */
+  u32 bit;
+  /* number of sessions using a port from this block */
+  u32 n_sessions;
+  /* owning subscriber */
+  u32 user_index;
+} nat44_ed_port_block_t;
+
+typedef struct
+{
+  /* inside address and fib */
+  ip4_address_t addr;
+  u32 fib_index;
+  /* allocated port blocks, most recent last */
+  u32 *blocks;
+} nat44_ed_port_block_user_t;
+
 typedef struct
 {
   /* Session pool */
@@ -463,6 +529,15 @@ typedef struct
   u32 icmp_lru_head_index;
   u32 unk_proto_lru_head_index;
 
+  /* next session pool index visited by the clock aging sweep */
+  u32 aging_cursor;
+
+  /* port block allocation */
+  nat44_ed_port_block_t *port_blocks;
+  nat44_ed_port_block_user_t *port_block_users;
+  /* subscriber index by (fib index << 32 | inside address) */
+  uword *port_block_user_by_key;
+
   /* NAT thread index */
   u32 snat_thread_index;
 
@@ -507,6 +582,15 @@ typedef struct snat_main_s
   u32 *workers;
   u16 port_per_thread;
 
+  /* RSS aware port selection: outside ports are picked so that the outside
+   * NIC's RSS hash of the return traffic lands on the session's worker */
+  u8 rss_port_selection;
+  clib_toeplitz_hash_key_t *rss_key;
+  u32 rss_reta_size;
+  /* thread polling each outside rx queue, by queue id; the indirection
+   * table is assumed to spread its entries round-robin over the queues */
+  u16 *rss_thread_by_queue;
+
   /* Per thread data */
   snat_main_per_thread_data_t *per_thread_data;
 
@@ -568,6 +652,15 @@ typedef struct snat_main_s
   /* If forwarding is enabled */
   u8 forwarding_enabled;
 
+  /* Sessions are aged by a clock sweep instead of LRU lists, the data path
+   * then only updates last_heard */
+  u8 clock_aging;
+
+  /* Outside ports are allocated in per subscriber blocks of this size and
+   * only block allocation and release are logged, 0 if disabled */
+  u16 port_block_size;
+  u16 port_blocks_per_user;
+
   /* Is translation memory size calculated or user defined */
   u8 translation_memory_size_set;
 
@@ -582,6 +675,9 @@ typedef struct snat_main_s
 
   /* counters */
   vlib_simple_counter_main_t total_sessions;
+  vlib_simple_counter_main_t aging_expired_sessions;
+  vlib_simple_counter_main_t port_blocks_allocated;
+  vlib_simple_counter_main_t port_blocks_released;
   u32 max_cfg_sessions_gauge; /* Index of max configured sessions gauge in
 				 stats */
 
@@ -732,6 +828,16 @@ nat44_ed_is_affinity_session (snat_session_t *s)
   return s->flags & SNAT_SESSION_FLAG_AFFINITY;
 }
 
+/** \brief Check if NAT session outside port comes from a port block.
+    @param s NAT session
+    @return true if outside port belongs to a port block
+*/
+always_inline bool
+nat44_ed_is_port_block_session (snat_session_t *s)
+{
+  return s->flags & SNAT_SESSION_FLAG_PORT_BLOCK;
+}
+
 /** \brief Check if exact pool address should be used.
     @param s SNAT session
     @return true if exact pool address
@@ -929,8 +1035,55 @@ void nat44_addresses_free (snat_address_t **addresses);
 
 void nat44_ed_sessions_clear ();
 
+/**
+ * @brief Delete expired sessions of a thread, resuming the clock sweep where
+ * the previous call stopped
+ *
+ * @param n_visit number of session pool slots to visit
+ * @param max_expired stop after deleting this many sessions
+ *
+ * @returns number of deleted sessions
+ */
+u32 nat44_ed_aging_sweep (snat_main_t *sm, u32 thread_index, f64 now,
+			  u32 n_visit, u32 max_expired);
+
+/**
+ * @brief Start the clock aging process if clock aging is configured
+ */
+void nat44_ed_aging_enable (vlib_main_t *vm);
+
+/**
+ * @brief Allocate an outside port for a session from one of the subscriber's
+ * port blocks on address a, allocating a new block if none has a free port
+ *
+ * @param snat_thread_index NAT thread index selecting the port range
+ * @param s session, inside tuple and o2i match already set
+ * @param outside_port suggested port on input, allocated port on output,
+ *                     network byte order
+ *
+ * @returns 0 on success, non-zero value otherwise.
+ */
+int nat44_ed_port_block_alloc (snat_main_t *sm, u32 thread_index,
+			       u32 snat_thread_index, snat_address_t *a,
+			       snat_session_t *s, ip4_address_t *outside_addr,
+			       u16 *outside_port);
+
+/**
+ * @brief Drop the session's reference to its port block, the block is
+ * released once no session uses it
+ */
+void nat44_ed_port_block_unref (snat_main_t *sm, snat_session_t *s,
+				u32 thread_index);
+
+void nat44_ed_port_block_db_init (snat_main_per_thread_data_t *tsm);
+void nat44_ed_port_block_db_free (snat_main_per_thread_data_t *tsm);
+void nat44_ed_port_block_address_reset (snat_address_t *a);
+
 int nat44_ed_set_frame_queue_nelts (u32 frame_queue_nelts);
 
+int nat44_ed_set_rss_port_selection (int enable, u32 sw_if_index, u8 *key,
+				     u32 reta_size, u32 *queue_workers);
+
 void nat_6t_l3_l4_csum_calc (nat_6t_flow_t *f);
 
 snat_static_mapping_t *nat44_ed_sm_i2o_lookup (snat_main_t *sm,
@@ -953,6 +1106,12 @@ void nat_syslog_nat44_sdel (u32 ssubix, u32 sfibix, ip4_address_t *isaddr,
 			    ip4_address_t *xdaddr, u16 xdport, u8 proto,
 			    u8 is_twicenat);
 
+void nat_syslog_nat44_pbadd (u32 sfibix, ip4_address_t *isaddr,
+			     ip4_address_t *xsaddr, u16 xsport, u16 xeport);
+
+void nat_syslog_nat44_pbdel (u32 sfibix, ip4_address_t *isaddr,
+			     ip4_address_t *xsaddr, u16 xsport, u16 xeport);
+
 typedef enum
 {
   NAT_ED_TRNSL_ERR_SUCCESS = 0,
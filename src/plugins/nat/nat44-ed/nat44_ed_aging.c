@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file
+ * @brief NAT44 endpoint-dependent clock aging
+ *
+ * With clock aging the data path only refreshes the session's last_heard
+ * timestamp and never touches the LRU lists. Expired sessions are instead
+ * found by a per-thread sweep over the session pool, run in small slices
+ * from an interrupt node so that every session is visited once per sweep
+ * period. When the session table is full, the allocating thread sweeps a
+ * bounded number of sessions looking for an expired one to recycle.
+ */
+
+#include <nat/nat44-ed/nat44_ed.h>
+#include <nat/nat44-ed/nat44_ed_inlines.h>
+
+u32
+nat44_ed_aging_sweep (snat_main_t *sm, u32 thread_index, f64 now,
+		      u32 n_visit, u32 max_expired)
+{
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+  u32 len = vec_len (tsm->sessions);
+  u32 cursor = tsm->aging_cursor;
+  u32 n_expired = 0;
+  snat_session_t *s;
+
+  if (!len)
+    return 0;
+
+  n_visit = clib_min (n_visit, len);
+  while (n_visit--)
+    {
+      if (cursor >= len)
+	cursor = 0;
+
+      if (PREDICT_TRUE (cursor + 8 < len))
+	CLIB_PREFETCH (&tsm->sessions[cursor + 8].last_heard,
+		       sizeof (f64) + sizeof (u8), LOAD);
+
+      s = tsm->sessions + cursor++;
+      if (pool_is_free (tsm->sessions, s))
+	continue;
+
+      if (now < s->last_heard + (f64) nat44_session_get_timeout (sm, s))
+	continue;
+
+      nat44_ed_free_session_data (sm, s, thread_index, 0);
+      nat_ed_session_delete (sm, s, thread_index, 0);
+      if (++n_expired >= max_expired)
+	break;
+    }
+
+  tsm->aging_cursor = cursor;
+  if (n_expired)
+    vlib_increment_simple_counter (&sm->aging_expired_sessions, thread_index,
+				   0, n_expired);
+  return n_expired;
+}
+
+/* per thread node running one sweep slice, woken up by the process node */
+static uword
+nat44_ed_aging_worker_fn (vlib_main_t *vm, vlib_node_runtime_t *rt,
+			  vlib_frame_t *f)
+{
+  snat_main_t *sm = &snat_main;
+  u32 thread_index = vm->thread_index;
+  snat_main_per_thread_data_t *tsm;
+  u32 n_visit;
+
+  if (!sm->enabled || !sm->clock_aging)
+    return 0;
+
+  tsm = &sm->per_thread_data[thread_index];
+  n_visit = vec_len (tsm->sessions) * NAT44_ED_AGING_INTERVAL /
+	    NAT44_ED_AGING_SWEEP_PERIOD;
+  n_visit = clib_max (n_visit, NAT44_ED_AGING_MIN_BATCH);
+
+  nat44_ed_aging_sweep (sm, thread_index, vlib_time_now (vm), n_visit, ~0);
+  return 0;
+}
+
+VLIB_REGISTER_NODE (nat44_ed_aging_worker_node) = {
+  .function = nat44_ed_aging_worker_fn,
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_INTERRUPT,
+  .name = "nat44-ed-aging-worker",
+};
+
+/* periodically wake up the per thread sweep nodes */
+static uword
+nat44_ed_aging_process (vlib_main_t *vm, vlib_node_runtime_t *rt,
+			vlib_frame_t *f)
+{
+  snat_main_t *sm = &snat_main;
+  uword *event_data = 0;
+  u32 ti;
+
+  while (1)
+    {
+      if (sm->enabled && sm->clock_aging)
+	vlib_process_wait_for_event_or_clock (vm, NAT44_ED_AGING_INTERVAL);
+      else
+	vlib_process_wait_for_event (vm);
+
+      vlib_process_get_events (vm, &event_data);
+      vec_reset_length (event_data);
+
+      if (!sm->enabled || !sm->clock_aging)
+	continue;
+
+      for (ti = 0; ti < vlib_get_n_threads (); ti++)
+	{
+	  if (ti >= vec_len (sm->per_thread_data))
+	    continue;
+	  vlib_node_set_interrupt_pending (vlib_get_main_by_index (ti),
+					   nat44_ed_aging_worker_node.index);
+	}
+    }
+
+  return 0;
+}
+
+VLIB_REGISTER_NODE (nat44_ed_aging_process_node) = {
+  .function = nat44_ed_aging_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "nat44-ed-aging-process",
+};
+
+void
+nat44_ed_aging_enable (vlib_main_t *vm)
+{
+  snat_main_t *sm = &snat_main;
+
+  if (sm->clock_aging)
+    vlib_process_signal_event (vm, nat44_ed_aging_process_node.index, 1, 0);
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -26,6 +26,7 @@
 #include <nat/nat44-ed/nat44_ed.h>
 #include <nat/nat44-ed/nat44_ed_inlines.h>
 #include <nat/nat44-ed/nat44_ed_affinity.h>
+#include <nat/nat44-ed/nat44_ed_ha.h>
 
 #define NAT44_ED_EXPECTED_ARGUMENT "expected required argument(s)"
 
@@ -39,6 +40,7 @@ nat44_ed_enable_disable_command_fn (vlib_main_t *vm, unformat_input_t *input,
 
   nat44_config_t c = { 0 };
   u8 enable_set = 0, enable = 0;
+  u32 port_block_size = 0, port_blocks_per_user = 0;
 
   if (!unformat_user (input, unformat_line_input, line_input))
     return clib_error_return (0, NAT44_ED_EXPECTED_ARGUMENT);
@@ -49,6 +51,13 @@ nat44_ed_enable_disable_command_fn (vlib_main_t *vm, unformat_input_t *input,
 	;
       else if (unformat (line_input, "outside-vrf %u", &c.outside_vrf));
       else if (unformat (line_input, "sessions %u", &c.sessions));
+      else if (unformat (line_input, "clock-aging"))
+	c.clock_aging = 1;
+      else if (unformat (line_input, "port-block-size %u", &port_block_size))
+	c.port_block_size = port_block_size;
+      else if (unformat (line_input, "port-blocks-per-user %u",
+			 &port_blocks_per_user))
+	c.port_blocks_per_user = port_blocks_per_user;
       else if (!enable_set)
 	{
 	  enable_set = 1;
@@ -71,6 +80,12 @@ nat44_ed_enable_disable_command_fn (vlib_main_t *vm, unformat_input_t *input,
       goto done;
     }
 
+  if (port_block_size > 0xffff || port_blocks_per_user > 0xffff)
+    {
+      error = clib_error_return (0, "invalid port block configuration");
+      goto done;
+    }
+
   if (enable)
     {
       if (sm->enabled)
@@ -436,6 +451,13 @@ nat44_show_lru_summary (vlib_main_t * vm, snat_main_per_thread_data_t * tsm,
   snat_session_t *s;
   u32 oldest_index;
 
+  if (sm->clock_aging)
+    {
+      vlib_cli_output (vm, "clock aging cursor %u/%u", tsm->aging_cursor,
+		       vec_len (tsm->sessions));
+      return;
+    }
+
   if (tsm->lru_pool)
     {
 #define _(n, d)                                                               \
@@ -606,6 +628,52 @@ nat44_show_summary_command_fn (vlib_main_t * vm, unformat_input_t * input,
   return 0;
 }
 
+static clib_error_t *
+nat44_show_port_blocks_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				   vlib_cli_command_t *cmd)
+{
+  snat_main_t *sm = &snat_main;
+  snat_main_per_thread_data_t *tsm;
+  nat44_ed_port_block_user_t *u;
+  nat44_ed_port_block_t *pb;
+  u32 *bi;
+  int i;
+
+  if (!sm->port_block_size)
+    {
+      vlib_cli_output (vm, "port block allocation disabled");
+      return 0;
+    }
+
+  vlib_cli_output (vm, "port block size %u, max %u blocks per subscriber",
+		   sm->port_block_size, sm->port_blocks_per_user);
+
+  vec_foreach_index (i, sm->per_thread_data)
+    {
+      tsm = vec_elt_at_index (sm->per_thread_data, i);
+
+      vlib_cli_output (vm, "-------- thread %d %s: %d subscribers --------",
+		       i, vlib_worker_threads[i].name,
+		       pool_elts (tsm->port_block_users));
+
+      pool_foreach (u, tsm->port_block_users)
+	{
+	  vlib_cli_output (vm, "  %U fib %u", format_ip4_address, &u->addr,
+			   u->fib_index);
+	  vec_foreach (bi, u->blocks)
+	    {
+	      pb = pool_elt_at_index (tsm->port_blocks, *bi);
+	      vlib_cli_output (vm, "    %U ports %u-%u sessions %u",
+			       format_ip4_address, &pb->addr, pb->start_port,
+			       pb->start_port + sm->port_block_size - 1,
+			       pb->n_sessions);
+	    }
+	}
+    }
+
+  return 0;
+}
+
 static clib_error_t *
 nat44_show_addresses_command_fn (vlib_main_t * vm, unformat_input_t * input,
 				 vlib_cli_command_t * cmd)
@@ -1838,6 +1906,229 @@ done:
   return error;
 }
 
+static clib_error_t *
+set_rss_port_selection_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				   vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  clib_error_t *error = 0;
+  u32 sw_if_index = ~0, reta_size = 128, w, *queue_workers = 0;
+  u8 *key = 0;
+  int enable = 1, rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, NAT44_ED_EXPECTED_ARGUMENT);
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (line_input, "key %U", unformat_hex_string, &key))
+	;
+      else if (unformat (line_input, "reta-size %u", &reta_size))
+	;
+      else if (unformat (line_input, "queue-workers %u", &w))
+	{
+	  vec_add1 (queue_workers, w);
+	  while (unformat (line_input, ",%u", &w))
+	    vec_add1 (queue_workers, w);
+	}
+      else if (unformat (line_input, "disable"))
+	enable = 0;
+      else
+	{
+	  error = clib_error_return (0, "unknown input '%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (enable && sw_if_index == ~0 && !queue_workers)
+    {
+      error = clib_error_return (0, "outside interface must be specified");
+      goto done;
+    }
+
+  rv = nat44_ed_set_rss_port_selection (enable, sw_if_index, key, reta_size,
+					queue_workers);
+  switch (rv)
+    {
+    case 0:
+      break;
+    case VNET_API_ERROR_FEATURE_DISABLED:
+      error =
+	clib_error_return (0, "Supported only if 2 or more workers available.");
+      break;
+    case VNET_API_ERROR_INVALID_VALUE:
+      error = clib_error_return (
+	0, "reta-size must be a power of 2 and the key at least 16 bytes");
+      break;
+    case VNET_API_ERROR_INVALID_WORKER:
+      error = clib_error_return (0, "invalid worker in queue-workers");
+      break;
+    default:
+      error = clib_error_return (0, "interface has no rx queues");
+      break;
+    }
+
+done:
+  vec_free (key);
+  vec_free (queue_workers);
+  unformat_free (line_input);
+  return error;
+}
+
+static clib_error_t *
+nat44_ed_ha_listener_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				 vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  ip4_address_t addr = { 0 };
+  u32 port = 0, path_mtu = 512;
+  clib_error_t *error = 0;
+  int rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, NAT44_ED_EXPECTED_ARGUMENT);
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U:%u", unformat_ip4_address, &addr, &port))
+	;
+      else if (unformat (line_input, "path-mtu %u", &path_mtu))
+	;
+      else if (unformat (line_input, "disable"))
+	port = 0;
+      else
+	{
+	  error = clib_error_return (0, "unknown input '%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (port > 0xffff)
+    {
+      error = clib_error_return (0, "invalid port %u", port);
+      goto done;
+    }
+
+  rv = nat44_ed_ha_set_listener (vm, &addr, (u16) port, path_mtu);
+  if (rv)
+    error = clib_error_return (0, "path-mtu too small");
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+static clib_error_t *
+nat44_ed_ha_failover_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				 vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  ip4_address_t addr = { 0 };
+  u32 port = 0, session_refresh_interval = 10, max_msgs_per_sec = 0;
+  clib_error_t *error = 0;
+  int rv;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return clib_error_return (0, NAT44_ED_EXPECTED_ARGUMENT);
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%U:%u", unformat_ip4_address, &addr, &port))
+	;
+      else if (unformat (line_input, "refresh-interval %u",
+			 &session_refresh_interval))
+	;
+      else if (unformat (line_input, "rate %u", &max_msgs_per_sec))
+	;
+      else if (unformat (line_input, "disable"))
+	port = 0;
+      else
+	{
+	  error = clib_error_return (0, "unknown input '%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (port > 0xffff)
+    {
+      error = clib_error_return (0, "invalid port %u", port);
+      goto done;
+    }
+
+  rv = nat44_ed_ha_set_failover (vm, &addr, (u16) port,
+				 session_refresh_interval, max_msgs_per_sec);
+  if (rv)
+    error = clib_error_return (0, "HA listener must be set first");
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+static clib_error_t *
+nat44_ed_show_ha_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			     vlib_cli_command_t *cmd)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  nat44_ed_ha_per_thread_data_t *td;
+
+  if (!ha->src_port)
+    {
+      vlib_cli_output (vm, "NAT HA disabled");
+      return 0;
+    }
+
+  vlib_cli_output (vm, "LISTENER:");
+  vlib_cli_output (vm, "  %U:%u path-mtu %u", format_ip4_address,
+		   &ha->src_ip_address, ha->src_port, ha->path_mtu);
+
+  vlib_cli_output (vm, "FAILOVER:");
+  if (!ha->dst_port)
+    {
+      vlib_cli_output (vm, "  NA");
+      return 0;
+    }
+  vlib_cli_output (vm, "  %U:%u refresh-interval %usec %s",
+		   format_ip4_address, &ha->dst_ip_address, ha->dst_port,
+		   ha->session_refresh_interval,
+		   ha->joined ? "joined" : "joining");
+  if (ha->max_msgs_per_sec)
+    vlib_cli_output (vm, "  rate %u msgs/sec per thread",
+		     ha->max_msgs_per_sec);
+
+  vlib_cli_output (vm, "THREADS:");
+  vec_foreach (td, ha->per_thread_data)
+    vlib_cli_output (vm, "  %u: queued %u resync %s",
+		     td - ha->per_thread_data, td->head - td->tail,
+		     td->resync_cursor == ~0 ? "idle" : "in progress");
+
+  return 0;
+}
+
+static clib_error_t *
+nat44_ed_ha_flush_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			      vlib_cli_command_t *cmd)
+{
+  nat44_ed_ha_flush ();
+  return 0;
+}
+
+static clib_error_t *
+nat44_ed_ha_resync_command_fn (vlib_main_t *vm, unformat_input_t *input,
+			       vlib_cli_command_t *cmd)
+{
+  if (nat44_ed_ha_resync ())
+    return clib_error_return (0, "HA failover not set");
+  return 0;
+}
+
 /*?
  * @cliexpar
  * @cliexstart{nat44}
@@ -1848,6 +2139,13 @@ done:
  *  vpp# nat44 plugin disable
  * To set inside-vrf outside-vrf, use:
  *  vpp# nat44 plugin enable inside-vrf <id> outside-vrf <id>
+ * To age sessions by a periodic sweep instead of per packet LRU list
+ * updates, use:
+ *  vpp# nat44 plugin enable clock-aging
+ * To allocate outside ports in per subscriber blocks of 512 ports, at most
+ * 4 blocks per subscriber and worker, logging only block allocation and
+ * release, use:
+ *  vpp# nat44 plugin enable port-block-size 512 port-blocks-per-user 4
  * @cliexend
 ?*/
 VLIB_CLI_COMMAND (nat44_ed_enable_disable_command, static) = {
@@ -1855,7 +2153,8 @@ VLIB_CLI_COMMAND (nat44_ed_enable_disable_command, static) = {
   .function = nat44_ed_enable_disable_command_fn,
   .short_help =
     "nat44 plugin <enable [sessions <max-number>] [inside-vrf <vrf-id>] "
-    "[outside-vrf <vrf-id>]>|disable",
+    "[outside-vrf <vrf-id>] [clock-aging] [port-block-size <n> "
+    "[port-blocks-per-user <n>]]>|disable",
 };
 
 /*?
@@ -1933,6 +2232,100 @@ VLIB_CLI_COMMAND (set_frame_queue_nelts_command, static) = {
   .short_help = "set nat frame-queue-nelts <number>",
 };
 
+/*?
+ * @cliexpar
+ * @cliexstart{set nat44 rss-port-selection}
+ * Pick outside ports of dynamic sessions so that the RSS hash the outside
+ * NIC computes over the return traffic selects an rx queue polled by the
+ * worker owning the session, so no worker handoff is needed. The key and
+ * indirection table size must match the NIC's (default: the common
+ * Microsoft key and 128 entries). The indirection table is assumed to
+ * hold the default round-robin layout, entry i pointing at rx queue
+ * i modulo the number of queues; a NIC with a custom table will steer
+ * return traffic elsewhere and it is handed off as before. The worker
+ * polling each queue is read from the interface's rx placement when the
+ * command is issued, so the command has to be repeated after moving
+ * queues, or the worker of each queue can be given with queue-workers.
+ * ICMP is hashed on addresses only and still uses handoff.
+ *  vpp# set nat44 rss-port-selection GigabitEthernet0/8/0 reta-size 512
+ *  vpp# set nat44 rss-port-selection queue-workers 0,1,2,3
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (set_rss_port_selection_command, static) = {
+  .path = "set nat44 rss-port-selection",
+  .function = set_rss_port_selection_command_fn,
+  .short_help = "set nat44 rss-port-selection <outside-interface> "
+		"[key <hex>] [reta-size <n>] [queue-workers <w0>,<w1>,...] "
+		"| disable",
+};
+
+/*?
+ * @cliexpar
+ * @cliexstart{nat44 ha listener}
+ * Set the local address and UDP port on which session state sync messages
+ * from the failover are received, and the path MTU used to batch events.
+ *  vpp# nat44 ha listener 10.0.0.1:1234 path-mtu 1500
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat44_ed_ha_listener_command, static) = {
+  .path = "nat44 ha listener",
+  .short_help =
+    "nat44 ha listener <ip4-address>:<port> [path-mtu <path-mtu>] | disable",
+  .function = nat44_ed_ha_listener_command_fn,
+};
+
+/*?
+ * @cliexpar
+ * @cliexstart{nat44 ha failover}
+ * Set the failover to which session create/refresh/delete events are sent.
+ * The failover is sent a join message and answers with a resync of its own
+ * sessions. rate limits the messages sent per second by each thread.
+ *  vpp# nat44 ha failover 10.0.0.2:1234 refresh-interval 10 rate 10000
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat44_ed_ha_failover_command, static) = {
+  .path = "nat44 ha failover",
+  .short_help = "nat44 ha failover <ip4-address>:<port> "
+		"[refresh-interval <sec>] [rate <msgs-per-sec>] | disable",
+  .function = nat44_ed_ha_failover_command_fn,
+};
+
+/*?
+ * @cliexpar
+ * @cliexstart{show nat44 ha}
+ * Show HA configuration/status
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat44_ed_show_ha_command, static) = {
+  .path = "show nat44 ha",
+  .short_help = "show nat44 ha",
+  .function = nat44_ed_show_ha_command_fn,
+};
+
+/*?
+ * @cliexpar
+ * @cliexstart{nat44 ha flush}
+ * Send the queued HA events now (for testing)
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat44_ed_ha_flush_command, static) = {
+  .path = "nat44 ha flush",
+  .short_help = "nat44 ha flush",
+  .function = nat44_ed_ha_flush_command_fn,
+};
+
+/*?
+ * @cliexpar
+ * @cliexstart{nat44 ha resync}
+ * Resend all existing sessions to the failover
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat44_ed_ha_resync_command, static) = {
+  .path = "nat44 ha resync",
+  .short_help = "nat44 ha resync",
+  .function = nat44_ed_ha_resync_command_fn,
+};
+
 /*?
  * @cliexpar
  * @cliexstart{nat set logging level}
@@ -2033,6 +2426,23 @@ VLIB_CLI_COMMAND (nat44_show_summary_command, static) = {
   .function = nat44_show_summary_command_fn,
 };
 
+/*?
+ * @cliexpar
+ * @cliexstart{show nat44 port-blocks}
+ * Show port blocks allocated to subscribers
+ * vpp# show nat44 port-blocks
+ * port block size 512, max 4 blocks per subscriber
+ * -------- thread 0 vpp_main: 1 subscribers --------
+ *   10.0.0.2 fib 0
+ *     1.2.3.4 ports 1024-1535 sessions 3
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (nat44_show_port_blocks_command, static) = {
+  .path = "show nat44 port-blocks",
+  .short_help = "show nat44 port-blocks",
+  .function = nat44_show_port_blocks_command_fn,
+};
+
 /*?
  * @cliexpar
  * @cliexstart{show nat44 addresses}
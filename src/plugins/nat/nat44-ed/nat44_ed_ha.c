@@ -0,0 +1,1012 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/udp/udp_local.h>
+#include <vppinfra/atomics.h>
+
+#include <nat/lib/log.h>
+
+#include <nat/nat44-ed/nat44_ed.h>
+#include <nat/nat44-ed/nat44_ed_ha.h>
+#include <nat/nat44-ed/nat44_ed_inlines.h>
+
+nat44_ed_ha_main_t nat44_ed_ha_main;
+
+vlib_node_registration_t nat44_ed_ha_node;
+vlib_node_registration_t nat44_ed_ha_handoff_node;
+
+static_always_inline void
+nat44_ed_ha_tuple_decode (nat_6t_t *m, nat44_ed_ha_tuple_t *t, u8 proto)
+{
+  m->saddr = t->saddr;
+  m->daddr = t->daddr;
+  m->sport = t->sport;
+  m->dport = t->dport;
+  m->fib_index = clib_net_to_host_u32 (t->fib_index);
+  m->proto = proto;
+}
+
+/* set the rewrite of flow f so that it produces the match of the reverse
+ * flow r with source and destination swapped */
+static_always_inline void
+nat44_ed_ha_flow_rewrite_set (nat_6t_flow_t *f, nat_6t_t *r, u8 is_i2o)
+{
+  if (f->match.saddr.as_u32 != r->daddr.as_u32)
+    nat_6t_flow_saddr_rewrite_set (f, r->daddr.as_u32);
+  if (f->match.daddr.as_u32 != r->saddr.as_u32)
+    nat_6t_flow_daddr_rewrite_set (f, r->saddr.as_u32);
+
+  if (IP_PROTOCOL_ICMP == f->match.proto)
+    {
+      /* the ICMP id is carried in the source port of i2o and in both ports
+       * of o2i */
+      u16 id = is_i2o ? r->dport : r->sport;
+      if (f->match.sport != id)
+	nat_6t_flow_icmp_id_rewrite_set (f, id);
+    }
+  else if (IP_PROTOCOL_TCP == f->match.proto ||
+	   IP_PROTOCOL_UDP == f->match.proto)
+    {
+      if (f->match.sport != r->dport)
+	nat_6t_flow_sport_rewrite_set (f, r->dport);
+      if (f->match.dport != r->sport)
+	nat_6t_flow_dport_rewrite_set (f, r->sport);
+    }
+
+  nat_6t_flow_txfib_rewrite_set (f, r->fib_index);
+}
+
+static_always_inline void
+nat44_ed_ha_tcp_state_set (snat_main_per_thread_data_t *tsm,
+			   snat_session_t *s, u8 tcp_state, f64 now)
+{
+  if (IP_PROTOCOL_TCP != s->proto || s->tcp_state == tcp_state)
+    return;
+
+  switch (tcp_state)
+    {
+    case NAT44_ED_TCP_STATE_ESTABLISHED:
+      s->lru_head_index = tsm->tcp_estab_lru_head_index;
+      break;
+    case NAT44_ED_TCP_STATE_CLOSING:
+      s->lru_head_index = tsm->tcp_trans_lru_head_index;
+      break;
+    case NAT44_ED_TCP_STATE_CLOSED:
+      break;
+    default:
+      return;
+    }
+  s->tcp_state = tcp_state;
+  if (snat_main.clock_aging)
+    return;
+  s->last_lru_update = now;
+  clib_dlist_remove (tsm->lru_pool, s->lru_index);
+  clib_dlist_addtail (tsm->lru_pool, s->lru_head_index, s->lru_index);
+}
+
+/* returns non-zero when the session exists, *sp is only set when it is
+ * owned by this thread */
+static_always_inline int
+nat44_ed_ha_session_lookup (snat_main_t *sm, nat_6t_t *i2o, u32 thread_index,
+			    snat_session_t **sp)
+{
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+  clib_bihash_kv_16_8_t kv, value;
+
+  *sp = 0;
+  init_ed_k (&kv, i2o->saddr.as_u32, i2o->sport, i2o->daddr.as_u32,
+	     i2o->dport, i2o->fib_index, i2o->proto);
+  if (clib_bihash_search_16_8 (&sm->flow_hash, &kv, &value))
+    return 0;
+
+  /* the session is owned by another thread, leave it alone */
+  if (ed_value_get_thread_index (&value) == thread_index)
+    *sp = pool_elt_at_index (tsm->sessions,
+			     ed_value_get_session_index (&value));
+  return 1;
+}
+
+/* free a session which did not make it into the flow hash */
+static void
+nat44_ed_ha_session_free_unhashed (snat_main_t *sm, snat_session_t *s,
+				   u32 thread_index)
+{
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+
+  if (!sm->clock_aging)
+    {
+      clib_dlist_remove (tsm->lru_pool, s->lru_index);
+      pool_put_index (tsm->lru_pool, s->lru_index);
+    }
+  pool_put (tsm->sessions, s);
+  vlib_set_simple_counter (&sm->total_sessions, thread_index, 0,
+			   pool_elts (tsm->sessions));
+}
+
+/* add or refresh session, returns non-zero on failure */
+static int
+nat44_ed_ha_recv_add (snat_main_t *sm, nat44_ed_ha_event_t *e, f64 now,
+		      u32 thread_index)
+{
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+  snat_session_t *s;
+  nat_6t_t i2o, o2i;
+
+  nat44_ed_ha_tuple_decode (&i2o, &e->i2o, e->proto);
+  nat44_ed_ha_tuple_decode (&o2i, &e->o2i, e->proto);
+
+  if (nat44_ed_ha_session_lookup (sm, &i2o, thread_index, &s))
+    {
+      if (!s)
+	return 1;
+      s->last_heard = now;
+      nat44_ed_ha_tcp_state_set (tsm, s, e->tcp_state, now);
+      nat44_session_update_lru (sm, s, thread_index);
+      return 0;
+    }
+
+  if (PREDICT_FALSE (
+	nat44_ed_maximum_sessions_exceeded (sm, i2o.fib_index, thread_index)))
+    {
+      if (!nat_lru_free_one (sm, thread_index, now))
+	return 1;
+    }
+
+  s = nat_ed_session_alloc (sm, thread_index, now, e->proto);
+
+  /* affinity and port blocks are not replicated, the session is a plain
+   * translation here */
+  s->flags = clib_net_to_host_u32 (e->flags) &
+	     ~(SNAT_SESSION_FLAG_AFFINITY | SNAT_SESSION_FLAG_PORT_BLOCK);
+  s->flags |= SNAT_SESSION_FLAG_HA_SYNCED;
+  s->proto = e->proto;
+  s->in2out.addr = i2o.saddr;
+  s->in2out.port = i2o.sport;
+  s->in2out.fib_index = i2o.fib_index;
+  s->out2in.addr = o2i.daddr;
+  s->out2in.port = o2i.dport;
+  s->out2in.fib_index = o2i.fib_index;
+  s->ext_host_addr = i2o.daddr;
+  s->ext_host_port = i2o.dport;
+  if (nat44_ed_is_twice_nat_session (s))
+    {
+      s->ext_host_nat_addr = o2i.saddr;
+      s->ext_host_nat_port = o2i.sport;
+    }
+
+  nat_6t_i2o_flow_init (sm, thread_index, s, i2o.saddr, i2o.sport, i2o.daddr,
+			i2o.dport, i2o.fib_index, e->proto);
+  nat44_ed_ha_flow_rewrite_set (&s->i2o, &o2i, 1);
+  nat_6t_o2i_flow_init (sm, thread_index, s, o2i.saddr, o2i.sport, o2i.daddr,
+			o2i.dport, o2i.fib_index, e->proto);
+  nat44_ed_ha_flow_rewrite_set (&s->o2i, &i2o, 0);
+
+  /* only remove the keys inserted here, existing ones belong to other
+   * sessions */
+  if (nat_ed_ses_i2o_flow_hash_add_del (sm, thread_index, s, 2))
+    {
+      nat44_ed_ha_session_free_unhashed (sm, s, thread_index);
+      return 1;
+    }
+  if (nat_ed_ses_o2i_flow_hash_add_del (sm, thread_index, s, 2))
+    {
+      nat_ed_ses_i2o_flow_hash_add_del (sm, thread_index, s, 0);
+      nat44_ed_ha_session_free_unhashed (sm, s, thread_index);
+      return 1;
+    }
+
+  nat44_ed_ha_tcp_state_set (tsm, s, e->tcp_state, now);
+  per_vrf_sessions_register_session (s, thread_index);
+  return 0;
+}
+
+static int
+nat44_ed_ha_recv_del (snat_main_t *sm, nat44_ed_ha_event_t *e,
+		      u32 thread_index)
+{
+  snat_session_t *s;
+  nat_6t_t i2o;
+
+  nat44_ed_ha_tuple_decode (&i2o, &e->i2o, e->proto);
+
+  nat44_ed_ha_session_lookup (sm, &i2o, thread_index, &s);
+  if (!s)
+    return 1;
+
+  nat44_ed_free_session_data (sm, s, thread_index, 1);
+  nat_ed_session_delete (sm, s, thread_index, 1);
+  return 0;
+}
+
+static_always_inline void
+nat44_ed_ha_event_process (snat_main_t *sm, nat44_ed_ha_event_t *e, f64 now,
+			   u32 thread_index)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  u32 counter;
+  int rv;
+
+  switch (e->event_type)
+    {
+    case NAT44_ED_HA_ADD:
+      counter = NAT44_ED_HA_COUNTER_RECV_ADD;
+      rv = nat44_ed_ha_recv_add (sm, e, now, thread_index);
+      break;
+    case NAT44_ED_HA_REFRESH:
+      counter = NAT44_ED_HA_COUNTER_RECV_REFRESH;
+      rv = nat44_ed_ha_recv_add (sm, e, now, thread_index);
+      break;
+    case NAT44_ED_HA_DEL:
+      counter = NAT44_ED_HA_COUNTER_RECV_DEL;
+      rv = nat44_ed_ha_recv_del (sm, e, thread_index);
+      break;
+    default:
+      counter = NAT44_ED_HA_COUNTER_RECV_FAILED;
+      rv = 0;
+      break;
+    }
+
+  vlib_increment_simple_counter (&ha->counters[counter], thread_index, 0, 1);
+  if (rv)
+    vlib_increment_simple_counter (
+      &ha->counters[NAT44_ED_HA_COUNTER_RECV_FAILED], thread_index, 0, 1);
+}
+
+static void
+nat44_ed_ha_buffer_init (vlib_buffer_t *b, u8 flags, u32 thread_index,
+			 u32 sequence_number)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  nat44_ed_ha_message_header_t *h;
+  ip4_header_t *ip;
+  udp_header_t *udp;
+
+  b->current_data = 0;
+  b->current_length = sizeof (*ip) + sizeof (*udp) + sizeof (*h);
+  b->flags |= VLIB_BUFFER_TOTAL_LENGTH_VALID;
+  b->flags |= VNET_BUFFER_F_LOCALLY_ORIGINATED;
+  vnet_buffer (b)->sw_if_index[VLIB_RX] = 0;
+  vnet_buffer (b)->sw_if_index[VLIB_TX] = 0;
+  ip = vlib_buffer_get_current (b);
+  udp = (udp_header_t *) (ip + 1);
+  h = (nat44_ed_ha_message_header_t *) (udp + 1);
+
+  clib_memset (ip, 0, sizeof (*ip));
+  ip->ip_version_and_header_length = 0x45;
+  ip->ttl = 254;
+  ip->protocol = IP_PROTOCOL_UDP;
+  ip->flags_and_fragment_offset =
+    clib_host_to_net_u16 (IP4_HEADER_FLAG_DONT_FRAGMENT);
+  ip->src_address.as_u32 = ha->src_ip_address.as_u32;
+  ip->dst_address.as_u32 = ha->dst_ip_address.as_u32;
+  udp->src_port = clib_host_to_net_u16 (ha->src_port);
+  udp->dst_port = clib_host_to_net_u16 (ha->dst_port);
+  udp->checksum = 0;
+
+  h->version = NAT44_ED_HA_VERSION;
+  h->flags = flags;
+  h->count = 0;
+  h->sequence_number = clib_host_to_net_u32 (sequence_number);
+  h->thread_index = clib_host_to_net_u32 (thread_index);
+}
+
+static void
+nat44_ed_ha_buffer_finalize (vlib_buffer_t *b)
+{
+  ip4_header_t *ip = vlib_buffer_get_current (b);
+  udp_header_t *udp = (udp_header_t *) (ip + 1);
+
+  ip->length = clib_host_to_net_u16 (b->current_length);
+  ip->checksum = ip4_header_checksum (ip);
+  udp->length = clib_host_to_net_u16 (b->current_length - sizeof (*ip));
+}
+
+/* queue add events for the next batch of existing sessions */
+static void
+nat44_ed_ha_resync_step (snat_main_t *sm, nat44_ed_ha_per_thread_data_t *td,
+			 u32 thread_index)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+  u32 n_free, n_visit = NAT44_ED_HA_RESYNC_BATCH, n_sent = 0;
+  u32 i, start = clib_atomic_load_acq_n (&td->resync_cursor);
+  snat_session_t *s;
+
+  if (PREDICT_TRUE (start == ~0))
+    return;
+
+  n_free = NAT44_ED_HA_RING_SIZE - (td->head - td->tail);
+
+  for (i = start; i < vec_len (tsm->sessions) && n_free && n_visit; i++)
+    {
+      n_visit--;
+      if (pool_is_free_index (tsm->sessions, i))
+	continue;
+      s = pool_elt_at_index (tsm->sessions, i);
+      if (na44_ed_is_fwd_bypass_session (s))
+	continue;
+      nat44_ed_ha_event_add (s, NAT44_ED_HA_ADD, thread_index);
+      n_free--;
+      n_sent++;
+    }
+
+  /* a concurrent resync request restarts the walk */
+  clib_atomic_cmp_and_swap (&td->resync_cursor, start,
+			    i < vec_len (tsm->sessions) ? i : ~0);
+  vlib_increment_simple_counter (&ha->counters[NAT44_ED_HA_COUNTER_RESYNC],
+				 thread_index, 0, n_sent);
+}
+
+/* drain the event ring into messages, within the rate limit */
+static void
+nat44_ed_ha_ring_drain (vlib_main_t *vm, nat44_ed_ha_per_thread_data_t *td,
+			u32 thread_index)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  u32 n_per_msg, n_sent[NAT44_ED_HA_REFRESH + 1] = { 0 };
+  u32 n_msgs = 0, bi, *to_next = 0;
+  vlib_frame_t *f = 0;
+  f64 now = vlib_time_now (vm);
+
+  n_per_msg = (ha->path_mtu - sizeof (ip4_header_t) - sizeof (udp_header_t) -
+	       sizeof (nat44_ed_ha_message_header_t)) /
+	      sizeof (nat44_ed_ha_event_t);
+  n_per_msg = clib_clamp (n_per_msg, 1, NAT44_ED_HA_RING_SIZE);
+
+  if (ha->max_msgs_per_sec)
+    {
+      /* allow bursts of up to 100ms worth of messages */
+      f64 burst = clib_max (ha->max_msgs_per_sec / 10.0, 1.0);
+      td->tokens += (now - td->last_refill) * ha->max_msgs_per_sec;
+      td->tokens = clib_min (td->tokens, burst);
+      td->last_refill = now;
+    }
+
+  while (td->head != td->tail)
+    {
+      nat44_ed_ha_message_header_t *h;
+      nat44_ed_ha_event_t *e;
+      vlib_buffer_t *b;
+      u32 i, n;
+
+      if (ha->max_msgs_per_sec)
+	{
+	  if (td->tokens < 1)
+	    {
+	      vlib_increment_simple_counter (
+		&ha->counters[NAT44_ED_HA_COUNTER_RATE_LIMITED], thread_index,
+		0, 1);
+	      break;
+	    }
+	  td->tokens -= 1;
+	}
+
+      if (vlib_buffer_alloc (vm, &bi, 1) != 1)
+	break;
+
+      b = vlib_get_buffer (vm, bi);
+      nat44_ed_ha_buffer_init (b, 0, thread_index, ++td->sequence_number);
+      h = vlib_buffer_get_current (b) + sizeof (ip4_header_t) +
+	  sizeof (udp_header_t);
+      e = (nat44_ed_ha_event_t *) (h + 1);
+
+      n = clib_min (td->head - td->tail, n_per_msg);
+      for (i = 0; i < n; i++)
+	{
+	  e[i] = td->ring[td->tail++ & (NAT44_ED_HA_RING_SIZE - 1)];
+	  if (e[i].event_type <= NAT44_ED_HA_REFRESH)
+	    n_sent[e[i].event_type]++;
+	}
+      h->count = clib_host_to_net_u16 (n);
+      b->current_length += n * sizeof (*e);
+      nat44_ed_ha_buffer_finalize (b);
+
+      if (!f)
+	{
+	  f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
+	  to_next = vlib_frame_vector_args (f);
+	}
+      to_next[f->n_vectors++] = bi;
+      n_msgs++;
+      if (f->n_vectors == VLIB_FRAME_SIZE)
+	{
+	  vlib_put_frame_to_node (vm, ip4_lookup_node.index, f);
+	  f = 0;
+	}
+    }
+
+  if (f)
+    vlib_put_frame_to_node (vm, ip4_lookup_node.index, f);
+
+  vlib_increment_simple_counter (&ha->counters[NAT44_ED_HA_COUNTER_SEND_MSG],
+				 thread_index, 0, n_msgs);
+  vlib_increment_simple_counter (&ha->counters[NAT44_ED_HA_COUNTER_SEND_ADD],
+				 thread_index, 0, n_sent[NAT44_ED_HA_ADD]);
+  vlib_increment_simple_counter (&ha->counters[NAT44_ED_HA_COUNTER_SEND_DEL],
+				 thread_index, 0, n_sent[NAT44_ED_HA_DEL]);
+  vlib_increment_simple_counter (
+    &ha->counters[NAT44_ED_HA_COUNTER_SEND_REFRESH], thread_index, 0,
+    n_sent[NAT44_ED_HA_REFRESH]);
+}
+
+/* per thread node draining the event ring, woken up by the process node */
+static uword
+nat44_ed_ha_worker_fn (vlib_main_t *vm, vlib_node_runtime_t *rt,
+		       vlib_frame_t *f)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  snat_main_t *sm = &snat_main;
+  u32 thread_index = vm->thread_index;
+  nat44_ed_ha_per_thread_data_t *td;
+
+  if (!ha->enabled || !sm->enabled)
+    return 0;
+
+  td = &ha->per_thread_data[thread_index];
+  nat44_ed_ha_resync_step (sm, td, thread_index);
+  nat44_ed_ha_ring_drain (vm, td, thread_index);
+  return 0;
+}
+
+VLIB_REGISTER_NODE (nat44_ed_ha_worker_node) = {
+  .function = nat44_ed_ha_worker_fn,
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_INTERRUPT,
+  .name = "nat44-ed-ha-worker",
+};
+
+static void
+nat44_ed_ha_send_join (vlib_main_t *vm)
+{
+  vlib_buffer_t *b;
+  vlib_frame_t *f;
+  u32 bi, *to_next;
+
+  if (vlib_buffer_alloc (vm, &bi, 1) != 1)
+    return;
+
+  b = vlib_get_buffer (vm, bi);
+  nat44_ed_ha_buffer_init (b, NAT44_ED_HA_FLAG_JOIN, vm->thread_index, 0);
+  nat44_ed_ha_buffer_finalize (b);
+
+  f = vlib_get_frame_to_node (vm, ip4_lookup_node.index);
+  to_next = vlib_frame_vector_args (f);
+  to_next[0] = bi;
+  f->n_vectors = 1;
+  vlib_put_frame_to_node (vm, ip4_lookup_node.index, f);
+}
+
+static void
+nat44_ed_ha_interrupt_workers (void)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  u32 ti;
+
+  for (ti = 0; ti < vlib_get_n_threads (); ti++)
+    {
+      if (ti >= vec_len (ha->per_thread_data))
+	continue;
+      vlib_node_set_interrupt_pending (vlib_get_main_by_index (ti),
+				       ha->ha_worker_node_index);
+    }
+}
+
+/* periodically wake up the per thread nodes and join the failover */
+static uword
+nat44_ed_ha_process (vlib_main_t *vm, vlib_node_runtime_t *rt,
+		     vlib_frame_t *f)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  f64 next_join = 0;
+  uword *event_data = 0;
+
+  while (1)
+    {
+      if (ha->enabled)
+	vlib_process_wait_for_event_or_clock (vm, NAT44_ED_HA_FLUSH_INTERVAL);
+      else
+	vlib_process_wait_for_event (vm);
+
+      /* any event restarts the join */
+      if (vlib_process_get_events (vm, &event_data) != ~0)
+	next_join = 0;
+      vec_reset_length (event_data);
+
+      if (!ha->enabled)
+	continue;
+
+      if (!ha->joined && vlib_time_now (vm) >= next_join)
+	{
+	  nat44_ed_ha_send_join (vm);
+	  next_join = vlib_time_now (vm) + 1.0;
+	}
+
+      nat44_ed_ha_interrupt_workers ();
+    }
+
+  return 0;
+}
+
+VLIB_REGISTER_NODE (nat44_ed_ha_process_node) = {
+  .function = nat44_ed_ha_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "nat44-ed-ha-process",
+};
+
+void
+nat44_ed_ha_init (vlib_main_t *vm, u32 num_threads)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  nat44_ed_ha_per_thread_data_t *td;
+
+  clib_memset (ha, 0, sizeof (*ha));
+
+  ha->fq_index = ~0;
+  ha->ha_node_index = nat44_ed_ha_node.index;
+  ha->ha_handoff_node_index = nat44_ed_ha_handoff_node.index;
+  ha->ha_worker_node_index = nat44_ed_ha_worker_node.index;
+  ha->ha_process_node_index = nat44_ed_ha_process_node.index;
+
+  vec_validate (ha->per_thread_data, num_threads);
+  vec_foreach (td, ha->per_thread_data)
+    {
+      vec_validate_aligned (td->ring, NAT44_ED_HA_RING_SIZE - 1,
+			    CLIB_CACHE_LINE_BYTES);
+      td->resync_cursor = ~0;
+    }
+
+#define _(N, s)                                                               \
+  ha->counters[NAT44_ED_HA_COUNTER_##N].name = s;                             \
+  ha->counters[NAT44_ED_HA_COUNTER_##N].stat_segment_name =                   \
+    "/nat44-ed/ha/" s;                                                        \
+  vlib_validate_simple_counter (&ha->counters[NAT44_ED_HA_COUNTER_##N], 0);   \
+  vlib_zero_simple_counter (&ha->counters[NAT44_ED_HA_COUNTER_##N], 0);
+  foreach_nat44_ed_ha_counter
+#undef _
+}
+
+int
+nat44_ed_ha_set_listener (vlib_main_t *vm, ip4_address_t *addr, u16 port,
+			  u32 path_mtu)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  snat_main_t *sm = &snat_main;
+
+  if (port && path_mtu < sizeof (ip4_header_t) + sizeof (udp_header_t) +
+			   sizeof (nat44_ed_ha_message_header_t) +
+			   sizeof (nat44_ed_ha_event_t))
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  if (ha->src_port)
+    udp_unregister_dst_port (vm, ha->src_port, 1);
+
+  ha->src_ip_address.as_u32 = addr->as_u32;
+  ha->src_port = port;
+  ha->path_mtu = path_mtu;
+
+  if (port)
+    {
+      /* if multiple worker threads first go to handoff node */
+      if (sm->num_workers > 1)
+	{
+	  if (ha->fq_index == ~0)
+	    ha->fq_index = vlib_frame_queue_main_init (ha->ha_node_index, 0);
+	  udp_register_dst_port (vm, port, ha->ha_handoff_node_index, 1);
+	}
+      else
+	{
+	  udp_register_dst_port (vm, port, ha->ha_node_index, 1);
+	}
+      nat_elog_info_X1 (sm, "HA listening on port %d for state sync", "i4",
+			port);
+    }
+
+  return 0;
+}
+
+int
+nat44_ed_ha_set_failover (vlib_main_t *vm, ip4_address_t *addr, u16 port,
+			  u32 session_refresh_interval, u32 max_msgs_per_sec)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  nat44_ed_ha_per_thread_data_t *td;
+
+  if (port && !ha->src_port)
+    return VNET_API_ERROR_FEATURE_DISABLED;
+
+  ha->enabled = 0;
+  ha->joined = 0;
+
+  /* let in-flight appends settle before resetting the rings */
+  vlib_worker_thread_barrier_sync (vm);
+  vec_foreach (td, ha->per_thread_data)
+    {
+      td->head = td->tail = 0;
+      td->resync_cursor = ~0;
+      td->tokens = 0;
+      td->last_refill = vlib_time_now (vm);
+    }
+  vlib_worker_thread_barrier_release (vm);
+
+  ha->dst_ip_address.as_u32 = addr->as_u32;
+  ha->dst_port = port;
+  ha->session_refresh_interval = session_refresh_interval;
+  ha->max_msgs_per_sec = max_msgs_per_sec;
+  ha->enabled = port != 0;
+
+  vlib_process_signal_event (vm, ha->ha_process_node_index, 1, 0);
+
+  return 0;
+}
+
+void
+nat44_ed_ha_disable (vlib_main_t *vm)
+{
+  ip4_address_t addr = { 0 };
+
+  nat44_ed_ha_set_failover (vm, &addr, 0, 0, 0);
+  nat44_ed_ha_set_listener (vm, &addr, 0, 0);
+}
+
+int
+nat44_ed_ha_resync (void)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  nat44_ed_ha_per_thread_data_t *td;
+
+  if (!ha->enabled)
+    return VNET_API_ERROR_FEATURE_DISABLED;
+
+  vec_foreach (td, ha->per_thread_data)
+    clib_atomic_store_rel_n (&td->resync_cursor, 0);
+
+  return 0;
+}
+
+void
+nat44_ed_ha_flush (void)
+{
+  if (nat44_ed_ha_main.enabled)
+    nat44_ed_ha_interrupt_workers ();
+}
+
+typedef struct
+{
+  ip4_address_t addr;
+  u32 event_count;
+  u32 sequence_number;
+  u8 flags;
+} nat44_ed_ha_trace_t;
+
+static u8 *
+format_nat44_ed_ha_trace (u8 *s, va_list *args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  nat44_ed_ha_trace_t *t = va_arg (*args, nat44_ed_ha_trace_t *);
+
+  s = format (s, "nat44-ed-ha: %u events seq %u flags 0x%x from %U",
+	      t->event_count, t->sequence_number, t->flags, format_ip4_address,
+	      &t->addr);
+
+  return s;
+}
+
+typedef enum
+{
+  NAT44_ED_HA_NEXT_IP4_LOOKUP,
+  NAT44_ED_HA_NEXT_DROP,
+  NAT44_ED_HA_N_NEXT,
+} nat44_ed_ha_next_t;
+
+#define foreach_nat44_ed_ha_error                                             \
+  _ (PROCESSED, "pkts-processed")                                             \
+  _ (BAD_VERSION, "bad-version")                                              \
+  _ (BAD_LENGTH, "bad-length")                                                \
+  _ (DISABLED, "nat44 plugin disabled")                                       \
+  _ (JOIN, "join received")
+
+typedef enum
+{
+#define _(sym, str) NAT44_ED_HA_ERROR_##sym,
+  foreach_nat44_ed_ha_error
+#undef _
+    NAT44_ED_HA_N_ERROR,
+} nat44_ed_ha_error_t;
+
+static char *nat44_ed_ha_error_strings[] = {
+#define _(sym, str) str,
+  foreach_nat44_ed_ha_error
+#undef _
+};
+
+/* turn a join message around into a join acknowledgement */
+static_always_inline void
+nat44_ed_ha_join_reply (vlib_buffer_t *b, ip4_header_t *ip, udp_header_t *udp,
+			nat44_ed_ha_message_header_t *h)
+{
+  u32 addr;
+  u16 port;
+
+  addr = ip->src_address.as_u32;
+  ip->src_address.as_u32 = ip->dst_address.as_u32;
+  ip->dst_address.as_u32 = addr;
+  port = udp->src_port;
+  udp->src_port = udp->dst_port;
+  udp->dst_port = port;
+  udp->checksum = 0;
+  ip->ttl = ip4_main.host_config.ttl;
+  h->flags = NAT44_ED_HA_FLAG_JOIN | NAT44_ED_HA_FLAG_ACK;
+  h->count = 0;
+
+  vlib_buffer_advance (b, (u8 *) ip - (u8 *) vlib_buffer_get_current (b));
+  b->current_length = sizeof (*ip) + sizeof (*udp) + sizeof (*h);
+  vnet_buffer (b)->sw_if_index[VLIB_TX] = ~0;
+  nat44_ed_ha_buffer_finalize (b);
+}
+
+/* process received NAT44-ED HA messages */
+static uword
+nat44_ed_ha_node_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
+		     vlib_frame_t *frame)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  nat44_ed_ha_per_thread_data_t *td;
+  snat_main_t *sm = &snat_main;
+  u32 n_left_from, *from, thread_index = vm->thread_index;
+  u32 pkts_processed = 0;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  f64 now = vlib_time_now (vm);
+
+  from = vlib_frame_vector_args (frame);
+  n_left_from = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left_from);
+  td = &ha->per_thread_data[thread_index];
+
+  while (n_left_from > 0)
+    {
+      nat44_ed_ha_message_header_t *h0;
+      nat44_ed_ha_event_t *e0;
+      ip4_header_t *ip0;
+      udp_header_t *udp0;
+      u32 count0, seq0, peer0, *expected0;
+
+      h0 = vlib_buffer_get_current (b[0]);
+      udp0 = (udp_header_t *) h0 - 1;
+      ip0 = (ip4_header_t *) (b[0]->data + vnet_buffer (b[0])->l3_hdr_offset);
+      next[0] = NAT44_ED_HA_NEXT_DROP;
+      count0 = 0;
+
+      if (PREDICT_FALSE (b[0]->current_length < sizeof (*h0)))
+	{
+	  b[0]->error = node->errors[NAT44_ED_HA_ERROR_BAD_LENGTH];
+	  goto trace0;
+	}
+
+      if (PREDICT_FALSE (h0->version != NAT44_ED_HA_VERSION))
+	{
+	  b[0]->error = node->errors[NAT44_ED_HA_ERROR_BAD_VERSION];
+	  goto trace0;
+	}
+
+      if (PREDICT_FALSE (h0->flags & NAT44_ED_HA_FLAG_JOIN))
+	{
+	  b[0]->error = node->errors[NAT44_ED_HA_ERROR_JOIN];
+	  if (h0->flags & NAT44_ED_HA_FLAG_ACK)
+	    {
+	      ha->joined = 1;
+	    }
+	  else
+	    {
+	      /* a peer (re)joined, send it everything we have */
+	      nat44_ed_ha_resync ();
+	      nat44_ed_ha_join_reply (b[0], ip0, udp0, h0);
+	      next[0] = NAT44_ED_HA_NEXT_IP4_LOOKUP;
+	    }
+	  goto trace0;
+	}
+
+      count0 = clib_net_to_host_u16 (h0->count);
+      if (PREDICT_FALSE (b[0]->current_length <
+			 sizeof (*h0) + count0 * sizeof (*e0)))
+	{
+	  b[0]->error = node->errors[NAT44_ED_HA_ERROR_BAD_LENGTH];
+	  goto trace0;
+	}
+
+      if (PREDICT_FALSE (!sm->enabled))
+	{
+	  b[0]->error = node->errors[NAT44_ED_HA_ERROR_DISABLED];
+	  goto trace0;
+	}
+
+      /* detect lost messages, lost state is repaired by later refreshes */
+      peer0 = clib_net_to_host_u32 (h0->thread_index);
+      seq0 = clib_net_to_host_u32 (h0->sequence_number);
+      vec_validate (td->peer_sequence_number, peer0);
+      expected0 = td->peer_sequence_number + peer0;
+      if (*expected0 && seq0 != *expected0)
+	vlib_increment_simple_counter (
+	  &ha->counters[NAT44_ED_HA_COUNTER_SEQ_GAP], thread_index, 0, 1);
+      *expected0 = seq0 + 1;
+
+      e0 = (nat44_ed_ha_event_t *) (h0 + 1);
+      for (u32 i = 0; i < count0; i++)
+	nat44_ed_ha_event_process (sm, e0 + i, now, thread_index);
+
+      vlib_increment_simple_counter (
+	&ha->counters[NAT44_ED_HA_COUNTER_RECV_MSG], thread_index, 0, 1);
+      b[0]->error = node->errors[NAT44_ED_HA_ERROR_PROCESSED];
+      pkts_processed++;
+
+    trace0:
+      if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE) &&
+			 (b[0]->flags & VLIB_BUFFER_IS_TRACED)))
+	{
+	  nat44_ed_ha_trace_t *t = vlib_add_trace (vm, node, b[0], sizeof (*t));
+	  t->addr.as_u32 = ip0->src_address.as_u32;
+	  t->event_count = count0;
+	  t->sequence_number = clib_net_to_host_u32 (h0->sequence_number);
+	  t->flags = h0->flags;
+	}
+
+      n_left_from--;
+      b++;
+      next++;
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
+  return frame->n_vectors;
+}
+
+VLIB_REGISTER_NODE (nat44_ed_ha_node) = {
+  .function = nat44_ed_ha_node_fn,
+  .name = "nat44-ed-ha",
+  .vector_size = sizeof (u32),
+  .format_trace = format_nat44_ed_ha_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = ARRAY_LEN (nat44_ed_ha_error_strings),
+  .error_strings = nat44_ed_ha_error_strings,
+  .n_next_nodes = NAT44_ED_HA_N_NEXT,
+  .next_nodes = {
+     [NAT44_ED_HA_NEXT_IP4_LOOKUP] = "ip4-lookup",
+     [NAT44_ED_HA_NEXT_DROP] = "error-drop",
+  },
+};
+
+typedef struct
+{
+  u32 next_worker_index;
+} nat44_ed_ha_handoff_trace_t;
+
+#define foreach_nat44_ed_ha_handoff_error                                     \
+  _ (CONGESTION_DROP, "congestion drop")                                      \
+  _ (SAME_WORKER, "same worker")                                              \
+  _ (DO_HANDOFF, "do handoff")
+
+typedef enum
+{
+#define _(sym, str) NAT44_ED_HA_HANDOFF_ERROR_##sym,
+  foreach_nat44_ed_ha_handoff_error
+#undef _
+    NAT44_ED_HA_HANDOFF_N_ERROR,
+} nat44_ed_ha_handoff_error_t;
+
+static char *nat44_ed_ha_handoff_error_strings[] = {
+#define _(sym, string) string,
+  foreach_nat44_ed_ha_handoff_error
+#undef _
+};
+
+static u8 *
+format_nat44_ed_ha_handoff_trace (u8 *s, va_list *args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  nat44_ed_ha_handoff_trace_t *t =
+    va_arg (*args, nat44_ed_ha_handoff_trace_t *);
+
+  s = format (s, "NAT44_ED_HA_WORKER_HANDOFF: next-worker %d",
+	      t->next_worker_index);
+
+  return s;
+}
+
+/* events from one peer thread always land on the same local worker, so the
+ * sessions they describe stay together */
+static uword
+nat44_ed_ha_handoff_node_fn (vlib_main_t *vm, vlib_node_runtime_t *node,
+			     vlib_frame_t *frame)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  snat_main_t *sm = &snat_main;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  u32 n_enq, n_left_from, *from;
+  u16 thread_indices[VLIB_FRAME_SIZE], *ti;
+  u32 thread_index = vm->thread_index;
+  u32 do_handoff = 0, same_worker = 0;
+
+  from = vlib_frame_vector_args (frame);
+  n_left_from = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left_from);
+
+  b = bufs;
+  ti = thread_indices;
+
+  while (n_left_from > 0)
+    {
+      nat44_ed_ha_message_header_t *h0;
+      u32 peer0;
+
+      h0 = vlib_buffer_get_current (b[0]);
+      peer0 = clib_net_to_host_u32 (h0->thread_index);
+      ti[0] = sm->first_worker_index +
+	      sm->workers[peer0 % _vec_len (sm->workers)];
+
+      if (ti[0] != thread_index)
+	do_handoff++;
+      else
+	same_worker++;
+
+      if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE) &&
+			 (b[0]->flags & VLIB_BUFFER_IS_TRACED)))
+	{
+	  nat44_ed_ha_handoff_trace_t *t =
+	    vlib_add_trace (vm, node, b[0], sizeof (*t));
+	  t->next_worker_index = ti[0];
+	}
+
+      n_left_from -= 1;
+      ti += 1;
+      b += 1;
+    }
+
+  n_enq = vlib_buffer_enqueue_to_thread (vm, node, ha->fq_index, from,
+					 thread_indices, frame->n_vectors, 1);
+
+  if (n_enq < frame->n_vectors)
+    vlib_node_increment_counter (vm, node->node_index,
+				 NAT44_ED_HA_HANDOFF_ERROR_CONGESTION_DROP,
+				 frame->n_vectors - n_enq);
+  vlib_node_increment_counter (
+    vm, node->node_index, NAT44_ED_HA_HANDOFF_ERROR_SAME_WORKER, same_worker);
+  vlib_node_increment_counter (
+    vm, node->node_index, NAT44_ED_HA_HANDOFF_ERROR_DO_HANDOFF, do_handoff);
+  return frame->n_vectors;
+}
+
+VLIB_REGISTER_NODE (nat44_ed_ha_handoff_node) = {
+  .function = nat44_ed_ha_handoff_node_fn,
+  .name = "nat44-ed-ha-handoff",
+  .vector_size = sizeof (u32),
+  .format_trace = format_nat44_ed_ha_handoff_trace,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = ARRAY_LEN (nat44_ed_ha_handoff_error_strings),
+  .error_strings = nat44_ed_ha_handoff_error_strings,
+  .n_next_nodes = 1,
+  .next_nodes = {
+    [0] = "error-drop",
+  },
+};
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file
+ * @brief NAT44 endpoint-dependent session state synchronization (HA)
+ *
+ * Session create/refresh/delete events are appended by the data path to a
+ * per-thread ring. A per-thread interrupt node drains the ring into UDP
+ * messages carrying as many events as the path MTU allows, subject to a
+ * per-thread message rate limit. A peer announces itself with a join
+ * message, which triggers a bulk resync of all existing sessions.
+ */
+
+#ifndef __included_nat44_ed_ha_h__
+#define __included_nat44_ed_ha_h__
+
+#include <nat/nat44-ed/nat44_ed.h>
+
+/* NAT44-ED HA protocol version */
+#define NAT44_ED_HA_VERSION 0x01
+
+/* NAT44-ED HA protocol flags */
+#define NAT44_ED_HA_FLAG_JOIN 0x01
+#define NAT44_ED_HA_FLAG_ACK  0x02
+
+/* per-thread event ring size, must be a power of 2 */
+#define NAT44_ED_HA_RING_SIZE (8 << 10)
+
+/* interval at which per-thread rings are drained */
+#define NAT44_ED_HA_FLUSH_INTERVAL (10e-3)
+
+/* max sessions visited by one resync step on one thread */
+#define NAT44_ED_HA_RESYNC_BATCH 1024
+
+#define foreach_nat44_ed_ha_counter                                           \
+  _ (SEND_ADD, "add-event-send")                                              \
+  _ (SEND_DEL, "del-event-send")                                              \
+  _ (SEND_REFRESH, "refresh-event-send")                                      \
+  _ (RECV_ADD, "add-event-recv")                                              \
+  _ (RECV_DEL, "del-event-recv")                                              \
+  _ (RECV_REFRESH, "refresh-event-recv")                                      \
+  _ (SEND_MSG, "msg-send")                                                    \
+  _ (RECV_MSG, "msg-recv")                                                    \
+  _ (RING_FULL, "ring-full-drop")                                             \
+  _ (RATE_LIMITED, "rate-limited")                                            \
+  _ (SEQ_GAP, "seq-gap")                                                      \
+  _ (RECV_FAILED, "recv-event-failed")                                        \
+  _ (RESYNC, "resync-event-send")
+
+typedef enum
+{
+#define _(N, s) NAT44_ED_HA_COUNTER_##N,
+  foreach_nat44_ed_ha_counter
+#undef _
+    NAT44_ED_HA_N_COUNTERS
+} nat44_ed_ha_counter_t;
+
+typedef enum
+{
+  NAT44_ED_HA_ADD = 1,
+  NAT44_ED_HA_DEL,
+  NAT44_ED_HA_REFRESH,
+} nat44_ed_ha_event_type_t;
+
+/* NAT44-ED HA protocol header */
+typedef CLIB_PACKED (struct {
+  u8 version;
+  u8 flags;
+  /* number of events following the header */
+  u16 count;
+  /* per originating thread sequence number */
+  u32 sequence_number;
+  /* thread index where events originated */
+  u32 thread_index;
+}) nat44_ed_ha_message_header_t;
+
+/* flow match tuple, addresses and ports in network byte order */
+typedef CLIB_PACKED (struct {
+  ip4_address_t saddr;
+  ip4_address_t daddr;
+  u16 sport;
+  u16 dport;
+  u32 fib_index;
+}) nat44_ed_ha_tuple_t;
+
+/* NAT44-ED HA protocol event, the translation is fully described by the
+ * match tuples of both directions, rewrites are derived from them */
+typedef CLIB_PACKED (struct {
+  u8 event_type;
+  u8 proto;
+  u8 tcp_state;
+  u8 pad;
+  u32 flags;
+  nat44_ed_ha_tuple_t i2o;
+  nat44_ed_ha_tuple_t o2i;
+}) nat44_ed_ha_event_t;
+
+STATIC_ASSERT_SIZEOF (nat44_ed_ha_event_t, 40);
+
+typedef struct
+{
+  /* event ring, written by the data path and drained by the worker node,
+   * both on the owning thread */
+  nat44_ed_ha_event_t *ring;
+  u32 head;
+  u32 tail;
+
+  /* next session pool index to resync, ~0 if no resync is pending */
+  u32 resync_cursor;
+
+  /* rate limiter */
+  f64 tokens;
+  f64 last_refill;
+
+  /* outgoing message sequence number */
+  u32 sequence_number;
+
+  /* next expected sequence number, by peer thread index */
+  u32 *peer_sequence_number;
+} nat44_ed_ha_per_thread_data_t;
+
+typedef struct
+{
+  /* 1 if events are queued and sent to the failover */
+  u8 enabled;
+  /* 1 once the failover acknowledged our join */
+  u8 joined;
+
+  /* local IP address and UDP port */
+  ip4_address_t src_ip_address;
+  u16 src_port;
+  /* failover IP address and UDP port */
+  ip4_address_t dst_ip_address;
+  u16 dst_port;
+  /* path MTU between local and failover */
+  u32 path_mtu;
+  /* number of seconds after which an active session is refreshed */
+  u32 session_refresh_interval;
+  /* max messages per second sent by one thread, 0 for unlimited */
+  u32 max_msgs_per_sec;
+
+  vlib_simple_counter_main_t counters[NAT44_ED_HA_N_COUNTERS];
+
+  nat44_ed_ha_per_thread_data_t *per_thread_data;
+
+  u32 ha_node_index;
+  u32 ha_handoff_node_index;
+  u32 ha_worker_node_index;
+  u32 ha_process_node_index;
+
+  /* worker handoff frame-queue index */
+  u32 fq_index;
+} nat44_ed_ha_main_t;
+
+extern nat44_ed_ha_main_t nat44_ed_ha_main;
+
+/**
+ * @brief Initialize NAT44-ED HA
+ */
+void nat44_ed_ha_init (vlib_main_t *vm, u32 num_threads);
+
+/**
+ * @brief Stop sending and receiving HA events
+ */
+void nat44_ed_ha_disable (vlib_main_t *vm);
+
+/**
+ * @brief Set HA listener (local settings)
+ *
+ * @param addr local IP4 address
+ * @param port local UDP port number, 0 to stop listening
+ * @param path_mtu path MTU between local and failover
+ *
+ * @returns 0 on success, non-zero value otherwise.
+ */
+int nat44_ed_ha_set_listener (vlib_main_t *vm, ip4_address_t *addr, u16 port,
+			      u32 path_mtu);
+
+/**
+ * @brief Set HA failover (remote settings)
+ *
+ * @param addr failover IP4 address
+ * @param port failover UDP port number, 0 to stop sending events
+ * @param session_refresh_interval seconds after which to refresh a session
+ * @param max_msgs_per_sec per thread message rate limit, 0 for unlimited
+ *
+ * @returns 0 on success, non-zero value otherwise.
+ */
+int nat44_ed_ha_set_failover (vlib_main_t *vm, ip4_address_t *addr, u16 port,
+			      u32 session_refresh_interval,
+			      u32 max_msgs_per_sec);
+
+/**
+ * @brief Resend all existing sessions to the failover
+ *
+ * @returns 0 on success, non-zero value otherwise.
+ */
+int nat44_ed_ha_resync (void);
+
+/**
+ * @brief Drain the event rings now instead of at the next flush interval
+ */
+void nat44_ed_ha_flush (void);
+
+static_always_inline void
+nat44_ed_ha_tuple_encode (nat44_ed_ha_tuple_t *t, nat_6t_t *m)
+{
+  t->saddr = m->saddr;
+  t->daddr = m->daddr;
+  t->sport = m->sport;
+  t->dport = m->dport;
+  t->fib_index = clib_host_to_net_u32 (m->fib_index);
+}
+
+static_always_inline void
+nat44_ed_ha_event_add (snat_session_t *s, u8 event_type, u32 thread_index)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+  nat44_ed_ha_per_thread_data_t *td = &ha->per_thread_data[thread_index];
+  nat44_ed_ha_event_t *e;
+
+  if (PREDICT_FALSE (td->head - td->tail >= NAT44_ED_HA_RING_SIZE))
+    {
+      vlib_increment_simple_counter (
+	&ha->counters[NAT44_ED_HA_COUNTER_RING_FULL], thread_index, 0, 1);
+      return;
+    }
+
+  e = td->ring + (td->head & (NAT44_ED_HA_RING_SIZE - 1));
+  e->event_type = event_type;
+  e->proto = s->proto;
+  e->tcp_state = s->tcp_state;
+  e->pad = 0;
+  e->flags = clib_host_to_net_u32 (s->flags & ~SNAT_SESSION_FLAG_HA_SYNCED);
+  nat44_ed_ha_tuple_encode (&e->i2o, &s->i2o.match);
+  nat44_ed_ha_tuple_encode (&e->o2i, &s->o2i.match);
+  td->head++;
+}
+
+/**
+ * @brief Queue session add HA event
+ */
+static_always_inline void
+nat44_ed_ha_sadd (snat_session_t *s, u32 thread_index)
+{
+  if (PREDICT_TRUE (!nat44_ed_ha_main.enabled))
+    return;
+
+  if (s->flags & SNAT_SESSION_FLAG_FWD_BYPASS)
+    return;
+
+  nat44_ed_ha_event_add (s, NAT44_ED_HA_ADD, thread_index);
+}
+
+/**
+ * @brief Queue session delete HA event
+ *
+ * Sessions learned from the failover are left to expire there on their own,
+ * so a local timeout of a session the failover still refreshes does not
+ * tear it down on the failover too.
+ */
+static_always_inline void
+nat44_ed_ha_sdel (snat_session_t *s, u32 thread_index)
+{
+  if (PREDICT_TRUE (!nat44_ed_ha_main.enabled))
+    return;
+
+  if (s->flags & (SNAT_SESSION_FLAG_FWD_BYPASS | SNAT_SESSION_FLAG_HA_SYNCED))
+    return;
+
+  nat44_ed_ha_event_add (s, NAT44_ED_HA_DEL, thread_index);
+}
+
+/**
+ * @brief Queue session refresh HA event if the refresh interval elapsed
+ */
+static_always_inline void
+nat44_ed_ha_sref (snat_session_t *s, f64 now, u32 thread_index)
+{
+  nat44_ed_ha_main_t *ha = &nat44_ed_ha_main;
+
+  if (PREDICT_TRUE (!ha->enabled))
+    return;
+
+  if (s->ha_last_refreshed + ha->session_refresh_interval > now)
+    return;
+
+  s->ha_last_refreshed = now;
+  if (s->flags & SNAT_SESSION_FLAG_FWD_BYPASS)
+    return;
+
+  nat44_ed_ha_event_add (s, NAT44_ED_HA_REFRESH, thread_index);
+}
+
+#endif /* __included_nat44_ed_ha_h__ */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
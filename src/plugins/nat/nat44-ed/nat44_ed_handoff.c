@@ -269,14 +269,50 @@ nat44_worker_handoff_fn_inline (vlib_main_t * vm,
 	}
     }
 
-  n_enq = vlib_buffer_enqueue_to_thread (vm, node, fq_index, from,
-					 thread_indices, frame->n_vectors, 1);
+  if (PREDICT_FALSE (sm->rss_port_selection) && same_worker)
+    {
+      /* packets staying on this worker skip the frame queue */
+      u32 local[VLIB_FRAME_SIZE], remote[VLIB_FRAME_SIZE];
+      u16 remote_ti[VLIB_FRAME_SIZE];
+      u32 i, n_local = 0, n_remote = 0, next;
+
+      for (i = 0; i < frame->n_vectors; i++)
+	{
+	  if (thread_indices[i] == thread_index)
+	    local[n_local++] = from[i];
+	  else
+	    {
+	      remote_ti[n_remote] = thread_indices[i];
+	      remote[n_remote++] = from[i];
+	    }
+	}
 
-  if (n_enq < frame->n_vectors)
+      if (is_in2out)
+	next = is_output ? NAT_NEXT_IN2OUT_ED_OUTPUT_FAST_PATH :
+			   NAT_NEXT_IN2OUT_ED_FAST_PATH;
+      else
+	next = NAT_NEXT_OUT2IN_ED_FAST_PATH;
+      vlib_buffer_enqueue_to_single_next (vm, node, local, next, n_local);
+
+      n_enq = n_remote ? vlib_buffer_enqueue_to_thread (
+			   vm, node, fq_index, remote, remote_ti, n_remote, 1) :
+			 0;
+      if (n_enq < n_remote)
+	vlib_node_increment_counter (vm, node->node_index,
+				     NAT44_HANDOFF_ERROR_CONGESTION_DROP,
+				     n_remote - n_enq);
+    }
+  else
     {
-      vlib_node_increment_counter (vm, node->node_index,
-				   NAT44_HANDOFF_ERROR_CONGESTION_DROP,
-				   frame->n_vectors - n_enq);
+      n_enq = vlib_buffer_enqueue_to_thread (
+	vm, node, fq_index, from, thread_indices, frame->n_vectors, 1);
+
+      if (n_enq < frame->n_vectors)
+	{
+	  vlib_node_increment_counter (vm, node->node_index,
+				       NAT44_HANDOFF_ERROR_CONGESTION_DROP,
+				       frame->n_vectors - n_enq);
+	}
     }
 
   vlib_node_increment_counter (vm, node->node_index,
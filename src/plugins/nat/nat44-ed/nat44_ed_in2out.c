@@ -102,6 +102,22 @@ nat_ed_alloc_addr_and_port_with_snat_address (
   u16 port_per_thread, u32 snat_thread_index, snat_session_t *s,
   ip4_address_t *outside_addr, u16 *outside_port)
 {
+  u32 rss_attempts = 0;
+
+  if (sm->port_block_size)
+    return nat44_ed_port_block_alloc (sm, thread_index, snat_thread_index, a,
+				      s, outside_addr, outside_port);
+
+  if (sm->rss_port_selection)
+    {
+      /* the whole range is shared, RSS decides which worker gets a port */
+      port_per_thread = 65536 - ED_USER_PORT_OFFSET;
+      snat_thread_index = 0;
+      /* icmp is hashed on addresses only, the identifier can't steer it */
+      if (IP_PROTOCOL_ICMP != proto)
+	rss_attempts = ED_RSS_PORT_ALLOC_ATTEMPTS;
+    }
+
   const u16 port_thread_offset =
     (port_per_thread * snat_thread_index) + ED_USER_PORT_OFFSET;
 
@@ -123,6 +139,17 @@ nat_ed_alloc_addr_and_port_with_snat_address (
   u16 attempts = ED_PORT_ALLOC_ATTEMPTS;
   do
     {
+      if (PREDICT_FALSE (rss_attempts) &&
+	  nat44_ed_rss_thread_index (sm, s->o2i.match.saddr,
+				     s->o2i.match.sport, a->addr,
+				     clib_host_to_net_u16 (port)) !=
+	    thread_index)
+	{
+	  --rss_attempts;
+	  port_offset = snat_random_port (0, port_per_thread - 1);
+	  port = port_thread_offset + port_offset;
+	  continue;
+	}
       if (IP_PROTOCOL_ICMP == proto)
 	{
 	  s->o2i.match.sport = clib_host_to_net_u16 (port);
@@ -599,23 +626,29 @@ slow_path_ed (vlib_main_t *vm, snat_main_t *sm, vlib_buffer_t *b,
       goto error;
     }
 
-  /* log NAT event */
-  nat_ipfix_logging_nat44_ses_create (
-    thread_index, s->in2out.addr.as_u32, s->out2in.addr.as_u32, s->proto,
-    s->in2out.port, s->out2in.port, s->in2out.fib_index);
-
-  nat_syslog_nat44_sadd (0, s->in2out.fib_index, &s->in2out.addr,
-			 s->in2out.port, &s->ext_host_nat_addr,
-			 s->ext_host_nat_port, &s->out2in.addr, s->out2in.port,
-			 &s->ext_host_addr, s->ext_host_port, s->proto, 0);
+  /* log NAT event, port block sessions are logged per block instead */
+  if (!nat44_ed_is_port_block_session (s))
+    {
+      nat_ipfix_logging_nat44_ses_create (
+	thread_index, s->in2out.addr.as_u32, s->out2in.addr.as_u32, s->proto,
+	s->in2out.port, s->out2in.port, s->in2out.fib_index);
+
+      nat_syslog_nat44_sadd (
+	0, s->in2out.fib_index, &s->in2out.addr, s->in2out.port,
+	&s->ext_host_nat_addr, s->ext_host_nat_port, &s->out2in.addr,
+	s->out2in.port, &s->ext_host_addr, s->ext_host_port, s->proto, 0);
+    }
 
   per_vrf_sessions_register_session (s, thread_index);
+  nat44_ed_ha_sadd (s, thread_index);
 
   *sessionp = s;
   return next;
 error:
   if (s)
     {
+      if (nat44_ed_is_port_block_session (s))
+	nat44_ed_port_block_unref (sm, s, thread_index);
       nat_ed_session_delete (sm, s, thread_index, 1);
     }
   *sessionp = s = NULL;
@@ -1021,6 +1054,7 @@ nat44_ed_in2out_slowpath_unknown_proto (snat_main_t *sm, vlib_buffer_t *b,
     }
 
   per_vrf_sessions_register_session (s, thread_index);
+  nat44_ed_ha_sadd (s, thread_index);
 
   /* Accounting */
   nat44_session_update_counters (s, now, vlib_buffer_length_in_chain (vm, b),
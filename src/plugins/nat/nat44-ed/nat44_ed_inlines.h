@@ -27,6 +27,7 @@
 #include <nat/lib/log.h>
 #include <nat/lib/ipfix_logging.h>
 #include <nat/nat44-ed/nat44_ed.h>
+#include <nat/nat44-ed/nat44_ed_ha.h>
 
 always_inline void
 init_ed_k (clib_bihash_kv_16_8_t *kv, u32 l_addr, u16 l_port, u32 r_addr,
@@ -117,6 +118,26 @@ split_ed_kv (clib_bihash_kv_16_8_t *kv, ip4_address_t *l_addr,
     }
 }
 
+/* worker that the outside NIC's RSS steers a packet with this 4-tuple to,
+ * addresses and ports in network byte order */
+static_always_inline u32
+nat44_ed_rss_thread_index (snat_main_t *sm, ip4_address_t saddr, u16 sport,
+			   ip4_address_t daddr, u16 dport)
+{
+  u8 data[12];
+  u32 hash, queue;
+
+  clib_memcpy_fast (data, &saddr, 4);
+  clib_memcpy_fast (data + 4, &daddr, 4);
+  clib_memcpy_fast (data + 8, &sport, 2);
+  clib_memcpy_fast (data + 10, &dport, 2);
+
+  hash = clib_toeplitz_hash (sm->rss_key, data, sizeof (data));
+  queue = (hash & (sm->rss_reta_size - 1)) % vec_len (sm->rss_thread_by_queue);
+
+  return sm->rss_thread_by_queue[queue];
+}
+
 static_always_inline int
 nat_get_icmp_session_lookup_values (vlib_buffer_t *b, ip4_header_t *ip0,
 				    ip4_address_t *lookup_saddr,
@@ -317,11 +338,14 @@ nat_ed_session_delete (snat_main_t *sm, snat_session_t *ses, u32 thread_index,
   snat_main_per_thread_data_t *tsm =
     vec_elt_at_index (sm->per_thread_data, thread_index);
 
-  if (lru_delete)
+  if (!sm->clock_aging)
     {
-      clib_dlist_remove (tsm->lru_pool, ses->lru_index);
+      if (lru_delete)
+	{
+	  clib_dlist_remove (tsm->lru_pool, ses->lru_index);
+	}
+      pool_put_index (tsm->lru_pool, ses->lru_index);
     }
-  pool_put_index (tsm->lru_pool, ses->lru_index);
   if (nat_ed_ses_i2o_flow_hash_add_del (sm, thread_index, ses, 0))
     nat_elog_warn (sm, "flow hash del failed");
   if (nat_ed_ses_o2i_flow_hash_add_del (sm, thread_index, ses, 0))
@@ -367,6 +391,11 @@ nat_lru_free_one (snat_main_t *sm, int thread_index, f64 now)
 {
   snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
   int rc = 0;
+
+  if (sm->clock_aging)
+    return nat44_ed_aging_sweep (sm, thread_index, now,
+				 NAT44_ED_AGING_ALLOC_BATCH, 1);
+
 #define _(p)                                                                  \
   if ((rc = nat_lru_free_one_with_head (sm, thread_index, now,                \
 					tsm->p##_lru_head_index)))            \
@@ -388,12 +417,17 @@ nat_ed_session_alloc (snat_main_t *sm, u32 thread_index, f64 now, u8 proto)
   snat_session_t *s;
   snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
 
-  nat_lru_free_one (sm, thread_index, now);
+  /* with clock aging expired sessions are reclaimed by the sweep */
+  if (!sm->clock_aging)
+    nat_lru_free_one (sm, thread_index, now);
 
   pool_get (tsm->sessions, s);
   clib_memset (s, 0, sizeof (*s));
 
-  nat_ed_lru_insert (tsm, s, now, proto);
+  if (sm->clock_aging)
+    s->lru_index = ~0;
+  else
+    nat_ed_lru_insert (tsm, s, now, proto);
 
   s->ha_last_refreshed = now;
   vlib_set_simple_counter (&sm->total_sessions, thread_index, 0,
@@ -786,7 +820,7 @@ nat44_set_tcp_session_state (snat_main_t *sm, f64 now, snat_session_t *ses,
 	}
       break;
     }
-  if (old_state == ses->tcp_state)
+  if (old_state == ses->tcp_state || sm->clock_aging)
     return;
   ses->last_lru_update = now;
   clib_dlist_remove (tsm->lru_pool, ses->lru_index);
@@ -817,12 +851,17 @@ nat44_session_update_counters (snat_session_t *s, f64 now, uword bytes,
   s->last_heard = now;
   s->total_pkts++;
   s->total_bytes += bytes;
+  nat44_ed_ha_sref (s, now, thread_index);
 }
 
 /** \brief Per-user LRU list maintenance */
 always_inline void
 nat44_session_update_lru (snat_main_t *sm, snat_session_t *s, u32 thread_index)
 {
+  /* the clock aging sweep only looks at last_heard */
+  if (sm->clock_aging)
+    return;
+
   /* don't update too often - timeout is in magnitude of seconds anyway */
   if (s->last_heard > s->last_lru_update + 1)
     {
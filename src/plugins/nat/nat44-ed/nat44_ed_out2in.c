@@ -552,6 +552,7 @@ create_session_for_static_mapping_ed (
 			 nat44_ed_is_twice_nat_session (s));
 
   per_vrf_sessions_register_session (s, thread_index);
+  nat44_ed_ha_sadd (s, thread_index);
 
   return s;
 }
@@ -645,6 +646,7 @@ create_bypass_for_fwd (snat_main_t *sm, vlib_buffer_t *b, snat_session_t *s,
 	}
 
       per_vrf_sessions_register_session (s, thread_index);
+      nat44_ed_ha_sadd (s, thread_index);
     }
 
   if (ip->protocol == IP_PROTOCOL_TCP)
@@ -724,6 +726,7 @@ nat44_ed_out2in_slowpath_unknown_proto (snat_main_t *sm, vlib_buffer_t *b,
     }
 
   per_vrf_sessions_register_session (s, thread_index);
+  nat44_ed_ha_sadd (s, thread_index);
 
   /* Accounting */
   nat44_session_update_counters (s, now, vlib_buffer_length_in_chain (vm, b),
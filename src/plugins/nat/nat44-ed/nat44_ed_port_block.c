@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2026 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ * @file
+ * @brief NAT44 endpoint-dependent port block allocation
+ *
+ * Outside ports are handed out to subscribers (inside address and fib) in
+ * blocks of consecutive ports carved from the thread's port range, in the
+ * spirit of RFC 7422. Sessions pick their port inside one of the
+ * subscriber's blocks, a new block is only allocated when none of them has
+ * a usable port, and a block is released with its last session. Only block
+ * allocation and release are logged, which is enough to map an outside
+ * address and port back to a subscriber.
+ */
+
+#include <nat/nat44-ed/nat44_ed.h>
+#include <nat/nat44-ed/nat44_ed_inlines.h>
+
+static_always_inline uword
+nat44_ed_port_block_user_key (ip4_address_t addr, u32 fib_index)
+{
+  return (u64) fib_index << 32 | addr.as_u32;
+}
+
+static nat44_ed_port_block_user_t *
+nat44_ed_port_block_user_get (snat_main_per_thread_data_t *tsm,
+			      ip4_address_t addr, u32 fib_index)
+{
+  nat44_ed_port_block_user_t *u;
+  uword key, *p;
+
+  key = nat44_ed_port_block_user_key (addr, fib_index);
+  p = hash_get (tsm->port_block_user_by_key, key);
+  if (p)
+    return pool_elt_at_index (tsm->port_block_users, p[0]);
+
+  pool_get_zero (tsm->port_block_users, u);
+  u->addr = addr;
+  u->fib_index = fib_index;
+  hash_set (tsm->port_block_user_by_key, key, u - tsm->port_block_users);
+  return u;
+}
+
+static void
+nat44_ed_port_block_user_put (snat_main_per_thread_data_t *tsm,
+			      nat44_ed_port_block_user_t *u)
+{
+  hash_unset (tsm->port_block_user_by_key,
+	      nat44_ed_port_block_user_key (u->addr, u->fib_index));
+  vec_free (u->blocks);
+  pool_put (tsm->port_block_users, u);
+}
+
+static nat44_ed_port_block_t *
+nat44_ed_port_block_new (snat_main_t *sm, snat_main_per_thread_data_t *tsm,
+			 u32 thread_index, u32 snat_thread_index,
+			 snat_address_t *a, nat44_ed_port_block_user_t *u)
+{
+  u32 n_blocks = sm->port_per_thread / sm->port_block_size;
+  nat44_ed_port_block_t *pb;
+  uword *bitmap;
+  u32 bit;
+
+  bitmap = a->busy_port_blocks[thread_index];
+  bit = clib_bitmap_first_clear (bitmap);
+  if (bit >= n_blocks)
+    return 0;
+  a->busy_port_blocks[thread_index] = clib_bitmap_set (bitmap, bit, 1);
+
+  pool_get_zero (tsm->port_blocks, pb);
+  pb->addr = a->addr;
+  pb->bit = bit;
+  pb->start_port = ED_USER_PORT_OFFSET +
+		   sm->port_per_thread * snat_thread_index +
+		   bit * sm->port_block_size;
+  pb->user_index = u - tsm->port_block_users;
+  vec_add1 (u->blocks, pb - tsm->port_blocks);
+
+  vlib_increment_simple_counter (&sm->port_blocks_allocated, thread_index, 0,
+				 1);
+  nat_syslog_nat44_pbadd (u->fib_index, &u->addr, &pb->addr, pb->start_port,
+			  pb->start_port + sm->port_block_size - 1);
+  return pb;
+}
+
+static void
+nat44_ed_port_block_release (snat_main_t *sm, snat_main_per_thread_data_t *tsm,
+			     u32 thread_index, nat44_ed_port_block_t *pb)
+{
+  nat44_ed_port_block_user_t *u;
+  snat_address_t *a;
+  u32 i;
+
+  vec_foreach (a, sm->addresses)
+    {
+      if (a->addr.as_u32 == pb->addr.as_u32)
+	{
+	  a->busy_port_blocks[thread_index] =
+	    clib_bitmap_set (a->busy_port_blocks[thread_index], pb->bit, 0);
+	  break;
+	}
+    }
+
+  u = pool_elt_at_index (tsm->port_block_users, pb->user_index);
+  vlib_increment_simple_counter (&sm->port_blocks_released, thread_index, 0,
+				 1);
+  nat_syslog_nat44_pbdel (u->fib_index, &u->addr, &pb->addr, pb->start_port,
+			  pb->start_port + sm->port_block_size - 1);
+
+  i = vec_search (u->blocks, pb - tsm->port_blocks);
+  ASSERT (i != ~0);
+  vec_delete (u->blocks, 1, i);
+  if (!vec_len (u->blocks))
+    nat44_ed_port_block_user_put (tsm, u);
+
+  pool_put (tsm->port_blocks, pb);
+}
+
+/* probe consecutive ports of the block, starting at the offset hint */
+static int
+nat44_ed_port_block_try (snat_main_t *sm, u32 thread_index,
+			 nat44_ed_port_block_t *pb, snat_session_t *s,
+			 u16 offset, u16 *port)
+{
+  u16 attempts =
+    clib_min (sm->port_block_size, ED_PORT_BLOCK_ALLOC_ATTEMPTS);
+
+  offset %= sm->port_block_size;
+  do
+    {
+      *port = pb->start_port + offset;
+      if (IP_PROTOCOL_ICMP == s->proto)
+	s->o2i.match.sport = clib_host_to_net_u16 (*port);
+      s->o2i.match.dport = clib_host_to_net_u16 (*port);
+      if (0 == nat_ed_ses_o2i_flow_hash_add_del (sm, thread_index, s, 2))
+	return 0;
+      offset = (offset + 1) % sm->port_block_size;
+    }
+  while (--attempts);
+
+  return 1;
+}
+
+int
+nat44_ed_port_block_alloc (snat_main_t *sm, u32 thread_index,
+			   u32 snat_thread_index, snat_address_t *a,
+			   snat_session_t *s, ip4_address_t *outside_addr,
+			   u16 *outside_port)
+{
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+  u16 hint = clib_net_to_host_u16 (*outside_port);
+  nat44_ed_port_block_user_t *u;
+  nat44_ed_port_block_t *pb;
+  u16 port;
+  int i;
+
+  /* Backup original match in case of failure */
+  const nat_6t_t match = s->o2i.match;
+
+  s->o2i.match.daddr = a->addr;
+
+  u = nat44_ed_port_block_user_get (tsm, s->in2out.addr,
+				    s->in2out.fib_index);
+
+  /* most recently allocated blocks are the least used ones */
+  for (i = vec_len (u->blocks) - 1; i >= 0; i--)
+    {
+      pb = pool_elt_at_index (tsm->port_blocks, u->blocks[i]);
+      if (pb->addr.as_u32 != a->addr.as_u32)
+	continue;
+      if (!nat44_ed_port_block_try (sm, thread_index, pb, s, hint, &port))
+	goto done;
+    }
+
+  if (vec_len (u->blocks) >= sm->port_blocks_per_user)
+    goto fail;
+
+  pb = nat44_ed_port_block_new (sm, tsm, thread_index, snat_thread_index, a,
+				u);
+  if (!pb)
+    goto fail;
+
+  if (nat44_ed_port_block_try (sm, thread_index, pb, s, hint, &port))
+    {
+      nat44_ed_port_block_release (sm, tsm, thread_index, pb);
+      s->o2i.match = match;
+      return 1;
+    }
+
+done:
+  pb->n_sessions++;
+  s->flags |= SNAT_SESSION_FLAG_PORT_BLOCK;
+  s->port_block_index = pb - tsm->port_blocks;
+  *outside_addr = a->addr;
+  *outside_port = clib_host_to_net_u16 (port);
+  return 0;
+
+fail:
+  if (!vec_len (u->blocks))
+    nat44_ed_port_block_user_put (tsm, u);
+  /* Revert match */
+  s->o2i.match = match;
+  return 1;
+}
+
+void
+nat44_ed_port_block_unref (snat_main_t *sm, snat_session_t *s,
+			   u32 thread_index)
+{
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+  nat44_ed_port_block_t *pb;
+
+  pb = pool_elt_at_index (tsm->port_blocks, s->port_block_index);
+  s->flags &= ~SNAT_SESSION_FLAG_PORT_BLOCK;
+
+  ASSERT (pb->n_sessions > 0);
+  if (--pb->n_sessions == 0)
+    nat44_ed_port_block_release (sm, tsm, thread_index, pb);
+}
+
+void
+nat44_ed_port_block_db_init (snat_main_per_thread_data_t *tsm)
+{
+  tsm->port_blocks = 0;
+  tsm->port_block_users = 0;
+  tsm->port_block_user_by_key = hash_create (0, sizeof (uword));
+}
+
+void
+nat44_ed_port_block_db_free (snat_main_per_thread_data_t *tsm)
+{
+  nat44_ed_port_block_user_t *u;
+
+  pool_foreach (u, tsm->port_block_users)
+    vec_free (u->blocks);
+  pool_free (tsm->port_block_users);
+  pool_free (tsm->port_blocks);
+  hash_free (tsm->port_block_user_by_key);
+}
+
+void
+nat44_ed_port_block_address_reset (snat_address_t *a)
+{
+  uword **bitmap;
+
+  vec_foreach (bitmap, a->busy_port_blocks)
+    clib_bitmap_free (*bitmap);
+}
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -567,15 +567,10 @@ nat64_db_st_entry_free (u32 thread_index,
     nat64_db_bib_entry_free (thread_index, db, bibe);
 }
 
-nat64_db_st_entry_t *
-nat64_db_st_entry_find (nat64_db_t * db, ip46_address_t * l_addr,
-			ip46_address_t * r_addr, u16 l_port, u16 r_port,
-			u8 proto, u32 fib_index, u8 is_ip6)
+static_always_inline nat64_db_st_entry_t *
+nat64_db_st_entry_by_value (nat64_db_t *db, u8 proto, u64 value)
 {
-  nat64_db_st_entry_t *ste = 0;
   nat64_db_st_entry_t *st;
-  nat64_db_st_entry_key_t ste_key;
-  clib_bihash_kv_48_8_t kv, value;
 
   switch (ip_proto_to_nat_proto (proto))
     {
@@ -592,27 +587,36 @@ nat64_db_st_entry_find (nat64_db_t * db, ip46_address_t * l_addr,
       break;
     }
 
-  clib_memset (&ste_key, 0, sizeof (ste_key));
-  ste_key.l_addr.as_u64[0] = l_addr->as_u64[0];
-  ste_key.l_addr.as_u64[1] = l_addr->as_u64[1];
-  ste_key.r_addr.as_u64[0] = r_addr->as_u64[0];
-  ste_key.r_addr.as_u64[1] = r_addr->as_u64[1];
-  ste_key.fib_index = fib_index;
-  ste_key.l_port = l_port;
-  ste_key.r_port = r_port;
-  ste_key.proto = proto;
-  kv.key[0] = ste_key.as_u64[0];
-  kv.key[1] = ste_key.as_u64[1];
-  kv.key[2] = ste_key.as_u64[2];
-  kv.key[3] = ste_key.as_u64[3];
-  kv.key[4] = ste_key.as_u64[4];
-  kv.key[5] = ste_key.as_u64[5];
+  return pool_elt_at_index (st, value);
+}
 
-  if (!clib_bihash_search_48_8
-      (is_ip6 ? &db->st.in2out : &db->st.out2in, &kv, &value))
-    ste = pool_elt_at_index (st, value.value);
+nat64_db_st_entry_t *
+nat64_db_st_entry_find (nat64_db_t * db, ip46_address_t * l_addr,
+			ip46_address_t * r_addr, u16 l_port, u16 r_port,
+			u8 proto, u32 fib_index, u8 is_ip6)
+{
+  clib_bihash_kv_48_8_t kv;
 
-  return ste;
+  nat64_db_st_entry_make_kv (&kv, l_addr, r_addr, l_port, r_port, proto,
+			     fib_index);
+
+  return nat64_db_st_entry_find_with_hash (db, &kv,
+					   clib_bihash_hash_48_8 (&kv),
+					   is_ip6);
+}
+
+nat64_db_st_entry_t *
+nat64_db_st_entry_find_with_hash (nat64_db_t *db, clib_bihash_kv_48_8_t *kv,
+				  u64 hash, u8 is_ip6)
+{
+  nat64_db_st_entry_key_t *key = (nat64_db_st_entry_key_t *) kv->key;
+  clib_bihash_kv_48_8_t value;
+
+  if (clib_bihash_search_inline_2_with_hash_48_8 (
+	is_ip6 ? &db->st.in2out : &db->st.out2in, hash, kv, &value))
+    return 0;
+
+  return nat64_db_st_entry_by_value (db, key->proto, value.value);
 }
 
 u32
@@ -308,6 +308,66 @@ nat64_db_st_entry_t *nat64_db_st_entry_find (nat64_db_t * db,
 					     u8 proto,
 					     u32 fib_index, u8 is_ip6);
 
+/**
+ * @brief Build NAT64 session table lookup key.
+ *
+ * @param kv Bihash key-value to fill.
+ * @param l_addr Local host address.
+ * @param r_addr Remote host address.
+ * @param l_port Local host port number.
+ * @param r_port Remote host port number.
+ * @param proto L4 protocol.
+ * @param fib_index FIB index.
+ */
+static_always_inline void
+nat64_db_st_entry_make_kv (clib_bihash_kv_48_8_t *kv, ip46_address_t *l_addr,
+			   ip46_address_t *r_addr, u16 l_port, u16 r_port,
+			   u8 proto, u32 fib_index)
+{
+  nat64_db_st_entry_key_t *key = (nat64_db_st_entry_key_t *) kv->key;
+
+  key->l_addr.as_u64[0] = l_addr->as_u64[0];
+  key->l_addr.as_u64[1] = l_addr->as_u64[1];
+  key->r_addr.as_u64[0] = r_addr->as_u64[0];
+  key->r_addr.as_u64[1] = r_addr->as_u64[1];
+  key->as_u64[5] = 0;
+  key->fib_index = fib_index;
+  key->l_port = l_port;
+  key->r_port = r_port;
+  key->proto = proto;
+}
+
+/**
+ * @brief Find NAT64 session table entry by key with precomputed hash.
+ *
+ * Lets the data path compute the hash and prefetch the bucket ahead of the
+ * lookup (see nat64_db_st_prefetch_bucket).
+ *
+ * @param db NAT64 DB.
+ * @param kv Lookup key built by nat64_db_st_entry_make_kv.
+ * @param hash Hash of the key.
+ * @param is_ip6 1 if find by IPv6 (inside) address, 0 by IPv4 (outside).
+ *
+ * @return session table entry if found.
+ */
+nat64_db_st_entry_t *nat64_db_st_entry_find_with_hash (nat64_db_t *db,
+						       clib_bihash_kv_48_8_t *kv,
+						       u64 hash, u8 is_ip6);
+
+/**
+ * @brief Prefetch NAT64 session table bucket for given key hash.
+ *
+ * @param db NAT64 DB.
+ * @param hash Hash of the key.
+ * @param is_ip6 1 for IPv6 (inside) lookup table, 0 for IPv4 (outside).
+ */
+static_always_inline void
+nat64_db_st_prefetch_bucket (nat64_db_t *db, u64 hash, u8 is_ip6)
+{
+  clib_bihash_prefetch_bucket_48_8 (is_ip6 ? &db->st.in2out : &db->st.out2in,
+				    hash);
+}
+
 /**
  * @brief Call back function when walking NAT64 session table, non-zero
  * return value stop walk.
@@ -76,6 +76,7 @@ typedef struct nat64_in2out_set_ctx_t_
   vlib_buffer_t *b;
   vlib_main_t *vm;
   u32 thread_index;
+  u64 st_hash;
 } nat64_in2out_set_ctx_t;
 
 static inline u8
@@ -138,6 +139,7 @@ nat64_in2out_tcp_udp (vlib_main_t * vm, vlib_buffer_t * p, u16 l4_offset,
   nat64_db_st_entry_t *ste;
   ip46_address_t old_saddr, old_daddr;
   ip4_address_t new_daddr;
+  clib_bihash_kv_48_8_t kv;
   u32 sw_if_index, fib_index;
   u8 proto = vnet_buffer (p)->ip.reass.ip_proto;
   u16 sport = vnet_buffer (p)->ip.reass.l4_src_port;
@@ -191,9 +193,9 @@ nat64_in2out_tcp_udp (vlib_main_t * vm, vlib_buffer_t * p, u16 l4_offset,
   fib_index =
     fib_table_get_index_for_sw_if_index (FIB_PROTOCOL_IP6, sw_if_index);
 
-  ste =
-    nat64_db_st_entry_find (db, &old_saddr, &old_daddr, sport, dport, proto,
-			    fib_index, 1);
+  nat64_db_st_entry_make_kv (&kv, &old_saddr, &old_daddr, sport, dport,
+			     proto, fib_index);
+  ste = nat64_db_st_entry_find_with_hash (db, &kv, ctx->st_hash, 1);
 
   if (ste)
     {
@@ -1025,6 +1027,51 @@ nat64_in2out_unk_proto_hairpinning (vlib_main_t * vm, vlib_buffer_t * b,
   return 0;
 }
 
+/**
+ * Compute session table hashes of TCP/UDP packets in the frame and prefetch
+ * their buckets, so that the lookups done while translating hit the cache.
+ */
+static_always_inline void
+nat64_in2out_st_prefetch (vlib_main_t *vm, nat64_db_t *db, u32 *from,
+			  u32 n_left, u64 *hashes)
+{
+  clib_bihash_kv_48_8_t kv;
+  vlib_buffer_t *b;
+  ip6_header_t *ip6;
+  u32 fib_index;
+  u8 proto;
+
+  while (n_left > 0)
+    {
+      if (n_left > 2)
+	{
+	  vlib_buffer_t *p2 = vlib_get_buffer (vm, from[2]);
+	  vlib_prefetch_buffer_header (p2, LOAD);
+	  CLIB_PREFETCH (p2->data, CLIB_CACHE_LINE_BYTES, LOAD);
+	}
+
+      b = vlib_get_buffer (vm, from[0]);
+      proto = vnet_buffer (b)->ip.reass.ip_proto;
+      if (proto == IP_PROTOCOL_TCP || proto == IP_PROTOCOL_UDP)
+	{
+	  ip6 = vlib_buffer_get_current (b);
+	  fib_index = fib_table_get_index_for_sw_if_index (
+	    FIB_PROTOCOL_IP6, vnet_buffer (b)->sw_if_index[VLIB_RX]);
+	  nat64_db_st_entry_make_kv (
+	    &kv, (ip46_address_t *) &ip6->src_address,
+	    (ip46_address_t *) &ip6->dst_address,
+	    vnet_buffer (b)->ip.reass.l4_src_port,
+	    vnet_buffer (b)->ip.reass.l4_dst_port, proto, fib_index);
+	  hashes[0] = clib_bihash_hash_48_8 (&kv);
+	  nat64_db_st_prefetch_bucket (db, hashes[0], 1);
+	}
+
+      from += 1;
+      hashes += 1;
+      n_left -= 1;
+    }
+}
+
 static inline uword
 nat64_in2out_node_fn_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			     vlib_frame_t * frame, u8 is_slow_path)
@@ -1033,11 +1080,16 @@ nat64_in2out_node_fn_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   nat64_in2out_next_t next_index;
   u32 thread_index = vm->thread_index;
   nat64_main_t *nm = &nat64_main;
+  u64 hashes[VLIB_FRAME_SIZE], *hash = hashes;
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
   next_index = node->cached_next_index;
 
+  if (!is_slow_path)
+    nat64_in2out_st_prefetch (vm, &nm->db[thread_index], from, n_left_from,
+			      hashes);
+
   while (n_left_from > 0)
     {
       u32 n_left_to_next;
@@ -1072,6 +1124,8 @@ nat64_in2out_node_fn_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  ctx0.b = b0;
 	  ctx0.vm = vm;
 	  ctx0.thread_index = thread_index;
+	  ctx0.st_hash = hash[0];
+	  hash += 1;
 
 	  next0 = NAT64_IN2OUT_NEXT_IP4_LOOKUP;
 
@@ -70,6 +70,7 @@ typedef struct nat64_out2in_set_ctx_t_
   vlib_buffer_t *b;
   vlib_main_t *vm;
   u32 thread_index;
+  u64 st_hash;
 } nat64_out2in_set_ctx_t;
 
 static int
@@ -90,6 +91,7 @@ nat64_out2in_tcp_udp (vlib_main_t * vm, vlib_buffer_t * b,
   ip46_address_t saddr;
   ip46_address_t daddr;
   ip6_address_t ip6_saddr;
+  clib_bihash_kv_48_8_t kv;
   u8 proto = vnet_buffer (b)->ip.reass.ip_proto;
   u16 dport = vnet_buffer (b)->ip.reass.l4_dst_port;
   u16 sport = vnet_buffer (b)->ip.reass.l4_src_port;
@@ -165,9 +167,9 @@ nat64_out2in_tcp_udp (vlib_main_t * vm, vlib_buffer_t * b,
   clib_memset (&daddr, 0, sizeof (daddr));
   daddr.ip4.as_u32 = ip4->dst_address.as_u32;
 
-  ste =
-    nat64_db_st_entry_find (db, &daddr, &saddr, dport, sport, proto,
-			    fib_index, 0);
+  nat64_db_st_entry_make_kv (&kv, &daddr, &saddr, dport, sport, proto,
+			     fib_index);
+  ste = nat64_db_st_entry_find_with_hash (db, &kv, ctx->st_hash, 0);
   if (ste)
     {
       bibe = nat64_db_bib_entry_by_index (db, proto, ste->bibe_index);
@@ -512,6 +514,56 @@ nat64_out2in_unk_proto (vlib_main_t * vm, vlib_buffer_t * p,
   return 0;
 }
 
+/**
+ * Compute session table hashes of TCP/UDP packets in the frame and prefetch
+ * their buckets, so that the lookups done while translating hit the cache.
+ */
+static_always_inline void
+nat64_out2in_st_prefetch (vlib_main_t *vm, nat64_db_t *db, u32 *from,
+			  u32 n_left, u64 *hashes)
+{
+  ip46_address_t saddr, daddr;
+  clib_bihash_kv_48_8_t kv;
+  vlib_buffer_t *b;
+  ip4_header_t *ip4;
+  u32 fib_index;
+  u8 proto;
+
+  clib_memset (&saddr, 0, sizeof (saddr));
+  clib_memset (&daddr, 0, sizeof (daddr));
+
+  while (n_left > 0)
+    {
+      if (n_left > 2)
+	{
+	  vlib_buffer_t *p2 = vlib_get_buffer (vm, from[2]);
+	  vlib_prefetch_buffer_header (p2, LOAD);
+	  CLIB_PREFETCH (p2->data, CLIB_CACHE_LINE_BYTES, LOAD);
+	}
+
+      b = vlib_get_buffer (vm, from[0]);
+      proto = vnet_buffer (b)->ip.reass.ip_proto;
+      if (proto == IP_PROTOCOL_TCP || proto == IP_PROTOCOL_UDP)
+	{
+	  ip4 = vlib_buffer_get_current (b);
+	  fib_index = ip4_fib_table_get_index_for_sw_if_index (
+	    vnet_buffer (b)->sw_if_index[VLIB_RX]);
+	  saddr.ip4.as_u32 = ip4->src_address.as_u32;
+	  daddr.ip4.as_u32 = ip4->dst_address.as_u32;
+	  nat64_db_st_entry_make_kv (&kv, &daddr, &saddr,
+				     vnet_buffer (b)->ip.reass.l4_dst_port,
+				     vnet_buffer (b)->ip.reass.l4_src_port,
+				     proto, fib_index);
+	  hashes[0] = clib_bihash_hash_48_8 (&kv);
+	  nat64_db_st_prefetch_bucket (db, hashes[0], 0);
+	}
+
+      from += 1;
+      hashes += 1;
+      n_left -= 1;
+    }
+}
+
 VLIB_NODE_FN (nat64_out2in_node) (vlib_main_t * vm,
 				  vlib_node_runtime_t * node,
 				  vlib_frame_t * frame)
@@ -520,10 +572,15 @@ VLIB_NODE_FN (nat64_out2in_node) (vlib_main_t * vm,
   nat64_out2in_next_t next_index;
   nat64_main_t *nm = &nat64_main;
   u32 thread_index = vm->thread_index;
+  u64 hashes[VLIB_FRAME_SIZE], *hash = hashes;
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
   next_index = node->cached_next_index;
+
+  nat64_out2in_st_prefetch (vm, &nm->db[thread_index], from, n_left_from,
+			    hashes);
+
   while (n_left_from > 0)
     {
       u32 n_left_to_next;
@@ -555,6 +612,8 @@ VLIB_NODE_FN (nat64_out2in_node) (vlib_main_t * vm,
 	  ctx0.b = b0;
 	  ctx0.vm = vm;
 	  ctx0.thread_index = thread_index;
+	  ctx0.st_hash = hash[0];
+	  hash += 1;
 
 	  next0 = NAT64_OUT2IN_NEXT_IP6_LOOKUP;
 
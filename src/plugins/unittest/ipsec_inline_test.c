@@ -0,0 +1,466 @@
+/*
+ * Copyright (c) 2022 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * A software stand-in for a NIC doing inline IPsec, on pg interfaces.
+ * The ESP packets of the SAs offloaded to an interface are decrypted on
+ * RX, before the graph sees them, and the ones esp-encrypt left to the
+ * device are encrypted on TX, the crypto engines doing what the NIC
+ * would. Like many NICs it does not do ESN nor UDP encapsulation.
+ */
+
+#include <vnet/vnet.h>
+#include <vnet/pg/pg.h>
+#include <vnet/feature/feature.h>
+#include <vnet/ethernet/ethernet.h>
+#include <vnet/ipsec/ipsec.h>
+#include <vnet/ipsec/ipsec_sa.h>
+#include <vnet/ipsec/esp.h>
+
+typedef struct
+{
+  /* emulation enabled, by hw interface */
+  u8 *enabled_by_hw_if_index;
+  /* SA index by SPI, by hw interface */
+  uword **sa_by_spi_by_hw_if_index;
+} ipsec_inline_test_main_t;
+
+static ipsec_inline_test_main_t ipsec_inline_test_main;
+
+#define foreach_ipsec_inline_test_error                                       \
+  _ (DECRYPTED, "packets decrypted by the emulated device")                   \
+  _ (ENCRYPTED, "packets encrypted by the emulated device")                   \
+  _ (ENCRYPT_FAILED, "packets the emulated device failed to encrypt")
+
+typedef enum
+{
+#define _(sym, str) IPSEC_INLINE_TEST_ERROR_##sym,
+  foreach_ipsec_inline_test_error
+#undef _
+    IPSEC_INLINE_TEST_N_ERROR,
+} ipsec_inline_test_error_t;
+
+static char *ipsec_inline_test_error_strings[] = {
+#define _(sym, string) string,
+  foreach_ipsec_inline_test_error
+#undef _
+};
+
+typedef enum
+{
+  IPSEC_INLINE_TEST_NEXT_DROP,
+  IPSEC_INLINE_TEST_N_NEXT,
+} ipsec_inline_test_next_t;
+
+/* the ESP header of a packet starting at its ethernet header, and where
+ * the IP packet ends */
+static esp_header_t *
+ipsec_inline_test_esp (vlib_buffer_t *b, u8 **end)
+{
+  ethernet_header_t *e = vlib_buffer_get_current (b);
+  u8 *tail = vlib_buffer_get_tail (b);
+  esp_header_t *esp;
+
+  if (b->flags & VLIB_BUFFER_NEXT_PRESENT ||
+      b->current_length < sizeof (*e) + sizeof (ip6_header_t))
+    return NULL;
+
+  if (e->type == clib_host_to_net_u16 (ETHERNET_TYPE_IP4))
+    {
+      ip4_header_t *ip4 = (ip4_header_t *) (e + 1);
+
+      if (ip4->protocol != IP_PROTOCOL_IPSEC_ESP || ip4_is_fragment (ip4))
+	return NULL;
+      esp = (esp_header_t *) ((u8 *) ip4 + ip4_header_bytes (ip4));
+      *end = (u8 *) ip4 + clib_net_to_host_u16 (ip4->length);
+    }
+  else if (e->type == clib_host_to_net_u16 (ETHERNET_TYPE_IP6))
+    {
+      ip6_header_t *ip6 = (ip6_header_t *) (e + 1);
+
+      if (ip6->protocol != IP_PROTOCOL_IPSEC_ESP)
+	return NULL;
+      esp = (esp_header_t *) (ip6 + 1);
+      *end = (u8 *) esp + clib_net_to_host_u16 (ip6->payload_length);
+    }
+  else
+    return NULL;
+
+  if (*end > tail || (u8 *) (esp + 1) > *end)
+    return NULL;
+
+  return esp;
+}
+
+static int
+ipsec_inline_test_decrypt (vlib_main_t *vm, ipsec_sa_t *sa,
+			   esp_header_t *esp, u8 *end)
+{
+  u8 *iv = (u8 *) (esp + 1);
+  u8 *payload = iv + sa->crypto_iv_size;
+  u8 *icv = end - sa->integ_icv_size;
+  vnet_crypto_op_t _op, *op = &_op;
+  esp_ctr_nonce_t nonce;
+  esp_aead_t aad;
+
+  if (icv <= payload)
+    return -1;
+
+  if (sa->integ_alg != IPSEC_INTEG_ALG_NONE)
+    {
+      vnet_crypto_op_init (op, sa->sync_op_data.integ_op_id);
+      op->key_index = sa->integ_key_index;
+      op->flags = VNET_CRYPTO_OP_FLAG_HMAC_CHECK;
+      op->src = (u8 *) esp;
+      op->len = icv - (u8 *) esp;
+      op->digest = icv;
+      op->digest_len = sa->integ_icv_size;
+      if (1 != vnet_crypto_process_ops (vm, op, 1))
+	return -1;
+    }
+
+  vnet_crypto_op_init (op, sa->sync_op_data.crypto_dec_op_id);
+  op->key_index = sa->crypto_key_index;
+  op->src = op->dst = payload;
+  op->len = icv - payload;
+  if (ipsec_sa_is_set_IS_CTR (sa))
+    {
+      nonce.salt = sa->salt;
+      nonce.iv = clib_mem_unaligned (iv, u64);
+      nonce.ctr = clib_host_to_net_u32 (1);
+      op->iv = (u8 *) &nonce;
+      if (ipsec_sa_is_set_IS_AEAD (sa))
+	{
+	  op->aad = (u8 *) &aad;
+	  op->aad_len = esp_aad_fill (op->aad, esp, sa, 0);
+	  op->tag = icv;
+	  op->tag_len = sa->integ_icv_size;
+	}
+    }
+  else
+    op->iv = iv;
+
+  return (1 == vnet_crypto_process_ops (vm, op, 1) ? 0 : -1);
+}
+
+static int
+ipsec_inline_test_encrypt (vlib_main_t *vm, ipsec_sa_t *sa,
+			   esp_header_t *esp, u8 *end)
+{
+  u8 *iv = (u8 *) (esp + 1);
+  u8 *payload = iv + sa->crypto_iv_size;
+  u8 *icv = end - sa->integ_icv_size;
+  vnet_crypto_op_t _op, *op = &_op;
+  esp_ctr_nonce_t nonce;
+  esp_aead_t aad;
+  u8 zero_iv[16] = {};
+
+  if (icv <= payload)
+    return -1;
+
+  vnet_crypto_op_init (op, sa->sync_op_data.crypto_enc_op_id);
+  op->key_index = sa->crypto_key_index;
+  if (ipsec_sa_is_set_IS_CTR (sa))
+    {
+      nonce.salt = sa->salt;
+      nonce.iv = clib_mem_unaligned (iv, u64);
+      nonce.ctr = clib_host_to_net_u32 (1);
+      op->iv = (u8 *) &nonce;
+      op->src = op->dst = payload;
+      op->len = icv - payload;
+      if (ipsec_sa_is_set_IS_AEAD (sa))
+	{
+	  op->aad = (u8 *) &aad;
+	  op->aad_len = esp_aad_fill (op->aad, esp, sa, 0);
+	  op->tag = icv;
+	  op->tag_len = sa->integ_icv_size;
+	}
+    }
+  else
+    {
+      /* as the software does, encrypt the IV counter into an
+       * unpredictable IV */
+      op->iv = zero_iv;
+      op->src = op->dst = iv;
+      op->len = icv - iv;
+    }
+  if (1 != vnet_crypto_process_ops (vm, op, 1))
+    return -1;
+
+  if (sa->integ_alg != IPSEC_INTEG_ALG_NONE)
+    {
+      vnet_crypto_op_init (op, sa->sync_op_data.integ_op_id);
+      op->key_index = sa->integ_key_index;
+      op->src = (u8 *) esp;
+      op->len = icv - (u8 *) esp;
+      op->digest = icv;
+      op->digest_len = sa->integ_icv_size;
+      if (1 != vnet_crypto_process_ops (vm, op, 1))
+	return -1;
+    }
+
+  return 0;
+}
+
+VLIB_NODE_FN (ipsec_inline_test_rx_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  ipsec_inline_test_main_t *itm = &ipsec_inline_test_main;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 *from = vlib_frame_vector_args (frame);
+  u32 n_left = frame->n_vectors, n_decrypted = 0;
+
+  vlib_get_buffers (vm, from, bufs, n_left);
+
+  while (n_left > 0)
+    {
+      esp_header_t *esp;
+      uword *p = NULL;
+      u32 hw_if_index;
+      u8 *end;
+
+      vnet_feature_next_u16 (next, b[0]);
+
+      esp = ipsec_inline_test_esp (b[0], &end);
+      if (esp)
+	{
+	  hw_if_index =
+	    vnet_get_sup_hw_interface (vnm,
+				       vnet_buffer (b[0])->sw_if_index[VLIB_RX])
+	      ->hw_if_index;
+	  p = hash_get (itm->sa_by_spi_by_hw_if_index[hw_if_index],
+			clib_net_to_host_u32 (esp->spi));
+	}
+
+      /* packets failing the checks are left to the software */
+      if (p &&
+	  !ipsec_inline_test_decrypt (vm, ipsec_sa_get (p[0]), esp, end))
+	{
+	  b[0]->flags |= VNET_BUFFER_F_IPSEC_INLINE;
+	  vnet_buffer2 (b[0])->ipsec_inline.sa_index = p[0];
+	  n_decrypted++;
+	}
+
+      b++;
+      next++;
+      n_left--;
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+  vlib_node_increment_counter (vm, node->node_index,
+			       IPSEC_INLINE_TEST_ERROR_DECRYPTED, n_decrypted);
+
+  return frame->n_vectors;
+}
+
+VLIB_REGISTER_NODE (ipsec_inline_test_rx_node) = {
+  .name = "ipsec-inline-test-rx",
+  .vector_size = sizeof (u32),
+  .format_buffer = format_ethernet_header_with_length,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = ARRAY_LEN (ipsec_inline_test_error_strings),
+  .error_strings = ipsec_inline_test_error_strings,
+  .n_next_nodes = IPSEC_INLINE_TEST_N_NEXT,
+  .next_nodes = {
+    [IPSEC_INLINE_TEST_NEXT_DROP] = "error-drop",
+  },
+};
+
+VNET_FEATURE_INIT (ipsec_inline_test_rx, static) = {
+  .arc_name = "device-input",
+  .node_name = "ipsec-inline-test-rx",
+  .runs_before = VNET_FEATURES ("ethernet-input"),
+};
+
+VLIB_NODE_FN (ipsec_inline_test_tx_node)
+(vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame)
+{
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  u32 *from = vlib_frame_vector_args (frame);
+  u32 n_left = frame->n_vectors, n_encrypted = 0;
+
+  vlib_get_buffers (vm, from, bufs, n_left);
+
+  while (n_left > 0)
+    {
+      esp_header_t *esp;
+      u8 *end;
+
+      vnet_feature_next_u16 (next, b[0]);
+
+      if (b[0]->flags & VNET_BUFFER_F_IPSEC_INLINE)
+	{
+	  b[0]->flags &= ~VNET_BUFFER_F_IPSEC_INLINE;
+	  esp = ipsec_inline_test_esp (b[0], &end);
+
+	  /* never let a packet out in clear */
+	  if (esp && !ipsec_inline_test_encrypt (
+		       vm,
+		       ipsec_sa_get (vnet_buffer2 (b[0])->ipsec_inline.sa_index),
+		       esp, end))
+	    n_encrypted++;
+	  else
+	    {
+	      b[0]->error = node->errors[IPSEC_INLINE_TEST_ERROR_ENCRYPT_FAILED];
+	      next[0] = IPSEC_INLINE_TEST_NEXT_DROP;
+	    }
+	}
+
+      b++;
+      next++;
+      n_left--;
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+  vlib_node_increment_counter (vm, node->node_index,
+			       IPSEC_INLINE_TEST_ERROR_ENCRYPTED, n_encrypted);
+
+  return frame->n_vectors;
+}
+
+VLIB_REGISTER_NODE (ipsec_inline_test_tx_node) = {
+  .name = "ipsec-inline-test-tx",
+  .vector_size = sizeof (u32),
+  .format_buffer = format_ethernet_header_with_length,
+  .type = VLIB_NODE_TYPE_INTERNAL,
+  .n_errors = ARRAY_LEN (ipsec_inline_test_error_strings),
+  .error_strings = ipsec_inline_test_error_strings,
+  .n_next_nodes = IPSEC_INLINE_TEST_N_NEXT,
+  .next_nodes = {
+    [IPSEC_INLINE_TEST_NEXT_DROP] = "error-drop",
+  },
+};
+
+VNET_FEATURE_INIT (ipsec_inline_test_tx, static) = {
+  .arc_name = "interface-output",
+  .node_name = "ipsec-inline-test-tx",
+  .runs_before = VNET_FEATURES ("interface-output-arc-end"),
+};
+
+static clib_error_t *
+ipsec_inline_test_sa_add_del (u32 hw_if_index, u32 sa_index, u8 is_add)
+{
+  ipsec_inline_test_main_t *itm = &ipsec_inline_test_main;
+  ipsec_sa_t *sa = ipsec_sa_get (sa_index);
+  uword *p;
+
+  if (!is_add)
+    {
+      p = hash_get (itm->sa_by_spi_by_hw_if_index[hw_if_index], sa->spi);
+      if (p && p[0] == sa_index)
+	hash_unset (itm->sa_by_spi_by_hw_if_index[hw_if_index], sa->spi);
+      return NULL;
+    }
+
+  if (hw_if_index >= vec_len (itm->enabled_by_hw_if_index) ||
+      !itm->enabled_by_hw_if_index[hw_if_index])
+    return clib_error_return (0, "no emulation on the interface");
+
+  if (ipsec_sa_is_set_USE_ESN (sa) || ipsec_sa_is_set_UDP_ENCAP (sa) ||
+      IPSEC_CRYPTO_ALG_NONE == sa->crypto_alg)
+    return clib_error_return (0, "SA not supported by the device");
+
+  /* SAs are not always flagged inbound, take all their SPIs */
+  hash_set (itm->sa_by_spi_by_hw_if_index[hw_if_index], sa->spi, sa_index);
+
+  return NULL;
+}
+
+static clib_error_t *
+test_ipsec_inline_offload_command_fn (vlib_main_t *vm,
+				      unformat_input_t *input,
+				      vlib_cli_command_t *cmd)
+{
+  ipsec_inline_test_main_t *itm = &ipsec_inline_test_main;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0, is_enable = 1;
+  vnet_hw_interface_t *hi;
+  ipsec_sa_t *sa;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "emulation %U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (input, "disable"))
+	is_enable = 0;
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (~0 == sw_if_index)
+    return clib_error_return (0, "interface required");
+
+  hi = vnet_get_sup_hw_interface (vnm, sw_if_index);
+  if (hi->dev_class_index != pg_dev_class.index)
+    return clib_error_return (0, "only pg interfaces can be emulated");
+
+  vec_validate (itm->enabled_by_hw_if_index, hi->hw_if_index);
+  vec_validate (itm->sa_by_spi_by_hw_if_index, hi->hw_if_index);
+  if (itm->enabled_by_hw_if_index[hi->hw_if_index] == is_enable)
+    return NULL;
+
+  if (!is_enable)
+    {
+      /* the SAs offloaded to the device go back to the software */
+      pool_foreach (sa, ipsec_sa_pool)
+	{
+	  if (ipsec_sa_is_set_IS_INLINE_OFFLOAD (sa) &&
+	      sa->inline_offload_sw_if_index == sw_if_index)
+	    ipsec_sa_inline_offload_enable_disable (sa - ipsec_sa_pool,
+						    sw_if_index, 0);
+	}
+      hash_free (itm->sa_by_spi_by_hw_if_index[hi->hw_if_index]);
+    }
+
+  itm->enabled_by_hw_if_index[hi->hw_if_index] = is_enable;
+  vnet_feature_enable_disable ("device-input", "ipsec-inline-test-rx",
+			       sw_if_index, is_enable, 0, 0);
+  vnet_feature_enable_disable ("interface-output", "ipsec-inline-test-tx",
+			       sw_if_index, is_enable, 0, 0);
+
+  return NULL;
+}
+
+VLIB_CLI_COMMAND (test_ipsec_inline_offload_command, static) = {
+  .path = "test ipsec inline-offload",
+  .short_help = "test ipsec inline-offload emulation <interface> [disable]",
+  .function = test_ipsec_inline_offload_command_fn,
+};
+
+static clib_error_t *
+ipsec_inline_test_init (vlib_main_t *vm)
+{
+  ipsec_register_inline_offload (&ipsec_main, pg_dev_class.index,
+				 "pg emulation",
+				 ipsec_inline_test_sa_add_del);
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (ipsec_inline_test_init) = {
+  .runs_after = VLIB_INITS ("ipsec_init"),
+};
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -16,6 +16,7 @@
 #include <vnet/ipsec/ipsec.h>
 #include <vnet/ipsec/ipsec_sa.h>
 #include <vnet/ipsec/ipsec_output.h>
+#include <vnet/ipsec/esp.h>
 
 static clib_error_t *
 test_ipsec_command_fn (vlib_main_t * vm,
@@ -134,7 +135,8 @@ test_ipsec_spd_outbound_perf_command_fn (vlib_main_t *vm,
   /* creating a new SA */
   rv = ipsec_sa_add_and_lock (sa_id, spi, proto, crypto_alg, &ck, integ_alg,
 			      &ik, sa_flags, clib_host_to_net_u32 (salt),
-			      udp_src, udp_dst, &tun, &sai);
+			      udp_src, udp_dst, IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE,
+			      &tun, &sai);
   if (rv)
     {
       err = clib_error_return (0, "create sa failure");
@@ -367,6 +369,278 @@ VLIB_CLI_COMMAND (test_ipsec_spd_perf_command, static) = {
   .function = test_ipsec_spd_outbound_perf_command_fn,
 };
 
+/*
+ * Outbound policies that all hash to the same fast path SPD entry: every
+ * range straddles the same power of 2 boundary, so they get the same mask
+ * type and masked key, and only the range index tells them apart.
+ */
+static clib_error_t *
+test_ipsec_spd_fp_range_perf_command_fn (vlib_main_t *vm,
+					 unformat_input_t *input,
+					 vlib_cli_command_t *cmd)
+{
+  ipsec_main_t *im = &ipsec_main;
+  clib_error_t *err = 0;
+  ipsec_policy_t policy = {}, *p, *policies[VLIB_FRAME_SIZE];
+  ipsec_fp_5tuple_t *tuples = 0;
+  u32 ids[VLIB_FRAME_SIZE], *stat_indices = 0, *expected = 0;
+  u32 n_policies = 10000, n_lookups = 100000, spd_id = 0xfeed;
+  u32 seed = random_default_seed ();
+  u32 i, j, n, stat_index, last_priority, n_matched = 0, n_mismatches = 0;
+  u64 t0, t_add, t_index, t_linear;
+  ipsec_spd_t *spd;
+  uword *pp;
+  int rv;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "policies %u", &n_policies))
+	;
+      else if (unformat (input, "lookups %u", &n_lookups))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (!im->fp_spd_ipv4_out_is_enabled)
+    return clib_error_return (0, "ipv4-outbound-spd-fast-path is not on");
+
+  rv = ipsec_add_del_spd (vm, spd_id, 1);
+  if (rv)
+    return clib_error_return (0, "create spd failure");
+
+  policy.id = spd_id;
+  policy.type = IPSEC_SPD_POLICY_IP4_OUTBOUND;
+  policy.policy = IPSEC_POLICY_ACTION_BYPASS;
+  policy.protocol = IP_PROTOCOL_UDP;
+  policy.sa_index = INDEX_INVALID;
+
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_policies; i++)
+    {
+      /* 10.0.0.0/8 straddling 10.128.0.0, ports straddling 32768 */
+      policy.priority = 1 + random_u32 (&seed) % (4 * n_policies);
+      policy.laddr.start.ip4.as_u32 = clib_host_to_net_u32 (
+	0x0a7fffff - random_u32 (&seed) % (1 << 23));
+      policy.laddr.stop.ip4.as_u32 =
+	clib_host_to_net_u32 (0x0a800000 + random_u32 (&seed) % (1 << 23));
+      policy.raddr.start.ip4.as_u32 = clib_host_to_net_u32 (
+	0x0a7fffff - random_u32 (&seed) % (1 << 23));
+      policy.raddr.stop.ip4.as_u32 =
+	clib_host_to_net_u32 (0x0a800000 + random_u32 (&seed) % (1 << 23));
+      policy.lport.start = 32767 - random_u32 (&seed) % 32768;
+      policy.lport.stop = 32768 + random_u32 (&seed) % 32768;
+      policy.rport.start = 32767 - random_u32 (&seed) % 32768;
+      policy.rport.stop = 32768 + random_u32 (&seed) % 32768;
+
+      rv = ipsec_add_del_policy (vm, &policy, 1, &stat_index);
+      if (rv)
+	{
+	  err = clib_error_return (0, "add SPD Policy failure");
+	  goto done;
+	}
+      vec_add1 (stat_indices, stat_index);
+    }
+  t_add = clib_cpu_time_now () - t0;
+
+  vec_validate (tuples, n_lookups - 1);
+  vec_validate (expected, n_lookups - 1);
+  for (i = 0; i < n_lookups; i++)
+    ipsec_fp_5tuple_from_ip4_range (
+      tuples + i, 0x0a000000 + random_u32 (&seed) % (1 << 24),
+      0x0a000000 + random_u32 (&seed) % (1 << 24), random_u32 (&seed),
+      random_u32 (&seed), IP_PROTOCOL_UDP);
+
+  /* what the scan of the whole vector finds */
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_lookups; i++)
+    {
+      expected[i] = ~0;
+      last_priority = 0;
+      vec_foreach_index (j, stat_indices)
+	{
+	  p = pool_elt_at_index (im->policies, stat_indices[j]);
+	  if ((last_priority < p->priority) &&
+	      single_rule_out_match_5tuple (p, tuples + i))
+	    {
+	      last_priority = p->priority;
+	      expected[i] = stat_indices[j];
+	    }
+	}
+    }
+  t_linear = clib_cpu_time_now () - t0;
+
+  pp = hash_get (im->spd_index_by_spd_id, spd_id);
+  spd = pool_elt_at_index (im->spds, pp[0]);
+
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_lookups; i += n)
+    {
+      n = clib_min (n_lookups - i, VLIB_FRAME_SIZE);
+      n_matched += ipsec_fp_out_policy_match_n (&spd->fp_spd, 0, tuples + i,
+						policies, ids, n);
+      for (j = 0; j < n; j++)
+	if ((policies[j] ? ids[j] : ~0) != expected[i + j])
+	  n_mismatches++;
+    }
+  t_index = clib_cpu_time_now () - t0;
+
+  vlib_cli_output (vm, "%u policies added in %.6f s", n_policies,
+		   t_add / vm->clib_time.clocks_per_second);
+  vlib_cli_output (vm, "%u lookups, %u matched, %u mismatches", n_lookups,
+		   n_matched, n_mismatches);
+  vlib_cli_output (vm, "range index: %.2f cycles/lookup",
+		   (f64) t_index / n_lookups);
+  vlib_cli_output (vm, "linear scan: %.2f cycles/lookup",
+		   (f64) t_linear / n_lookups);
+
+  if (n_mismatches)
+    err = clib_error_return (0, "%u mismatches", n_mismatches);
+
+done:
+  for (i = 0; i < vec_len (stat_indices); i++)
+    {
+      policy = *pool_elt_at_index (im->policies, stat_indices[i]);
+      ipsec_add_del_policy (vm, &policy, 0, &stat_index);
+    }
+  ipsec_add_del_spd (vm, spd_id, 0);
+  vec_free (stat_indices);
+  vec_free (expected);
+  vec_free (tuples);
+  return err;
+}
+
+VLIB_CLI_COMMAND (test_ipsec_spd_fp_range_perf_command, static) = {
+  .path = "test ipsec_spd_fp_range_perf",
+  .short_help = "test ipsec_spd_fp_range_perf [policies <n>] [lookups <n>] "
+		"[seed <n>]",
+  .function = test_ipsec_spd_fp_range_perf_command_fn,
+};
+
+/*
+ * Sends packets on a multi-worker SA from a number of simulated threads
+ * taking turns to send a burst each, and receives them, so reordered, on
+ * a multi-worker SA and on a single thread one.
+ */
+static clib_error_t *
+test_ipsec_sa_mw_perf_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				  vlib_cli_command_t *cmd)
+{
+  u32 n_packets = 1000000, n_threads = 4, burst = 4, window_size = 1024;
+  u32 i, j, n_accepted[2] = {}, n_dropped[2] = {}, hi_seq;
+  ipsec_sa_t *out, *in[2];
+  u64 *seqs = 0, seq64, t0, t_out, t_in[2];
+  clib_error_t *err = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "packets %u", &n_packets))
+	;
+      else if (unformat (input, "threads %u", &n_threads))
+	;
+      else if (unformat (input, "burst %u", &burst))
+	;
+      else if (unformat (input, "window %u", &window_size))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (!is_pow2 (window_size) ||
+      window_size <= IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE ||
+      window_size > IPSEC_SA_ANTI_REPLAY_WINDOW_MAX_SIZE || !n_threads ||
+      !burst)
+    return clib_error_return (0, "bad window size, thread count or burst");
+
+  out = clib_mem_alloc_aligned (sizeof (*out), CLIB_CACHE_LINE_BYTES);
+  clib_memset (out, 0, sizeof (*out));
+  out->flags = IPSEC_SA_FLAG_IS_MULTI_WORKER | IPSEC_SA_FLAG_USE_ESN;
+  vec_validate_aligned (out->seq_blocks, n_threads - 1, CLIB_CACHE_LINE_BYTES);
+
+  for (i = 0; i < 2; i++)
+    {
+      in[i] = clib_mem_alloc_aligned (sizeof (*out), CLIB_CACHE_LINE_BYTES);
+      clib_memset (in[i], 0, sizeof (*out));
+      in[i]->flags = IPSEC_SA_FLAG_USE_ESN | IPSEC_SA_FLAG_USE_ANTI_REPLAY |
+		     IPSEC_SA_FLAG_IS_INBOUND;
+      in[i]->replay_window_log2 = min_log2 (window_size);
+    }
+  in[0]->flags |= IPSEC_SA_FLAG_IS_MULTI_WORKER;
+  vec_validate_aligned (in[0]->replay_window_slots, window_size - 1,
+			CLIB_CACHE_LINE_BYTES);
+  in[1]->flags |= IPSEC_SA_FLAG_ANTI_REPLAY_HUGE;
+  clib_bitmap_alloc (in[1]->replay_window_huge, window_size);
+
+  vec_validate (seqs, n_packets - 1);
+  t0 = clib_cpu_time_now ();
+  for (i = 0; i < n_packets; i++)
+    {
+      if (esp_seq_advance_mw (out, (i / burst) % n_threads, &seq64))
+	{
+	  err = clib_error_return (0, "sequence number cycled");
+	  goto done;
+	}
+      seqs[i] = seq64;
+    }
+  t_out = clib_cpu_time_now () - t0;
+
+  for (j = 0; j < 2; j++)
+    {
+      t0 = clib_cpu_time_now ();
+      for (i = 0; i < n_packets; i++)
+	{
+	  if (ipsec_sa_anti_replay_and_sn_advance (in[j], seqs[i], ~0, false,
+						   &hi_seq) ||
+	      ipsec_sa_anti_replay_and_sn_advance (in[j], seqs[i], hi_seq,
+						   true, NULL))
+	    {
+	      n_dropped[j]++;
+	      continue;
+	    }
+	  ipsec_sa_anti_replay_advance (in[j], 0, seqs[i], hi_seq);
+	  n_accepted[j]++;
+	}
+      t_in[j] = clib_cpu_time_now () - t0;
+    }
+
+  vlib_cli_output (vm, "%u packets from %u threads in bursts of %u, "
+		   "window %u", n_packets, n_threads, burst, window_size);
+  vlib_cli_output (vm, "send: %.2f cycles/packet", (f64) t_out / n_packets);
+  vlib_cli_output (vm,
+		   "receive multi-worker: %.2f cycles/packet, %u accepted, "
+		   "%u dropped",
+		   (f64) t_in[0] / n_packets, n_accepted[0], n_dropped[0]);
+  vlib_cli_output (vm,
+		   "receive single thread: %.2f cycles/packet, %u accepted, "
+		   "%u dropped",
+		   (f64) t_in[1] / n_packets, n_accepted[1], n_dropped[1]);
+
+  if (n_accepted[0] != n_accepted[1])
+    err = clib_error_return (0, "windows disagree");
+
+done:
+  vec_free (seqs);
+  vec_free (out->seq_blocks);
+  vec_free (in[0]->replay_window_slots);
+  clib_bitmap_free (in[1]->replay_window_huge);
+  clib_mem_free (out);
+  clib_mem_free (in[0]);
+  clib_mem_free (in[1]);
+  return err;
+}
+
+VLIB_CLI_COMMAND (test_ipsec_sa_mw_perf_command, static) = {
+  .path = "test ipsec_sa_mw_perf",
+  .short_help =
+    "test ipsec_sa_mw_perf [packets <n>] [threads <n>] [burst <n>] "
+    "[window <n>]",
+  .function = test_ipsec_sa_mw_perf_command_fn,
+};
+
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (test_ipsec_command, static) =
 {
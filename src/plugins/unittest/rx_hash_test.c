@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2023 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Stands in for a device delivering an RSS hash: packets received on an
+ * interface with the feature enabled carry a fixed rx hash, so tests can
+ * check which load-balance bucket it selects.
+ */
+
+#include <vnet/vnet.h>
+#include <vnet/feature/feature.h>
+
+typedef struct rx_hash_test_trace_t_
+{
+  u32 rx_hash;
+} rx_hash_test_trace_t;
+
+static u32 rx_hash_test_value;
+
+static u8 *
+format_rx_hash_test_trace (u8 *s, va_list *args)
+{
+  CLIB_UNUSED (vlib_main_t * vm) = va_arg (*args, vlib_main_t *);
+  CLIB_UNUSED (vlib_node_t * node) = va_arg (*args, vlib_node_t *);
+  rx_hash_test_trace_t *t = va_arg (*args, rx_hash_test_trace_t *);
+
+  s = format (s, "rx-hash 0x%08x", t->rx_hash);
+
+  return s;
+}
+
+static uword
+rx_hash_test_ip4 (vlib_main_t *vm, vlib_node_runtime_t *node,
+		  vlib_frame_t *frame)
+{
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b = bufs;
+  u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
+  u32 n_left, *from;
+
+  from = vlib_frame_vector_args (frame);
+  n_left = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left);
+
+  while (n_left > 0)
+    {
+      u32 next0;
+
+      vnet_buffer_rx_hash_set (b[0], rx_hash_test_value);
+      vnet_feature_next (&next0, b[0]);
+      next[0] = next0;
+
+      if (PREDICT_FALSE (b[0]->flags & VLIB_BUFFER_IS_TRACED))
+	{
+	  rx_hash_test_trace_t *t;
+
+	  t = vlib_add_trace (vm, node, b[0], sizeof (*t));
+	  t->rx_hash = rx_hash_test_value;
+	}
+
+      b += 1;
+      next += 1;
+      n_left -= 1;
+    }
+
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
+  return frame->n_vectors;
+}
+
+VLIB_REGISTER_NODE (rx_hash_test_ip4_node) = {
+  .function = rx_hash_test_ip4,
+  .name = "rx-hash-test-ip4",
+  .vector_size = sizeof (u32),
+  .format_trace = format_rx_hash_test_trace,
+};
+
+VNET_FEATURE_INIT (rx_hash_test_ip4_feature, static) = {
+  .arc_name = "ip4-unicast",
+  .node_name = "rx-hash-test-ip4",
+};
+
+static clib_error_t *
+rx_hash_test (vlib_main_t *vm, unformat_input_t *input,
+	      vlib_cli_command_t *cmd_arg)
+{
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sw_if_index = ~0;
+  int enable = 1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "%U", unformat_vnet_sw_interface, vnm,
+		    &sw_if_index))
+	;
+      else if (unformat (input, "hash %u", &rx_hash_test_value))
+	;
+      else if (unformat (input, "clear"))
+	enable = 0;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (~0 == sw_if_index)
+    return clib_error_return (0, "interface required");
+
+  vnet_feature_enable_disable ("ip4-unicast", "rx-hash-test-ip4", sw_if_index,
+			       enable, NULL, 0);
+
+  return NULL;
+}
+
+VLIB_CLI_COMMAND (rx_hash_test_command, static) = {
+  .path = "test rx-hash",
+  .short_help = "test rx-hash <interface> [hash <value>] [clear]",
+  .function = rx_hash_test,
+};
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -1163,6 +1163,31 @@ vlib_buffer_clone_256 (vlib_main_t * vm, u32 src_buffer, u32 * buffers,
       if (offset)
 	vlib_buffer_move (vm, s, offset);
 
+      if (PREDICT_TRUE ((s->flags & VLIB_BUFFER_NEXT_PRESENT) == 0))
+	{
+	  /* single segment: allocate all the copies at once */
+	  u16 n_alloc = 0;
+
+	  if (n_buffers > 1)
+	    n_alloc = vlib_buffer_alloc_from_pool (
+	      vm, buffers + 1, n_buffers - 1, s->buffer_pool_index);
+
+	  for (i = 1; i <= n_alloc; i++)
+	    {
+	      vlib_buffer_t *d = vlib_get_buffer (vm, buffers[i]);
+	      d->current_data = s->current_data;
+	      d->current_length = s->current_length;
+	      d->flags = s->flags & VLIB_BUFFER_COPY_CLONE_FLAGS_MASK;
+	      d->trace_handle = s->trace_handle;
+	      d->total_length_not_including_first_buffer = 0;
+	      clib_memcpy_fast (d->opaque, s->opaque, sizeof (s->opaque));
+	      clib_memcpy_fast (d->opaque2, s->opaque2, sizeof (s->opaque2));
+	      clib_memcpy_fast (vlib_buffer_get_current (d),
+				vlib_buffer_get_current (s), s->current_length);
+	    }
+	  return n_alloc + 1;
+	}
+
       for (i = 1; i < n_buffers; i++)
 	{
 	  vlib_buffer_t *d;
@@ -462,6 +462,17 @@ adj_get (adj_index_t adj_index)
     return (pool_elt_at_index(adj_pool, adj_index));
 }
 
+/**
+ * @brief
+ * Prefetch the rewrite of an adjacency; the part of it the
+ * rewrite nodes read in the data-path
+ */
+static inline void
+adj_prefetch_rewrite (adj_index_t adj_index)
+{
+    clib_prefetch_load (&adj_get(adj_index)->rewrite_header);
+}
+
 static inline int
 adj_is_valid(adj_index_t adj_index)
 {
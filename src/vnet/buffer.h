@@ -65,15 +65,15 @@
   _ (16, IS_DVR, "dvr", 1)                                                    \
   _ (17, QOS_DATA_VALID, "qos-data-valid", 0)                                 \
   _ (18, GSO, "gso", 0)                                                       \
-  _ (19, AVAIL1, "avail1", 1)                                                 \
-  _ (20, AVAIL2, "avail2", 1)                                                 \
-  _ (21, AVAIL3, "avail3", 1)                                                 \
-  _ (22, AVAIL4, "avail4", 1)                                                 \
-  _ (23, AVAIL5, "avail5", 1)                                                 \
-  _ (24, AVAIL6, "avail6", 1)                                                 \
-  _ (25, AVAIL7, "avail7", 1)                                                 \
-  _ (26, AVAIL8, "avail8", 1)                                                 \
-  _ (27, AVAIL9, "avail9", 1)
+  _ (19, RX_HASH_VALID, "rx-hash-valid", 0)                                  \
+  _ (20, IPSEC_INLINE, "ipsec-inline", 1)                                     \
+  _ (21, AVAIL1, "avail1", 1)                                                 \
+  _ (22, AVAIL2, "avail2", 1)                                                 \
+  _ (23, AVAIL3, "avail3", 1)                                                 \
+  _ (24, AVAIL4, "avail4", 1)                                                 \
+  _ (25, AVAIL5, "avail5", 1)                                                 \
+  _ (26, AVAIL6, "avail6", 1)                                                 \
+  _ (27, AVAIL7, "avail7", 1)
 
 /*
  * Please allocate the FIRST available bit, redefine
@@ -84,7 +84,7 @@
 #define VNET_BUFFER_FLAGS_ALL_AVAIL                                           \
   (VNET_BUFFER_F_AVAIL1 | VNET_BUFFER_F_AVAIL2 | VNET_BUFFER_F_AVAIL3 |       \
    VNET_BUFFER_F_AVAIL4 | VNET_BUFFER_F_AVAIL5 | VNET_BUFFER_F_AVAIL6 |       \
-   VNET_BUFFER_F_AVAIL7 | VNET_BUFFER_F_AVAIL8 | VNET_BUFFER_F_AVAIL9)
+   VNET_BUFFER_F_AVAIL7)
 
 #define VNET_BUFFER_FLAGS_VLAN_BITS \
   (VNET_BUFFER_F_VLAN_1_DEEP | VNET_BUFFER_F_VLAN_2_DEEP)
@@ -495,7 +495,40 @@ typedef struct
     };
   } nat;
 
-  u32 unused[8];
+  /**
+   * Flow hash delivered by the device (e.g. RSS hash) or computed once
+   * on ingress. Only valid when VNET_BUFFER_F_RX_HASH_VALID is set.
+   */
+  u32 rx_hash;
+
+  /**
+   * Range of replicate buckets served by a copy of the packet when a
+   * high fanout replication is spread across workers.
+   */
+  struct
+  {
+    u16 first_bucket;
+    u16 n_buckets;
+  } replicate;
+
+  /**
+   * SA of a packet the device decrypts on RX, or is to encrypt on TX,
+   * when VNET_BUFFER_F_IPSEC_INLINE is set. seq_hi is the high half of
+   * the ESN of a packet to encrypt. rx_sw_if_index is the interface a
+   * decrypted packet was received on, saved when a tunnel takes over
+   * sw_if_index[VLIB_RX].
+   */
+  struct
+  {
+    u32 sa_index;
+    union
+    {
+      u32 seq_hi;
+      u32 rx_sw_if_index;
+    };
+  } ipsec_inline;
+
+  u32 unused[4];
 } vnet_buffer_opaque2_t;
 
 #define vnet_buffer2(b) ((vnet_buffer_opaque2_t *) (b)->opaque2)
@@ -536,6 +569,23 @@ vnet_buffer_offload_flags_set (vlib_buffer_t *b, vnet_buffer_oflags_t oflags)
     }
 }
 
+static_always_inline void
+vnet_buffer_rx_hash_set (vlib_buffer_t *b, u32 hash)
+{
+  vnet_buffer2 (b)->rx_hash = hash;
+  b->flags |= VNET_BUFFER_F_RX_HASH_VALID;
+}
+
+/**
+ * The hash of a tunnelled packet covers its outer headers, so decap nodes
+ * drop it and the inner packet is hashed on its own headers.
+ */
+static_always_inline void
+vnet_buffer_reset_rx_hash (vlib_buffer_t *b)
+{
+  b->flags &= ~VNET_BUFFER_F_RX_HASH_VALID;
+}
+
 static_always_inline void
 vnet_buffer_offload_flags_clear (vlib_buffer_t *b, vnet_buffer_oflags_t oflags)
 {
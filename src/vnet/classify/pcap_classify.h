@@ -23,16 +23,17 @@
  * Use the vpp classifier to decide whether to capture packets
  */
 
-/** @brief vnet_is_packet_pcaped
+/** @brief vnet_is_packet_pcaped_unclassified
  * @param vlib_buffer_t *b - packet to capture
- * @return 0 => no capture, 1 => capture
+ * @return 0 => no capture, 1 => capture unless the classifier filter says
+ * otherwise
  */
 
 static_always_inline int
-vnet_is_packet_pcaped (vnet_pcap_t *pp, vlib_buffer_t *b, u32 sw_if_index)
+vnet_is_packet_pcaped_unclassified (vnet_pcap_t *pp, vlib_buffer_t *b,
+				    u32 sw_if_index)
 {
   const u32 pcap_sw_if_index = pp->pcap_sw_if_index;
-  const u32 filter_classify_table_index = pp->filter_classify_table_index;
   const vlib_error_t pcap_error_index = pp->pcap_error_index;
 
   if (pcap_sw_if_index != 0)
@@ -46,6 +47,22 @@ vnet_is_packet_pcaped (vnet_pcap_t *pp, vlib_buffer_t *b, u32 sw_if_index)
   if (pcap_error_index != (vlib_error_t) ~0 && pcap_error_index != b->error)
     return 0; /* wrong error */
 
+  return 1;
+}
+
+/** @brief vnet_is_packet_pcaped
+ * @param vlib_buffer_t *b - packet to capture
+ * @return 0 => no capture, 1 => capture
+ */
+
+static_always_inline int
+vnet_is_packet_pcaped (vnet_pcap_t *pp, vlib_buffer_t *b, u32 sw_if_index)
+{
+  const u32 filter_classify_table_index = pp->filter_classify_table_index;
+
+  if (!vnet_is_packet_pcaped_unclassified (pp, b, sw_if_index))
+    return 0;
+
   if (filter_classify_table_index != ~0 &&
       vnet_is_packet_traced_inline (b, filter_classify_table_index,
 				    0 /* full classify */) != 1)
@@ -54,6 +71,53 @@ vnet_is_packet_pcaped (vnet_pcap_t *pp, vlib_buffer_t *b, u32 sw_if_index)
   return 1; /* success */
 }
 
+/** @brief vnet_pcap_classify_buffers
+ * Apply the classifier filter to a vector of buffers which passed
+ * vnet_is_packet_pcaped_unclassified, the whole vector at once.
+ * @param u32 *bi - buffer indices, compacted in place to the matches
+ * @param u32 n - number of buffers, at most VLIB_FRAME_SIZE
+ * @return number of buffers to capture
+ */
+
+static_always_inline u32
+vnet_pcap_classify_buffers (vlib_main_t *vm, vnet_pcap_t *pp, u32 *bi, u32 n)
+{
+  const u32 filter_classify_table_index = pp->filter_classify_table_index;
+  vnet_classify_entry_t *e[VLIB_FRAME_SIZE];
+  vlib_buffer_t *b[VLIB_FRAME_SIZE];
+  u32 table_index[VLIB_FRAME_SIZE];
+  const u8 *h[VLIB_FRAME_SIZE];
+  u32 i, n_match = 0;
+
+  if (filter_classify_table_index == ~0)
+    return n;
+
+  /* This will happen... */
+  if (pool_is_free_index (vnet_classify_main.tables,
+			  filter_classify_table_index))
+    return 0;
+
+  vlib_get_buffers (vm, bi, b, n);
+  for (i = 0; i < n; i++)
+    {
+      h[i] = vlib_buffer_get_current (b[i]);
+      table_index[i] = filter_classify_table_index;
+    }
+
+  vnet_classify_find_entries_chain (h, table_index, e, n,
+				    0 /* time = 0, disables hit-counter */);
+
+  for (i = 0; i < n; i++)
+    if (e[i])
+      {
+	/* Manual hit accounting */
+	e[i]->hits++;
+	bi[n_match++] = bi[i];
+      }
+
+  return n_match;
+}
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
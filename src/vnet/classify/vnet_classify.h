@@ -581,6 +581,68 @@ vnet_classify_find_entry_inline (const vnet_classify_table_t *t, const u8 *h,
   return 0;
 }
 
+/**
+ * Look up a vector of packets in their classifier table chains.
+ *
+ * The chains are walked breadth first: every packet still looking is
+ * hashed against its current table with its bucket prefetched, then the
+ * entries are prefetched and finally matched, so the memory latency of
+ * one packet is hidden behind the work on the others. Packets that miss
+ * move on to the next table of their chain for the following round.
+ *
+ * @param h - per packet data to classify
+ * @param table_index - in: first table per packet, ~0 to skip the packet,
+ *                      out: the table that matched, else the last one tried
+ * @param e - out: matching entry per packet, 0 on miss
+ * @param n - number of packets, at most VLIB_FRAME_SIZE
+ * @param now - time for the hit accounting, 0 disables it
+ */
+static_always_inline void
+vnet_classify_find_entries_chain (const u8 **h, u32 *table_index,
+				  vnet_classify_entry_t **e, u32 n, f64 now)
+{
+  vnet_classify_main_t *vcm = &vnet_classify_main;
+  vnet_classify_table_t *t[VLIB_FRAME_SIZE];
+  u32 hash[VLIB_FRAME_SIZE];
+  u16 todo[VLIB_FRAME_SIZE];
+  u32 i, k, n_todo = 0, n_miss;
+
+  ASSERT (n <= VLIB_FRAME_SIZE);
+
+  for (i = 0; i < n; i++)
+    {
+      e[i] = 0;
+      if (table_index[i] != ~0)
+	todo[n_todo++] = i;
+    }
+
+  while (n_todo)
+    {
+      for (k = 0; k < n_todo; k++)
+	{
+	  i = todo[k];
+	  t[k] = pool_elt_at_index (vcm->tables, table_index[i]);
+	  hash[k] = vnet_classify_hash_packet_inline (t[k], h[i]);
+	  vnet_classify_prefetch_bucket (t[k], hash[k]);
+	}
+
+      for (k = 0; k < n_todo; k++)
+	vnet_classify_prefetch_entry (t[k], hash[k]);
+
+      n_miss = 0;
+      for (k = 0; k < n_todo; k++)
+	{
+	  i = todo[k];
+	  e[i] = vnet_classify_find_entry_inline (t[k], h[i], hash[k], now);
+	  if (e[i] || t[k]->next_table_index == ~0)
+	    continue;
+	  table_index[i] = t[k]->next_table_index;
+	  todo[n_miss++] = i;
+	}
+      n_todo = n_miss;
+    }
+}
+
 vnet_classify_table_t *vnet_classify_new_table (vnet_classify_main_t *cm,
 						const u8 *mask, u32 nbuckets,
 						u32 memory_size,
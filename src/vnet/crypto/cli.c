@@ -328,6 +328,9 @@ show_crypto_async_status_command_fn (vlib_main_t * vm,
 		   cm->dispatch_mode ==
 		   VNET_CRYPTO_ASYNC_DISPATCH_POLLING ? "POLLING" :
 		   "INTERRUPT");
+  if (cm->dispatch_budget_us)
+    vlib_cli_output (vm, "Crypto async dispatch budget: %uus",
+		     cm->dispatch_budget_us);
 
   for (i = skip_master; i < tm->n_vlib_mains; i++)
     {
@@ -464,6 +467,105 @@ set_crypto_async_dispatch_interrupt_command_fn (vlib_main_t * vm,
   return 0;
 }
 
+static clib_error_t *
+set_crypto_async_dispatch_budget_command_fn (vlib_main_t *vm,
+					     unformat_input_t *input,
+					     vlib_cli_command_t *cmd)
+{
+  u32 budget;
+
+  if (!unformat (input, "%u", &budget))
+    return clib_error_return (0, "expected budget in microseconds, got `%U'",
+			      format_unformat_error, input);
+
+  vnet_crypto_set_async_dispatch_budget (budget);
+  return 0;
+}
+
+static u8 *
+format_crypto_async_hist (u8 *s, va_list *args)
+{
+  vlib_simple_counter_main_t *sm = va_arg (*args, vlib_simple_counter_main_t *);
+  u32 ei = va_arg (*args, u32);
+  u32 b, last = 0;
+  u64 v[VNET_CRYPTO_ASYNC_HIST_N_BUCKETS];
+
+  for (b = 0; b < VNET_CRYPTO_ASYNC_HIST_N_BUCKETS; b++)
+    {
+      v[b] = vlib_get_simple_counter (
+	sm, ei * VNET_CRYPTO_ASYNC_HIST_N_BUCKETS + b);
+      if (v[b])
+	last = b;
+    }
+
+  for (b = 0; b <= last; b++)
+    {
+      if (b == 0)
+	s = format (s, " 0:%lu", v[b]);
+      else if (b == VNET_CRYPTO_ASYNC_HIST_N_BUCKETS - 1)
+	s = format (s, " >=%u:%lu", 1 << (b - 1), v[b]);
+      else
+	s = format (s, " <%u:%lu", 1 << b, v[b]);
+    }
+  return s;
+}
+
+static clib_error_t *
+show_crypto_async_stats_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				    vlib_cli_command_t *cmd)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vlib_simple_counter_main_t *sm = cm->async_counters;
+  vnet_crypto_thread_t *ct;
+  vnet_crypto_engine_t *e;
+  u32 ei;
+
+  vec_foreach (e, cm->engines)
+    {
+      u64 inflight = 0;
+
+      ei = e - cm->engines;
+      if (!vlib_get_simple_counter (
+	    &sm[VNET_CRYPTO_ASYNC_COUNTER_FRAMES_SUBMITTED], ei))
+	continue;
+
+      vec_foreach (ct, cm->threads)
+	inflight += ct->n_inflight_elts[ei];
+
+      vlib_cli_output (vm, "%s:", e->name);
+      vlib_cli_output (
+	vm, "  submitted: %lu frames %lu elts",
+	vlib_get_simple_counter (
+	  &sm[VNET_CRYPTO_ASYNC_COUNTER_FRAMES_SUBMITTED], ei),
+	vlib_get_simple_counter (&sm[VNET_CRYPTO_ASYNC_COUNTER_ELTS_SUBMITTED],
+				 ei));
+      vlib_cli_output (
+	vm, "  completed: %lu frames %lu elts",
+	vlib_get_simple_counter (
+	  &sm[VNET_CRYPTO_ASYNC_COUNTER_FRAMES_COMPLETED], ei),
+	vlib_get_simple_counter (&sm[VNET_CRYPTO_ASYNC_COUNTER_ELTS_COMPLETED],
+				 ei));
+      vlib_cli_output (vm, "  in flight: %lu elts", inflight);
+      vlib_cli_output (vm, "  queue depth (elts):%U", format_crypto_async_hist,
+		       &sm[VNET_CRYPTO_ASYNC_COUNTER_DEPTH_HIST], ei);
+      vlib_cli_output (vm, "  latency (us):%U", format_crypto_async_hist,
+		       &sm[VNET_CRYPTO_ASYNC_COUNTER_LATENCY_HIST], ei);
+    }
+  return 0;
+}
+
+VLIB_CLI_COMMAND (show_crypto_async_stats_command, static) = {
+  .path = "show crypto async stats",
+  .short_help = "show crypto async stats",
+  .function = show_crypto_async_stats_command_fn,
+};
+
+VLIB_CLI_COMMAND (set_crypto_async_dispatch_budget_command, static) = {
+  .path = "set crypto async dispatch budget",
+  .short_help = "set crypto async dispatch budget <usec>",
+  .function = set_crypto_async_dispatch_budget_command_fn,
+};
+
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (set_crypto_async_dispatch_polling_command, static) =
 {
@@ -113,14 +113,28 @@ vnet_crypto_register_engine (vlib_main_t * vm, char *name, int prio,
 			     char *desc)
 {
   vnet_crypto_main_t *cm = &crypto_main;
+  vnet_crypto_thread_t *ct;
   vnet_crypto_engine_t *p;
+  u32 ei, i;
 
   vec_add2 (cm->engines, p, 1);
   p->name = name;
   p->desc = desc;
   p->priority = prio;
+  ei = p - cm->engines;
 
-  hash_set_mem (cm->engine_index_by_name, p->name, p - cm->engines);
+  hash_set_mem (cm->engine_index_by_name, p->name, ei);
+
+  for (i = 0; i < VNET_CRYPTO_ASYNC_N_COUNTERS; i++)
+    {
+      u32 n = (i == VNET_CRYPTO_ASYNC_COUNTER_DEPTH_HIST ||
+	       i == VNET_CRYPTO_ASYNC_COUNTER_LATENCY_HIST) ?
+		VNET_CRYPTO_ASYNC_HIST_N_BUCKETS :
+		1;
+      vlib_validate_simple_counter (&cm->async_counters[i], (ei + 1) * n - 1);
+    }
+  vec_foreach (ct, cm->threads)
+    vec_validate (ct->n_inflight_elts, ei);
 
   return p - cm->engines;
 }
@@ -718,6 +732,17 @@ vnet_crypto_set_async_dispatch_mode (u8 mode)
     }
 }
 
+void
+vnet_crypto_set_async_dispatch_budget (u32 budget_us)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  vlib_main_t *vm = vlib_get_main ();
+
+  cm->dispatch_budget_us = budget_us;
+  cm->dispatch_budget_clocks =
+    (u64) (budget_us * 1e-6 * vm->clib_time.clocks_per_second);
+}
+
 int
 vnet_crypto_is_set_async_handler (vnet_crypto_async_op_id_t op)
 {
@@ -814,6 +839,12 @@ vnet_crypto_init (vlib_main_t * vm)
   vnet_crypto_thread_t *ct = 0;
 
   cm->dispatch_mode = VNET_CRYPTO_ASYNC_DISPATCH_POLLING;
+#define _(sym, str)                                                           \
+  cm->async_counters[VNET_CRYPTO_ASYNC_COUNTER_##sym].name = str;             \
+  cm->async_counters[VNET_CRYPTO_ASYNC_COUNTER_##sym].stat_segment_name =     \
+    "/crypto/async/" str;
+  foreach_crypto_async_counter
+#undef _
   cm->engine_index_by_name = hash_create_string ( /* size */ 0,
 						 sizeof (uword));
   cm->alg_index_by_name = hash_create_string (0, sizeof (uword));
@@ -365,6 +365,8 @@ typedef struct
   u32 buffer_indices[VNET_CRYPTO_FRAME_SIZE];
   u16 next_node_index[VNET_CRYPTO_FRAME_SIZE];
   u32 enqueue_thread_index;
+  u32 engine_index;	/**< engine the frame was submitted to */
+  u64 submit_time;	/**< cpu time at submission, for latency stats */
 } vnet_crypto_async_frame_t;
 
 typedef struct
@@ -373,6 +375,7 @@ typedef struct
   vnet_crypto_async_frame_t *frame_pool;
   u32 *buffer_indices;
   u16 *nexts;
+  u32 *n_inflight_elts;	/**< per engine, submitted but not yet dequeued */
 } vnet_crypto_thread_t;
 
 typedef u32 vnet_crypto_key_index_t;
@@ -451,6 +454,28 @@ typedef struct
   u32 next_idx;
 } vnet_crypto_async_next_node_t;
 
+/* per engine async counters; the histograms have
+ * VNET_CRYPTO_ASYNC_HIST_N_BUCKETS entries per engine */
+#define foreach_crypto_async_counter                                          \
+  _ (FRAMES_SUBMITTED, "frames-submitted")                                    \
+  _ (ELTS_SUBMITTED, "elts-submitted")                                        \
+  _ (FRAMES_COMPLETED, "frames-completed")                                    \
+  _ (ELTS_COMPLETED, "elts-completed")                                        \
+  _ (DEPTH_HIST, "depth-hist")                                                \
+  _ (LATENCY_HIST, "latency-hist")
+
+typedef enum
+{
+#define _(sym, str) VNET_CRYPTO_ASYNC_COUNTER_##sym,
+  foreach_crypto_async_counter
+#undef _
+    VNET_CRYPTO_ASYNC_N_COUNTERS,
+} vnet_crypto_async_counter_t;
+
+/* bucket 0 counts zero, bucket n counts [2^(n-1), 2^n) and the last
+ * bucket is open ended; depth is in elts, latency in microseconds */
+#define VNET_CRYPTO_ASYNC_HIST_N_BUCKETS 16
+
 typedef struct
 {
   vnet_crypto_alg_data_t *algs;
@@ -473,6 +498,10 @@ typedef struct
 #define VNET_CRYPTO_ASYNC_DISPATCH_POLLING 0
 #define VNET_CRYPTO_ASYNC_DISPATCH_INTERRUPT 1
   u8 dispatch_mode;
+  /* max time crypto-dispatch spends dequeuing per call, 0 for no limit */
+  u32 dispatch_budget_us;
+  u64 dispatch_budget_clocks;
+  vlib_simple_counter_main_t async_counters[VNET_CRYPTO_ASYNC_N_COUNTERS];
 } vnet_crypto_main_t;
 
 extern vnet_crypto_main_t crypto_main;
@@ -510,6 +539,8 @@ void vnet_crypto_request_async_mode (int is_enable);
 
 void vnet_crypto_set_async_dispatch_mode (u8 mode);
 
+void vnet_crypto_set_async_dispatch_budget (u32 budget_us);
+
 vnet_crypto_async_alg_t vnet_crypto_link_algs (vnet_crypto_alg_t crypto_alg,
 					       vnet_crypto_alg_t integ_alg);
 
@@ -587,6 +618,22 @@ vnet_crypto_async_free_frame (vlib_main_t * vm,
   pool_put (ct->frame_pool, frame);
 }
 
+static_always_inline u32
+vnet_crypto_async_hist_bucket (u64 v)
+{
+  if (v == 0)
+    return 0;
+  return clib_min (1 + min_log2 (v), VNET_CRYPTO_ASYNC_HIST_N_BUCKETS - 1);
+}
+
+static_always_inline void
+vnet_crypto_async_count (vnet_crypto_main_t *cm, u32 thread_index,
+			 vnet_crypto_async_counter_t c, u32 index, u64 n)
+{
+  vlib_increment_simple_counter (&cm->async_counters[c], thread_index, index,
+				 n);
+}
+
 static_always_inline int
 vnet_crypto_async_submit_open_frame (vlib_main_t * vm,
 				     vnet_crypto_async_frame_t * frame)
@@ -597,6 +644,8 @@ vnet_crypto_async_submit_open_frame (vlib_main_t * vm,
 
   frame->state = VNET_CRYPTO_FRAME_STATE_PENDING;
   frame->enqueue_thread_index = vm->thread_index;
+  frame->engine_index = cm->async_opt_data[frame->op].active_engine_index_async;
+  frame->submit_time = clib_cpu_time_now ();
 
   if (PREDICT_FALSE (cm->enqueue_handlers == NULL))
     {
@@ -608,6 +657,18 @@ vnet_crypto_async_submit_open_frame (vlib_main_t * vm,
 
   if (PREDICT_TRUE (ret == 0))
     {
+      vnet_crypto_thread_t *ct = cm->threads + vm->thread_index;
+      u32 ti = vm->thread_index, ei = frame->engine_index;
+      u32 b = vnet_crypto_async_hist_bucket (ct->n_inflight_elts[ei]);
+
+      vnet_crypto_async_count (cm, ti,
+			       VNET_CRYPTO_ASYNC_COUNTER_FRAMES_SUBMITTED, ei, 1);
+      vnet_crypto_async_count (cm, ti, VNET_CRYPTO_ASYNC_COUNTER_ELTS_SUBMITTED,
+			       ei, frame->n_elts);
+      vnet_crypto_async_count (cm, ti, VNET_CRYPTO_ASYNC_COUNTER_DEPTH_HIST,
+			       ei * VNET_CRYPTO_ASYNC_HIST_N_BUCKETS + b, 1);
+      ct->n_inflight_elts[ei] += frame->n_elts;
+
       if (cm->dispatch_mode == VNET_CRYPTO_ASYNC_DISPATCH_INTERRUPT)
 	{
 	  for (; i < tm->n_vlib_mains; i++)
@@ -71,11 +71,36 @@ vnet_crypto_async_add_trace (vlib_main_t * vm, vlib_node_runtime_t * node,
   tr->op = op_id;
 }
 
+static_always_inline void
+crypto_async_frame_completed (vlib_main_t *vm, vnet_crypto_thread_t *ct,
+			      vnet_crypto_async_frame_t *cf)
+{
+  vnet_crypto_main_t *cm = &crypto_main;
+  u32 ti = vm->thread_index, ei = cf->engine_index;
+  u64 dt = clib_cpu_time_now () - cf->submit_time;
+  u64 us = dt * vm->clib_time.seconds_per_clock * 1e6;
+  u32 b = vnet_crypto_async_hist_bucket (us);
+
+  vnet_crypto_async_count (cm, ti, VNET_CRYPTO_ASYNC_COUNTER_FRAMES_COMPLETED,
+			   ei, 1);
+  vnet_crypto_async_count (cm, ti, VNET_CRYPTO_ASYNC_COUNTER_ELTS_COMPLETED, ei,
+			   cf->n_elts);
+  vnet_crypto_async_count (cm, ti, VNET_CRYPTO_ASYNC_COUNTER_LATENCY_HIST,
+			   ei * VNET_CRYPTO_ASYNC_HIST_N_BUCKETS + b, 1);
+  ct->n_inflight_elts[ei] -= clib_min (ct->n_inflight_elts[ei], cf->n_elts);
+}
+
+static_always_inline int
+crypto_dispatch_budget_exhausted (u64 deadline)
+{
+  return deadline && clib_cpu_time_now () >= deadline;
+}
+
 static_always_inline u32
 crypto_dequeue_frame (vlib_main_t * vm, vlib_node_runtime_t * node,
 		      vnet_crypto_thread_t * ct,
 		      vnet_crypto_frame_dequeue_t * hdl, u32 n_cache,
-		      u32 * n_total)
+		      u32 * n_total, u64 deadline)
 {
   vnet_crypto_main_t *cm = &crypto_main;
   u32 n_elts = 0;
@@ -132,6 +157,7 @@ crypto_dequeue_frame (vlib_main_t * vm, vlib_node_runtime_t * node,
 						 cf->elts[i].status);
 		}
 	    }
+	  crypto_async_frame_completed (vm, ct, cf);
 	  vnet_crypto_async_free_frame (vm, cf);
 	}
       /* signal enqueue-thread to dequeue the processed frame (n_elts>0) */
@@ -143,6 +169,10 @@ crypto_dequeue_frame (vlib_main_t * vm, vlib_node_runtime_t * node,
 	    cm->crypto_node_index);
 	}
 
+      /* leave the rest for the next call rather than starve the graph */
+      if (crypto_dispatch_budget_exhausted (deadline))
+	break;
+
       n_elts = 0;
       enqueue_thread_idx = 0;
       cf = (hdl) (vm, &n_elts, &enqueue_thread_idx);
@@ -159,18 +189,39 @@ VLIB_NODE_FN (crypto_dispatch_node) (vlib_main_t * vm,
   vnet_crypto_main_t *cm = &crypto_main;
   vnet_crypto_thread_t *ct = cm->threads + vm->thread_index;
   u32 n_dispatched = 0, n_cache = 0, index;
+  u64 deadline = 0;
+  int rearm;
+
+  if (cm->dispatch_budget_clocks)
+    deadline = clib_cpu_time_now () + cm->dispatch_budget_clocks;
+
   vec_foreach_index (index, cm->dequeue_handlers)
     {
       if (PREDICT_FALSE (cm->dequeue_handlers[index] == 0))
 	continue;
-      n_cache = crypto_dequeue_frame (
-	vm, node, ct, cm->dequeue_handlers[index], n_cache, &n_dispatched);
+      n_cache =
+	crypto_dequeue_frame (vm, node, ct, cm->dequeue_handlers[index],
+			      n_cache, &n_dispatched, deadline);
+      if (crypto_dispatch_budget_exhausted (deadline))
+	break;
     }
   /* *INDENT-ON* */
   if (n_cache)
     vlib_buffer_enqueue_to_next_vec (vm, node, &ct->buffer_indices, &ct->nexts,
 				     n_cache);
 
+  /* in interrupt mode keep running while this thread has frames in flight
+   * or work was left behind; engines completing in hardware never signal
+   * us, and once everything is back the node goes idle */
+  if (cm->dispatch_mode == VNET_CRYPTO_ASYNC_DISPATCH_INTERRUPT)
+    {
+      rearm = crypto_dispatch_budget_exhausted (deadline);
+      vec_foreach_index (index, ct->n_inflight_elts)
+	rearm |= ct->n_inflight_elts[index] != 0;
+      if (rearm)
+	vlib_node_set_interrupt_pending (vm, node->node_index);
+    }
+
   return n_dispatched;
 }
 
@@ -36,7 +36,9 @@ vlib_log_class_t replicate_logger;
 }
 
 #define foreach_replicate_dpo_error                       \
-_(BUFFER_ALLOCATION_FAILURE, "Buffer Allocation Failure")
+_(BUFFER_ALLOCATION_FAILURE, "Buffer Allocation Failure")    \
+_(CONGESTION_DROP, "Handoff Congestion Drop")                \
+_(REPLICATE_DELETED, "Replicate Deleted During Handoff")
 
 typedef enum {
 #define _(sym,str) REPLICATE_DPO_ERROR_##sym,
@@ -714,101 +716,292 @@ VLIB_CLI_COMMAND (replicate_show_command, static) = {
     .function = replicate_show,
 };
 
+extern vlib_node_registration_t ip4_replicate_slice_node;
+extern vlib_node_registration_t ip6_replicate_slice_node;
+extern vlib_node_registration_t mpls_replicate_slice_node;
+
+void
+replicate_set_handoff_threshold (u32 threshold)
+{
+    replicate_main_t * rm = &replicate_main;
+
+    /* the slice frame queues are only needed once handoff is enabled */
+    if (threshold && ~0 == rm->fq_index[DPO_PROTO_IP4])
+    {
+        rm->fq_index[DPO_PROTO_IP4] =
+            vlib_frame_queue_main_init (ip4_replicate_slice_node.index, 0);
+        rm->fq_index[DPO_PROTO_IP6] =
+            vlib_frame_queue_main_init (ip6_replicate_slice_node.index, 0);
+        rm->fq_index[DPO_PROTO_MPLS] =
+            vlib_frame_queue_main_init (mpls_replicate_slice_node.index, 0);
+    }
+
+    rm->handoff_threshold = threshold;
+}
+
+static clib_error_t *
+replicate_set_handoff (vlib_main_t * vm,
+                       unformat_input_t * input,
+                       vlib_cli_command_t * cmd)
+{
+    u32 threshold = ~0;
+
+    while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+        if (unformat (input, "threshold %d", &threshold))
+            ;
+        else if (unformat (input, "disable"))
+            threshold = 0;
+        else
+            return clib_error_return (0, "unknown input '%U'",
+                                      format_unformat_error, input);
+    }
+
+    if (~0 == threshold)
+        return clib_error_return (0, "specify a threshold or disable");
+    if (threshold > UINT16_MAX)
+        return clib_error_return (0, "threshold must be at most %d",
+                                  UINT16_MAX);
+
+    replicate_set_handoff_threshold (threshold);
+
+    return 0;
+}
+
+/*?
+ * Spread the replication of packets whose replicate has more buckets
+ * than the threshold across the workers. Each worker serves a slice of
+ * the buckets from its own copy of the packet.
+ *
+ * @cliexpar
+ * @cliexcmd{set replicate handoff threshold 256}
+?*/
+VLIB_CLI_COMMAND (replicate_set_handoff_command, static) = {
+    .path = "set replicate handoff",
+    .short_help = "set replicate handoff [threshold <n>|disable]",
+    .function = replicate_set_handoff,
+};
+
 typedef struct replicate_trace_t_
 {
     index_t rep_index;
     dpo_id_t dpo;
 } replicate_trace_t;
 
-static uword
+/**
+ * Spread the buckets of a high fanout replication across the workers.
+ * The first slice is served by this worker, each other slice by another
+ * worker from its own copy of the packet.
+ * Returns the number of buckets to serve locally.
+ */
+static u32
+replicate_handoff_slices (vlib_main_t * vm,
+                          vlib_node_runtime_t * node,
+                          vlib_buffer_t * b0,
+                          u32 n_buckets)
+{
+    replicate_main_t * rm = &replicate_main;
+    u32 n_workers, n_slices, slice_size, slice, first;
+    u32 thread_index = vm->thread_index;
+
+    n_workers = vlib_num_workers ();
+    n_slices = clib_min (n_workers,
+                         ((n_buckets + rm->handoff_threshold - 1) /
+                          rm->handoff_threshold));
+
+    if (n_slices < 2)
+        return (n_buckets);
+
+    slice_size = (n_buckets + n_slices - 1) / n_slices;
+
+    for (slice = 1; slice < n_slices; slice++)
+    {
+        vlib_buffer_t *c0;
+
+        first = slice * slice_size;
+        if (first >= n_buckets)
+            break;
+
+        c0 = vlib_buffer_copy (vm, b0);
+        if (PREDICT_FALSE (NULL == c0))
+        {
+            vlib_node_increment_counter
+                (vm, node->node_index,
+                 REPLICATE_DPO_ERROR_BUFFER_ALLOCATION_FAILURE, 1);
+            continue;
+        }
+
+        vnet_buffer2 (c0)->replicate.first_bucket = first;
+        vnet_buffer2 (c0)->replicate.n_buckets =
+            clib_min (slice_size, n_buckets - first);
+
+        vec_add1 (rm->handoff_buffers[thread_index],
+                  vlib_get_buffer_index (vm, c0));
+        /* workers are threads 1 .. n_workers */
+        vec_add1 (rm->handoff_threads[thread_index],
+                  1 + ((thread_index + slice - 1) % n_workers));
+    }
+
+    return (slice_size);
+}
+
+static_always_inline void
+replicate_flush (vlib_main_t * vm,
+                 vlib_node_runtime_t * node,
+                 u32 thread_index)
+{
+    replicate_main_t * rm = &replicate_main;
+
+    vlib_buffer_enqueue_to_next (vm, node, rm->clones[thread_index],
+                                 rm->nexts[thread_index],
+                                 vec_len (rm->clones[thread_index]));
+    vec_reset_length (rm->clones[thread_index]);
+    vec_reset_length (rm->nexts[thread_index]);
+}
+
+static_always_inline uword
 replicate_inline (vlib_main_t * vm,
                   vlib_node_runtime_t * node,
-                  vlib_frame_t * frame)
+                  vlib_frame_t * frame,
+                  dpo_proto_t proto,
+                  int is_slice)
 {
     vlib_combined_counter_main_t * cm = &replicate_main.repm_counters;
     replicate_main_t * rm = &replicate_main;
-    u32 n_left_from, * from, * to_next, next_index;
-    u32 thread_index = vlib_get_thread_index();
+    u32 n_left_from, * from, n_handoff;
+    u32 thread_index = vm->thread_index;
 
     from = vlib_frame_vector_args (frame);
     n_left_from = frame->n_vectors;
-    next_index = node->cached_next_index;
-  
+
     while (n_left_from > 0)
     {
-        u32 n_left_to_next;
-
-        vlib_get_next_frame (vm, node, next_index,
-                             to_next, n_left_to_next);
-
-        while (n_left_from > 0 && n_left_to_next > 0)
-	{
-            u32 next0, ci0, bi0, bucket, repi0;
-            const replicate_t *rep0;
-            vlib_buffer_t * b0, *c0;
-            const dpo_id_t *dpo0;
-	    u8 num_cloned;
-
-            bi0 = from[0];
-            from += 1;
-            n_left_from -= 1;
-
-            b0 = vlib_get_buffer (vm, bi0);
-            repi0 = vnet_buffer (b0)->ip.adj_index[VLIB_TX];
+        u32 bi0, bucket, repi0, first0, n_buckets0, n_pending;
+        const replicate_t *rep0;
+        vlib_buffer_t * b0, *c0;
+        const dpo_id_t *dpo0;
+        u32 *clones;
+        u16 *nexts;
+        u16 num_cloned;
+
+        bi0 = from[0];
+        from += 1;
+        n_left_from -= 1;
+
+        b0 = vlib_get_buffer (vm, bi0);
+        repi0 = vnet_buffer (b0)->ip.adj_index[VLIB_TX];
+
+        if (is_slice)
+        {
+            /*
+             * the copy holds no lock on the replicate and frame queues
+             * are not drained by the barrier, so the replicate may have
+             * been deleted or have shrunk while the copy was queued
+             */
+            if (PREDICT_FALSE (pool_is_free_index (replicate_pool,
+                                                   repi0 & ~MPLS_IS_REPLICATE)))
+            {
+                vlib_node_increment_counter
+                    (vm, node->node_index,
+                     REPLICATE_DPO_ERROR_REPLICATE_DELETED, 1);
+                vlib_buffer_free_one (vm, bi0);
+                continue;
+            }
             rep0 = replicate_get(repi0);
 
+            first0 = vnet_buffer2 (b0)->replicate.first_bucket;
+            n_buckets0 = vnet_buffer2 (b0)->replicate.n_buckets;
+            if (first0 >= rep0->rep_n_buckets)
+                n_buckets0 = 0;
+            else
+                n_buckets0 = clib_min (n_buckets0,
+                                       rep0->rep_n_buckets - first0);
+            if (PREDICT_FALSE (0 == n_buckets0))
+            {
+                vlib_buffer_free_one (vm, bi0);
+                continue;
+            }
+        }
+        else
+        {
+            rep0 = replicate_get(repi0);
             vlib_increment_combined_counter(
                 cm, thread_index, repi0, 1,
                 vlib_buffer_length_in_chain(vm, b0));
 
-	    vec_validate (rm->clones[thread_index], rep0->rep_n_buckets - 1);
+            first0 = 0;
+            n_buckets0 = rep0->rep_n_buckets;
 
-	    num_cloned = vlib_buffer_clone (vm, bi0, rm->clones[thread_index],
-                                            rep0->rep_n_buckets,
-					    VLIB_BUFFER_CLONE_HEAD_SIZE);
+            if (PREDICT_FALSE (rm->handoff_threshold &&
+                               n_buckets0 > rm->handoff_threshold))
+                n_buckets0 = replicate_handoff_slices (vm, node, b0,
+                                                       n_buckets0);
+        }
 
-	    if (num_cloned != rep0->rep_n_buckets)
-	      {
-		vlib_node_increment_counter
-		  (vm, node->node_index,
-		   REPLICATE_DPO_ERROR_BUFFER_ALLOCATION_FAILURE, 1);
-	      }
+        /*
+         * clone into the tail of the pending vector, so the replicas of
+         * many packets are enqueued together
+         */
+        n_pending = vec_len (rm->clones[thread_index]);
+        vec_validate (rm->clones[thread_index], n_pending + n_buckets0 - 1);
+        vec_validate (rm->nexts[thread_index], n_pending + n_buckets0 - 1);
+        clones = rm->clones[thread_index] + n_pending;
+        nexts = rm->nexts[thread_index] + n_pending;
 
-            for (bucket = 0; bucket < num_cloned; bucket++)
-            {
-                ci0 = rm->clones[thread_index][bucket];
-                c0 = vlib_get_buffer(vm, ci0);
+        num_cloned = vlib_buffer_clone (vm, bi0, clones, n_buckets0,
+                                        VLIB_BUFFER_CLONE_HEAD_SIZE);
 
-                to_next[0] = ci0;
-                to_next += 1;
-                n_left_to_next -= 1;
+        if (num_cloned != n_buckets0)
+        {
+            vlib_node_increment_counter
+                (vm, node->node_index,
+                 REPLICATE_DPO_ERROR_BUFFER_ALLOCATION_FAILURE, 1);
+        }
 
-                dpo0 = replicate_get_bucket_i(rep0, bucket);
-                next0 = dpo0->dpoi_next_node;
-                vnet_buffer (c0)->ip.adj_index[VLIB_TX] = dpo0->dpoi_index;
+        for (bucket = 0; bucket < num_cloned; bucket++)
+        {
+            c0 = vlib_get_buffer(vm, clones[bucket]);
 
-                if (PREDICT_FALSE(b0->flags & VLIB_BUFFER_IS_TRACED))
-                {
-                    replicate_trace_t *t;
+            dpo0 = replicate_get_bucket_i(rep0, first0 + bucket);
+            nexts[bucket] = dpo0->dpoi_next_node;
+            vnet_buffer (c0)->ip.adj_index[VLIB_TX] = dpo0->dpoi_index;
 
-                    t = vlib_add_trace (vm, node, c0, sizeof (*t));
-                    t->rep_index = repi0;
-                    t->dpo = *dpo0;
-                }
+            if (PREDICT_FALSE(b0->flags & VLIB_BUFFER_IS_TRACED))
+            {
+                replicate_trace_t *t;
 
-                vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-                                                 to_next, n_left_to_next,
-                                                 ci0, next0);
-		if (PREDICT_FALSE (n_left_to_next == 0))
-		  {
-		    vlib_put_next_frame (vm, node, next_index, n_left_to_next);
-		    vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
-		  }
+                t = vlib_add_trace (vm, node, c0, sizeof (*t));
+                t->rep_index = repi0;
+                t->dpo = *dpo0;
             }
-	    vec_reset_length (rm->clones[thread_index]);
         }
 
-        vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+        vec_set_len (rm->clones[thread_index], n_pending + num_cloned);
+        vec_set_len (rm->nexts[thread_index], n_pending + num_cloned);
+
+        if (vec_len (rm->clones[thread_index]) >= VLIB_FRAME_SIZE)
+            replicate_flush (vm, node, thread_index);
+    }
+
+    if (vec_len (rm->clones[thread_index]))
+        replicate_flush (vm, node, thread_index);
+
+    n_handoff = vec_len (rm->handoff_buffers[thread_index]);
+    if (PREDICT_FALSE (n_handoff))
+    {
+        u32 n_enq;
+
+        n_enq = vlib_buffer_enqueue_to_thread (vm, node, rm->fq_index[proto],
+                                               rm->handoff_buffers[thread_index],
+                                               rm->handoff_threads[thread_index],
+                                               n_handoff, 1);
+        if (n_enq < n_handoff)
+            vlib_node_increment_counter
+                (vm, node->node_index,
+                 REPLICATE_DPO_ERROR_CONGESTION_DROP, n_handoff - n_enq);
+
+        vec_reset_length (rm->handoff_buffers[thread_index]);
+        vec_reset_length (rm->handoff_threads[thread_index]);
     }
 
     return frame->n_vectors;
@@ -832,7 +1025,7 @@ ip4_replicate (vlib_main_t * vm,
                vlib_node_runtime_t * node,
                vlib_frame_t * frame)
 {
-    return (replicate_inline (vm, node, frame));
+    return (replicate_inline (vm, node, frame, DPO_PROTO_IP4, 0));
 }
 
 /**
@@ -853,12 +1046,35 @@ VLIB_REGISTER_NODE (ip4_replicate_node) = {
   },
 };
 
+static uword
+ip4_replicate_slice (vlib_main_t * vm,
+                     vlib_node_runtime_t * node,
+                     vlib_frame_t * frame)
+{
+    return (replicate_inline (vm, node, frame, DPO_PROTO_IP4, 1));
+}
+
+/**
+ * @brief IP4 replication of the buckets handed off by another worker
+ */
+VLIB_REGISTER_NODE (ip4_replicate_slice_node) = {
+  .function = ip4_replicate_slice,
+  .name = "ip4-replicate-slice",
+  .vector_size = sizeof (u32),
+  .sibling_of = "ip4-replicate",
+
+  .n_errors = ARRAY_LEN(replicate_dpo_error_strings),
+  .error_strings = replicate_dpo_error_strings,
+
+  .format_trace = format_replicate_trace,
+};
+
 static uword
 ip6_replicate (vlib_main_t * vm,
                vlib_node_runtime_t * node,
                vlib_frame_t * frame)
 {
-    return (replicate_inline (vm, node, frame));
+    return (replicate_inline (vm, node, frame, DPO_PROTO_IP6, 0));
 }
 
 /**
@@ -879,12 +1095,35 @@ VLIB_REGISTER_NODE (ip6_replicate_node) = {
   },
 };
 
+static uword
+ip6_replicate_slice (vlib_main_t * vm,
+                     vlib_node_runtime_t * node,
+                     vlib_frame_t * frame)
+{
+    return (replicate_inline (vm, node, frame, DPO_PROTO_IP6, 1));
+}
+
+/**
+ * @brief IPv6 replication of the buckets handed off by another worker
+ */
+VLIB_REGISTER_NODE (ip6_replicate_slice_node) = {
+  .function = ip6_replicate_slice,
+  .name = "ip6-replicate-slice",
+  .vector_size = sizeof (u32),
+  .sibling_of = "ip6-replicate",
+
+  .n_errors = ARRAY_LEN(replicate_dpo_error_strings),
+  .error_strings = replicate_dpo_error_strings,
+
+  .format_trace = format_replicate_trace,
+};
+
 static uword
 mpls_replicate (vlib_main_t * vm,
                 vlib_node_runtime_t * node,
                 vlib_frame_t * frame)
 {
-    return (replicate_inline (vm, node, frame));
+    return (replicate_inline (vm, node, frame, DPO_PROTO_MPLS, 0));
 }
 
 /**
@@ -905,12 +1144,41 @@ VLIB_REGISTER_NODE (mpls_replicate_node) = {
   },
 };
 
+static uword
+mpls_replicate_slice (vlib_main_t * vm,
+                      vlib_node_runtime_t * node,
+                      vlib_frame_t * frame)
+{
+    return (replicate_inline (vm, node, frame, DPO_PROTO_MPLS, 1));
+}
+
+/**
+ * @brief MPLS replication of the buckets handed off by another worker
+ */
+VLIB_REGISTER_NODE (mpls_replicate_slice_node) = {
+  .function = mpls_replicate_slice,
+  .name = "mpls-replicate-slice",
+  .vector_size = sizeof (u32),
+  .sibling_of = "mpls-replicate",
+
+  .n_errors = ARRAY_LEN(replicate_dpo_error_strings),
+  .error_strings = replicate_dpo_error_strings,
+
+  .format_trace = format_replicate_trace,
+};
+
 clib_error_t *
 replicate_dpo_init (vlib_main_t * vm)
 {
   replicate_main_t * rm = &replicate_main;
 
   vec_validate (rm->clones, vlib_num_workers());
+  vec_validate (rm->nexts, vlib_num_workers());
+  vec_validate (rm->handoff_buffers, vlib_num_workers());
+  vec_validate (rm->handoff_threads, vlib_num_workers());
+
+  /* created when handoff is first enabled */
+  clib_memset (rm->fq_index, 0xff, sizeof (rm->fq_index));
 
   return 0;
 }
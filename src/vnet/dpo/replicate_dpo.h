@@ -36,6 +36,23 @@ typedef struct replicate_main_t_
 
     /* per-cpu vector of cloned packets */
     u32 **clones;
+
+    /* per-cpu vector of the next nodes of the cloned packets */
+    u16 **nexts;
+
+    /* per-cpu vectors of the packet copies handed off to other workers */
+    u32 **handoff_buffers;
+    u16 **handoff_threads;
+
+    /**
+     * replications with more buckets than this are spread across
+     * the workers. 0 disables it.
+     */
+    u32 handoff_threshold;
+
+    /* frame queues of the per-protocol slice nodes, ~0 until handoff
+       is first enabled */
+    u32 fq_index[DPO_PROTO_NUM];
 } replicate_main_t;
 
 extern replicate_main_t replicate_main;
@@ -138,6 +155,8 @@ extern u16 replicate_n_buckets(index_t repi);
 extern index_t replicate_dup(replicate_flags_t flags,
                              index_t repi);
 
+extern void replicate_set_handoff_threshold(u32 threshold);
+
 /**
  * The encapsulation breakages are for fast DP access
  */
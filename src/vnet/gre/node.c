@@ -288,6 +288,7 @@ gre_input (vlib_main_t * vm,
 					   1 /* packets */ ,
 					   len[0] /* bytes */ );
 	  vnet_buffer (b[0])->sw_if_index[VLIB_RX] = tun_sw_if_index[0];
+	  vnet_buffer_reset_rx_hash (b[0]);
 	}
       if (PREDICT_TRUE (next[1] > GRE_INPUT_NEXT_DROP))
 	{
@@ -299,6 +300,7 @@ gre_input (vlib_main_t * vm,
 					   1 /* packets */ ,
 					   len[1] /* bytes */ );
 	  vnet_buffer (b[1])->sw_if_index[VLIB_RX] = tun_sw_if_index[1];
+	  vnet_buffer_reset_rx_hash (b[1]);
 	}
 
       vnet_buffer (b[0])->sw_if_index[VLIB_TX] = (u32) ~0;
@@ -412,6 +414,7 @@ gre_input (vlib_main_t * vm,
 					   1 /* packets */ ,
 					   len[0] /* bytes */ );
 	  vnet_buffer (b[0])->sw_if_index[VLIB_RX] = tun_sw_if_index[0];
+	  vnet_buffer_reset_rx_hash (b[0]);
 	}
 
       vnet_buffer (b[0])->sw_if_index[VLIB_TX] = (u32) ~0;
@@ -24,6 +24,8 @@ typedef struct
   vnet_hash_fn_t hash_fn;
   uword *workers_bitmap;
   u32 *workers;
+  /* the hash covers the L4 ports and is kept in the buffer for ECMP */
+  u8 keep_rx_hash;
 } per_inteface_handoff_data_t;
 
 typedef struct
@@ -115,41 +117,65 @@ VLIB_NODE_FN (worker_handoff_node) (vlib_main_t * vm,
   vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
   u32 n_enq, n_left_from, *from;
   u16 thread_indices[VLIB_FRAME_SIZE], *ti;
+  u32 hashes[VLIB_FRAME_SIZE], *h;
+  void *data[VLIB_FRAME_SIZE];
+  u32 i;
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
   vlib_get_buffers (vm, from, bufs, n_left_from);
 
+  for (i = 0; i < n_left_from; i++)
+    data[i] = vlib_buffer_get_current (bufs[i]);
+
   b = bufs;
   ti = thread_indices;
+  h = hashes;
 
   while (n_left_from > 0)
     {
       per_inteface_handoff_data_t *ihd0;
-      u32 sw_if_index0, hash, index0;
-      void *data;
+      u32 sw_if_index0, index0, n_same;
 
       sw_if_index0 = vnet_buffer (b[0])->sw_if_index[VLIB_RX];
       ihd0 = vec_elt_at_index (hm->if_data, sw_if_index0);
 
-      /* Compute ingress LB hash */
-      data = vlib_buffer_get_current (b[0]);
-      ihd0->hash_fn (&data, &hash, 1);
-
-      /* if input node did not specify next index, then packet
-         should go to ethernet-input */
+      /* packets received on the same interface share the hash function,
+         so compute the ingress LB hash for the whole run in one call */
+      n_same = 1;
+      while (n_same < n_left_from &&
+	     vnet_buffer (b[n_same])->sw_if_index[VLIB_RX] == sw_if_index0)
+	n_same++;
 
-      if (PREDICT_TRUE (is_pow2 (vec_len (ihd0->workers))))
-	index0 = hash & (vec_len (ihd0->workers) - 1);
-      else
-	index0 = hash % vec_len (ihd0->workers);
+      ihd0->hash_fn (data + (b - bufs), h, n_same);
 
-      ti[0] = hm->first_worker_index + ihd0->workers[index0];
+      for (i = 0; i < n_same; i++)
+	{
+	  if (PREDICT_TRUE (is_pow2 (vec_len (ihd0->workers))))
+	    index0 = h[i] & (vec_len (ihd0->workers) - 1);
+	  else
+	    index0 = h[i] % vec_len (ihd0->workers);
+
+	  ti[i] = hm->first_worker_index + ihd0->workers[index0];
+
+	  /* keep the hash so that the ECMP lookup on the receiving worker
+	     does not need to compute another one. Its low bits selected
+	     the worker, so mix it first or each worker would only ever
+	     use the ECMP buckets matching its own index */
+	  if (ihd0->keep_rx_hash &&
+	      !(b[i]->flags & VNET_BUFFER_F_RX_HASH_VALID))
+	    {
+	      u32 a = h[i], b0 = 0, c = 0;
+	      hash_v3_finalize32 (a, b0, c);
+	      vnet_buffer_rx_hash_set (b[i], c);
+	    }
+	}
 
       /* next */
-      n_left_from -= 1;
-      ti += 1;
-      b += 1;
+      n_left_from -= n_same;
+      ti += n_same;
+      h += n_same;
+      b += n_same;
     }
 
   if (PREDICT_FALSE (node->flags & VLIB_NODE_FLAG_TRACE))
@@ -214,6 +240,7 @@ interface_handoff_enable_disable (vlib_main_t *vm, u32 sw_if_index,
 
   vec_free (d->workers);
   vec_free (d->workers_bitmap);
+  d->keep_rx_hash = 0;
 
   if (enable_disable)
     {
@@ -234,8 +261,11 @@ interface_handoff_enable_disable (vlib_main_t *vm, u32 sw_if_index,
       else
 	{
 	  if (is_l4)
-	    d->hash_fn =
-	      vnet_hash_default_function (VNET_HASH_FN_TYPE_ETHERNET);
+	    {
+	      d->hash_fn =
+		vnet_hash_default_function (VNET_HASH_FN_TYPE_ETHERNET);
+	      d->keep_rx_hash = 1;
+	    }
 	  else
 	    d->hash_fn = vnet_hash_function_from_name (
 	      "handoff-eth", VNET_HASH_FN_TYPE_ETHERNET);
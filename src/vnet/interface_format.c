@@ -701,6 +701,19 @@ format_vnet_buffer_opaque2 (u8 * s, va_list * args)
 	      (u32) (o->gso_size), (u32) (o->gso_l4_hdr_sz));
   vec_add1 (s, '\n');
 
+  if (b->flags & VNET_BUFFER_F_RX_HASH_VALID)
+    {
+      s = format (s, "rx_hash: 0x%08x", o->rx_hash);
+      vec_add1 (s, '\n');
+    }
+
+  if (b->flags & VNET_BUFFER_F_IPSEC_INLINE)
+    {
+      s = format (s, "ipsec_inline.sa_index: %d, ipsec_inline.seq_hi: %u",
+		  o->ipsec_inline.sa_index, o->ipsec_inline.seq_hi);
+      vec_add1 (s, '\n');
+    }
+
   for (i = 0; i < vec_len (im->buffer_opaque2_format_helpers); i++)
     {
       helper_fp = im->buffer_opaque2_format_helpers[i];
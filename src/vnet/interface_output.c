@@ -313,6 +313,7 @@ vnet_interface_pcap_tx_trace (vlib_main_t *vm, vlib_node_runtime_t *node,
   u32 n_left_from, *from;
   u32 sw_if_index = ~0, hw_if_index = ~0;
   vnet_pcap_t *pp = &vnm->pcap;
+  u32 to_pcap[VLIB_FRAME_SIZE], n_to_pcap = 0, i;
 
   if (PREDICT_TRUE (pp->pcap_tx_enable == 0))
     return;
@@ -357,9 +358,14 @@ vnet_interface_pcap_tx_trace (vlib_main_t *vm, vlib_node_runtime_t *node,
 	    continue; /* defer to interface-output-template */
 	}
 
-      if (vnet_is_packet_pcaped (pp, b0, sw_if_index))
-	pcap_add_buffer (&pp->pcap_main, vm, bi0, pp->max_bytes_per_pkt);
+      if (vnet_is_packet_pcaped_unclassified (pp, b0, sw_if_index))
+	to_pcap[n_to_pcap++] = bi0;
     }
+
+  n_to_pcap = vnet_pcap_classify_buffers (vm, pp, to_pcap, n_to_pcap);
+
+  for (i = 0; i < n_to_pcap; i++)
+    pcap_add_buffer (&pp->pcap_main, vm, to_pcap[i], pp->max_bytes_per_pkt);
 }
 
 static_always_inline void
@@ -1080,6 +1086,7 @@ pcap_drop_trace (vlib_main_t * vm,
   i16 save_current_data;
   u16 save_current_length;
   vlib_error_main_t *em = &vm->error_main;
+  u32 to_pcap[VLIB_FRAME_SIZE], n_to_pcap = 0;
 
   from = vlib_frame_vector_args (f);
 
@@ -1101,8 +1108,20 @@ pcap_drop_trace (vlib_main_t * vm,
 	  && hash_get (im->pcap_drop_filter_hash, b0->error))
 	continue;
 
-      if (!vnet_is_packet_pcaped (pp, b0, ~0))
-	continue; /* not matching, skip */
+      if (vnet_is_packet_pcaped_unclassified (pp, b0, ~0))
+	to_pcap[n_to_pcap++] = bi0;
+    }
+
+  /* Classify the survivors in one go, matches only from here on */
+  n_left = vnet_pcap_classify_buffers (vm, pp, to_pcap, n_to_pcap);
+  from = to_pcap;
+
+  while (n_left > 0)
+    {
+      bi0 = from[0];
+      b0 = vlib_get_buffer (vm, bi0);
+      from++;
+      n_left--;
 
       /* Trace all drops, or drops received on a specific interface */
       save_current_data = b0->current_data;
@@ -172,7 +172,7 @@ VLIB_NODE_FN (ip4_load_balance_node) (vlib_main_t * vm,
 	  else
 	    {
 	      hc0 = vnet_buffer (b[0])->ip.flow_hash =
-		ip4_compute_flow_hash (ip0, lb0->lb_hash_config);
+		ip4_compute_flow_hash_buffer (b[0], ip0, lb0->lb_hash_config);
 	    }
 	  dpo0 = load_balance_get_fwd_bucket
 	    (lb0, (hc0 & (lb0->lb_n_buckets_minus_1)));
@@ -191,7 +191,7 @@ VLIB_NODE_FN (ip4_load_balance_node) (vlib_main_t * vm,
 	  else
 	    {
 	      hc1 = vnet_buffer (b[1])->ip.flow_hash =
-		ip4_compute_flow_hash (ip1, lb1->lb_hash_config);
+		ip4_compute_flow_hash_buffer (b[1], ip1, lb1->lb_hash_config);
 	    }
 	  dpo1 = load_balance_get_fwd_bucket
 	    (lb1, (hc1 & (lb1->lb_n_buckets_minus_1)));
@@ -240,7 +240,7 @@ VLIB_NODE_FN (ip4_load_balance_node) (vlib_main_t * vm,
 	  else
 	    {
 	      hc0 = vnet_buffer (b[0])->ip.flow_hash =
-		ip4_compute_flow_hash (ip0, lb0->lb_hash_config);
+		ip4_compute_flow_hash_buffer (b[0], ip0, lb0->lb_hash_config);
 	    }
 	  dpo0 = load_balance_get_fwd_bucket
 	    (lb0, (hc0 & (lb0->lb_n_buckets_minus_1)));
@@ -2136,6 +2136,12 @@ ip4_rewrite_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       int i;
       for (i = 2; i < 6; i++)
 	vlib_prefetch_buffer_header (bufs[i], LOAD);
+      /*
+       * start the rewrite stage of the pipeline, the loop prefetches the
+       * rewrites of b[4] and b[5] onwards
+       */
+      for (i = 0; i < 4; i++)
+	adj_prefetch_rewrite (vnet_buffer (bufs[i])->ip.adj_index[VLIB_TX]);
     }
 
   next = nexts;
@@ -2149,11 +2155,16 @@ ip4_rewrite_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       u32 tx_sw_if_index0, tx_sw_if_index1;
       u8 *p;
 
-      if (is_midchain)
-	{
-	  vlib_prefetch_buffer_header (b[6], LOAD);
-	  vlib_prefetch_buffer_header (b[7], LOAD);
-	}
+      /*
+       * pipeline the loads: buffer headers three iterations ahead, the
+       * adjacency rewrite two iterations ahead and the packet data one
+       * iteration ahead
+       */
+      vlib_prefetch_buffer_header (b[6], LOAD);
+      vlib_prefetch_buffer_header (b[7], LOAD);
+
+      adj_prefetch_rewrite (vnet_buffer (b[4])->ip.adj_index[VLIB_TX]);
+      adj_prefetch_rewrite (vnet_buffer (b[5])->ip.adj_index[VLIB_TX]);
 
       adj_index0 = vnet_buffer (b[0])->ip.adj_index[VLIB_TX];
       adj_index1 = vnet_buffer (b[1])->ip.adj_index[VLIB_TX];
@@ -2181,7 +2192,10 @@ ip4_rewrite_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       adj0 = adj_get (adj_index0);
       adj1 = adj_get (adj_index1);
 
-      /* Worth pipelining. No guarantee that adj0,1 are hot... */
+      /*
+       * The rewrites were prefetched two iterations ago, by the pipeline
+       * start for the first two pairs.
+       */
       rw_len0 = adj0[0].rewrite_header.data_bytes;
       rw_len1 = adj1[0].rewrite_header.data_bytes;
       vnet_buffer (b[0])->ip.save_rewrite_length = rw_len0;
@@ -2753,6 +2767,10 @@ set_ip_flow_hash_command_fn (vlib_main_t * vm,
 /*?
  * Configure the set of IPv4 fields used by the flow hash.
  *
+ * With 'rxhash' the hash delivered by the device (RSS) or computed by
+ * worker-handoff on ingress is used when present, instead of hashing the
+ * packet again.
+ *
  * @cliexpar
  * Example of how to set the flow hash on a given table:
  * @cliexcmd{set ip flow-hash table 7 dst sport dport proto}
@@ -2838,7 +2856,8 @@ VLIB_CLI_COMMAND (set_ip_flow_hash_command, static) =
 {
   .path = "set ip flow-hash",
   .short_help =
-  "set ip flow-hash table <table-id> [src] [dst] [sport] [dport] [proto] [reverse]",
+  "set ip flow-hash table <table-id> [src] [dst] [sport] [dport] [proto] "
+  "[reverse] [rxhash]",
   .function = set_ip_flow_hash_command_fn,
 };
 /* *INDENT-ON* */
@@ -140,7 +140,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	{
 	  flow_hash_config0 = lb0->lb_hash_config;
 	  hash_c0 = vnet_buffer (b[0])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip0, flow_hash_config0);
+	    ip4_compute_flow_hash_buffer (b[0], ip0, flow_hash_config0);
 	  dpo0 =
 	    load_balance_get_fwd_bucket (lb0,
 					 (hash_c0 &
@@ -154,7 +154,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	{
 	  flow_hash_config1 = lb1->lb_hash_config;
 	  hash_c1 = vnet_buffer (b[1])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip1, flow_hash_config1);
+	    ip4_compute_flow_hash_buffer (b[1], ip1, flow_hash_config1);
 	  dpo1 =
 	    load_balance_get_fwd_bucket (lb1,
 					 (hash_c1 &
@@ -168,7 +168,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	{
 	  flow_hash_config2 = lb2->lb_hash_config;
 	  hash_c2 = vnet_buffer (b[2])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip2, flow_hash_config2);
+	    ip4_compute_flow_hash_buffer (b[2], ip2, flow_hash_config2);
 	  dpo2 =
 	    load_balance_get_fwd_bucket (lb2,
 					 (hash_c2 &
@@ -182,7 +182,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	{
 	  flow_hash_config3 = lb3->lb_hash_config;
 	  hash_c3 = vnet_buffer (b[3])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip3, flow_hash_config3);
+	    ip4_compute_flow_hash_buffer (b[3], ip3, flow_hash_config3);
 	  dpo3 =
 	    load_balance_get_fwd_bucket (lb3,
 					 (hash_c3 &
@@ -268,7 +268,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	{
 	  flow_hash_config0 = lb0->lb_hash_config;
 	  hash_c0 = vnet_buffer (b[0])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip0, flow_hash_config0);
+	    ip4_compute_flow_hash_buffer (b[0], ip0, flow_hash_config0);
 	  dpo0 =
 	    load_balance_get_fwd_bucket (lb0,
 					 (hash_c0 &
@@ -282,7 +282,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	{
 	  flow_hash_config1 = lb1->lb_hash_config;
 	  hash_c1 = vnet_buffer (b[1])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip1, flow_hash_config1);
+	    ip4_compute_flow_hash_buffer (b[1], ip1, flow_hash_config1);
 	  dpo1 =
 	    load_balance_get_fwd_bucket (lb1,
 					 (hash_c1 &
@@ -340,7 +340,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	  flow_hash_config0 = lb0->lb_hash_config;
 
 	  hash_c0 = vnet_buffer (b[0])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip0, flow_hash_config0);
+	    ip4_compute_flow_hash_buffer (b[0], ip0, flow_hash_config0);
 	  dpo0 =
 	    load_balance_get_fwd_bucket (lb0,
 					 (hash_c0 &
@@ -40,6 +40,7 @@
 #ifndef included_ip_ip4_inlines_h
 #define included_ip_ip4_inlines_h
 
+#include <vnet/buffer.h>
 #include <vnet/ip/ip_flow_hash.h>
 #include <vnet/ip/ip4_packet.h>
 #include <vnet/tcp/tcp_packet.h>
@@ -98,6 +99,19 @@ ip4_compute_flow_hash (const ip4_header_t * ip,
   return c;
 }
 
+/* Compute the flow hash for a buffer, reusing the hash provided on
+   ingress if the config allows it */
+always_inline u32
+ip4_compute_flow_hash_buffer (const vlib_buffer_t *b, const ip4_header_t *ip,
+			      flow_hash_config_t flow_hash_config)
+{
+  if ((flow_hash_config & IP_FLOW_HASH_RX_HASH) &&
+      (b->flags & VNET_BUFFER_F_RX_HASH_VALID))
+    return ip_flow_hash_from_rx_hash (vnet_buffer2 (b)->rx_hash);
+
+  return ip4_compute_flow_hash (ip, flow_hash_config);
+}
+
 always_inline void *
 vlib_buffer_push_ip4_custom (vlib_main_t *vm, vlib_buffer_t *b,
 			     ip4_address_t *src, ip4_address_t *dst, int proto,
@@ -818,7 +818,7 @@ VLIB_NODE_FN (ip6_load_balance_node) (vlib_main_t * vm,
 	  else
 	    {
 	      hc0 = vnet_buffer (b[0])->ip.flow_hash =
-		ip6_compute_flow_hash (ip0, lb0->lb_hash_config);
+		ip6_compute_flow_hash_buffer (b[0], ip0, lb0->lb_hash_config);
 	    }
 	  dpo0 = load_balance_get_fwd_bucket
 	    (lb0, (hc0 & (lb0->lb_n_buckets_minus_1)));
@@ -837,7 +837,7 @@ VLIB_NODE_FN (ip6_load_balance_node) (vlib_main_t * vm,
 	  else
 	    {
 	      hc1 = vnet_buffer (b[1])->ip.flow_hash =
-		ip6_compute_flow_hash (ip1, lb1->lb_hash_config);
+		ip6_compute_flow_hash_buffer (b[1], ip1, lb1->lb_hash_config);
 	    }
 	  dpo1 = load_balance_get_fwd_bucket
 	    (lb1, (hc1 & (lb1->lb_n_buckets_minus_1)));
@@ -899,7 +899,7 @@ VLIB_NODE_FN (ip6_load_balance_node) (vlib_main_t * vm,
 	  else
 	    {
 	      hc0 = vnet_buffer (b[0])->ip.flow_hash =
-		ip6_compute_flow_hash (ip0, lb0->lb_hash_config);
+		ip6_compute_flow_hash_buffer (b[0], ip0, lb0->lb_hash_config);
 	    }
 	  dpo0 = load_balance_get_fwd_bucket
 	    (lb0, (hc0 & (lb0->lb_n_buckets_minus_1)));
@@ -1803,6 +1803,17 @@ ip6_rewrite_inline_with_gso (vlib_main_t * vm,
   next_index = node->cached_next_index;
   u32 thread_index = vm->thread_index;
 
+  /*
+   * start the pipeline: the dual loop reads the buffer headers of the
+   * next pair to prefetch their adjacency rewrites, and prefetches the
+   * headers of the pair after it
+   */
+  if (n_left_from >= 4)
+    {
+      vlib_prefetch_buffer_header (vlib_get_buffer (vm, from[2]), LOAD);
+      vlib_prefetch_buffer_header (vlib_get_buffer (vm, from[3]), LOAD);
+    }
+
   while (n_left_from > 0)
     {
       vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
@@ -1824,14 +1835,26 @@ ip6_rewrite_inline_with_gso (vlib_main_t * vm,
 	    p2 = vlib_get_buffer (vm, from[2]);
 	    p3 = vlib_get_buffer (vm, from[3]);
 
-	    vlib_prefetch_buffer_header (p2, LOAD);
-	    vlib_prefetch_buffer_header (p3, LOAD);
-
 	    clib_prefetch_store (p2->pre_data);
 	    clib_prefetch_store (p3->pre_data);
 
 	    CLIB_PREFETCH (p2->data, sizeof (ip0[0]), STORE);
 	    CLIB_PREFETCH (p3->data, sizeof (ip0[0]), STORE);
+
+	    /*
+	     * the headers of p2 and p3 were prefetched an iteration ago,
+	     * by the pipeline start for the first pair
+	     */
+	    adj_prefetch_rewrite (vnet_buffer (p2)->ip.adj_index[VLIB_TX]);
+	    adj_prefetch_rewrite (vnet_buffer (p3)->ip.adj_index[VLIB_TX]);
+
+	    if (n_left_from >= 6)
+	      {
+		vlib_prefetch_buffer_header (vlib_get_buffer (vm, from[4]),
+					     LOAD);
+		vlib_prefetch_buffer_header (vlib_get_buffer (vm, from[5]),
+					     LOAD);
+	      }
 	  }
 
 	  pi0 = to_next[0] = from[0];
@@ -2933,6 +2956,10 @@ set_ip6_flow_hash_command_fn (vlib_main_t * vm,
 /*?
  * Configure the set of IPv6 fields used by the flow hash.
  *
+ * With 'rxhash' the hash delivered by the device (RSS) or computed by
+ * worker-handoff on ingress is used when present, instead of hashing the
+ * packet again.
+ *
  * @cliexpar
  * @parblock
  * Example of how to set the flow hash on a given table:
@@ -3009,7 +3036,7 @@ set_ip6_flow_hash_command_fn (vlib_main_t * vm,
 VLIB_CLI_COMMAND (set_ip6_flow_hash_command, static) = {
   .path = "set ip6 flow-hash",
   .short_help = "set ip6 flow-hash table <table-id> [src] [dst] [sport] "
-		"[dport] [proto] [reverse] [flowlabel]",
+		"[dport] [proto] [reverse] [flowlabel] [rxhash]",
   .function = set_ip6_flow_hash_command_fn,
 };
 /* *INDENT-ON* */
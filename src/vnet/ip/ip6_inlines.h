@@ -40,6 +40,8 @@
 #ifndef included_ip_ip6_inlines_h
 #define included_ip_ip6_inlines_h
 
+#include <vnet/buffer.h>
+#include <vnet/ip/ip_flow_hash.h>
 #include <vnet/ip/ip6_packet.h>
 #include <vnet/ip/ip6_hop_by_hop_packet.h>
 
@@ -118,6 +120,19 @@ ip6_compute_flow_hash (const ip6_header_t * ip,
   return (u32) c;
 }
 
+/* Compute the flow hash for a buffer, reusing the hash provided on
+   ingress if the config allows it */
+always_inline u32
+ip6_compute_flow_hash_buffer (const vlib_buffer_t *b, const ip6_header_t *ip,
+			      flow_hash_config_t flow_hash_config)
+{
+  if ((flow_hash_config & IP_FLOW_HASH_RX_HASH) &&
+      (b->flags & VNET_BUFFER_F_RX_HASH_VALID))
+    return ip_flow_hash_from_rx_hash (vnet_buffer2 (b)->rx_hash);
+
+  return ip6_compute_flow_hash (ip, flow_hash_config);
+}
+
 /* ip6_locate_header
  *
  * This function is to search for the header specified by the protocol number
@@ -17,6 +17,7 @@
 #define __IP_FLOW_HASH_H__
 
 #include <vnet/ip/ip_types.h>
+#include <vppinfra/hash.h>
 
 /** Default: 5-tuple + flowlabel without the "reverse" bit */
 #define IP_FLOW_HASH_DEFAULT (0x9F)
@@ -38,7 +39,8 @@
   _ (proto, 4, IP_FLOW_HASH_PROTO)                                            \
   _ (reverse, 5, IP_FLOW_HASH_REVERSE_SRC_DST)                                \
   _ (symmetric, 6, IP_FLOW_HASH_SYMMETRIC)                                    \
-  _ (flowlabel, 7, IP_FLOW_HASH_FL)
+  _ (flowlabel, 7, IP_FLOW_HASH_FL)                                           \
+  _ (rxhash, 8, IP_FLOW_HASH_RX_HASH)
 
 /**
  * A flow hash configuration is a mask of the flow hash options
@@ -53,6 +55,27 @@ typedef enum flow_hash_config_t_
 /* Router ID mixed into the flow hash to prevent network polarisation */
 extern u32 ip_flow_hash_router_id;
 
+/**
+ * Derive the flow hash from a hash the packet carried in from the device
+ * (RSS) or from ingress handoff. The other config bits do not apply, the
+ * hash is only mixed with the router ID.
+ */
+always_inline u32
+ip_flow_hash_from_rx_hash (u32 rx_hash)
+{
+  u32 a, b, c;
+
+  if (PREDICT_TRUE (0 == ip_flow_hash_router_id))
+    return rx_hash;
+
+  a = rx_hash;
+  b = ip_flow_hash_router_id;
+  c = 0;
+  hash_v3_finalize32 (a, b, c);
+
+  return c;
+}
+
 int ip_flow_hash_set (ip_address_family_t af, u32 table_id,
 		      flow_hash_config_t flow_hash_config);
 void ip_flow_hash_router_id_set (u32 router_id);
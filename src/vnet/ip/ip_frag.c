@@ -42,7 +42,24 @@ format_ip_frag_trace (u8 * s, va_list * args)
   return s;
 }
 
-static u32 running_fragment_id;
+/*
+ * Fragment IDs are allocated per thread so the workers can fragment in
+ * parallel without sharing a counter; each thread starts at a different
+ * place in the ID space.
+ */
+typedef struct
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u32 running_fragment_id;
+} ip_frag_per_thread_t;
+
+static ip_frag_per_thread_t *ip_frag_per_thread;
+
+static_always_inline u32
+ip_frag_next_id (u32 thread_index)
+{
+  return ++ip_frag_per_thread[thread_index].running_fragment_id;
+}
 
 static void
 frag_set_sw_if_index (vlib_buffer_t * to, vlib_buffer_t * from)
@@ -87,16 +104,23 @@ frag_buffer_alloc (vlib_buffer_t * org_b, u32 * bi)
  * but does not generate buffer chains. I.e. a fragment is always
  * contained with in a single buffer and limited to the max buffer
  * size.
+ * When the packet to fragment is a single buffer that is not shared,
+ * it becomes the first fragment; only the payload of the following
+ * fragments is copied. The buffer then holds an extra reference, which
+ * the caller drops when freeing the original packet.
  * from_bi: current pointer must point to IPv4 header
  */
-ip_frag_error_t
-ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
-		      u16 l2unfragmentablesize, u32 ** buffer)
+static_always_inline ip_frag_error_t
+ip4_frag_do_fragment_inline (vlib_main_t *vm, u32 from_bi, u16 mtu,
+			     u16 l2unfragmentablesize, u32 **buffer,
+			     u32 *n_bytes_copied, u32 *n_bytes_referenced)
 {
   vlib_buffer_t *from_b;
   ip4_header_t *ip4;
   u16 len, max, rem, ip_frag_id, ip_frag_offset, head_bytes;
   u8 *org_from_packet, more;
+  u32 n_frags, n_alloc, n_first, *to_bis;
+  int in_place;
 
   from_b = vlib_get_buffer (vm, from_bi);
   org_from_packet = vlib_buffer_get_current (from_b);
@@ -113,7 +137,7 @@ ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
       return IP_FRAG_ERROR_MALFORMED;
     }
 
-  if (mtu < sizeof (ip4_header_t))
+  if (mtu < head_bytes + 8)
     {
       return IP_FRAG_ERROR_CANT_FRAGMENT_HEADER;
     }
@@ -134,7 +158,7 @@ ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
     }
   else
     {
-      ip_frag_id = (++running_fragment_id);
+      ip_frag_id = ip_frag_next_id (vm->thread_index);
       ip_frag_offset = 0;
       more = 0;
     }
@@ -145,6 +169,34 @@ ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
   u16 left_in_from_buffer = from_b->current_length - head_bytes;
   u16 ptr = 0;
 
+  /* All but the last fragment carry max bytes of payload */
+  n_frags = (rem + max - 1) / max;
+  in_place = (n_frags && 1 == from_b->ref_count &&
+	      !(from_b->flags &
+		(VLIB_BUFFER_NEXT_PRESENT | VNET_BUFFER_F_OFFLOAD)));
+
+  if (in_place && rem > left_in_from_buffer)
+    {
+      return IP_FRAG_ERROR_MALFORMED;
+    }
+
+  /* Allocate the buffers of all the copied fragments at once */
+  n_first = vec_len (*buffer);
+  n_alloc = n_frags - in_place;
+  vec_add2 (*buffer, to_bis, n_frags);
+  if (in_place)
+    to_bis[0] = from_bi;
+  if (n_alloc)
+    {
+      u32 n = vlib_buffer_alloc (vm, to_bis + in_place, n_alloc);
+      if (PREDICT_FALSE (n != n_alloc))
+	{
+	  vlib_buffer_free (vm, to_bis + in_place, n);
+	  vec_set_len (*buffer, n_first);
+	  return IP_FRAG_ERROR_MEMORY;
+	}
+    }
+
   /* Do the actual fragmentation */
   while (rem)
     {
@@ -156,58 +208,78 @@ ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
       len = (rem > max ? max : rem);
       if (len != rem)		/* Last fragment does not need to divisible by 8 */
 	len &= ~0x7;
-      if ((to_b = frag_buffer_alloc (org_from_b, &to_bi)) == 0)
-	{
-	  return IP_FRAG_ERROR_MEMORY;
-	}
-      vec_add1 (*buffer, to_bi);
-      frag_set_sw_if_index (to_b, org_from_b);
 
-      /* Copy ip4 header */
-      to_data = vlib_buffer_get_current (to_b);
-      clib_memcpy_fast (to_data, org_from_packet, head_bytes);
-      to_ip4 = (ip4_header_t *) (to_data + l2unfragmentablesize);
-      to_data = (void *) (to_ip4 + 1);
-      vnet_buffer (to_b)->l3_hdr_offset = to_b->current_data;
-      vlib_buffer_copy_trace_flag (vm, from_b, to_bi);
-      to_b->flags |= VNET_BUFFER_F_L3_HDR_OFFSET_VALID;
+      to_bi = *to_bis++;
 
-      if (from_b->flags & VNET_BUFFER_F_L4_HDR_OFFSET_VALID)
+      if (in_place && 0 == fo)
 	{
-	  vnet_buffer (to_b)->l4_hdr_offset =
-	    (vnet_buffer (to_b)->l3_hdr_offset +
-	     (vnet_buffer (from_b)->l4_hdr_offset -
-	      vnet_buffer (from_b)->l3_hdr_offset));
-	  to_b->flags |= VNET_BUFFER_F_L4_HDR_OFFSET_VALID;
+	  /*
+	   * The first fragment is the head of the original packet, the
+	   * following fragments copy the header from it before updating
+	   * all the fields that differ.
+	   */
+	  to_b = from_b;
+	  to_ip4 = ip4;
+	  vnet_buffer (to_b)->l3_hdr_offset = to_b->current_data;
+	  to_b->flags |= VNET_BUFFER_F_L3_HDR_OFFSET_VALID;
+	  to_b->ref_count++;
+	  ptr += len;
+	  left_in_from_buffer -= len;
+	  *n_bytes_referenced += len;
 	}
-
-      /* Spin through from buffers filling up the to buffer */
-      u16 left_in_to_buffer = len, to_ptr = 0;
-      while (1)
+      else
 	{
-	  u16 bytes_to_copy;
-
-	  /* Figure out how many bytes we can safely copy */
-	  bytes_to_copy = left_in_to_buffer <= left_in_from_buffer ?
-	    left_in_to_buffer : left_in_from_buffer;
-	  clib_memcpy_fast (to_data + to_ptr, from_data + ptr, bytes_to_copy);
-	  left_in_to_buffer -= bytes_to_copy;
-	  ptr += bytes_to_copy;
-	  left_in_from_buffer -= bytes_to_copy;
-	  if (left_in_to_buffer == 0)
-	    break;
+	  to_b = vlib_get_buffer (vm, to_bi);
+	  frag_set_sw_if_index (to_b, org_from_b);
+
+	  /* Copy ip4 header */
+	  to_data = vlib_buffer_get_current (to_b);
+	  clib_memcpy_fast (to_data, org_from_packet, head_bytes);
+	  to_ip4 = (ip4_header_t *) (to_data + l2unfragmentablesize);
+	  to_data = (void *) (to_ip4 + 1);
+	  vnet_buffer (to_b)->l3_hdr_offset = to_b->current_data;
+	  vlib_buffer_copy_trace_flag (vm, from_b, to_bi);
+	  to_b->flags |= VNET_BUFFER_F_L3_HDR_OFFSET_VALID;
+
+	  if (from_b->flags & VNET_BUFFER_F_L4_HDR_OFFSET_VALID)
+	    {
+	      vnet_buffer (to_b)->l4_hdr_offset =
+		(vnet_buffer (to_b)->l3_hdr_offset +
+		 (vnet_buffer (from_b)->l4_hdr_offset -
+		  vnet_buffer (from_b)->l3_hdr_offset));
+	      to_b->flags |= VNET_BUFFER_F_L4_HDR_OFFSET_VALID;
+	    }
 
-	  ASSERT (left_in_from_buffer <= 0);
-	  /* Move buffer */
-	  if (!(from_b->flags & VLIB_BUFFER_NEXT_PRESENT))
+	  /* Spin through from buffers filling up the to buffer */
+	  u16 left_in_to_buffer = len, to_ptr = 0;
+	  while (1)
 	    {
-	      return IP_FRAG_ERROR_MALFORMED;
+	      u16 bytes_to_copy;
+
+	      /* Figure out how many bytes we can safely copy */
+	      bytes_to_copy = left_in_to_buffer <= left_in_from_buffer ?
+		left_in_to_buffer : left_in_from_buffer;
+	      clib_memcpy_fast (to_data + to_ptr, from_data + ptr,
+				bytes_to_copy);
+	      left_in_to_buffer -= bytes_to_copy;
+	      ptr += bytes_to_copy;
+	      left_in_from_buffer -= bytes_to_copy;
+	      if (left_in_to_buffer == 0)
+		break;
+
+	      ASSERT (left_in_from_buffer <= 0);
+	      /* Move buffer */
+	      if (!(from_b->flags & VLIB_BUFFER_NEXT_PRESENT))
+		{
+		  return IP_FRAG_ERROR_MALFORMED;
+		}
+	      from_b = vlib_get_buffer (vm, from_b->next_buffer);
+	      from_data = (u8 *) vlib_buffer_get_current (from_b);
+	      ptr = 0;
+	      left_in_from_buffer = from_b->current_length;
+	      to_ptr += bytes_to_copy;
 	    }
-	  from_b = vlib_get_buffer (vm, from_b->next_buffer);
-	  from_data = (u8 *) vlib_buffer_get_current (from_b);
-	  ptr = 0;
-	  left_in_from_buffer = from_b->current_length;
-	  to_ptr += bytes_to_copy;
+	  *n_bytes_copied += len + head_bytes;
 	}
 
       to_b->flags |= VNET_BUFFER_F_IS_IP4;
@@ -231,6 +303,17 @@ ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
   return IP_FRAG_ERROR_NONE;
 }
 
+ip_frag_error_t
+ip4_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
+		      u16 l2unfragmentablesize, u32 ** buffer)
+{
+  u32 n_bytes_copied = 0, n_bytes_referenced = 0;
+
+  return ip4_frag_do_fragment_inline (vm, from_bi, mtu, l2unfragmentablesize,
+				      buffer, &n_bytes_copied,
+				      &n_bytes_referenced);
+}
+
 void
 ip_frag_set_vnet_buffer (vlib_buffer_t * b, u16 mtu, u8 next_index, u8 flags)
 {
@@ -250,6 +333,7 @@ frag_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
   n_left_from = frame->n_vectors;
   next_index = node->cached_next_index;
   u32 frag_sent = 0, small_packets = 0;
+  u32 bytes_copied = 0, bytes_referenced = 0;
   u32 *buffer = 0;
 
   while (n_left_from > 0)
@@ -273,17 +357,25 @@ frag_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  p0 = vlib_get_buffer (vm, pi0);
 	  u16 mtu = vnet_buffer (p0)->ip_frag.mtu;
+	  u16 pkt_size0 = 0;
+
+	  /* the original packet may become the first fragment */
+	  if (PREDICT_FALSE (p0->flags & VLIB_BUFFER_IS_TRACED))
+	    pkt_size0 = vlib_buffer_length_in_chain (vm, p0);
+
 	  if (is_ip6)
 	    error0 = ip6_frag_do_fragment (vm, pi0, mtu, 0, &buffer);
 	  else
-	    error0 = ip4_frag_do_fragment (vm, pi0, mtu, 0, &buffer);
+	    error0 = ip4_frag_do_fragment_inline (vm, pi0, mtu, 0, &buffer,
+						  &bytes_copied,
+						  &bytes_referenced);
 
 	  if (PREDICT_FALSE (p0->flags & VLIB_BUFFER_IS_TRACED))
 	    {
 	      ip_frag_trace_t *tr =
 		vlib_add_trace (vm, node, p0, sizeof (*tr));
 	      tr->mtu = mtu;
-	      tr->pkt_size = vlib_buffer_length_in_chain (vm, p0);
+	      tr->pkt_size = pkt_size0;
 	      tr->n_fragments = vec_len (buffer);
 	      tr->next = vnet_buffer (p0)->ip_frag.next_index;
 	    }
@@ -349,6 +441,11 @@ frag_node_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 			       IP_FRAG_ERROR_FRAGMENT_SENT, frag_sent);
   vlib_node_increment_counter (vm, node_index,
 			       IP_FRAG_ERROR_SMALL_PACKET, small_packets);
+  vlib_node_increment_counter (vm, node_index,
+			       IP_FRAG_ERROR_BYTES_COPIED, bytes_copied);
+  vlib_node_increment_counter (vm, node_index,
+			       IP_FRAG_ERROR_BYTES_REFERENCED,
+			       bytes_referenced);
 
   return frame->n_vectors;
 }
@@ -413,7 +510,7 @@ ip6_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
     from_b->current_length - (l2unfragmentablesize + sizeof (ip6_header_t));
   u16 ptr = 0;
 
-  ip_frag_id = ++running_fragment_id;	// Fix
+  ip_frag_id = ip_frag_next_id (vm->thread_index);
 
   /* Do the actual fragmentation */
   while (rem)
@@ -500,6 +597,21 @@ ip6_frag_do_fragment (vlib_main_t * vm, u32 from_bi, u16 mtu,
   return IP_FRAG_ERROR_NONE;
 }
 
+static clib_error_t *
+ip_frag_init (vlib_main_t *vm)
+{
+  u32 n_threads = vlib_num_workers () + 1, i;
+
+  vec_validate_aligned (ip_frag_per_thread, n_threads - 1,
+			CLIB_CACHE_LINE_BYTES);
+  for (i = 0; i < n_threads; i++)
+    ip_frag_per_thread[i].running_fragment_id = (i << 16) / n_threads;
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (ip_frag_init);
+
 /* *INDENT-OFF* */
 VLIB_REGISTER_NODE (ip4_frag_node) = {
   .function = ip4_frag,
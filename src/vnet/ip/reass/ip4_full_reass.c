@@ -195,6 +195,10 @@ typedef struct
 
   // whether local fragmented packets are reassembled or not
   int is_local_reass_enabled;
+
+  // whether a worker adds fragments to reassemblies owned by another
+  // worker directly, instead of handing them off
+  int is_shared_contexts_enabled;
 } ip4_full_reass_main_t;
 
 extern ip4_full_reass_main_t ip4_full_reass_main;
@@ -542,44 +546,72 @@ ip4_full_reass_init (ip4_full_reass_t * reass)
   reass->error_next_index = ~0;
 }
 
+/*
+ * Returns the reassembly of the fragment and in reass_rt the per-thread
+ * data owning it. When that is another worker's (shared contexts), its
+ * lock is held and the caller releases it once done with the fragment.
+ */
 always_inline ip4_full_reass_t *
 ip4_full_reass_find_or_create (vlib_main_t *vm, vlib_node_runtime_t *node,
 			       ip4_full_reass_main_t *rm,
 			       ip4_full_reass_per_thread_t *rt,
-			       ip4_full_reass_kv_t *kv, u8 *do_handoff)
+			       ip4_full_reass_kv_t *kv, u8 *do_handoff,
+			       ip4_full_reass_per_thread_t **reass_rt)
 {
+  ip4_full_reass_per_thread_t *ort;
   ip4_full_reass_t *reass;
   f64 now;
 
 again:
 
   reass = NULL;
+  ort = rt;
   now = vlib_time_now (vm);
   if (!clib_bihash_search_16_8 (&rm->hash, &kv->kv, &kv->kv))
     {
       if (vm->thread_index != kv->v.memory_owner_thread_index)
 	{
-	  *do_handoff = 1;
-	  return NULL;
+	  ort = &rm->per_thread_data[kv->v.memory_owner_thread_index];
+
+	  /* hand off unless the owner's contexts can be used right now */
+	  if (!rm->is_shared_contexts_enabled ||
+	      !clib_spinlock_trylock (&ort->lock))
+	    {
+	      *do_handoff = 1;
+	      return NULL;
+	    }
+
+	  /* the owner may have completed the reassembly since the lookup */
+	  if (pool_is_free_index (ort->pool, kv->v.reass_index) ||
+	      clib_memcmp (&pool_elt_at_index (ort->pool, kv->v.reass_index)
+			      ->key,
+			   &kv->kv.key, sizeof (kv->kv.key)))
+	    {
+	      clib_spinlock_unlock (&ort->lock);
+	      goto again;
+	    }
 	}
-      reass =
-	pool_elt_at_index (rm->per_thread_data
-			   [kv->v.memory_owner_thread_index].pool,
-			   kv->v.reass_index);
+      reass = pool_elt_at_index (ort->pool, kv->v.reass_index);
 
       if (now > reass->last_heard + rm->timeout)
 	{
 	  vlib_node_increment_counter (vm, node->node_index,
 				       IP4_ERROR_REASS_TIMEOUT, 1);
 	  ip4_full_reass_drop_all (vm, node, reass);
-	  ip4_full_reass_free (rm, rt, reass);
+	  ip4_full_reass_free (rm, ort, reass);
 	  reass = NULL;
+	  if (ort != rt)
+	    {
+	      clib_spinlock_unlock (&ort->lock);
+	      ort = rt;
+	    }
 	}
     }
 
   if (reass)
     {
       reass->last_heard = now;
+      *reass_rt = ort;
       return reass;
     }
 
@@ -1128,8 +1160,7 @@ ip4_full_reass_update (vlib_main_t * vm, vlib_node_runtime_t * node,
       reass->data_len == reass->last_packet_octet + 1)
     {
       *handoff_thread_idx = reass->sendout_thread_index;
-      int handoff =
-	reass->memory_owner_thread_index != reass->sendout_thread_index;
+      int handoff = vm->thread_index != reass->sendout_thread_index;
       rc =
 	ip4_full_reass_finalize (vm, node, rm, rt, reass, bi0, next0, error0,
 				 is_custom);
@@ -1233,9 +1264,10 @@ ip4_full_reass_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 
       };
       u8 do_handoff = 0;
+      ip4_full_reass_per_thread_t *reass_rt = rt;
 
-      ip4_full_reass_t *reass =
-	ip4_full_reass_find_or_create (vm, node, rm, rt, &kv, &do_handoff);
+      ip4_full_reass_t *reass = ip4_full_reass_find_or_create (
+	vm, node, rm, rt, &kv, &do_handoff, &reass_rt);
 
       if (reass)
 	{
@@ -1256,8 +1288,8 @@ ip4_full_reass_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	{
 	  u32 handoff_thread_idx;
 	  u32 counter = ~0;
-	  switch (ip4_full_reass_update (vm, node, rm, rt, reass, &bi0, &next0,
-					 &error0, CUSTOM == type,
+	  switch (ip4_full_reass_update (vm, node, rm, reass_rt, reass, &bi0,
+					 &next0, &error0, CUSTOM == type,
 					 &handoff_thread_idx))
 	    {
 	    case IP4_REASS_RC_OK:
@@ -1293,9 +1325,14 @@ ip4_full_reass_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	    {
 	      vlib_node_increment_counter (vm, node->node_index, counter, 1);
 	      ip4_full_reass_drop_all (vm, node, reass);
-	      ip4_full_reass_free (rm, rt, reass);
-	      goto next_packet;
+	      ip4_full_reass_free (rm, reass_rt, reass);
 	    }
+
+	  if (reass_rt != rt)
+	    clib_spinlock_unlock (&reass_rt->lock);
+
+	  if (~0 != counter)
+	    goto next_packet;
 	}
       else
 	{
@@ -1824,6 +1861,8 @@ show_ip4_reass (vlib_main_t * vm,
   vlib_cli_output (vm,
 		   "Maximum configured full IP4 reassembly expire walk interval: %lums\n",
 		   (long unsigned) rm->expire_walk_interval_ms);
+  vlib_cli_output (vm, "Shared reassembly contexts: %s\n",
+		   rm->is_shared_contexts_enabled ? "enabled" : "disabled");
   return 0;
 }
 
@@ -1833,6 +1872,45 @@ VLIB_CLI_COMMAND (show_ip4_full_reass_cmd, static) = {
     .function = show_ip4_reass,
 };
 
+static clib_error_t *
+set_ip4_full_reass_shared_contexts (vlib_main_t *vm, unformat_input_t *input,
+				    CLIB_UNUSED (vlib_cli_command_t *lmd))
+{
+  int enable = -1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "enable"))
+	enable = 1;
+      else if (unformat (input, "disable"))
+	enable = 0;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (-1 == enable)
+    return clib_error_return (0, "expected enable or disable");
+
+  ip4_full_reass_shared_contexts_enable_disable (enable);
+  return 0;
+}
+
+/*?
+ * With shared contexts, a worker receiving a fragment of a reassembly
+ * owned by another worker adds it to the reassembly itself, provided
+ * the owner is not processing its own reassemblies at that moment.
+ * Otherwise the fragment is handed off to the owner.
+ *
+ * @cliexpar
+ * @cliexcmd{set ip4-full-reassembly shared-contexts enable}
+?*/
+VLIB_CLI_COMMAND (set_ip4_full_reass_shared_contexts_cmd, static) = {
+    .path = "set ip4-full-reassembly shared-contexts",
+    .short_help = "set ip4-full-reassembly shared-contexts enable|disable",
+    .function = set_ip4_full_reass_shared_contexts,
+};
+
 #ifndef CLIB_MARCH_VARIANT
 vnet_api_error_t
 ip4_full_reass_enable_disable (u32 sw_if_index, u8 enable_disable)
@@ -2088,6 +2166,12 @@ ip4_local_full_reass_enabled ()
   return ip4_full_reass_main.is_local_reass_enabled;
 }
 
+void
+ip4_full_reass_shared_contexts_enable_disable (int enable)
+{
+  ip4_full_reass_main.is_shared_contexts_enabled = ! !enable;
+}
+
 #endif
 
 /*
@@ -50,6 +50,12 @@ uword ip4_full_reass_custom_register_next_node (uword node_index);
 
 void ip4_local_full_reass_enable_disable (int enable);
 int ip4_local_full_reass_enabled ();
+
+/**
+ * @brief let workers add fragments to reassemblies owned by other workers
+ * instead of handing them off
+ */
+void ip4_full_reass_shared_contexts_enable_disable (int enable);
 #endif /* __included_ip4_full_reass_h__ */
 
 /*
@@ -177,6 +177,10 @@ typedef struct
 
   // whether local fragmented packets are reassembled or not
   int is_local_reass_enabled;
+
+  // whether a worker adds fragments to reassemblies owned by another
+  // worker directly, instead of handing them off
+  int is_shared_contexts_enabled;
 } ip6_full_reass_main_t;
 
 extern ip6_full_reass_main_t ip6_full_reass_main;
@@ -590,34 +594,56 @@ ip6_full_reass_on_timeout (vlib_main_t *vm, vlib_node_runtime_t *node,
   ip6_full_reass_drop_all (vm, node, reass, n_left_to_next, to_next);
 }
 
+/*
+ * Returns the reassembly of the fragment and in reass_rt the per-thread
+ * data owning it. When that is another worker's (shared contexts), its
+ * lock is held and the caller releases it once done with the fragment.
+ */
 always_inline ip6_full_reass_t *
 ip6_full_reass_find_or_create (vlib_main_t *vm, vlib_node_runtime_t *node,
 			       ip6_full_reass_main_t *rm,
 			       ip6_full_reass_per_thread_t *rt,
 			       ip6_full_reass_kv_t *kv, u32 *icmp_bi,
 			       u8 *do_handoff, int skip_bihash,
-			       u32 *n_left_to_next, u32 **to_next)
+			       u32 *n_left_to_next, u32 **to_next,
+			       ip6_full_reass_per_thread_t **reass_rt)
 {
+  ip6_full_reass_per_thread_t *ort;
   ip6_full_reass_t *reass;
   f64 now;
 
 again:
 
   reass = NULL;
+  ort = rt;
   now = vlib_time_now (vm);
 
   if (!skip_bihash && !clib_bihash_search_48_8 (&rm->hash, &kv->kv, &kv->kv))
     {
       if (vm->thread_index != kv->v.memory_owner_thread_index)
 	{
-	  *do_handoff = 1;
-	  return NULL;
+	  ort = &rm->per_thread_data[kv->v.memory_owner_thread_index];
+
+	  /* hand off unless the owner's contexts can be used right now */
+	  if (!rm->is_shared_contexts_enabled ||
+	      !clib_spinlock_trylock (&ort->lock))
+	    {
+	      *do_handoff = 1;
+	      return NULL;
+	    }
+
+	  /* the owner may have completed the reassembly since the lookup */
+	  if (pool_is_free_index (ort->pool, kv->v.reass_index) ||
+	      clib_memcmp (&pool_elt_at_index (ort->pool, kv->v.reass_index)
+			      ->key,
+			   &kv->kv.key, sizeof (kv->kv.key)))
+	    {
+	      clib_spinlock_unlock (&ort->lock);
+	      goto again;
+	    }
 	}
 
-      reass =
-	pool_elt_at_index (rm->per_thread_data
-			   [kv->v.memory_owner_thread_index].pool,
-			   kv->v.reass_index);
+      reass = pool_elt_at_index (ort->pool, kv->v.reass_index);
 
       if (now > reass->last_heard + rm->timeout)
 	{
@@ -625,14 +651,20 @@ again:
 				       IP6_ERROR_REASS_TIMEOUT, 1);
 	  ip6_full_reass_on_timeout (vm, node, reass, icmp_bi, n_left_to_next,
 				     to_next);
-	  ip6_full_reass_free (rm, rt, reass);
+	  ip6_full_reass_free (rm, ort, reass);
 	  reass = NULL;
+	  if (ort != rt)
+	    {
+	      clib_spinlock_unlock (&ort->lock);
+	      ort = rt;
+	    }
 	}
     }
 
   if (reass)
     {
       reass->last_heard = now;
+      *reass_rt = ort;
       return reass;
     }
 
@@ -1083,8 +1115,7 @@ check_if_done_maybe:
       reass->data_len == reass->last_packet_octet + 1)
     {
       *handoff_thread_idx = reass->sendout_thread_index;
-      int handoff =
-	reass->memory_owner_thread_index != reass->sendout_thread_index;
+      int handoff = vm->thread_index != reass->sendout_thread_index;
       ip6_full_reass_rc_t rc =
 	ip6_full_reass_finalize (vm, node, rm, rt, reass, bi0, next0, error0,
 				 is_custom_app);
@@ -1270,6 +1301,7 @@ ip6_full_reassembly_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  int skip_bihash = 0;
 	  ip6_full_reass_kv_t kv;
 	  u8 do_handoff = 0;
+	  ip6_full_reass_per_thread_t *reass_rt = rt;
 
 	  if (0 == ip6_frag_hdr_offset (frag_hdr) &&
 	      !ip6_frag_hdr_more (frag_hdr))
@@ -1300,7 +1332,7 @@ ip6_full_reassembly_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 
 	  ip6_full_reass_t *reass = ip6_full_reass_find_or_create (
 	    vm, node, rm, rt, &kv, &icmp_bi, &do_handoff, skip_bihash,
-	    &n_left_to_next, &to_next);
+	    &n_left_to_next, &to_next, &reass_rt);
 
 	  if (reass)
 	    {
@@ -1321,7 +1353,7 @@ ip6_full_reassembly_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	      u32 handoff_thread_idx;
 	      u32 counter = ~0;
 	      switch (ip6_full_reass_update (
-		vm, node, rm, rt, reass, &bi0, &next0, &error0, frag_hdr,
+		vm, node, rm, reass_rt, reass, &bi0, &next0, &error0, frag_hdr,
 		is_custom_app, &handoff_thread_idx, skip_bihash))
 		{
 		case IP6_FULL_REASS_RC_OK:
@@ -1364,10 +1396,14 @@ ip6_full_reassembly_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 					       1);
 		  ip6_full_reass_drop_all (vm, node, reass, &n_left_to_next,
 					   &to_next);
-		  ip6_full_reass_free (rm, rt, reass);
-		  goto next_packet;
-		  break;
+		  ip6_full_reass_free (rm, reass_rt, reass);
 		}
+
+	      if (reass_rt != rt)
+		clib_spinlock_unlock (&reass_rt->lock);
+
+	      if (~0 != counter)
+		goto next_packet;
 	    }
 	  else
 	    {
@@ -1947,6 +1983,8 @@ show_ip6_full_reass (vlib_main_t * vm, unformat_input_t * input,
 		   (long unsigned) rm->expire_walk_interval_ms);
   vlib_cli_output (vm, "Buffers in use: %lu\n",
 		   (long unsigned) sum_buffers_n);
+  vlib_cli_output (vm, "Shared reassembly contexts: %s\n",
+		   rm->is_shared_contexts_enabled ? "enabled" : "disabled");
   return 0;
 }
 
@@ -1956,6 +1994,45 @@ VLIB_CLI_COMMAND (show_ip6_full_reassembly_cmd, static) = {
     .function = show_ip6_full_reass,
 };
 
+static clib_error_t *
+set_ip6_full_reass_shared_contexts (vlib_main_t *vm, unformat_input_t *input,
+				    CLIB_UNUSED (vlib_cli_command_t *lmd))
+{
+  int enable = -1;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "enable"))
+	enable = 1;
+      else if (unformat (input, "disable"))
+	enable = 0;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (-1 == enable)
+    return clib_error_return (0, "expected enable or disable");
+
+  ip6_full_reass_shared_contexts_enable_disable (enable);
+  return 0;
+}
+
+/*?
+ * With shared contexts, a worker receiving a fragment of a reassembly
+ * owned by another worker adds it to the reassembly itself, provided
+ * the owner is not processing its own reassemblies at that moment.
+ * Otherwise the fragment is handed off to the owner.
+ *
+ * @cliexpar
+ * @cliexcmd{set ip6-full-reassembly shared-contexts enable}
+?*/
+VLIB_CLI_COMMAND (set_ip6_full_reass_shared_contexts_cmd, static) = {
+    .path = "set ip6-full-reassembly shared-contexts",
+    .short_help = "set ip6-full-reassembly shared-contexts enable|disable",
+    .function = set_ip6_full_reass_shared_contexts,
+};
+
 #ifndef CLIB_MARCH_VARIANT
 vnet_api_error_t
 ip6_full_reass_enable_disable (u32 sw_if_index, u8 enable_disable)
@@ -2214,6 +2291,12 @@ ip6_local_full_reass_enabled ()
   return ip6_full_reass_main.is_local_reass_enabled;
 }
 
+void
+ip6_full_reass_shared_contexts_enable_disable (int enable)
+{
+  ip6_full_reass_main.is_shared_contexts_enabled = ! !enable;
+}
+
 #endif
 
 /*
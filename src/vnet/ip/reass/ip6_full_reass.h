@@ -48,6 +48,12 @@ int ip6_full_reass_enable_disable_with_refcnt (u32 sw_if_index,
 
 void ip6_local_full_reass_enable_disable (int enable);
 int ip6_local_full_reass_enabled ();
+
+/**
+ * @brief let workers add fragments to reassemblies owned by other workers
+ * instead of handing them off
+ */
+void ip6_full_reass_shared_contexts_enable_disable (int enable);
 #endif /* __included_ip6_full_reass_h */
 
 /*
@@ -129,6 +129,7 @@ ah_decrypt_inline (vlib_main_t * vm,
   n_left = from_frame->n_vectors;
   ipsec_sa_t *sa0 = 0;
   u32 current_sa_index = ~0, current_sa_bytes = 0, current_sa_pkts = 0;
+  ipsec_sa_replay_t replay;
 
   clib_memset (pkt_data, 0, VLIB_FRAME_SIZE * sizeof (pkt_data[0]));
   vlib_get_buffers (vm, from, b, n_left);
@@ -201,9 +202,11 @@ ah_decrypt_inline (vlib_main_t * vm,
       pd->seq = clib_host_to_net_u32 (ah0->seq_no);
 
       /* anti-replay check */
-      if (ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, ~0, false,
-					       &pd->seq_hi))
+      replay = ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, ~0, false,
+						    &pd->seq_hi);
+      if (replay)
 	{
+	  ipsec_sa_anti_replay_count (thread_index, current_sa_index, replay);
 	  b[0]->error = node->errors[AH_DECRYPT_ERROR_REPLAY];
 	  next[0] = AH_DECRYPT_NEXT_DROP;
 	  goto next;
@@ -304,9 +307,11 @@ ah_decrypt_inline (vlib_main_t * vm,
       if (PREDICT_TRUE (sa0->integ_alg != IPSEC_INTEG_ALG_NONE))
 	{
 	  /* redo the anti-reply check. see esp_decrypt for details */
-	  if (ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, pd->seq_hi,
-						   true, NULL))
+	  replay = ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq,
+							pd->seq_hi, true, NULL);
+	  if (replay)
 	    {
+	      ipsec_sa_anti_replay_count (thread_index, pd->sa_index, replay);
 	      b[0]->error = node->errors[AH_DECRYPT_ERROR_REPLAY];
 	      next[0] = AH_DECRYPT_NEXT_DROP;
 	      goto trace;
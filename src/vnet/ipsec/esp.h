@@ -91,7 +91,6 @@ typedef struct esp_aead_t_
 
 u8 *format_esp_header (u8 * s, va_list * args);
 
-/* TODO seq increment should be atomic to be accessed by multiple workers */
 always_inline int
 esp_seq_advance (ipsec_sa_t * sa)
 {
@@ -117,6 +116,32 @@ esp_seq_advance (ipsec_sa_t * sa)
   return 0;
 }
 
+/*
+ * Multi-worker SAs are advanced by every worker sending on them. Each
+ * worker takes its sequence numbers from a block it reserved with an
+ * atomic add on the SA's 64 bit sequence number.
+ */
+always_inline int
+esp_seq_advance_mw (ipsec_sa_t *sa, u32 thread_index, u64 *seq64)
+{
+  ipsec_sa_seq_block_t *blk = vec_elt_at_index (sa->seq_blocks, thread_index);
+
+  if (PREDICT_FALSE (blk->next == blk->end))
+    {
+      blk->next =
+	clib_atomic_fetch_add_relax (&sa->seq64, IPSEC_SA_SEQ_BLOCK_SIZE) + 1;
+      blk->end = blk->next + IPSEC_SA_SEQ_BLOCK_SIZE;
+    }
+
+  if (PREDICT_FALSE (ipsec_sa_is_set_USE_ANTI_REPLAY (sa) &&
+		     !ipsec_sa_is_set_USE_ESN (sa) && blk->next > ESP_SEQ_MAX))
+    return 1;
+
+  *seq64 = blk->next++;
+
+  return 0;
+}
+
 always_inline u16
 esp_aad_fill (u8 *data, const esp_header_t *esp, const ipsec_sa_t *sa,
 	      u32 seq_hi)
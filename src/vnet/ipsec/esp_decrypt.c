@@ -733,6 +733,7 @@ esp_decrypt_post_crypto (vlib_main_t *vm, const vlib_node_runtime_t *node,
   const u8 esp_sz = sizeof (esp_header_t);
   const u8 tun_flags = IPSEC_SA_FLAG_IS_TUNNEL | IPSEC_SA_FLAG_IS_TUNNEL_V6;
   u8 pad_length = 0, next_header = 0;
+  ipsec_sa_replay_t replay;
   u16 icv_sz;
 
   /*
@@ -757,9 +758,11 @@ esp_decrypt_post_crypto (vlib_main_t *vm, const vlib_node_runtime_t *node,
    * a sequence s, s+1, s+2, s+3, ... s+n and nothing will prevent any
    * implementation, sequential or batching, from decrypting these.
    */
-  if (ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, pd->seq_hi, true,
-					   NULL))
+  replay = ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, pd->seq_hi,
+						true, NULL);
+  if (replay)
     {
+      ipsec_sa_anti_replay_count (vm->thread_index, pd->sa_index, replay);
       b->error = node->errors[ESP_DECRYPT_ERROR_REPLAY];
       next[0] = ESP_DECRYPT_NEXT_DROP;
       return;
@@ -829,6 +832,8 @@ esp_decrypt_post_crypto (vlib_main_t *vm, const vlib_node_runtime_t *node,
   u16 tail = sizeof (esp_footer_t) + pad_length + icv_sz;
   u16 tail_orig = sizeof (esp_footer_t) + pad_length + pd->icv_sz;
   b->flags &= ~VLIB_BUFFER_TOTAL_LENGTH_VALID;
+  /* a device hash covers the ESP packet, not the decrypted one */
+  vnet_buffer_reset_rx_hash (b);
 
   if ((pd->flags & tun_flags) == 0 && !is_tun)	/* transport mode */
     {
@@ -1033,15 +1038,16 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   vnet_crypto_async_op_id_t async_op = ~0;
   vnet_crypto_async_frame_t *async_frames[VNET_CRYPTO_ASYNC_OP_N_IDS];
   esp_decrypt_error_t err;
+  ipsec_sa_replay_t replay;
+  u32 n_inline = 0;
+  int is_inline;
 
   vlib_get_buffers (vm, from, b, n_left);
-  if (!is_async)
-    {
-      vec_reset_length (ptd->crypto_ops);
-      vec_reset_length (ptd->integ_ops);
-      vec_reset_length (ptd->chained_crypto_ops);
-      vec_reset_length (ptd->chained_integ_ops);
-    }
+  /* inline offloaded packets go the sync way even in async mode */
+  vec_reset_length (ptd->crypto_ops);
+  vec_reset_length (ptd->integ_ops);
+  vec_reset_length (ptd->chained_crypto_ops);
+  vec_reset_length (ptd->chained_integ_ops);
   vec_reset_length (ptd->async_frames);
   vec_reset_length (ptd->chunks);
   clib_memset (sync_nexts, -1, sizeof (sync_nexts));
@@ -1052,6 +1058,7 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       u8 *payload;
 
       err = ESP_DECRYPT_ERROR_RX_PKTS;
+      is_inline = 0;
       if (n_left > 2)
 	{
 	  u8 *p;
@@ -1092,16 +1099,7 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  is_async = im->async_mode | ipsec_sa_is_set_IS_ASYNC (sa0);
 	}
 
-      if (PREDICT_FALSE (~0 == sa0->thread_index))
-	{
-	  /* this is the first packet to use this SA, claim the SA
-	   * for this thread. this could happen simultaneously on
-	   * another thread */
-	  clib_atomic_cmp_and_swap (&sa0->thread_index, ~0,
-				    ipsec_sa_assign_thread (thread_index));
-	}
-
-      if (PREDICT_FALSE (thread_index != sa0->thread_index))
+      if (PREDICT_FALSE (ipsec_sa_handoff_needed (sa0, thread_index)))
 	{
 	  vnet_buffer (b[0])->ipsec.thread_index = sa0->thread_index;
 	  err = ESP_DECRYPT_ERROR_HANDOFF;
@@ -1140,9 +1138,11 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       pd->current_length = b[0]->current_length;
 
       /* anti-reply check */
-      if (ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, ~0, false,
-					       &pd->seq_hi))
+      replay = ipsec_sa_anti_replay_and_sn_advance (sa0, pd->seq, ~0, false,
+						    &pd->seq_hi);
+      if (replay)
 	{
+	  ipsec_sa_anti_replay_count (thread_index, current_sa_index, replay);
 	  err = ESP_DECRYPT_ERROR_REPLAY;
 	  esp_set_next_index (b[0], node, err, n_noop, noop_nexts,
 			      ESP_DECRYPT_NEXT_DROP);
@@ -1161,6 +1161,29 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       current_sa_pkts += 1;
       current_sa_bytes += vlib_buffer_length_in_chain (vm, b[0]);
 
+      if (b[0]->flags & VNET_BUFFER_F_IPSEC_INLINE)
+	{
+	  /* decrypted and verified by the device, only the decapsulation
+	   * is left. The device must be the one the SA is offloaded to. */
+	  u32 rx_sw_if_index =
+	    is_tun ? vnet_buffer2 (b[0])->ipsec_inline.rx_sw_if_index :
+		     vnet_buffer (b[0])->sw_if_index[VLIB_RX];
+	  b[0]->flags &= ~VNET_BUFFER_F_IPSEC_INLINE;
+	  if (PREDICT_FALSE (!ipsec_sa_is_set_IS_INLINE_OFFLOAD (sa0) ||
+			     vnet_buffer2 (b[0])->ipsec_inline.sa_index !=
+			       current_sa_index ||
+			     rx_sw_if_index != sa0->inline_offload_sw_if_index))
+	    {
+	      err = ESP_DECRYPT_ERROR_INLINE_OFFLOAD_NO_SA;
+	      esp_set_next_index (b[0], node, err, n_noop, noop_nexts,
+				  ESP_DECRYPT_NEXT_DROP);
+	      goto next;
+	    }
+	  is_inline = 1;
+	  n_inline++;
+	  goto next;
+	}
+
       if (is_async)
 	{
 	  async_op = sa0->crypto_async_dec_op_id;
@@ -1197,7 +1220,7 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  noop_bi[n_noop] = from[b - bufs];
 	  n_noop++;
 	}
-      else if (!is_async)
+      else if (!is_async || is_inline)
 	{
 	  sync_bi[n_sync] = from[b - bufs];
 	  sync_bufs[n_sync] = b[0];
@@ -1313,6 +1336,9 @@ esp_decrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 
   vlib_node_increment_counter (vm, node->node_index, ESP_DECRYPT_ERROR_RX_PKTS,
 			       from_frame->n_vectors);
+  if (n_inline)
+    vlib_node_increment_counter (vm, node->node_index,
+				 ESP_DECRYPT_ERROR_INLINE_OFFLOAD, n_inline);
 
   if (n_sync)
     vlib_buffer_enqueue_to_next (vm, node, sync_bi, sync_nexts, n_sync);
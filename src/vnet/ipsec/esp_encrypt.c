@@ -224,12 +224,14 @@ esp_get_ip6_hdr_len (ip6_header_t * ip6, ip6_ext_header_t ** ext_hdr)
  * as the message. You can refer to NIST SP800-38a and NIST SP800-38d
  * for more details. */
 static_always_inline void *
-esp_generate_iv (ipsec_sa_t *sa, void *payload, int iv_sz)
+esp_generate_iv (ipsec_sa_t *sa, void *payload, int iv_sz, u64 seq64)
 {
   ASSERT (iv_sz >= sizeof (u64));
   u64 *iv = (u64 *) (payload - iv_sz);
   clib_memset_u8 (iv, 0, iv_sz);
-  *iv = sa->iv_counter++;
+  /* the sequence numbers of a multi-worker SA are unique, its counter is
+   * not */
+  *iv = ipsec_sa_is_set_IS_MULTI_WORKER (sa) ? seq64 : sa->iv_counter++;
   return iv;
 }
 
@@ -328,10 +330,10 @@ esp_encrypt_chain_crypto (vlib_main_t * vm, ipsec_per_thread_data_t * ptd,
 }
 
 static_always_inline u32
-esp_encrypt_chain_integ (vlib_main_t * vm, ipsec_per_thread_data_t * ptd,
-			 ipsec_sa_t * sa0, vlib_buffer_t * b,
-			 vlib_buffer_t * lb, u8 icv_sz, u8 * start,
-			 u32 start_len, u8 * digest, u16 * n_ch)
+esp_encrypt_chain_integ (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
+			 ipsec_sa_t *sa0, u32 seq_hi, vlib_buffer_t *b,
+			 vlib_buffer_t *lb, u8 icv_sz, u8 *start,
+			 u32 start_len, u8 *digest, u16 *n_ch)
 {
   vnet_crypto_op_chunk_t *ch;
   vlib_buffer_t *cb = b;
@@ -351,8 +353,8 @@ esp_encrypt_chain_integ (vlib_main_t * vm, ipsec_per_thread_data_t * ptd,
 	  total_len += ch->len = cb->current_length - icv_sz;
 	  if (ipsec_sa_is_set_USE_ESN (sa0))
 	    {
-	      u32 seq_hi = clib_net_to_host_u32 (sa0->seq_hi);
-	      clib_memcpy_fast (digest, &seq_hi, sizeof (seq_hi));
+	      u32 tmp = clib_net_to_host_u32 (seq_hi);
+	      clib_memcpy_fast (digest, &tmp, sizeof (seq_hi));
 	      ch->len += sizeof (seq_hi);
 	      total_len += sizeof (seq_hi);
 	    }
@@ -376,11 +378,13 @@ esp_encrypt_chain_integ (vlib_main_t * vm, ipsec_per_thread_data_t * ptd,
 always_inline void
 esp_prepare_sync_op (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 		     vnet_crypto_op_t **crypto_ops,
-		     vnet_crypto_op_t **integ_ops, ipsec_sa_t *sa0, u32 seq_hi,
+		     vnet_crypto_op_t **integ_ops, ipsec_sa_t *sa0, u64 seq64,
 		     u8 *payload, u16 payload_len, u8 iv_sz, u8 icv_sz, u32 bi,
 		     vlib_buffer_t **b, vlib_buffer_t *lb, u32 hdr_len,
 		     esp_header_t *esp)
 {
+  u32 seq_hi = seq64 >> 32;
+
   if (sa0->crypto_enc_op_id)
     {
       vnet_crypto_op_t *op;
@@ -393,7 +397,7 @@ esp_prepare_sync_op (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
       u16 crypto_len = payload_len - icv_sz;
 
       /* generate the IV in front of the payload */
-      void *pkt_iv = esp_generate_iv (sa0, payload, iv_sz);
+      void *pkt_iv = esp_generate_iv (sa0, payload, iv_sz, seq64);
 
       op->key_index = sa0->crypto_key_index;
       op->user_data = bi;
@@ -467,7 +471,7 @@ esp_prepare_sync_op (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 	  op->chunk_index = vec_len (ptd->chunks);
 	  op->digest = vlib_buffer_get_tail (lb) - icv_sz;
 
-	  esp_encrypt_chain_integ (vm, ptd, sa0, b[0], lb, icv_sz,
+	  esp_encrypt_chain_integ (vm, ptd, sa0, seq_hi, b[0], lb, icv_sz,
 				   payload - iv_sz - sizeof (esp_header_t),
 				   payload_len + iv_sz +
 				   sizeof (esp_header_t), op->digest,
@@ -485,8 +489,8 @@ esp_prepare_sync_op (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 static_always_inline void
 esp_prepare_async_frame (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 			 vnet_crypto_async_frame_t *async_frame,
-			 ipsec_sa_t *sa, vlib_buffer_t *b, esp_header_t *esp,
-			 u8 *payload, u32 payload_len, u8 iv_sz, u8 icv_sz,
+			 ipsec_sa_t *sa, u64 seq64, vlib_buffer_t *b,
+			 esp_header_t *esp, u8 *payload, u32 payload_len, u8 iv_sz, u8 icv_sz,
 			 u32 bi, u16 next, u32 hdr_len, u16 async_next,
 			 vlib_buffer_t *lb)
 {
@@ -507,7 +511,7 @@ esp_prepare_async_frame (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
   key_index = sa->linked_key_index;
 
   /* generate the IV in front of the payload */
-  void *pkt_iv = esp_generate_iv (sa, payload, iv_sz);
+  void *pkt_iv = esp_generate_iv (sa, payload, iv_sz, seq64);
 
   if (ipsec_sa_is_set_IS_CTR (sa))
     {
@@ -518,7 +522,7 @@ esp_prepare_async_frame (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
 	{
 	  /* constuct aad in a scratch space in front of the nonce */
 	  aad = (u8 *) nonce - sizeof (esp_aead_t);
-	  esp_aad_fill (aad, esp, sa, sa->seq_hi);
+	  esp_aad_fill (aad, esp, sa, seq64 >> 32);
 	  key_index = sa->crypto_key_index;
 	}
       else
@@ -558,13 +562,13 @@ esp_prepare_async_frame (vlib_main_t *vm, ipsec_per_thread_data_t *ptd,
       if (b != lb)
 	{
 	  integ_total_len = esp_encrypt_chain_integ (
-	    vm, ptd, sa, b, lb, icv_sz,
+	    vm, ptd, sa, seq64 >> 32, b, lb, icv_sz,
 	    payload - iv_sz - sizeof (esp_header_t),
 	    payload_len + iv_sz + sizeof (esp_header_t), tag, 0);
 	}
       else if (ipsec_sa_is_set_USE_ESN (sa))
 	{
-	  u32 seq_hi = clib_net_to_host_u32 (sa->seq_hi);
+	  u32 seq_hi = clib_net_to_host_u32 (seq64 >> 32);
 	  clib_memcpy_fast (tag, &seq_hi, sizeof (seq_hi));
 	  integ_total_len += sizeof (seq_hi);
 	}
@@ -614,6 +618,9 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
   u32 sync_bi[VLIB_FRAME_SIZE];
   u32 noop_bi[VLIB_FRAME_SIZE];
   esp_encrypt_error_t err;
+  u64 seq64 = 0;
+  u32 n_inline = 0;
+  int is_inline;
 
   vlib_get_buffers (vm, from, b, n_left);
 
@@ -635,6 +642,7 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
       u32 hdr_len;
 
       err = ESP_ENCRYPT_ERROR_RX_PKTS;
+      is_inline = 0;
 
       if (n_left > 2)
 	{
@@ -698,16 +706,7 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  is_async = im->async_mode | ipsec_sa_is_set_IS_ASYNC (sa0);
 	}
 
-      if (PREDICT_FALSE (~0 == sa0->thread_index))
-	{
-	  /* this is the first packet to use this SA, claim the SA
-	   * for this thread. this could happen simultaneously on
-	   * another thread */
-	  clib_atomic_cmp_and_swap (&sa0->thread_index, ~0,
-				    ipsec_sa_assign_thread (thread_index));
-	}
-
-      if (PREDICT_FALSE (thread_index != sa0->thread_index))
+      if (PREDICT_FALSE (ipsec_sa_handoff_needed (sa0, thread_index)))
 	{
 	  vnet_buffer (b[0])->ipsec.thread_index = sa0->thread_index;
 	  err = ESP_ENCRYPT_ERROR_HANDOFF;
@@ -732,12 +731,16 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	    lb = vlib_get_buffer (vm, lb->next_buffer);
 	}
 
-      if (PREDICT_FALSE (esp_seq_advance (sa0)))
+      if (PREDICT_FALSE (ipsec_sa_is_set_IS_MULTI_WORKER (sa0) ?
+			   esp_seq_advance_mw (sa0, thread_index, &seq64) :
+			   esp_seq_advance (sa0)))
 	{
 	  err = ESP_ENCRYPT_ERROR_SEQ_CYCLED;
 	  esp_set_next_index (b[0], node, err, n_noop, noop_nexts, drop_next);
 	  goto trace;
 	}
+      if (!ipsec_sa_is_set_IS_MULTI_WORKER (sa0))
+	seq64 = ((u64) sa0->seq_hi << 32) | sa0->seq;
 
       /* space for IV */
       hdr_len = iv_sz;
@@ -975,9 +978,20 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	}
 
       esp->spi = spi;
-      esp->seq = clib_net_to_host_u32 (sa0->seq);
+      esp->seq = clib_net_to_host_u32 (seq64);
 
-      if (is_async)
+      if (PREDICT_FALSE (ipsec_sa_inline_offload_tx (sa0, b[0])))
+	{
+	  /* the device encrypts the packet and fills the ICV in. As the
+	   * software, it has to make a CBC IV unpredictable */
+	  esp_generate_iv (sa0, payload, iv_sz, seq64);
+	  b[0]->flags |= VNET_BUFFER_F_IPSEC_INLINE;
+	  vnet_buffer2 (b[0])->ipsec_inline.sa_index = sa_index0;
+	  vnet_buffer2 (b[0])->ipsec_inline.seq_hi = seq64 >> 32;
+	  is_inline = 1;
+	  n_inline++;
+	}
+      else if (is_async)
 	{
 	  async_op = sa0->crypto_async_enc_op_id;
 
@@ -992,13 +1006,13 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	      vec_add1 (ptd->async_frames, async_frames[async_op]);
 	    }
 
-	  esp_prepare_async_frame (vm, ptd, async_frames[async_op], sa0, b[0],
-				   esp, payload, payload_len, iv_sz, icv_sz,
+	  esp_prepare_async_frame (vm, ptd, async_frames[async_op], sa0, seq64,
+				   b[0], esp, payload, payload_len, iv_sz, icv_sz,
 				   from[b - bufs], sync_next[0], hdr_len,
 				   async_next_node, lb);
 	}
       else
-	esp_prepare_sync_op (vm, ptd, crypto_ops, integ_ops, sa0, sa0->seq_hi,
+	esp_prepare_sync_op (vm, ptd, crypto_ops, integ_ops, sa0, seq64,
 			     payload, payload_len, iv_sz, icv_sz, n_sync, b,
 			     lb, hdr_len, esp);
 
@@ -1018,8 +1032,8 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	    {
 	      tr->sa_index = sa_index0;
 	      tr->spi = sa0->spi;
-	      tr->seq = sa0->seq;
-	      tr->sa_seq_hi = sa0->seq_hi;
+	      tr->seq = seq64;
+	      tr->sa_seq_hi = seq64 >> 32;
 	      tr->udp_encap = ipsec_sa_is_set_UDP_ENCAP (sa0);
 	      tr->crypto_alg = sa0->crypto_alg;
 	      tr->integ_alg = sa0->integ_alg;
@@ -1032,7 +1046,7 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 	  noop_bi[n_noop] = from[b - bufs];
 	  n_noop++;
 	}
-      else if (!is_async)
+      else if (!is_async || is_inline)
 	{
 	  sync_bi[n_sync] = from[b - bufs];
 	  sync_bufs[n_sync] = b[0];
@@ -1087,6 +1101,9 @@ esp_encrypt_inline (vlib_main_t *vm, vlib_node_runtime_t *node,
 
   vlib_node_increment_counter (vm, node->node_index, ESP_ENCRYPT_ERROR_RX_PKTS,
 			       frame->n_vectors);
+  if (n_inline)
+    vlib_node_increment_counter (vm, node->node_index,
+				 ESP_ENCRYPT_ERROR_INLINE_OFFLOAD, n_inline);
 
   return frame->n_vectors;
 }
@@ -396,6 +396,25 @@ ipsec_select_esp_backend (ipsec_main_t * im, u32 backend_idx)
   return 0;
 }
 
+u32
+ipsec_register_inline_offload (ipsec_main_t *im, u32 dev_class_index,
+			       const char *name,
+			       inline_offload_sa_add_del_cb_t sa_add_del_cb)
+{
+  ipsec_inline_offload_t *io;
+
+  pool_get (im->inline_offloads, io);
+  io->name = format (0, "%s%c", name, 0);
+  io->sa_add_del_cb = sa_add_del_cb;
+
+  vec_validate_init_empty (im->inline_offload_by_dev_class, dev_class_index,
+			   ~0);
+  im->inline_offload_by_dev_class[dev_class_index] =
+    io - im->inline_offloads;
+
+  return io - im->inline_offloads;
+}
+
 void
 ipsec_set_async_mode (u32 is_enabled)
 {
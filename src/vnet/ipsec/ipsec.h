@@ -36,6 +36,9 @@
 typedef clib_error_t *(*add_del_sa_sess_cb_t) (u32 sa_index, u8 is_add);
 typedef clib_error_t *(*check_support_cb_t) (ipsec_sa_t * sa);
 typedef clib_error_t *(*enable_disable_cb_t) (int is_enable);
+typedef clib_error_t *(*inline_offload_sa_add_del_cb_t) (u32 hw_if_index,
+							 u32 sa_index,
+							 u8 is_add);
 
 typedef struct
 {
@@ -112,6 +115,17 @@ typedef struct
   u32 esp_mpls_encrypt_tun_node_index;
 } ipsec_esp_backend_t;
 
+/*
+ * A device class doing the ESP transforms inline, see
+ * ipsec_sa_inline_offload_tx ()
+ */
+typedef struct
+{
+  u8 *name;
+  /* program/unprogram an SA on a device, fails if the device can't do it */
+  inline_offload_sa_add_del_cb_t sa_add_del_cb;
+} ipsec_inline_offload_t;
+
 typedef struct
 {
   vnet_crypto_op_id_t enc_op_id;
@@ -225,6 +239,11 @@ typedef struct
   /* index of default esp backend */
   u32 esp_default_backend;
 
+  /* pool of inline offload devices */
+  ipsec_inline_offload_t *inline_offloads;
+  /* inline offload device index by device class index, ~0 if none */
+  u32 *inline_offload_by_dev_class;
+
   /* crypto alg data */
   ipsec_main_crypto_alg_t *crypto_algs;
 
@@ -370,6 +389,10 @@ u32 ipsec_register_esp_backend (
 int ipsec_select_ah_backend (ipsec_main_t * im, u32 ah_backend_idx);
 int ipsec_select_esp_backend (ipsec_main_t * im, u32 esp_backend_idx);
 
+u32 ipsec_register_inline_offload (ipsec_main_t *im, u32 dev_class_index,
+				   const char *name,
+				   inline_offload_sa_add_del_cb_t sa_add_del_cb);
+
 clib_error_t *ipsec_rsc_in_use (ipsec_main_t * im);
 void ipsec_set_async_mode (u32 is_enabled);
 
@@ -385,7 +385,8 @@ static void vl_api_ipsec_sad_entry_add_del_t_handler
   rv = ipsec_sa_add_and_lock (id, spi, proto, crypto_alg, &crypto_key,
 			      integ_alg, &integ_key, flags, mp->entry.salt,
 			      htons (mp->entry.udp_src_port),
-			      htons (mp->entry.udp_dst_port), &tun, &sa_index);
+			      htons (mp->entry.udp_dst_port),
+			      IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE, &tun, &sa_index);
 
 out:
   /* *INDENT-OFF* */
@@ -459,7 +460,8 @@ static void vl_api_ipsec_sad_entry_add_del_v2_t_handler
     rv = ipsec_sa_add_and_lock (
       id, spi, proto, crypto_alg, &crypto_key, integ_alg, &integ_key, flags,
       mp->entry.salt, htons (mp->entry.udp_src_port),
-      htons (mp->entry.udp_dst_port), &tun, &sa_index);
+      htons (mp->entry.udp_dst_port), IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE, &tun,
+      &sa_index);
 
 out:
   /* *INDENT-OFF* */
@@ -517,7 +519,8 @@ ipsec_sad_entry_add_v3 (const vl_api_ipsec_sad_entry_v3_t *entry,
   return ipsec_sa_add_and_lock (id, spi, proto, crypto_alg, &crypto_key,
 				integ_alg, &integ_key, flags, entry->salt,
 				htons (entry->udp_src_port),
-				htons (entry->udp_dst_port), &tun, sa_index);
+				htons (entry->udp_dst_port),
+				IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE, &tun, sa_index);
 }
 
 static void
@@ -567,6 +570,55 @@ vl_api_ipsec_sad_entry_add_t_handler (vl_api_ipsec_sad_entry_add_t *mp)
 		{ rmp->stat_index = htonl (sa_index); });
 }
 
+static void
+vl_api_ipsec_sad_entry_add_v2_t_handler (vl_api_ipsec_sad_entry_add_v2_t *mp)
+{
+  vl_api_ipsec_sad_entry_add_v2_reply_t *rmp;
+  vl_api_ipsec_sad_entry_v4_t *entry = &mp->entry;
+  ipsec_key_t crypto_key, integ_key;
+  ipsec_crypto_alg_t crypto_alg;
+  ipsec_integ_alg_t integ_alg;
+  ipsec_protocol_t proto;
+  ipsec_sa_flags_t flags;
+  u32 sa_index = ~0;
+  tunnel_t tun = { 0 };
+  int rv;
+
+  rv = ipsec_proto_decode (entry->protocol, &proto);
+  if (rv)
+    goto out;
+
+  rv = ipsec_crypto_algo_decode (entry->crypto_algorithm, &crypto_alg);
+  if (rv)
+    goto out;
+
+  rv = ipsec_integ_algo_decode (entry->integrity_algorithm, &integ_alg);
+  if (rv)
+    goto out;
+
+  flags = ipsec_sa_flags_decode (entry->flags);
+
+  if (flags & IPSEC_SA_FLAG_IS_TUNNEL)
+    {
+      rv = tunnel_decode (&entry->tunnel, &tun);
+      if (rv)
+	goto out;
+    }
+
+  ipsec_key_decode (&entry->crypto_key, &crypto_key);
+  ipsec_key_decode (&entry->integrity_key, &integ_key);
+
+  rv = ipsec_sa_add_and_lock (
+    ntohl (entry->sad_id), ntohl (entry->spi), proto, crypto_alg, &crypto_key,
+    integ_alg, &integ_key, flags, entry->salt, htons (entry->udp_src_port),
+    htons (entry->udp_dst_port), ntohl (entry->anti_replay_window_size), &tun,
+    &sa_index);
+
+out:
+  REPLY_MACRO2 (VL_API_IPSEC_SAD_ENTRY_ADD_V2_REPLY,
+		{ rmp->stat_index = htonl (sa_index); });
+}
+
 static void
 vl_api_ipsec_sad_entry_update_t_handler (vl_api_ipsec_sad_entry_update_t *mp)
 {
@@ -923,7 +975,8 @@ send_ipsec_sa_details (ipsec_sa_t * sa, void *arg)
       mp->last_seq_inbound |= (u64) (clib_host_to_net_u32 (sa->seq_hi));
     }
   if (ipsec_sa_is_set_USE_ANTI_REPLAY (sa))
-    mp->replay_window = clib_host_to_net_u64 (sa->replay_window);
+    mp->replay_window = clib_host_to_net_u64 (
+      ipsec_sa_anti_replay_get_64b_window (sa));
 
   mp->stat_index = clib_host_to_net_u32 (sa->stat_index);
 
@@ -1010,7 +1063,8 @@ send_ipsec_sa_v2_details (ipsec_sa_t * sa, void *arg)
       mp->last_seq_inbound |= (u64) (clib_host_to_net_u32 (sa->seq_hi));
     }
   if (ipsec_sa_is_set_USE_ANTI_REPLAY (sa))
-    mp->replay_window = clib_host_to_net_u64 (sa->replay_window);
+    mp->replay_window = clib_host_to_net_u64 (
+      ipsec_sa_anti_replay_get_64b_window (sa));
 
   mp->stat_index = clib_host_to_net_u32 (sa->stat_index);
 
@@ -1090,7 +1144,8 @@ send_ipsec_sa_v3_details (ipsec_sa_t *sa, void *arg)
       mp->last_seq_inbound |= (u64) (clib_host_to_net_u32 (sa->seq_hi));
     }
   if (ipsec_sa_is_set_USE_ANTI_REPLAY (sa))
-    mp->replay_window = clib_host_to_net_u64 (sa->replay_window);
+    mp->replay_window = clib_host_to_net_u64 (
+      ipsec_sa_anti_replay_get_64b_window (sa));
 
   mp->stat_index = clib_host_to_net_u32 (sa->stat_index);
 
@@ -93,7 +93,7 @@ ipsec_sa_add_del_command_fn (vlib_main_t * vm,
   clib_error_t *error;
   ipsec_key_t ck = { 0 };
   ipsec_key_t ik = { 0 };
-  u32 id, spi, salt, sai;
+  u32 id, spi, salt, sai, anti_replay_window_size;
   int i = 0;
   u16 udp_src, udp_dst;
   int is_add, rv;
@@ -108,6 +108,7 @@ ipsec_sa_add_del_command_fn (vlib_main_t * vm,
   integ_alg = IPSEC_INTEG_ALG_NONE;
   crypto_alg = IPSEC_CRYPTO_ALG_NONE;
   udp_src = udp_dst = IPSEC_UDP_PORT_NONE;
+  anti_replay_window_size = IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE;
 
   if (!unformat_user (input, unformat_line_input, line_input))
     return 0;
@@ -157,12 +158,17 @@ ipsec_sa_add_del_command_fn (vlib_main_t * vm,
 	flags |= IPSEC_SA_FLAG_IS_INBOUND;
       else if (unformat (line_input, "use-anti-replay"))
 	flags |= IPSEC_SA_FLAG_USE_ANTI_REPLAY;
+      else if (unformat (line_input, "anti-replay-window-size %u",
+			 &anti_replay_window_size))
+	;
       else if (unformat (line_input, "use-esn"))
 	flags |= IPSEC_SA_FLAG_USE_ESN;
       else if (unformat (line_input, "udp-encap"))
 	flags |= IPSEC_SA_FLAG_UDP_ENCAP;
       else if (unformat (line_input, "async"))
 	flags |= IPSEC_SA_FLAG_IS_ASYNC;
+      else if (unformat (line_input, "multi-worker"))
+	flags |= IPSEC_SA_FLAG_IS_MULTI_WORKER;
       else
 	{
 	  error = clib_error_return (0, "parse error: '%U'",
@@ -186,7 +192,8 @@ ipsec_sa_add_del_command_fn (vlib_main_t * vm,
 	}
       rv = ipsec_sa_add_and_lock (id, spi, proto, crypto_alg, &ck, integ_alg,
 				  &ik, flags, clib_host_to_net_u32 (salt),
-				  udp_src, udp_dst, &tun, &sai);
+				  udp_src, udp_dst, anti_replay_window_size,
+				  &tun, &sai);
     }
   else
     {
@@ -770,6 +777,8 @@ clear_ipsec_counters_command_fn (vlib_main_t * vm,
   vlib_clear_combined_counters (&ipsec_spd_policy_counters);
   vlib_clear_combined_counters (&ipsec_sa_counters);
   vlib_clear_simple_counters (&ipsec_sa_lost_counters);
+  vlib_clear_simple_counters (&ipsec_sa_replay_duplicate_counters);
+  vlib_clear_simple_counters (&ipsec_sa_replay_out_of_window_counters);
 
   return (NULL);
 }
@@ -961,6 +970,86 @@ VLIB_CLI_COMMAND (set_async_mode_command, static) = {
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+ipsec_sa_inline_offload_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				    vlib_cli_command_t *cmd)
+{
+  unformat_input_t _line_input, *line_input = &_line_input;
+  vnet_main_t *vnm = vnet_get_main ();
+  u32 sa_id = ~0, sw_if_index = ~0;
+  clib_error_t *error = NULL;
+  int is_enable = 1, rv;
+  index_t sai;
+
+  if (!unformat_user (input, unformat_line_input, line_input))
+    return 0;
+
+  while (unformat_check_input (line_input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (line_input, "%u", &sa_id))
+	;
+      else if (unformat (line_input, "%U", unformat_vnet_sw_interface, vnm,
+			 &sw_if_index))
+	;
+      else if (unformat (line_input, "disable"))
+	is_enable = 0;
+      else
+	{
+	  error = clib_error_return (0, "unknown input '%U'",
+				     format_unformat_error, line_input);
+	  goto done;
+	}
+    }
+
+  if (~0 == sa_id || ~0 == sw_if_index)
+    {
+      error = clib_error_return (0, "SA ID and interface required");
+      goto done;
+    }
+
+  sai = ipsec_sa_find_and_lock (sa_id);
+  if (INDEX_INVALID == sai)
+    {
+      error = clib_error_return (0, "unknown SA %u", sa_id);
+      goto done;
+    }
+
+  rv = ipsec_sa_inline_offload_enable_disable (sai, sw_if_index, is_enable);
+  ipsec_sa_unlock (sai);
+
+  switch (rv)
+    {
+    case 0:
+      break;
+    case VNET_API_ERROR_UNSUPPORTED:
+      vlib_cli_output (vm, "SA %u not supported by %U, left to software",
+		       sa_id, format_vnet_sw_if_index_name, vnm, sw_if_index);
+      break;
+    default:
+      error = clib_error_return (0, "failed: %U", format_vnet_api_errno, rv);
+      break;
+    }
+
+done:
+  unformat_free (line_input);
+  return error;
+}
+
+/*?
+ * Offload the ESP encryption and decryption of an SA to the device of
+ * an interface. SAs the device does not support keep using the crypto
+ * engines.
+ *
+ * @cliexpar
+ * @cliexcmd{ipsec sa inline-offload 10 GigabitEthernet0/8/0}
+ * @cliexcmd{ipsec sa inline-offload 10 GigabitEthernet0/8/0 disable}
+?*/
+VLIB_CLI_COMMAND (ipsec_sa_inline_offload_command, static) = {
+  .path = "ipsec sa inline-offload",
+  .short_help = "ipsec sa inline-offload <sa-id> <interface> [disable]",
+  .function = ipsec_sa_inline_offload_command_fn,
+};
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
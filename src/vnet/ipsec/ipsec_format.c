@@ -466,8 +466,9 @@ format_ipsec_sa (u8 * s, va_list * args)
   s = format (s, "\n   salt 0x%x", clib_net_to_host_u32 (sa->salt));
   s = format (s, "\n   thread-index:%d", sa->thread_index);
   s = format (s, "\n   seq %u seq-hi %u", sa->seq, sa->seq_hi);
-  s = format (s, "\n   window %U", format_ipsec_replay_window,
-	      sa->replay_window);
+  s = format (s, "\n   window-size %u window %U",
+	      ipsec_sa_anti_replay_window_size (sa), format_ipsec_replay_window,
+	      ipsec_sa_anti_replay_get_64b_window (sa));
   s = format (s, "\n   crypto alg %U",
 	      format_ipsec_crypto_alg, sa->crypto_alg);
   if (sa->crypto_alg && (flags & IPSEC_FORMAT_INSECURE))
@@ -483,11 +484,18 @@ format_ipsec_sa (u8 * s, va_list * args)
   s = format (s, "\n   UDP:[src:%d dst:%d]",
 	      clib_host_to_net_u16 (sa->udp_hdr.src_port),
 	      clib_host_to_net_u16 (sa->udp_hdr.dst_port));
+  if (ipsec_sa_is_set_IS_INLINE_OFFLOAD (sa))
+    s = format (s, "\n   inline-offload %U", format_vnet_sw_if_index_name,
+		vnet_get_main (), sa->inline_offload_sw_if_index);
 
   vlib_get_combined_counter (&ipsec_sa_counters, sai, &counts);
   lost = vlib_get_simple_counter (&ipsec_sa_lost_counters, sai);
   s = format (s, "\n   tx/rx:[packets:%Ld bytes:%Ld], lost:[packets:%Ld]",
 	      counts.packets, counts.bytes, lost);
+  s = format (
+    s, "\n   replay:[duplicate:%Ld out-of-window:%Ld]",
+    vlib_get_simple_counter (&ipsec_sa_replay_duplicate_counters, sai),
+    vlib_get_simple_counter (&ipsec_sa_replay_out_of_window_counters, sai));
 
   if (ipsec_sa_is_set_IS_TUNNEL (sa))
     s = format (s, "\n%U", format_tunnel, &sa->tunnel, 3);
@@ -32,6 +32,14 @@ vlib_simple_counter_main_t ipsec_sa_lost_counters = {
   .name = "SA-lost",
   .stat_segment_name = "/net/ipsec/sa/lost",
 };
+vlib_simple_counter_main_t ipsec_sa_replay_duplicate_counters = {
+  .name = "SA-replay-duplicate",
+  .stat_segment_name = "/net/ipsec/sa/replay-duplicate",
+};
+vlib_simple_counter_main_t ipsec_sa_replay_out_of_window_counters = {
+  .name = "SA-replay-out-of-window",
+  .stat_segment_name = "/net/ipsec/sa/replay-out-of-window",
+};
 
 ipsec_sa_t *ipsec_sa_pool;
 
@@ -307,7 +315,8 @@ ipsec_sa_add_and_lock (u32 id, u32 spi, ipsec_protocol_t proto,
 		       ipsec_crypto_alg_t crypto_alg, const ipsec_key_t *ck,
 		       ipsec_integ_alg_t integ_alg, const ipsec_key_t *ik,
 		       ipsec_sa_flags_t flags, u32 salt, u16 src_port,
-		       u16 dst_port, const tunnel_t *tun, u32 *sa_out_index)
+		       u16 dst_port, u32 anti_replay_window_size,
+		       const tunnel_t *tun, u32 *sa_out_index)
 {
   vlib_main_t *vm = vlib_get_main ();
   ipsec_main_t *im = &ipsec_main;
@@ -321,6 +330,17 @@ ipsec_sa_add_and_lock (u32 id, u32 spi, ipsec_protocol_t proto,
   if (p)
     return VNET_API_ERROR_ENTRY_ALREADY_EXISTS;
 
+  if (0 == anti_replay_window_size)
+    anti_replay_window_size = IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE;
+  if (!is_pow2 (anti_replay_window_size) ||
+      anti_replay_window_size < IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE ||
+      anti_replay_window_size > IPSEC_SA_ANTI_REPLAY_WINDOW_MAX_SIZE)
+    return VNET_API_ERROR_INVALID_VALUE;
+
+  /* only ESP takes its sequence numbers in blocks */
+  if ((flags & IPSEC_SA_FLAG_IS_MULTI_WORKER) && IPSEC_PROTOCOL_AH == proto)
+    return VNET_API_ERROR_INVALID_VALUE;
+
   pool_get_aligned_zero (ipsec_sa_pool, sa, CLIB_CACHE_LINE_BYTES);
 
   fib_node_init (&sa->node, FIB_NODE_TYPE_IPSEC_SA);
@@ -331,15 +351,24 @@ ipsec_sa_add_and_lock (u32 id, u32 spi, ipsec_protocol_t proto,
   vlib_zero_combined_counter (&ipsec_sa_counters, sa_index);
   vlib_validate_simple_counter (&ipsec_sa_lost_counters, sa_index);
   vlib_zero_simple_counter (&ipsec_sa_lost_counters, sa_index);
+  vlib_validate_simple_counter (&ipsec_sa_replay_duplicate_counters,
+				sa_index);
+  vlib_zero_simple_counter (&ipsec_sa_replay_duplicate_counters, sa_index);
+  vlib_validate_simple_counter (&ipsec_sa_replay_out_of_window_counters,
+				sa_index);
+  vlib_zero_simple_counter (&ipsec_sa_replay_out_of_window_counters,
+			    sa_index);
 
   tunnel_copy (tun, &sa->tunnel);
   sa->id = id;
   sa->spi = spi;
   sa->stat_index = sa_index;
   sa->protocol = proto;
-  sa->flags = flags;
+  sa->flags = flags & ~IPSEC_SA_FLAG_IS_INLINE_OFFLOAD;
   sa->salt = salt;
+  sa->inline_offload_sw_if_index = ~0;
   sa->thread_index = (vlib_num_workers ()) ? ~0 : 0;
+  sa->replay_window_log2 = min_log2 (anti_replay_window_size);
   if (integ_alg != IPSEC_INTEG_ALG_NONE)
     {
       ipsec_sa_set_integ_alg (sa, integ_alg);
@@ -461,6 +490,20 @@ ipsec_sa_add_and_lock (u32 id, u32 spi, ipsec_protocol_t proto,
 				 !ipsec_sa_is_set_IS_TUNNEL_V6 (sa));
     }
 
+  if (ipsec_sa_is_set_IS_MULTI_WORKER (sa))
+    {
+      /* SAs are not always flagged inbound, be ready for both ways */
+      vec_validate_aligned (sa->replay_window_slots,
+			    anti_replay_window_size - 1, CLIB_CACHE_LINE_BYTES);
+      vec_validate_aligned (sa->seq_blocks, vlib_get_n_threads () - 1,
+			    CLIB_CACHE_LINE_BYTES);
+    }
+  else if (anti_replay_window_size > IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE)
+    {
+      ipsec_sa_set_ANTI_REPLAY_HUGE (sa);
+      clib_bitmap_alloc (sa->replay_window_huge, anti_replay_window_size);
+    }
+
   hash_set (im->sa_index_by_sa_id, sa->id, sa_index);
 
   if (sa_out_index)
@@ -483,6 +526,10 @@ ipsec_sa_del (ipsec_sa_t * sa)
   /* no recovery possible when deleting an SA */
   (void) ipsec_call_add_del_callbacks (im, sa, sa_index, 0);
 
+  if (ipsec_sa_is_set_IS_INLINE_OFFLOAD (sa))
+    (void) ipsec_sa_inline_offload_enable_disable (
+      sa_index, sa->inline_offload_sw_if_index, 0);
+
   if (ipsec_sa_is_set_IS_ASYNC (sa))
     {
       vnet_crypto_request_async_mode (0);
@@ -499,6 +546,13 @@ ipsec_sa_del (ipsec_sa_t * sa)
   vnet_crypto_key_del (vm, sa->crypto_key_index);
   if (sa->integ_alg != IPSEC_INTEG_ALG_NONE)
     vnet_crypto_key_del (vm, sa->integ_key_index);
+  if (ipsec_sa_is_set_ANTI_REPLAY_HUGE (sa))
+    clib_bitmap_free (sa->replay_window_huge);
+  if (ipsec_sa_is_set_IS_MULTI_WORKER (sa))
+    {
+      vec_free (sa->replay_window_slots);
+      vec_free (sa->seq_blocks);
+    }
   pool_put (ipsec_sa_pool, sa);
 }
 
@@ -568,6 +622,85 @@ ipsec_sa_clear (index_t sai)
 {
   vlib_zero_combined_counter (&ipsec_sa_counters, sai);
   vlib_zero_simple_counter (&ipsec_sa_lost_counters, sai);
+  vlib_zero_simple_counter (&ipsec_sa_replay_duplicate_counters, sai);
+  vlib_zero_simple_counter (&ipsec_sa_replay_out_of_window_counters, sai);
+}
+
+static ipsec_inline_offload_t *
+ipsec_sa_inline_offload_get (u32 sw_if_index, u32 *hw_if_index)
+{
+  ipsec_main_t *im = &ipsec_main;
+  vnet_hw_interface_t *hi;
+  u32 ioi;
+
+  hi = vnet_get_sup_hw_interface (im->vnet_main, sw_if_index);
+  *hw_if_index = hi->hw_if_index;
+  if (hi->dev_class_index >= vec_len (im->inline_offload_by_dev_class))
+    return NULL;
+
+  ioi = im->inline_offload_by_dev_class[hi->dev_class_index];
+  if (~0 == ioi)
+    return NULL;
+
+  return pool_elt_at_index (im->inline_offloads, ioi);
+}
+
+/*
+ * Offload the ESP transforms of an SA to the device of an interface.
+ * VNET_API_ERROR_UNSUPPORTED if the device can't do them, the SA is then
+ * left to the software.
+ */
+int
+ipsec_sa_inline_offload_enable_disable (index_t sai, u32 sw_if_index,
+					int is_enable)
+{
+  ipsec_main_t *im = &ipsec_main;
+  ipsec_inline_offload_t *io;
+  clib_error_t *err;
+  ipsec_sa_t *sa;
+  u32 hw_if_index;
+
+  if (pool_is_free_index (ipsec_sa_pool, sai))
+    return VNET_API_ERROR_NO_SUCH_ENTRY;
+  if (!vnet_sw_interface_is_valid (im->vnet_main, sw_if_index))
+    return VNET_API_ERROR_INVALID_SW_IF_INDEX;
+
+  sa = ipsec_sa_get (sai);
+
+  if (!is_enable)
+    {
+      if (!ipsec_sa_is_set_IS_INLINE_OFFLOAD (sa) ||
+	  sa->inline_offload_sw_if_index != sw_if_index)
+	return VNET_API_ERROR_NO_SUCH_ENTRY;
+
+      ipsec_sa_unset_IS_INLINE_OFFLOAD (sa);
+      sa->inline_offload_sw_if_index = ~0;
+
+      io = ipsec_sa_inline_offload_get (sw_if_index, &hw_if_index);
+      if (io && (err = io->sa_add_del_cb (hw_if_index, sai, 0)))
+	clib_error_report (err);
+      return 0;
+    }
+
+  if (ipsec_sa_is_set_IS_INLINE_OFFLOAD (sa))
+    return VNET_API_ERROR_VALUE_EXIST;
+  if (IPSEC_PROTOCOL_ESP != sa->protocol)
+    return VNET_API_ERROR_UNSUPPORTED;
+
+  io = ipsec_sa_inline_offload_get (sw_if_index, &hw_if_index);
+  if (!io)
+    return VNET_API_ERROR_UNSUPPORTED;
+
+  if ((err = io->sa_add_del_cb (hw_if_index, sai, 1)))
+    {
+      clib_error_free (err);
+      return VNET_API_ERROR_UNSUPPORTED;
+    }
+
+  sa->inline_offload_sw_if_index = sw_if_index;
+  ipsec_sa_set_IS_INLINE_OFFLOAD (sa);
+
+  return 0;
 }
 
 void
@@ -651,6 +784,28 @@ ipsec_sa_interface_init (vlib_main_t * vm)
 
 VLIB_INIT_FUNCTION (ipsec_sa_interface_init);
 
+static clib_error_t *
+ipsec_sa_sw_interface_add_del (vnet_main_t *vnm, u32 sw_if_index, u32 is_add)
+{
+  ipsec_sa_t *sa;
+
+  if (is_add)
+    return 0;
+
+  /* the SAs offloaded to a deleted interface go back to the software */
+  pool_foreach (sa, ipsec_sa_pool)
+    {
+      if (ipsec_sa_is_set_IS_INLINE_OFFLOAD (sa) &&
+	  sa->inline_offload_sw_if_index == sw_if_index)
+	(void) ipsec_sa_inline_offload_enable_disable (sa - ipsec_sa_pool,
+						       sw_if_index, 0);
+    }
+
+  return 0;
+}
+
+VNET_SW_INTERFACE_ADD_DEL_FUNCTION (ipsec_sa_sw_interface_add_del);
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
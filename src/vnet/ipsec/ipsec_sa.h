@@ -107,7 +107,10 @@ typedef struct ipsec_key_t_
   _ (128, IS_AEAD, "aead")                                                    \
   _ (256, IS_CTR, "ctr")                                                      \
   _ (512, IS_ASYNC, "async")                                                  \
-  _ (1024, NO_ALGO_NO_DROP, "no-algo-no-drop")
+  _ (1024, NO_ALGO_NO_DROP, "no-algo-no-drop")                               \
+  _ (2048, ANTI_REPLAY_HUGE, "anti-replay-huge")                             \
+  _ (4096, IS_MULTI_WORKER, "multi-worker")                                   \
+  _ (8192, IS_INLINE_OFFLOAD, "inline-offload")
 
 typedef enum ipsec_sad_flags_t_
 {
@@ -129,14 +132,36 @@ typedef struct
   u8 esp_block_align;
   u8 integ_icv_size;
 
-  u8 __pad1[3];
+  /* log2 of the anti-replay window size */
+  u8 replay_window_log2;
+  u8 __pad1[2];
 
   u32 thread_index;
 
   u32 spi;
-  u32 seq;
-  u32 seq_hi;
-  u64 replay_window;
+  union
+  {
+    struct
+    {
+#if CLIB_ARCH_IS_BIG_ENDIAN
+      u32 seq_hi;
+      u32 seq;
+#else
+      u32 seq;
+      u32 seq_hi;
+#endif
+    };
+    /* the two together, moved atomically on multi-worker SAs */
+    u64 seq64;
+  };
+  union
+  {
+    u64 replay_window;
+    /* ring of 2^replay_window_log2 bits indexed by sequence number */
+    clib_bitmap_t *replay_window_huge;
+    /* ring of the last sequence numbers seen, on multi-worker SAs */
+    u64 *replay_window_slots;
+  };
   u64 iv_counter;
   dpo_id_t dpo;
 
@@ -180,6 +205,9 @@ typedef struct
   tunnel_encap_decap_flags_t tunnel_flags;
   u8 __pad[2];
 
+  /* per thread blocks of sequence numbers, on multi-worker SAs */
+  struct ipsec_sa_seq_block_t_ *seq_blocks;
+
   /* data accessed by dataplane code should be above this comment */
     CLIB_CACHE_LINE_ALIGN_MARK (cacheline2);
 
@@ -213,6 +241,8 @@ typedef struct
   /* elements with u32 size */
   u32 id;
   u32 stat_index;
+  /* interface whose device does the crypto, on inline offloaded SAs */
+  u32 inline_offload_sw_if_index;
   vnet_crypto_alg_t integ_calg;
   vnet_crypto_alg_t crypto_calg;
 
@@ -227,6 +257,20 @@ typedef struct
 STATIC_ASSERT_OFFSET_OF (ipsec_sa_t, cacheline1, CLIB_CACHE_LINE_BYTES);
 STATIC_ASSERT_OFFSET_OF (ipsec_sa_t, cacheline2, 2 * CLIB_CACHE_LINE_BYTES);
 
+/*
+ * The outbound sequence numbers of a multi-worker SA are handed out to
+ * each thread in blocks, so the threads only contend on the SA once per
+ * block. The receiver sees them reordered by up to a block per thread.
+ */
+#define IPSEC_SA_SEQ_BLOCK_SIZE 32
+
+typedef struct ipsec_sa_seq_block_t_
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  u64 next;
+  u64 end;
+} ipsec_sa_seq_block_t;
+
 /**
  * Pool of IPSec SAs
  */
@@ -267,6 +311,8 @@ foreach_ipsec_sa_flags
  */
 extern vlib_combined_counter_main_t ipsec_sa_counters;
 extern vlib_simple_counter_main_t ipsec_sa_lost_counters;
+extern vlib_simple_counter_main_t ipsec_sa_replay_duplicate_counters;
+extern vlib_simple_counter_main_t ipsec_sa_replay_out_of_window_counters;
 
 extern void ipsec_mk_key (ipsec_key_t * key, const u8 * data, u8 len);
 
@@ -277,12 +323,16 @@ ipsec_sa_add_and_lock (u32 id, u32 spi, ipsec_protocol_t proto,
 		       ipsec_crypto_alg_t crypto_alg, const ipsec_key_t *ck,
 		       ipsec_integ_alg_t integ_alg, const ipsec_key_t *ik,
 		       ipsec_sa_flags_t flags, u32 salt, u16 src_port,
-		       u16 dst_port, const tunnel_t *tun, u32 *sa_out_index);
+		       u16 dst_port, u32 anti_replay_window_size,
+		       const tunnel_t *tun, u32 *sa_out_index);
 extern index_t ipsec_sa_find_and_lock (u32 id);
 extern int ipsec_sa_unlock_id (u32 id);
 extern void ipsec_sa_unlock (index_t sai);
 extern void ipsec_sa_lock (index_t sai);
 extern void ipsec_sa_clear (index_t sai);
+extern int ipsec_sa_inline_offload_enable_disable (index_t sai,
+						   u32 sw_if_index,
+						   int is_enable);
 extern void ipsec_sa_set_crypto_alg (ipsec_sa_t * sa,
 				     ipsec_crypto_alg_t crypto_alg);
 extern void ipsec_sa_set_integ_alg (ipsec_sa_t * sa,
@@ -309,23 +359,165 @@ extern uword unformat_ipsec_key (unformat_input_t * input, va_list * args);
  */
 
 #define IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE (64)
-#define IPSEC_SA_ANTI_REPLAY_WINDOW_MAX_INDEX (IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE-1)
+
+/*
+ * Windows larger than the default are configured per SA, as a power of 2
+ * up to this size. They are kept in a ring of bits indexed by the low bits
+ * of the sequence number, so moving the window only clears the slots of
+ * the sequence numbers it moves over, rather than shifting the whole of it.
+ */
+#define IPSEC_SA_ANTI_REPLAY_WINDOW_MAX_SIZE (1 << 14)
+
+typedef enum ipsec_sa_replay_t_
+{
+  IPSEC_SA_REPLAY_NONE = 0,
+  IPSEC_SA_REPLAY_DUPLICATE,
+  IPSEC_SA_REPLAY_OUT_OF_WINDOW,
+} ipsec_sa_replay_t;
+
+always_inline u32
+ipsec_sa_anti_replay_window_size (const ipsec_sa_t *sa)
+{
+  return 1 << sa->replay_window_log2;
+}
 
 /*
  * sequence number less than the lower bound are outside of the window
  * From RFC4303 Appendix A:
  *  Bl = Tl - W + 1
  */
-#define IPSEC_SA_ANTI_REPLAY_WINDOW_LOWER_BOUND(_tl) (_tl - IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE + 1)
+always_inline u32
+ipsec_sa_anti_replay_window_lower_bound (const ipsec_sa_t *sa)
+{
+  return sa->seq - ipsec_sa_anti_replay_window_size (sa) + 1;
+}
 
-always_inline int
+always_inline ipsec_sa_replay_t
 ipsec_sa_anti_replay_check (const ipsec_sa_t *sa, u32 seq)
 {
-  if (ipsec_sa_is_set_USE_ANTI_REPLAY (sa) &&
-      sa->replay_window & (1ULL << (sa->seq - seq)))
-    return 1;
+  int seen;
+
+  if (!ipsec_sa_is_set_USE_ANTI_REPLAY (sa))
+    return IPSEC_SA_REPLAY_NONE;
+
+  if (PREDICT_FALSE (ipsec_sa_is_set_ANTI_REPLAY_HUGE (sa)))
+    seen = clib_bitmap_get_no_check (
+      sa->replay_window_huge,
+      seq & (ipsec_sa_anti_replay_window_size (sa) - 1));
   else
-    return 0;
+    seen = (sa->replay_window >> (sa->seq - seq)) & 1;
+
+  return seen ? IPSEC_SA_REPLAY_DUPLICATE : IPSEC_SA_REPLAY_NONE;
+}
+
+/*
+ * The most recent 64 sequence numbers of the window, the last one
+ * received in the lowest bit, as the default window has them.
+ */
+always_inline u64
+ipsec_sa_anti_replay_get_64b_window (const ipsec_sa_t *sa)
+{
+  u32 i, mask;
+  u64 w = 0;
+
+  mask = ipsec_sa_anti_replay_window_size (sa) - 1;
+
+  if (ipsec_sa_is_set_IS_MULTI_WORKER (sa))
+    {
+      u64 top = sa->seq64;
+      for (i = 0; i < BITS (u64) && i <= top; i++)
+	if (sa->replay_window_slots[(top - i) & mask] == top - i)
+	  w |= 1ULL << i;
+      return w;
+    }
+
+  if (!ipsec_sa_is_set_ANTI_REPLAY_HUGE (sa))
+    return sa->replay_window;
+
+  for (i = 0; i < BITS (u64); i++)
+    if (clib_bitmap_get_no_check (sa->replay_window_huge,
+				  (sa->seq - i) & mask))
+      w |= 1ULL << i;
+
+  return w;
+}
+
+/*
+ * Multi-worker SAs are checked and advanced concurrently by every worker
+ * their packets land on. The top of the window is the 64 bit sequence
+ * number, which only moves up, and each slot of the window holds the
+ * whole sequence number last accepted in it rather than a bit, so it
+ * never needs clearing: a packet is a replay if its slot holds its own
+ * number, or a later one, and workers claim slots with a compare and swap.
+ */
+always_inline u64
+ipsec_sa_anti_replay_mw_seq64 (const ipsec_sa_t *sa, u32 seq, u64 top)
+{
+  u32 tl = top, th = top >> 32;
+  u32 bl = tl - ipsec_sa_anti_replay_window_size (sa) + 1;
+
+  if (!ipsec_sa_is_set_USE_ESN (sa))
+    return seq;
+
+  /* RFC4303 Appendix A2.2, the high bits the sender most likely used */
+  if (tl >= bl)
+    th += (seq < bl);
+  else if (seq >= bl && th)
+    th--;
+
+  return ((u64) th << 32) | seq;
+}
+
+always_inline ipsec_sa_replay_t
+ipsec_sa_anti_replay_mw_check (ipsec_sa_t *sa, u32 seq, u32 hi_seq_used,
+			       bool post_decrypt, u32 *hi_seq_req)
+{
+  u32 window_size = ipsec_sa_anti_replay_window_size (sa);
+  u64 top = clib_atomic_load_relax_n (&sa->seq64);
+  u64 seq64, old, *slot;
+
+  if (post_decrypt)
+    seq64 = ((u64) hi_seq_used << 32) | seq;
+  else
+    {
+      seq64 = ipsec_sa_anti_replay_mw_seq64 (sa, seq, top);
+      *hi_seq_req = seq64 >> 32;
+    }
+
+  if (!ipsec_sa_is_set_USE_ANTI_REPLAY (sa))
+    return IPSEC_SA_REPLAY_NONE;
+
+  if (seq64 + window_size <= top)
+    return IPSEC_SA_REPLAY_OUT_OF_WINDOW;
+
+  slot = &sa->replay_window_slots[seq64 & (window_size - 1)];
+  old = clib_atomic_load_relax_n (slot);
+
+  if (!post_decrypt)
+    return (old < seq64 ? IPSEC_SA_REPLAY_NONE :
+	    old == seq64 ? IPSEC_SA_REPLAY_DUPLICATE :
+			   IPSEC_SA_REPLAY_OUT_OF_WINDOW);
+
+  /* the packet decrypted, claim its slot unless another worker did */
+  while (old < seq64)
+    {
+      if (clib_atomic_cmp_and_swap_acq_relax_n (slot, &old, seq64, 0))
+	return IPSEC_SA_REPLAY_NONE;
+    }
+
+  return (old == seq64 ? IPSEC_SA_REPLAY_DUPLICATE :
+			 IPSEC_SA_REPLAY_OUT_OF_WINDOW);
+}
+
+always_inline void
+ipsec_sa_anti_replay_mw_advance (ipsec_sa_t *sa, u32 seq, u32 hi_seq)
+{
+  u64 seq64 = ((u64) hi_seq << 32) | seq;
+  u64 top = clib_atomic_load_relax_n (&sa->seq64);
+
+  while (top < seq64)
+    if (clib_atomic_cmp_and_swap_acq_relax_n (&sa->seq64, &top, seq64, 0))
+      break;
 }
 
 /*
@@ -339,16 +531,23 @@ ipsec_sa_anti_replay_check (const ipsec_sa_t *sa, u32 seq)
  * post-decrypt:
  *  Checks whether the packet is a replay or falls out of window
  *
+ * The return value tells the two kinds of replay apart, it is
+ * IPSEC_SA_REPLAY_NONE (zero) for a packet to accept.
+ *
  * This funcion should be called even without anti-replay enabled to ensure
  * the high sequence number is set.
  */
-always_inline int
-ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
+always_inline ipsec_sa_replay_t
+ipsec_sa_anti_replay_and_sn_advance (ipsec_sa_t *sa, u32 seq,
 				     u32 hi_seq_used, bool post_decrypt,
 				     u32 *hi_seq_req)
 {
   ASSERT ((post_decrypt == false) == (hi_seq_req != 0));
 
+  if (PREDICT_FALSE (ipsec_sa_is_set_IS_MULTI_WORKER (sa)))
+    return ipsec_sa_anti_replay_mw_check (sa, seq, hi_seq_used, post_decrypt,
+					  hi_seq_req);
+
   if (!ipsec_sa_is_set_USE_ESN (sa))
     {
       if (hi_seq_req)
@@ -356,19 +555,17 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
 	*hi_seq_req = 0;
 
       if (!ipsec_sa_is_set_USE_ANTI_REPLAY (sa))
-	return 0;
+	return IPSEC_SA_REPLAY_NONE;
 
       if (PREDICT_TRUE (seq > sa->seq))
-	return 0;
+	return IPSEC_SA_REPLAY_NONE;
 
       u32 diff = sa->seq - seq;
 
-      if (IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE > diff)
-	return ((sa->replay_window & (1ULL << diff)) ? 1 : 0);
+      if (ipsec_sa_anti_replay_window_size (sa) > diff)
+	return (ipsec_sa_anti_replay_check (sa, seq));
       else
-	return 1;
-
-      return 0;
+	return IPSEC_SA_REPLAY_OUT_OF_WINDOW;
     }
 
   if (!ipsec_sa_is_set_USE_ANTI_REPLAY (sa))
@@ -406,16 +603,16 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
        * else
        *   this is post-decrpyt and since it decrypted we accept it
        */
-      return 0;
+      return IPSEC_SA_REPLAY_NONE;
     }
-  if (PREDICT_TRUE (sa->seq >= (IPSEC_SA_ANTI_REPLAY_WINDOW_MAX_INDEX)))
+  if (PREDICT_TRUE (sa->seq >= ipsec_sa_anti_replay_window_size (sa) - 1))
     {
       /*
        * the last sequence number VPP recieved is more than one
        * window size greater than zero.
        * Case A from RFC4303 Appendix A.
        */
-      if (seq < IPSEC_SA_ANTI_REPLAY_WINDOW_LOWER_BOUND (sa->seq))
+      if (seq < ipsec_sa_anti_replay_window_lower_bound (sa))
 	{
 	  /*
 	   * the received sequence number is lower than the lower bound
@@ -430,12 +627,12 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
 		 * packet is the same as the last-sequnence number of the SA.
 		 * that means this packet did not cause a wrap.
 		 * this packet is thus out of window and should be dropped */
-		return 1;
+		return IPSEC_SA_REPLAY_OUT_OF_WINDOW;
 	      else
 		/* The packet decrypted with a different high sequence number
 		 * to the SA, that means it is the wrap packet and should be
 		 * accepted */
-		return 0;
+		return IPSEC_SA_REPLAY_NONE;
 	    }
 	  else
 	    {
@@ -443,7 +640,7 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
 	       * need to decrpyt to find out */
 	      if (hi_seq_req)
 		*hi_seq_req = sa->seq_hi + 1;
-	      return 0;
+	      return IPSEC_SA_REPLAY_NONE;
 	    }
 	}
       else
@@ -466,7 +663,7 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
 	     * upper bound. this packet will move the window along, assuming
 	     * it decrypts correctly.
 	     */
-	    return 0;
+	    return IPSEC_SA_REPLAY_NONE;
 	}
     }
   else
@@ -479,7 +676,7 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
        * RHS will be a larger number.
        * Case B from RFC4303 Appendix A.
        */
-      if (seq < IPSEC_SA_ANTI_REPLAY_WINDOW_LOWER_BOUND (sa->seq))
+      if (seq < ipsec_sa_anti_replay_window_lower_bound (sa))
 	{
 	  /*
 	   * the sequence number is less than the lower bound.
@@ -507,7 +704,7 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
 	       */
 	      if (hi_seq_req)
 		*hi_seq_req = sa->seq_hi;
-	      return 0;
+	      return IPSEC_SA_REPLAY_NONE;
 	    }
 	}
       else
@@ -527,17 +724,69 @@ ipsec_sa_anti_replay_and_sn_advance (const ipsec_sa_t *sa, u32 seq,
 
   /* unhandled case */
   ASSERT (0);
-  return 0;
+  return IPSEC_SA_REPLAY_NONE;
+}
+
+/*
+ * Clear n slots of the ring from the one of sequence number seq on,
+ * returning how many were set. Windows are whole words, so a run of
+ * slots only wraps at a word boundary and the words in the middle are
+ * taken whole.
+ */
+always_inline u32
+ipsec_sa_anti_replay_window_clear_huge (ipsec_sa_t *sa, u32 seq, u32 n)
+{
+  u32 mask = ipsec_sa_anti_replay_window_size (sa) - 1;
+  uword *w = sa->replay_window_huge, m;
+  u32 n_set = 0, i, n_bits;
+
+  while (n)
+    {
+      i = seq & mask;
+      n_bits = clib_min (n, BITS (uword) - i % BITS (uword));
+      m = n_bits == BITS (uword) ? ~(uword) 0 :
+				   pow2_mask (n_bits) << (i % BITS (uword));
+      n_set += count_set_bits (w[i / BITS (uword)] & m);
+      w[i / BITS (uword)] &= ~m;
+      seq += n_bits;
+      n -= n_bits;
+    }
+
+  return n_set;
 }
 
 always_inline u32
 ipsec_sa_anti_replay_window_shift (ipsec_sa_t *sa, u32 inc)
 {
-  u32 n_lost = 0;
+  u32 window_size = ipsec_sa_anti_replay_window_size (sa);
+  u32 n_lost = 0, seen;
+
+  if (PREDICT_FALSE (ipsec_sa_is_set_ANTI_REPLAY_HUGE (sa)))
+    {
+      /*
+       * the slots of the sequence numbers the window moves over are
+       * those of the oldest ones it leaves behind
+       */
+      if (inc < window_size)
+	{
+	  seen = ipsec_sa_anti_replay_window_clear_huge (sa, sa->seq + 1, inc);
+	  if (sa->seq > window_size)
+	    n_lost = inc - seen;
+	}
+      else
+	{
+	  seen = clib_bitmap_count_set_bits (sa->replay_window_huge);
+	  n_lost = window_size - seen + inc - window_size;
+	  clib_bitmap_zero (sa->replay_window_huge);
+	}
+      clib_bitmap_set_no_check (sa->replay_window_huge,
+				(sa->seq + inc) & (window_size - 1), 1);
+      return (n_lost);
+    }
 
-  if (inc < IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE)
+  if (inc < window_size)
     {
-      if (sa->seq > IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE)
+      if (sa->seq > window_size)
 	{
 	  /*
 	   * count how many holes there are in the portion
@@ -547,7 +796,7 @@ ipsec_sa_anti_replay_window_shift (ipsec_sa_t *sa, u32 inc)
 	  u64 mask = (((u64) 1 << inc) - 1) << (BITS (u64) - inc);
 	  u64 old = sa->replay_window & mask;
 	  /* the number of packets we saw in this section of the window */
-	  u64 seen = count_set_bits (old);
+	  seen = count_set_bits (old);
 
 	  /*
 	   * the number we missed is the size of the window section
@@ -564,7 +813,7 @@ ipsec_sa_anti_replay_window_shift (ipsec_sa_t *sa, u32 inc)
 
       /* any sequence numbers that now fall outside the window
        * are forever lost */
-      n_lost += inc - IPSEC_SA_ANTI_REPLAY_WINDOW_SIZE;
+      n_lost += inc - window_size;
 
       sa->replay_window = 1;
     }
@@ -572,6 +821,30 @@ ipsec_sa_anti_replay_window_shift (ipsec_sa_t *sa, u32 inc)
   return (n_lost);
 }
 
+/* mark an already passed sequence number, pos behind the last one, seen */
+always_inline void
+ipsec_sa_anti_replay_window_set (ipsec_sa_t *sa, u32 seq, u32 pos)
+{
+  if (PREDICT_FALSE (ipsec_sa_is_set_ANTI_REPLAY_HUGE (sa)))
+    clib_bitmap_set_no_check (
+      sa->replay_window_huge,
+      seq & (ipsec_sa_anti_replay_window_size (sa) - 1), 1);
+  else
+    sa->replay_window |= (1ULL << pos);
+}
+
+/* count a packet the anti-replay check dropped against the reason */
+always_inline void
+ipsec_sa_anti_replay_count (u32 thread_index, u32 sa_index,
+			    ipsec_sa_replay_t replay)
+{
+  vlib_increment_simple_counter (
+    (IPSEC_SA_REPLAY_DUPLICATE == replay ?
+       &ipsec_sa_replay_duplicate_counters :
+       &ipsec_sa_replay_out_of_window_counters),
+    thread_index, sa_index, 1);
+}
+
 /*
  * Anti replay window advance
  *  inputs need to be in host byte order.
@@ -588,6 +861,16 @@ ipsec_sa_anti_replay_advance (ipsec_sa_t *sa, u32 thread_index, u32 seq,
   u64 n_lost = 0;
   u32 pos;
 
+  /*
+   * the lost packets of a multi-worker SA are not counted, no one worker
+   * sees the window move over them
+   */
+  if (PREDICT_FALSE (ipsec_sa_is_set_IS_MULTI_WORKER (sa)))
+    {
+      ipsec_sa_anti_replay_mw_advance (sa, seq, hi_seq);
+      return 0;
+    }
+
   if (ipsec_sa_is_set_USE_ESN (sa))
     {
       int wrap = hi_seq - sa->seq_hi;
@@ -600,7 +883,7 @@ ipsec_sa_anti_replay_advance (ipsec_sa_t *sa, u32 thread_index, u32 seq,
 	}
       else if (wrap > 0)
 	{
-	  pos = ~seq + sa->seq + 1;
+	  pos = seq + ~sa->seq + 1;
 	  n_lost = ipsec_sa_anti_replay_window_shift (sa, pos);
 	  sa->seq = seq;
 	  sa->seq_hi = hi_seq;
@@ -608,12 +891,12 @@ ipsec_sa_anti_replay_advance (ipsec_sa_t *sa, u32 thread_index, u32 seq,
       else if (wrap < 0)
 	{
 	  pos = ~seq + sa->seq + 1;
-	  sa->replay_window |= (1ULL << pos);
+	  ipsec_sa_anti_replay_window_set (sa, seq, pos);
 	}
       else
 	{
 	  pos = sa->seq - seq;
-	  sa->replay_window |= (1ULL << pos);
+	  ipsec_sa_anti_replay_window_set (sa, seq, pos);
 	}
     }
   else
@@ -627,7 +910,7 @@ ipsec_sa_anti_replay_advance (ipsec_sa_t *sa, u32 thread_index, u32 seq,
       else
 	{
 	  pos = sa->seq - seq;
-	  sa->replay_window |= (1ULL << pos);
+	  ipsec_sa_anti_replay_window_set (sa, seq, pos);
 	}
     }
 
@@ -646,6 +929,51 @@ ipsec_sa_assign_thread (u32 thread_id)
 	  : (unix_time_now_nsec () % vlib_num_workers ()) + 1);
 }
 
+/*
+ * Whether the SA's packet has to be handed off to the thread owning the SA,
+ * which is the first one to use it. Multi-worker SAs are not owned.
+ */
+always_inline int
+ipsec_sa_handoff_needed (ipsec_sa_t *sa, u32 thread_index)
+{
+  if (ipsec_sa_is_set_IS_MULTI_WORKER (sa))
+    return 0;
+
+  if (PREDICT_FALSE (~0 == sa->thread_index))
+    {
+      /* this is the first packet to use this SA, claim the SA
+       * for this thread. this could happen simultaneously on
+       * another thread */
+      clib_atomic_cmp_and_swap (&sa->thread_index, ~0,
+				ipsec_sa_assign_thread (thread_index));
+    }
+
+  return (thread_index != sa->thread_index);
+}
+
+/*
+ * The device of the interface an SA is inline offloaded to does the ESP
+ * transforms of the SA's packets:
+ *  - on RX it decrypts the packets in place and verifies their ICV,
+ *    leaving the ESP header, IV, trailer and ICV where they were, and
+ *    marks them with VNET_BUFFER_F_IPSEC_INLINE and the SA index in
+ *    vnet_buffer2 ()->ipsec_inline. esp-decrypt then only does the
+ *    anti-replay checks and the decapsulation. The packets the device
+ *    did not handle come unmarked and are decrypted in software.
+ *  - on TX esp-encrypt builds the ESP packet, IV included, and marks it
+ *    for the device to encrypt and fill the ICV in. Only the transport
+ *    mode packets leaving through the offload interface are left to the
+ *    device, the others are encrypted in software.
+ */
+always_inline int
+ipsec_sa_inline_offload_tx (const ipsec_sa_t *sa, vlib_buffer_t *b)
+{
+  return (ipsec_sa_is_set_IS_INLINE_OFFLOAD (sa) &&
+	  !ipsec_sa_is_set_IS_TUNNEL (sa) &&
+	  vnet_buffer (b)->sw_if_index[VLIB_TX] ==
+	    sa->inline_offload_sw_if_index);
+}
+
 always_inline ipsec_sa_t *
 ipsec_sa_get (u32 sa_index)
 {
@@ -133,6 +133,116 @@ single_rule_in_match_5tuple (ipsec_policy_t *policy, ipsec_fp_5tuple_t *match)
   return (1);
 }
 
+static_always_inline u64
+ipsec_fp_range_index_key (ipsec_fp_range_index_t *ri, ipsec_fp_5tuple_t *match,
+			  u32 dim)
+{
+  switch (dim)
+    {
+    case IPSEC_FP_RANGE_DIM_LADDR:
+      return ri->is_ipv6 ? clib_net_to_host_u64 (match->ip6_laddr.as_u64[0]) :
+			   clib_net_to_host_u32 (match->laddr.as_u32);
+    case IPSEC_FP_RANGE_DIM_RADDR:
+      return ri->is_ipv6 ? clib_net_to_host_u64 (match->ip6_raddr.as_u64[0]) :
+			   clib_net_to_host_u32 (match->raddr.as_u32);
+    case IPSEC_FP_RANGE_DIM_LPORT:
+      return match->lport;
+    default:
+      return match->rport;
+    }
+}
+
+/*
+ * Match against a policy vector with a range index. The blocks the
+ * interval bitmaps agree on are walked in priority order, so the first
+ * policy matching is the best one; then the policies added since the
+ * build are checked. Returns the best policy beating last_priority,
+ * ~0 if none does.
+ */
+static_always_inline u32
+ipsec_fp_range_index_match (ipsec_main_t *im, u32 *policy_ids,
+			    ipsec_fp_5tuple_t *match, u32 last_priority,
+			    int is_inbound)
+{
+  ipsec_fp_policies_hdr_t *hdr = ipsec_fp_policies_hdr (policy_ids);
+  ipsec_fp_range_index_t *ri = hdr->range_index;
+  u64 *bitmaps[IPSEC_FP_RANGE_N_DIMS], keys[IPSEC_FP_RANGE_N_DIMS], word;
+  u32 *policy_id, best = ~0, n_left, n_dims, dim, w, i, end;
+  u32 n = vec_len (ri->policy_ids);
+  ipsec_fp_range_t *r;
+  ipsec_policy_t *policy;
+
+  /* ports are only compared for these protocols */
+  n_dims = ri->n_dims;
+  if (match->protocol != IP_PROTOCOL_TCP &&
+      match->protocol != IP_PROTOCOL_UDP &&
+      match->protocol != IP_PROTOCOL_SCTP)
+    n_dims = clib_min (n_dims, IPSEC_FP_RANGE_DIM_LPORT);
+
+  for (dim = 0; dim < n_dims; dim++)
+    {
+      keys[dim] = ipsec_fp_range_index_key (ri, match, dim);
+      bitmaps[dim] =
+	ri->block_bitmaps[dim] +
+	ipsec_fp_range_index_find (ri->bounds[dim], keys[dim]) * ri->n_words;
+    }
+
+  for (w = 0; w < ri->n_words; w++)
+    {
+      word = bitmaps[0][w];
+      for (dim = 1; dim < n_dims; dim++)
+	word &= bitmaps[dim][w];
+
+      while (word)
+	{
+	  i = (w * 64 + count_trailing_zeros (word)) << ri->log2_block_size;
+	  end = clib_min (n, i + (1 << ri->log2_block_size));
+	  for (; i < end; i++)
+	    {
+	      if (ri->policy_ids[i] == ~0)
+		continue;
+
+	      r = ri->ranges + i * ri->n_dims;
+	      for (dim = 0; dim < n_dims; dim++)
+		if (keys[dim] < r[dim].start || keys[dim] > r[dim].stop)
+		  break;
+	      if (dim < n_dims)
+		continue;
+
+	      policy = im->policies + ri->policy_ids[i];
+	      if (!(last_priority < policy->priority))
+		goto added;
+
+	      if (is_inbound ? single_rule_in_match_5tuple (policy, match) :
+			       single_rule_out_match_5tuple (policy, match))
+		{
+		  last_priority = policy->priority;
+		  best = ri->policy_ids[i];
+		  goto added;
+		}
+	    }
+	  word = clear_lowest_set_bit (word);
+	}
+    }
+
+added:
+  policy_id = policy_ids + hdr->n_indexed;
+  n_left = vec_len (policy_ids) - hdr->n_indexed;
+  for (; n_left > 0; n_left--, policy_id++)
+    {
+      policy = im->policies + *policy_id;
+      if ((last_priority < policy->priority) &&
+	  (is_inbound ? single_rule_in_match_5tuple (policy, match) :
+			single_rule_out_match_5tuple (policy, match)))
+	{
+	  last_priority = policy->priority;
+	  best = *policy_id;
+	}
+    }
+
+  return best;
+}
+
 static_always_inline u32
 ipsec_fp_in_ip6_policy_match_n (void *spd_fp, ipsec_fp_5tuple_t *tuples,
 				ipsec_policy_t **policies, u32 n)
@@ -284,7 +394,23 @@ ipsec_fp_in_ip4_policy_match_n (void *spd_fp, ipsec_fp_5tuple_t *tuples,
 	      /* Find the policy with highest priority. */
 	      /* Store the lookup results in a dedicated array. */
 
-	      if (vec_len (result_val->fp_policies_ids) > 1)
+	      if (PREDICT_FALSE (
+		    ipsec_fp_policies_hdr (result_val->fp_policies_ids)
+		      ->range_index != 0))
+		{
+		  u32 policy_id = ipsec_fp_range_index_match (
+		    im, result_val->fp_policies_ids, match, last_priority[i],
+		    1);
+		  if (policy_id != ~0)
+		    {
+		      policy = im->policies + policy_id;
+		      last_priority[i] = policy->priority;
+		      if (policies[i] == 0)
+			counter++;
+		      policies[i] = policy;
+		    }
+		}
+	      else if (vec_len (result_val->fp_policies_ids) > 1)
 		{
 		  u32 *policy_id;
 		  vec_foreach (policy_id, result_val->fp_policies_ids)
@@ -401,7 +527,24 @@ ipsec_fp_out_ip6_policy_match_n (void *spd_fp, ipsec_fp_5tuple_t *tuples,
 	      /* Find the policy with highest priority. */
 	      /* Store the lookup results in a dedicated array. */
 
-	      if (vec_len (result_val->fp_policies_ids) > 1)
+	      if (PREDICT_FALSE (
+		    ipsec_fp_policies_hdr (result_val->fp_policies_ids)
+		      ->range_index != 0))
+		{
+		  u32 policy_id = ipsec_fp_range_index_match (
+		    im, result_val->fp_policies_ids, match, last_priority[i],
+		    0);
+		  if (policy_id != ~0)
+		    {
+		      policy = im->policies + policy_id;
+		      last_priority[i] = policy->priority;
+		      if (policies[i] == 0)
+			counter++;
+		      policies[i] = policy;
+		      ids[i] = policy_id;
+		    }
+		}
+	      else if (vec_len (result_val->fp_policies_ids) > 1)
 		{
 		  u32 *policy_id;
 		  vec_foreach (policy_id, result_val->fp_policies_ids)
@@ -504,7 +647,24 @@ ipsec_fp_out_ip4_policy_match_n (void *spd_fp, ipsec_fp_5tuple_t *tuples,
 	      /* Find the policy with highest priority. */
 	      /* Store the lookup results in a dedicated array. */
 
-	      if (vec_len (result_val->fp_policies_ids) > 1)
+	      if (PREDICT_FALSE (
+		    ipsec_fp_policies_hdr (result_val->fp_policies_ids)
+		      ->range_index != 0))
+		{
+		  u32 policy_id = ipsec_fp_range_index_match (
+		    im, result_val->fp_policies_ids, match, last_priority[i],
+		    0);
+		  if (policy_id != ~0)
+		    {
+		      policy = im->policies + policy_id;
+		      last_priority[i] = policy->priority;
+		      if (policies[i] == 0)
+			counter++;
+		      policies[i] = policy;
+		      ids[i] = policy_id;
+		    }
+		}
+	      else if (vec_len (result_val->fp_policies_ids) > 1)
 		{
 		  u32 *policy_id;
 		  vec_foreach (policy_id, result_val->fp_policies_ids)
@@ -528,6 +528,267 @@ ipsec_fp_mask_type_idx_cmp (ipsec_fp_mask_id_t *mask_id, u32 *idx)
   return mask_id->mask_type_idx == *idx;
 }
 
+static void
+ipsec_fp_policy_range (ipsec_policy_t *policy, ipsec_fp_range_dim_t dim,
+		       bool inbound, u64 *start, u64 *stop)
+{
+  ip46_address_range_t *r;
+
+  if (dim == IPSEC_FP_RANGE_DIM_LPORT || dim == IPSEC_FP_RANGE_DIM_RPORT)
+    {
+      port_range_t *pr =
+	dim == IPSEC_FP_RANGE_DIM_LPORT ? &policy->lport : &policy->rport;
+      *start = pr->start;
+      *stop = pr->stop;
+      return;
+    }
+
+  /* inbound protect policies match on the SA, whatever their ranges */
+  if (inbound && policy->policy == IPSEC_POLICY_ACTION_PROTECT)
+    {
+      *start = 0;
+      *stop = ~0ULL;
+      return;
+    }
+
+  r = dim == IPSEC_FP_RANGE_DIM_LADDR ? &policy->laddr : &policy->raddr;
+  if (policy->is_ipv6)
+    {
+      /* the index is on the upper half, the policies match the rest */
+      *start = clib_net_to_host_u64 (r->start.ip6.as_u64[0]);
+      *stop = clib_net_to_host_u64 (r->stop.ip6.as_u64[0]);
+    }
+  else
+    {
+      *start = clib_net_to_host_u32 (r->start.ip4.as_u32);
+      *stop = clib_net_to_host_u32 (r->stop.ip4.as_u32);
+    }
+}
+
+typedef struct
+{
+  u32 priority;
+  u32 index;
+  u32 policy_id;
+} ipsec_fp_range_sort_elt_t;
+
+static int
+ipsec_fp_range_sort_elt_cmp (void *a1, void *a2)
+{
+  ipsec_fp_range_sort_elt_t *e1 = a1, *e2 = a2;
+
+  /* highest priority first, then in vector order, as the scan does */
+  if (e1->priority != e2->priority)
+    return e1->priority > e2->priority ? -1 : 1;
+  return (int) e1->index - (int) e2->index;
+}
+
+static int
+ipsec_fp_range_bound_cmp (void *a1, void *a2)
+{
+  u64 b1 = *(u64 *) a1, b2 = *(u64 *) a2;
+  return b1 < b2 ? -1 : b1 > b2;
+}
+
+static ipsec_fp_range_index_t *
+ipsec_fp_range_index_build (ipsec_main_t *im, u32 *policy_ids, bool is_ipv6,
+			    bool inbound)
+{
+  ipsec_fp_range_index_t *ri;
+  ipsec_fp_range_sort_elt_t *elts = 0;
+  ipsec_fp_range_t *r;
+  u32 n = vec_len (policy_ids), n_blocks, block_size, n_intervals;
+  u32 i, j, k, dim, first, last;
+  i32 *counts = 0, sum;
+  u64 *bounds, *bitmap;
+
+  ri = clib_mem_alloc (sizeof (*ri));
+  clib_memset (ri, 0, sizeof (*ri));
+  ri->is_ipv6 = is_ipv6;
+  /* inbound policies only have address ranges */
+  ri->n_dims = inbound ? IPSEC_FP_RANGE_DIM_LPORT : IPSEC_FP_RANGE_N_DIMS;
+
+  vec_validate (elts, n - 1);
+  vec_foreach_index (i, policy_ids)
+    {
+      ipsec_policy_t *p = pool_elt_at_index (im->policies, policy_ids[i]);
+      elts[i].priority = p->priority;
+      elts[i].index = i;
+      elts[i].policy_id = policy_ids[i];
+    }
+  vec_sort_with_function (elts, ipsec_fp_range_sort_elt_cmp);
+
+  vec_validate (ri->policy_ids, n - 1);
+  vec_validate (ri->ranges, n * ri->n_dims - 1);
+  for (i = 0; i < n; i++)
+    {
+      ri->policy_ids[i] = elts[i].policy_id;
+      for (dim = 0; dim < ri->n_dims; dim++)
+	{
+	  r = ri->ranges + i * ri->n_dims + dim;
+	  ipsec_fp_policy_range (im->policies + elts[i].policy_id, dim,
+				 inbound, &r->start, &r->stop);
+	}
+    }
+
+  while ((n >> ri->log2_block_size) >= IPSEC_FP_RANGE_INDEX_MAX_BLOCKS)
+    ri->log2_block_size++;
+  block_size = 1 << ri->log2_block_size;
+  n_blocks = (n + block_size - 1) / block_size;
+  ri->n_words = (n_blocks + 63) / 64;
+
+  for (dim = 0; dim < ri->n_dims; dim++)
+    {
+      bounds = 0;
+      vec_add1 (bounds, 0);
+      for (i = 0; i < n; i++)
+	{
+	  r = ri->ranges + i * ri->n_dims + dim;
+	  vec_add1 (bounds, r->start);
+	  if (r->stop != ~0ULL)
+	    vec_add1 (bounds, r->stop + 1);
+	}
+      vec_sort_with_function (bounds, ipsec_fp_range_bound_cmp);
+      for (i = 1, j = 1; i < vec_len (bounds); i++)
+	if (bounds[i] != bounds[j - 1])
+	  bounds[j++] = bounds[i];
+      vec_set_len (bounds, j);
+      n_intervals = j;
+
+      /* per block, count the policies over each interval */
+      vec_validate (ri->block_bitmaps[dim], n_intervals * ri->n_words - 1);
+      vec_validate (counts, n_intervals);
+      for (k = 0; k < n_blocks; k++)
+	{
+	  clib_memset (counts, 0, vec_bytes (counts));
+	  for (i = k * block_size; i < clib_min (n, (k + 1) * block_size); i++)
+	    {
+	      r = ri->ranges + i * ri->n_dims + dim;
+	      first = ipsec_fp_range_index_find (bounds, r->start);
+	      last = ipsec_fp_range_index_find (bounds, r->stop);
+	      counts[first]++;
+	      counts[last + 1]--;
+	    }
+	  for (i = 0, sum = 0; i < n_intervals; i++)
+	    {
+	      sum += counts[i];
+	      if (sum)
+		{
+		  bitmap = ri->block_bitmaps[dim] + i * ri->n_words;
+		  bitmap[k / 64] |= 1ULL << (k % 64);
+		}
+	    }
+	}
+      ri->bounds[dim] = bounds;
+    }
+
+  vec_free (counts);
+  vec_free (elts);
+  return ri;
+}
+
+static void
+ipsec_fp_range_index_free (ipsec_fp_range_index_t *ri)
+{
+  u32 dim;
+
+  if (!ri)
+    return;
+  for (dim = 0; dim < IPSEC_FP_RANGE_N_DIMS; dim++)
+    {
+      vec_free (ri->bounds[dim]);
+      vec_free (ri->block_bitmaps[dim]);
+    }
+  vec_free (ri->policy_ids);
+  vec_free (ri->ranges);
+  clib_mem_free (ri);
+}
+
+/*
+ * (Re)build the index of a policy vector. The new index replaces the
+ * old one with a single store, the workers are stopped by the barrier
+ * held around policy changes.
+ */
+static void
+ipsec_fp_policies_build_range_index (ipsec_main_t *im, u32 *policy_ids,
+				     bool is_ipv6, bool inbound)
+{
+  ipsec_fp_policies_hdr_t *hdr = ipsec_fp_policies_hdr (policy_ids);
+  ipsec_fp_range_index_t *old = hdr->range_index;
+
+  /* the inbound IPv6 match looks at the IPv4 addresses of the tuple */
+  if (vec_len (policy_ids) < IPSEC_FP_RANGE_INDEX_MIN_POLICIES ||
+      (inbound && is_ipv6))
+    hdr->range_index = 0;
+  else
+    hdr->range_index =
+      ipsec_fp_range_index_build (im, policy_ids, is_ipv6, inbound);
+  hdr->n_indexed = vec_len (policy_ids);
+  ipsec_fp_range_index_free (old);
+}
+
+/*
+ * A policy was appended; rebuild once the policies matched outside
+ * of the index grew by a quarter.
+ */
+static void
+ipsec_fp_policies_add (ipsec_main_t *im, u32 *policy_ids, bool is_ipv6,
+		       bool inbound)
+{
+  ipsec_fp_policies_hdr_t *hdr = ipsec_fp_policies_hdr (policy_ids);
+  u32 n = vec_len (policy_ids);
+
+  if (n >= IPSEC_FP_RANGE_INDEX_MIN_POLICIES &&
+      4 * (n - hdr->n_indexed) >= hdr->n_indexed)
+    ipsec_fp_policies_build_range_index (im, policy_ids, is_ipv6, inbound);
+}
+
+/*
+ * Delete the policy at index ii of the vector, keeping the order so
+ * the policies added since the last build stay at the end. An indexed
+ * policy is crossed out of the index, which is rebuilt once a quarter
+ * of it is gone.
+ */
+static void
+ipsec_fp_policies_del (ipsec_main_t *im, u32 *policy_ids, u32 ii,
+		       bool is_ipv6, bool inbound)
+{
+  ipsec_fp_policies_hdr_t *hdr = ipsec_fp_policies_hdr (policy_ids);
+  ipsec_fp_range_index_t *ri = hdr->range_index;
+  u32 policy_id = policy_ids[ii], i;
+
+  vec_delete (policy_ids, 1, ii);
+
+  if (ii >= hdr->n_indexed)
+    return;
+
+  hdr->n_indexed--;
+  if (!ri)
+    return;
+
+  if (vec_len (policy_ids) < IPSEC_FP_RANGE_INDEX_MIN_POLICIES ||
+      4 * (ri->n_deleted + 1) > hdr->n_indexed)
+    {
+      ipsec_fp_policies_build_range_index (im, policy_ids, is_ipv6, inbound);
+      return;
+    }
+
+  vec_foreach_index (i, ri->policy_ids)
+    if (ri->policy_ids[i] == policy_id)
+      {
+	ri->policy_ids[i] = ~0;
+	break;
+      }
+  ri->n_deleted++;
+}
+
+static void
+ipsec_fp_policies_free (u32 **policy_ids)
+{
+  ipsec_fp_range_index_free (ipsec_fp_policies_hdr (*policy_ids)->range_index);
+  vec_free (*policy_ids);
+}
+
 int
 ipsec_fp_ip4_add_policy (ipsec_main_t *im, ipsec_spd_fp_t *fp_spd,
 			 ipsec_policy_t *policy, u32 *stat_index)
@@ -541,6 +802,7 @@ ipsec_fp_ip4_add_policy (ipsec_main_t *im, ipsec_spd_fp_t *fp_spd,
   ipsec_fp_lookup_value_t *result_val =
     (ipsec_fp_lookup_value_t *) &result.value;
   ipsec_fp_lookup_value_t *key_val = (ipsec_fp_lookup_value_t *) &kv.value;
+  u32 *policy_ids;
 
   ipsec_fp_5tuple_t mask, policy_5tuple;
   int res;
@@ -578,7 +840,9 @@ ipsec_fp_ip4_add_policy (ipsec_main_t *im, ipsec_spd_fp_t *fp_spd,
   if (res != 0)
     {
       /* key was not found crate a new entry */
-      vec_add1 (key_val->fp_policies_ids, policy_index);
+      vec_add1_ha (key_val->fp_policies_ids, policy_index,
+		   sizeof (ipsec_fp_policies_hdr_t), 0);
+      policy_ids = key_val->fp_policies_ids;
       res = clib_bihash_add_del_16_8 (bihash_table, &kv, 1);
 
       if (res != 0)
@@ -602,6 +866,7 @@ ipsec_fp_ip4_add_policy (ipsec_main_t *im, ipsec_spd_fp_t *fp_spd,
 	  if (res != 0)
 	    goto error;
 	}
+      policy_ids = result_val->fp_policies_ids;
     }
 
   if (mte->refcount == 0)
@@ -623,6 +888,7 @@ ipsec_fp_ip4_add_policy (ipsec_main_t *im, ipsec_spd_fp_t *fp_spd,
 
   mte->refcount++;
   clib_memcpy (vp, policy, sizeof (*vp));
+  ipsec_fp_policies_add (im, policy_ids, false, inbound);
 
   return 0;
 
@@ -646,6 +912,7 @@ ipsec_fp_ip6_add_policy (ipsec_main_t *im, ipsec_spd_fp_t *fp_spd,
   ipsec_fp_lookup_value_t *result_val =
     (ipsec_fp_lookup_value_t *) &result.value;
   ipsec_fp_lookup_value_t *key_val = (ipsec_fp_lookup_value_t *) &kv.value;
+  u32 *policy_ids;
 
   ipsec_fp_5tuple_t mask, policy_5tuple;
   int res;
@@ -683,7 +950,9 @@ ipsec_fp_ip6_add_policy (ipsec_main_t *im, ipsec_spd_fp_t *fp_spd,
   if (res != 0)
     {
       /* key was not found crate a new entry */
-      vec_add1 (key_val->fp_policies_ids, policy_index);
+      vec_add1_ha (key_val->fp_policies_ids, policy_index,
+		   sizeof (ipsec_fp_policies_hdr_t), 0);
+      policy_ids = key_val->fp_policies_ids;
       res = clib_bihash_add_del_40_8 (bihash_table, &kv, 1);
       if (res != 0)
 	goto error;
@@ -706,6 +975,7 @@ ipsec_fp_ip6_add_policy (ipsec_main_t *im, ipsec_spd_fp_t *fp_spd,
 	  if (res != 0)
 	    goto error;
 	}
+      policy_ids = result_val->fp_policies_ids;
     }
 
   if (mte->refcount == 0)
@@ -727,6 +997,7 @@ ipsec_fp_ip6_add_policy (ipsec_main_t *im, ipsec_spd_fp_t *fp_spd,
 
   mte->refcount++;
   clib_memcpy (vp, policy, sizeof (*vp));
+  ipsec_fp_policies_add (im, policy_ids, true, inbound);
 
   return 0;
 
@@ -771,11 +1042,12 @@ ipsec_fp_ip6_del_policy (ipsec_main_t *im, ipsec_spd_fp_t *fp_spd,
 	{
 	  if (vec_len (result_val->fp_policies_ids) == 1)
 	    {
-	      vec_free (result_val->fp_policies_ids);
+	      ipsec_fp_policies_free (&result_val->fp_policies_ids);
 	      clib_bihash_add_del_40_8 (bihash_table, &result, 0);
 	    }
 	  else
-	    vec_del1 (result_val->fp_policies_ids, ii);
+	    ipsec_fp_policies_del (im, result_val->fp_policies_ids, ii,
+				   true, inbound);
 
 	  vec_foreach_index (imt, fp_spd->fp_mask_ids[policy->type])
 	    {
@@ -835,11 +1107,12 @@ ipsec_fp_ip4_del_policy (ipsec_main_t *im, ipsec_spd_fp_t *fp_spd,
 	{
 	  if (vec_len (result_val->fp_policies_ids) == 1)
 	    {
-	      vec_free (result_val->fp_policies_ids);
+	      ipsec_fp_policies_free (&result_val->fp_policies_ids);
 	      clib_bihash_add_del_16_8 (bihash_table, &result, 0);
 	    }
 	  else
-	    vec_del1 (result_val->fp_policies_ids, ii);
+	    ipsec_fp_policies_del (im, result_val->fp_policies_ids, ii,
+				   false, inbound);
 
 	  vec_foreach_index (imt, fp_spd->fp_mask_ids[policy->type])
 	    {
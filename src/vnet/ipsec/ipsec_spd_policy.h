@@ -182,6 +182,84 @@ typedef union
   };
 } ipsec_fp_lookup_value_t;
 
+/*
+ * Policies sharing a bihash entry differ only in the ranges the mask
+ * type does not cover. Long vectors of such policies get a bitmap
+ * intersection index: the bounds of the policies' ranges cut each
+ * dimension into elementary intervals, and each interval has a bitmap
+ * of the blocks of policies overlapping it, the blocks being taken in
+ * priority order. ANDing the bitmaps of the intervals a tuple falls in
+ * gives the blocks that may hold a match, best first.
+ */
+#define IPSEC_FP_RANGE_INDEX_MIN_POLICIES 32
+#define IPSEC_FP_RANGE_INDEX_MAX_BLOCKS 256
+
+typedef enum ipsec_fp_range_dim_t_
+{
+  IPSEC_FP_RANGE_DIM_LADDR,
+  IPSEC_FP_RANGE_DIM_RADDR,
+  IPSEC_FP_RANGE_DIM_LPORT,
+  IPSEC_FP_RANGE_DIM_RPORT,
+  IPSEC_FP_RANGE_N_DIMS,
+} ipsec_fp_range_dim_t;
+
+typedef struct
+{
+  u64 start;
+  u64 stop;
+} ipsec_fp_range_t;
+
+typedef struct
+{
+  /* policies in priority order, ~0 for the ones deleted since the build */
+  u32 *policy_ids;
+  /* their ranges, n_dims per policy */
+  ipsec_fp_range_t *ranges;
+  /* sorted lower bounds of the intervals of each dimension, from 0 */
+  u64 *bounds[IPSEC_FP_RANGE_N_DIMS];
+  /* n_words of block bitmap per interval of each dimension */
+  u64 *block_bitmaps[IPSEC_FP_RANGE_N_DIMS];
+  u32 n_deleted;
+  u8 n_dims;
+  u8 n_words;
+  u8 log2_block_size;
+  u8 is_ipv6;
+} ipsec_fp_range_index_t;
+
+/*
+ * User header of the fp_policies_ids vectors. The first n_indexed
+ * policies were there when the index was last built, the ones added
+ * since are matched one by one.
+ */
+typedef struct
+{
+  ipsec_fp_range_index_t *range_index;
+  u32 n_indexed;
+} ipsec_fp_policies_hdr_t;
+
+static_always_inline ipsec_fp_policies_hdr_t *
+ipsec_fp_policies_hdr (u32 *fp_policies_ids)
+{
+  return vec_header (fp_policies_ids);
+}
+
+/* the interval holding value, i.e. the last bound not above it */
+static_always_inline u32
+ipsec_fp_range_index_find (u64 *bounds, u64 value)
+{
+  u32 lo = 0, hi = vec_len (bounds), mid;
+
+  while (hi - lo > 1)
+    {
+      mid = (lo + hi) / 2;
+      if (bounds[mid] <= value)
+	lo = mid;
+      else
+	hi = mid;
+    }
+  return lo;
+}
+
 /**
  *  @brief add or delete a fast path policy
  */
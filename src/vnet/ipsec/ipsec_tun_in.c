@@ -317,6 +317,9 @@ ipsec_tun_protect_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
       vnet_buffer (b[0])->ipsec.protect_index = itr0.tun_index;
 
       sw_if_index0 = itr0.sw_if_index;
+      if (b[0]->flags & VNET_BUFFER_F_IPSEC_INLINE)
+	vnet_buffer2 (b[0])->ipsec_inline.rx_sw_if_index =
+	  vnet_buffer (b[0])->sw_if_index[VLIB_RX];
       vnet_buffer (b[0])->sw_if_index[VLIB_RX] = sw_if_index0;
 
       if (PREDICT_FALSE (!vnet_sw_interface_is_admin_up (vnm, sw_if_index0)))
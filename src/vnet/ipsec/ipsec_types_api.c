@@ -145,6 +145,8 @@ ipsec_sa_flags_decode (vl_api_ipsec_sad_flags_t in)
     flags |= IPSEC_SA_FLAG_IS_INBOUND;
   if (in & IPSEC_API_SAD_FLAG_ASYNC)
     flags |= IPSEC_SA_FLAG_IS_ASYNC;
+  if (in & IPSEC_API_SAD_FLAG_MULTI_WORKER)
+    flags |= IPSEC_SA_FLAG_IS_MULTI_WORKER;
 
   return (flags);
 }
@@ -168,6 +170,8 @@ ipsec_sad_flags_encode (const ipsec_sa_t * sa)
     flags |= IPSEC_API_SAD_FLAG_IS_INBOUND;
   if (ipsec_sa_is_set_IS_ASYNC (sa))
     flags |= IPSEC_API_SAD_FLAG_ASYNC;
+  if (ipsec_sa_is_set_IS_MULTI_WORKER (sa))
+    flags |= IPSEC_API_SAD_FLAG_MULTI_WORKER;
 
   return clib_host_to_net_u32 (flags);
 }
@@ -414,6 +414,15 @@ mpls_frag (vlib_main_t * vm,
 	    encap_size = vnet_buffer (p0)->l3_hdr_offset - p0->current_data;
 	    mtu = adj0->rewrite_header.max_l3_packet_bytes - encap_size;
 
+	    /* traced before the buffer is fragmented in place */
+	    if (PREDICT_FALSE (p0->flags & VLIB_BUFFER_IS_TRACED))
+	      {
+		mpls_frag_trace_t *tr =
+		  vlib_add_trace (vm, node, p0, sizeof (*tr));
+		tr->mtu = mtu;
+		tr->pkt_size = vlib_buffer_length_in_chain (vm, p0);
+	      }
+
 	    /* IP fragmentation */
 	    if (is_ip4)
 	      error0 = ip4_frag_do_fragment (vm, pi0, mtu, encap_size, &frags);
@@ -431,14 +440,6 @@ mpls_frag (vlib_main_t * vm,
 		  }
 	      }
 
-	    if (PREDICT_FALSE (p0->flags & VLIB_BUFFER_IS_TRACED))
-	      {
-		mpls_frag_trace_t *tr =
-		  vlib_add_trace (vm, node, p0, sizeof (*tr));
-		tr->mtu = mtu;
-		tr->pkt_size = vlib_buffer_length_in_chain (vm, p0);
-	      }
-
 	    if (PREDICT_TRUE (error0 == IP_FRAG_ERROR_NONE))
 	      {
 		/* Free original buffer chain */
@@ -410,6 +410,11 @@ policer_classify_inline (vlib_main_t * vm,
   u32 chain_hits = 0;
   u32 n_next_nodes;
   u64 time_in_policer_periods;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE];
+  vnet_classify_entry_t *entries[VLIB_FRAME_SIZE];
+  u32 table_index[VLIB_FRAME_SIZE], first_table_index[VLIB_FRAME_SIZE];
+  const u8 *h[VLIB_FRAME_SIZE];
+  u32 i;
 
   time_in_policer_periods =
     clib_cpu_time_now () >> POLICER_TICKS_PER_PERIOD_SHIFT;
@@ -419,94 +424,19 @@ policer_classify_inline (vlib_main_t * vm,
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
 
-  /* First pass: compute hashes */
-  while (n_left_from > 2)
+  /* First pass: find each packet's table, then classify the whole frame
+   * at once, walking the table chains breadth first */
+  vlib_get_buffers (vm, from, bufs, n_left_from);
+  for (i = 0; i < n_left_from; i++)
     {
-      vlib_buffer_t *b0, *b1;
-      u32 bi0, bi1;
-      u8 *h0, *h1;
-      u32 sw_if_index0, sw_if_index1;
-      u32 table_index0, table_index1;
-      vnet_classify_table_t *t0, *t1;
-
-      /* Prefetch next iteration */
-      {
-	vlib_buffer_t *p1, *p2;
-
-	p1 = vlib_get_buffer (vm, from[1]);
-	p2 = vlib_get_buffer (vm, from[2]);
-
-	vlib_prefetch_buffer_header (p1, STORE);
-	clib_prefetch_store (p1->data);
-	vlib_prefetch_buffer_header (p2, STORE);
-	clib_prefetch_store (p2->data);
-      }
-
-      bi0 = from[0];
-      b0 = vlib_get_buffer (vm, bi0);
-      h0 = b0->data;
-
-      bi1 = from[1];
-      b1 = vlib_get_buffer (vm, bi1);
-      h1 = b1->data;
-
-      sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-      table_index0 =
-	pcm->classify_table_index_by_sw_if_index[tid][sw_if_index0];
-
-      sw_if_index1 = vnet_buffer (b1)->sw_if_index[VLIB_RX];
-      table_index1 =
-	pcm->classify_table_index_by_sw_if_index[tid][sw_if_index1];
-
-      t0 = pool_elt_at_index (vcm->tables, table_index0);
-
-      t1 = pool_elt_at_index (vcm->tables, table_index1);
-
-      vnet_buffer (b0)->l2_classify.hash =
-	vnet_classify_hash_packet (t0, (u8 *) h0);
-
-      vnet_classify_prefetch_bucket (t0, vnet_buffer (b0)->l2_classify.hash);
-
-      vnet_buffer (b1)->l2_classify.hash =
-	vnet_classify_hash_packet (t1, (u8 *) h1);
+      u32 sw_if_index0 = vnet_buffer (bufs[i])->sw_if_index[VLIB_RX];
 
-      vnet_classify_prefetch_bucket (t1, vnet_buffer (b1)->l2_classify.hash);
-
-      vnet_buffer (b0)->l2_classify.table_index = table_index0;
-
-      vnet_buffer (b1)->l2_classify.table_index = table_index1;
-
-      from += 2;
-      n_left_from -= 2;
-    }
-
-  while (n_left_from > 0)
-    {
-      vlib_buffer_t *b0;
-      u32 bi0;
-      u8 *h0;
-      u32 sw_if_index0;
-      u32 table_index0;
-      vnet_classify_table_t *t0;
-
-      bi0 = from[0];
-      b0 = vlib_get_buffer (vm, bi0);
-      h0 = b0->data;
-
-      sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
-      table_index0 =
+      h[i] = bufs[i]->data;
+      first_table_index[i] = table_index[i] =
 	pcm->classify_table_index_by_sw_if_index[tid][sw_if_index0];
-
-      t0 = pool_elt_at_index (vcm->tables, table_index0);
-      vnet_buffer (b0)->l2_classify.hash =
-	vnet_classify_hash_packet (t0, (u8 *) h0);
-
-      vnet_buffer (b0)->l2_classify.table_index = table_index0;
-      vnet_classify_prefetch_bucket (t0, vnet_buffer (b0)->l2_classify.hash);
-
-      from++;
-      n_left_from--;
     }
+  vnet_classify_find_entries_chain (h, table_index, entries, n_left_from,
+				    now);
 
   next_index = node->cached_next_index;
   from = vlib_frame_vector_args (frame);
@@ -524,30 +454,11 @@ policer_classify_inline (vlib_main_t * vm,
 	  u32 bi0;
 	  vlib_buffer_t *b0;
 	  u32 next0 = POLICER_CLASSIFY_NEXT_INDEX_DROP;
-	  u32 table_index0;
 	  vnet_classify_table_t *t0;
 	  vnet_classify_entry_t *e0;
-	  u32 hash0;
-	  u8 *h0;
 	  u8 act0;
 
-	  /* Stride 3 seems to work best */
-	  if (PREDICT_TRUE (n_left_from > 3))
-	    {
-	      vlib_buffer_t *p1 = vlib_get_buffer (vm, from[3]);
-	      vnet_classify_table_t *tp1;
-	      u32 table_index1;
-	      u32 phash1;
-
-	      table_index1 = vnet_buffer (p1)->l2_classify.table_index;
-
-	      if (PREDICT_TRUE (table_index1 != ~0))
-		{
-		  tp1 = pool_elt_at_index (vcm->tables, table_index1);
-		  phash1 = vnet_buffer (p1)->l2_classify.hash;
-		  vnet_classify_prefetch_entry (tp1, phash1);
-		}
-	    }
+	  i = frame->n_vectors - n_left_from;
 
 	  /* Speculatively enqueue b0 to the current next frame */
 	  bi0 = from[0];
@@ -557,10 +468,8 @@ policer_classify_inline (vlib_main_t * vm,
 	  n_left_from -= 1;
 	  n_left_to_next -= 1;
 
-	  b0 = vlib_get_buffer (vm, bi0);
-	  h0 = b0->data;
-	  table_index0 = vnet_buffer (b0)->l2_classify.table_index;
-	  e0 = 0;
+	  b0 = bufs[i];
+	  e0 = entries[i];
 	  t0 = 0;
 
 	  if (tid == POLICER_CLASSIFY_TABLE_L2)
@@ -576,11 +485,9 @@ policer_classify_inline (vlib_main_t * vm,
 
 	  vnet_buffer (b0)->l2_classify.opaque_index = ~0;
 
-	  if (PREDICT_TRUE (table_index0 != ~0))
+	  if (PREDICT_TRUE (table_index[i] != ~0))
 	    {
-	      hash0 = vnet_buffer (b0)->l2_classify.hash;
-	      t0 = pool_elt_at_index (vcm->tables, table_index0);
-	      e0 = vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
+	      t0 = pool_elt_at_index (vcm->tables, table_index[i]);
 
 	      if (e0)
 		{
@@ -593,43 +500,15 @@ policer_classify_inline (vlib_main_t * vm,
 		      b0->error = node->errors[POLICER_CLASSIFY_ERROR_DROP];
 		    }
 		  hits++;
+		  if (table_index[i] != first_table_index[i])
+		    chain_hits++;
 		}
 	      else
 		{
-		  while (1)
-		    {
-		      if (PREDICT_TRUE (t0->next_table_index != ~0))
-			{
-			  t0 = pool_elt_at_index (vcm->tables,
-						  t0->next_table_index);
-			}
-		      else
-			{
-			  next0 = (t0->miss_next_index < n_next_nodes) ?
-			    t0->miss_next_index : next0;
-			  misses++;
-			  break;
-			}
-
-		      hash0 = vnet_classify_hash_packet (t0, (u8 *) h0);
-		      e0 =
-			vnet_classify_find_entry (t0, (u8 *) h0, hash0, now);
-		      if (e0)
-			{
-			  act0 = vnet_policer_police (vm, b0, e0->next_index,
-						      time_in_policer_periods,
-						      e0->opaque_index, false);
-			  if (PREDICT_FALSE (act0 == QOS_ACTION_DROP))
-			    {
-			      next0 = POLICER_CLASSIFY_NEXT_INDEX_DROP;
-			      b0->error =
-				node->errors[POLICER_CLASSIFY_ERROR_DROP];
-			    }
-			  hits++;
-			  chain_hits++;
-			  break;
-			}
-		    }
+		  next0 = (t0->miss_next_index < n_next_nodes) ?
+			    t0->miss_next_index :
+			    next0;
+		  misses++;
 		}
 	    }
 	  if (PREDICT_FALSE ((node->flags & VLIB_NODE_FLAG_TRACE)
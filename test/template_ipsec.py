@@ -71,6 +71,7 @@ class IPsecIPv4Params:
         )
         self.dscp = 0
         self.async_mode = False
+        self.anti_replay_window_size = None
 
 
 class IPsecIPv6Params:
@@ -119,6 +120,7 @@ class IPsecIPv6Params:
         )
         self.dscp = 0
         self.async_mode = False
+        self.anti_replay_window_size = None
 
 
 def mk_scapy_crypt_key(p):
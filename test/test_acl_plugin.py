@@ -1621,5 +1621,24 @@ class TestACLplugin(VppTestCase):
         self.logger.info("ACLP_TEST_FINISH_0315")
 
 
+class TestACLpluginDecisionTree(TestACLplugin):
+    """ACL plugin Test Case with decision tree lookups"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestACLpluginDecisionTree, cls).setUpClass()
+        cls.vapi.cli("set acl-plugin decision-tree default 1")
+
+    def test_0400_decision_tree_vs_linear(self):
+        """ACL decision tree lookups agree with the linear lookup"""
+        for af in ["", " ip6"]:
+            reply = self.vapi.cli(
+                "test acl-plugin decision-tree rules 2000 lookups 20000 verify 2000"
+                + af
+            )
+            self.logger.info(reply)
+            self.assertIn(": 0 mismatches", reply)
+
+
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
@@ -581,6 +581,132 @@ class Flowprobe(MethodHolder):
         ipfix.remove_vpp_config()
         self.logger.info("FFP_TEST_FINISH_0004")
 
+    def test_sampling(self):
+        """Sample one packet in N"""
+        self.logger.info("FFP_TEST_START_0005")
+        self.pg_enable_capture(self.pg_interfaces)
+        counter = "/err/flowprobe-output-l2/Packets not sampled"
+
+        ipfix = VppCFLOW(test=self, active=2)
+        ipfix.add_vpp_config()
+
+        # sampling without flowprobe on the interface is refused
+        with self.vapi.assert_negative_api_retval():
+            self.vapi.flowprobe_interface_set_sampling(
+                sw_if_index=self.pg3.sw_if_index, interval=2
+            )
+
+        # with the largest interval, practically no packet is sampled
+        self.vapi.flowprobe_interface_set_sampling(
+            sw_if_index=self.pg2.sw_if_index, interval=0xFFFFFFFF
+        )
+        self.assertIn("sampling 1/4294967295", self.vapi.cli("show flowprobe feature"))
+        self.create_stream(packets=10)
+        self.send_packets()
+        self.assertEqual(self.statistics.get_err_counter(counter), 10)
+
+        # back to every packet
+        self.vapi.flowprobe_interface_set_sampling(
+            sw_if_index=self.pg2.sw_if_index, interval=1
+        )
+        self.create_stream(packets=10)
+        self.send_packets()
+        self.assertEqual(self.statistics.get_err_counter(counter), 10)
+
+        ipfix.remove_vpp_config()
+        self.logger.info("FFP_TEST_FINISH_0005")
+
+
+@tag_run_solo
+@tag_fixme_vpp_workers
+@tag_fixme_ubuntu2204
+@tag_fixme_debian11
+class FlowprobeCache(MethodHolder):
+    """Flow cache eviction and expiry"""
+
+    # a single bucket of 8 flows per worker
+    extra_vpp_punt_config = ["flowprobe", "{", "cache-size-log2", "3", "}"]
+
+    @classmethod
+    def setUpClass(cls):
+        super(FlowprobeCache, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(FlowprobeCache, cls).tearDownClass()
+
+    def node_variants(self, node):
+        """march variants of a node function usable on this cpu"""
+        variants = []
+        out = self.vapi.cli("show node %s" % node)
+        m = re.search(r"node function variants:(.*?)\n\n", out, re.S)
+        for line in m.group(1).splitlines()[2:]:
+            fields = line.split()
+            if len(fields) > 1 and int(fields[1]) >= 0:
+                variants.append(fields[0])
+        return variants
+
+    def flow(self, sport):
+        return (
+            Ether(src=self.pg1.remote_mac, dst=self.pg1.local_mac)
+            / IP(src=self.pg1.remote_ip4, dst=self.pg2.remote_ip4)
+            / UDP(sport=sport, dport=4321)
+            / Raw(b"\xa5" * 100)
+        )
+
+    def test_bucket_overflow(self):
+        """Full bucket evicts and exports its least recent flow"""
+        self.logger.info("FFP_TEST_START_0006")
+        self.pg_enable_capture(self.pg_interfaces)
+        node = "flowprobe-output-l2"
+        counter = "/err/%s/Hash table collisions" % node
+
+        ipfix = VppCFLOW(test=self, layer="l4", active=2)
+        ipfix.add_vpp_config()
+        ipfix_decoder = IPFIXDecoder()
+        templates = ipfix.verify_templates(ipfix_decoder, count=2)
+
+        variants = self.node_variants(node)
+        self.assertGreater(len(variants), 0)
+        for i, variant in enumerate(variants):
+            # each variant has its own signature compare
+            self.vapi.cli("set node function %s %s" % (node, variant))
+            self.pg_enable_capture([self.collector])
+            sport = 1000 * (i + 1)
+            collisions = self.statistics.get_err_counter(counter)
+
+            # fill the bucket, the first flow is the least recently updated
+            self.pkts = [self.flow(sport + j) for j in range(8)]
+            self.send_packets()
+            self.assertEqual(self.statistics.get_err_counter(counter), collisions)
+
+            # refresh the first flow, a new one then evicts the second
+            self.pkts = [self.flow(sport), self.flow(sport + 8)]
+            self.send_packets()
+            self.assertEqual(self.statistics.get_err_counter(counter), collisions + 1)
+
+            self.vapi.ipfix_flush()
+            cflow = self.wait_for_cflow_packet(self.collector, templates[0])
+            data = ipfix_decoder.decode_data_set(cflow.getlayer(Set))
+            self.assertEqual(len(data), 1)
+            self.assertEqual(int(binascii.hexlify(data[0][7]), 16), sport + 1)
+            self.assertEqual(int(binascii.hexlify(data[0][2]), 16), 1)
+
+            # passive expiry exports and deletes every flow, freeing
+            # their ways: a full bucket of new flows does not collide
+            self.sleep(5, "wait for passive expiry")
+            self.assertIn(
+                "Pool utilisation thread 0 is 0%",
+                self.vapi.cli("show flowprobe statistics"),
+            )
+            self.pkts = [self.flow(sport + 100 + j) for j in range(8)]
+            self.send_packets()
+            self.assertEqual(self.statistics.get_err_counter(counter), collisions + 1)
+            self.sleep(5, "wait for passive expiry")
+
+        ipfix.remove_vpp_config()
+        self.logger.info("FFP_TEST_FINISH_0006")
+
 
 class DatapathTestsHolder(object):
     """collect information on Ethernet, IP4 and IP6 datapath (no timers)"""
@@ -1330,6 +1330,42 @@ class TestIPLoadBalance(VppTestCase):
 
         self.send_and_expect_only(self.pg0, port_ip_pkts, self.pg2)
 
+        #
+        # reuse the ingress hash; pg does not provide one so the packets
+        # are hashed on the 5-tuple and still load-balance
+        #
+        self.vapi.set_ip_flow_hash_v2(
+            af=af.ADDRESS_IP4,
+            table_id=0,
+            flow_hash_config=(
+                fhc.IP_API_FLOW_HASH_SRC_IP
+                | fhc.IP_API_FLOW_HASH_DST_IP
+                | fhc.IP_API_FLOW_HASH_SRC_PORT
+                | fhc.IP_API_FLOW_HASH_DST_PORT
+                | fhc.IP_API_FLOW_HASH_PROTO
+                | fhc.IP_API_FLOW_HASH_RX_HASH
+            ),
+        )
+        self.send_and_expect_load_balancing(
+            self.pg0, port_ip_pkts, [self.pg1, self.pg2]
+        )
+
+        #
+        # with a hash on the buffers, as a NIC's RSS would deliver it, the
+        # packets no longer spread on their ports: the hash picks the
+        # bucket, one of the two paths for each hash value
+        #
+        paths = set()
+        for rx_hash in range(2):
+            self.vapi.cli("test rx-hash pg0 hash %d" % rx_hash)
+            self.pg_send(self.pg0, port_ip_pkts)
+            rx = [len(i._get_capture(1) or []) for i in [self.pg1, self.pg2]]
+            self.assertIn(len(port_ip_pkts), rx)
+            self.assertIn(0, rx)
+            paths.add(rx.index(len(port_ip_pkts)))
+        self.assertEqual(paths, {0, 1})
+        self.vapi.cli("test rx-hash pg0 clear")
+
         #
         # change the flow hash config back to defaults
         #
@@ -67,6 +67,18 @@ class ConfigIpsecESP(TemplateIpsec):
         for p in params:
             p.flags |= saf.IPSEC_API_SAD_FLAG_USE_ANTI_REPLAY
 
+    def gen_tra_pkts(self, p, seqs):
+        return [
+            (
+                Ether(src=self.tra_if.remote_mac, dst=self.tra_if.local_mac)
+                / p.scapy_tra_sa.encrypt(
+                    IP(src=self.tra_if.remote_ip4, dst=self.tra_if.local_ip4) / ICMP(),
+                    seq_num=seq,
+                )
+            )
+            for seq in seqs
+        ]
+
     def config_network(self, params):
         self.net_objs = []
         self.tun_if = self.pg0
@@ -287,6 +299,7 @@ class ConfigIpsecESP(TemplateIpsec):
             self.vpp_esp_protocol,
             flags=flags,
             salt=salt,
+            anti_replay_window_size=params.anti_replay_window_size,
         )
         params.tra_sa_out = VppIpsecSA(
             self,
@@ -605,6 +618,155 @@ class TestIpsecEsp2(TemplateIpsecEsp, IpsecTcpTests):
     pass
 
 
+class TestIpsecEspReplayWindow(TemplateIpsecEsp):
+    """Ipsec ESP - large anti-replay window"""
+
+    def config_anti_replay(self, params):
+        super(TestIpsecEspReplayWindow, self).config_anti_replay(params)
+        for p in params:
+            p.anti_replay_window_size = 1024
+
+    def test_large_window(self):
+        """ipsec esp 1024 packet anti-replay window"""
+        p = self.params[socket.AF_INET]
+        sa = p.tra_sa_in
+        replay_count = self.get_replay_counts(p)
+
+        self.assertIn(
+            "window-size 1024", self.vapi.cli("show ipsec sa %d" % sa.stat_index)
+        )
+
+        # move the window well past its size
+        self.send_and_expect(self.tra_if, self.gen_tra_pkts(p, [2000]), self.tra_if)
+
+        # sequence numbers far behind the last one are still in the window
+        pkts = self.gen_tra_pkts(p, range(1000, 1100))
+        self.send_and_expect(self.tra_if, pkts, self.tra_if)
+
+        # replays of them are duplicates
+        self.send_and_assert_no_replies(self.tra_if, pkts[:10], timeout=0.2)
+        self.assertEqual(sa.get_replay_duplicate(), 10)
+        self.assertEqual(sa.get_replay_out_of_window(), 0)
+
+        # and the ones below the window's lower bound are out of it
+        self.send_and_assert_no_replies(
+            self.tra_if, self.gen_tra_pkts(p, range(900, 905)), timeout=0.2
+        )
+        self.assertEqual(sa.get_replay_duplicate(), 10)
+        self.assertEqual(sa.get_replay_out_of_window(), 5)
+        self.assertEqual(self.get_replay_counts(p), replay_count + 15)
+
+        # the holes are still open
+        self.send_and_expect(
+            self.tra_if, self.gen_tra_pkts(p, [1500, 1999]), self.tra_if
+        )
+
+        # moving the window a long way loses the ones it passed over
+        lost = sa.get_lost()
+        self.send_and_expect(self.tra_if, self.gen_tra_pkts(p, [5000]), self.tra_if)
+        self.assertEqual(sa.get_lost(), lost + 3000 - 103)
+        self.send_and_assert_no_replies(
+            self.tra_if, self.gen_tra_pkts(p, [3976]), timeout=0.2
+        )
+        self.send_and_expect(self.tra_if, self.gen_tra_pkts(p, [3977]), self.tra_if)
+
+
+class TestIpsecEspMultiWorker(TemplateIpsecEsp, IpsecTra4):
+    """Ipsec ESP - multi-worker SAs"""
+
+    vpp_worker_count = 2
+
+    def config_anti_replay(self, params):
+        super(TestIpsecEspMultiWorker, self).config_anti_replay(params)
+        saf = VppEnum.vl_api_ipsec_sad_flags_t
+        for p in params:
+            p.flags |= saf.IPSEC_API_SAD_FLAG_MULTI_WORKER
+            p.anti_replay_window_size = 1024
+
+    def test_tra_multi_worker(self):
+        """ipsec v4 transport multi-worker SA"""
+        p = self.params[socket.AF_INET]
+
+        self.verify_tra_basic4(count=257)
+
+        # no thread claimed the SAs
+        for sa in [p.tra_sa_in, p.tra_sa_out]:
+            self.assertIn(
+                "thread-index:-1", self.vapi.cli("show ipsec sa %d" % sa.stat_index)
+            )
+
+        # the shared window catches replays
+        pkts = self.gen_tra_pkts(p, range(300, 310))
+        self.send_and_expect(self.tra_if, pkts, self.tra_if)
+        self.send_and_assert_no_replies(self.tra_if, pkts, timeout=0.2)
+        self.assertEqual(p.tra_sa_in.get_replay_duplicate(), 10)
+
+
+class TestIpsecEspInlineOffload(TemplateIpsecEsp, IpsecTra4):
+    """Ipsec ESP - inline offload"""
+
+    def setUp(self):
+        super(TestIpsecEspInlineOffload, self).setUp()
+        self.vapi.cli("test ipsec inline-offload emulation %s" % self.tra_if.name)
+
+    def tearDown(self):
+        self.vapi.cli(
+            "test ipsec inline-offload emulation %s disable" % self.tra_if.name
+        )
+        super(TestIpsecEspInlineOffload, self).tearDown()
+
+    def test_tra_inline_offload(self):
+        """ipsec v4 transport inline offload"""
+        p = self.params[socket.AF_INET]
+
+        for sa in [p.tra_sa_in, p.tra_sa_out]:
+            self.vapi.cli("ipsec sa inline-offload %d %s" % (sa.id, self.tra_if.name))
+            self.assertIn(
+                "inline-offload %s" % self.tra_if.name,
+                self.vapi.cli("show ipsec sa %d" % sa.stat_index),
+            )
+
+        # the device does the crypto, the software only the ESP framing
+        self.verify_tra_basic4(count=17)
+        self.assertEqual(
+            self.statistics.get_err_counter("/err/esp4-decrypt/inline_offload"), 17
+        )
+        self.assertEqual(
+            self.statistics.get_err_counter("/err/esp4-encrypt/inline_offload"), 17
+        )
+
+        # the device refuses ESN SAs, they stay with the software
+        esn_sa = VppIpsecSA(
+            self,
+            p.scapy_tra_sa_id + 100,
+            p.scapy_tra_spi + 100,
+            p.auth_algo_vpp_id,
+            p.auth_key,
+            p.crypt_algo_vpp_id,
+            p.crypt_key,
+            self.vpp_esp_protocol,
+            flags=VppEnum.vl_api_ipsec_sad_flags_t.IPSEC_API_SAD_FLAG_USE_ESN,
+        )
+        esn_sa.add_vpp_config()
+        reply = self.vapi.cli(
+            "ipsec sa inline-offload %d %s" % (esn_sa.id, self.tra_if.name)
+        )
+        self.assertIn("left to software", reply)
+        self.assertNotIn(
+            "inline-offload", self.vapi.cli("show ipsec sa %d" % esn_sa.stat_index)
+        )
+
+        # back to the software
+        for sa in [p.tra_sa_in, p.tra_sa_out]:
+            self.vapi.cli(
+                "ipsec sa inline-offload %d %s disable" % (sa.id, self.tra_if.name)
+            )
+        self.verify_tra_basic4(count=3)
+        self.assertEqual(
+            self.statistics.get_err_counter("/err/esp4-decrypt/inline_offload"), 0
+        )
+
+
 class TestIpsecEspAsync(TemplateIpsecEsp):
     """Ipsec ESP - Aysnc tests"""
 
@@ -827,6 +989,122 @@ class TestIpsecEspAsync(TemplateIpsecEsp):
         # screen scrape.
         self.assertTrue("DISABLED" in self.vapi.cli("sh crypto async status"))
 
+    def test_sw_scheduler_steal(self):
+        """Async frames are stolen by the workers of the same numa first"""
+        self.vapi.ipsec_set_async_mode(async_enable=True)
+
+        pkts = [
+            (
+                Ether(src=self.pg1.remote_mac, dst=self.pg1.local_mac)
+                / IP(src=self.pg1.remote_ip4, dst=self.p_async.remote_tun_if_host)
+                / UDP(sport=4444, dport=4444)
+                / Raw(b"0x0" * 200)
+            )
+        ]
+        pkts *= 257
+
+        def frames(kind):
+            # indexed by thread, worker N is thread N + 1
+            return self.statistics["/crypto/sw_scheduler/%s-frames" % kind][:, 0]
+
+        # worker 0 does its own crypto, worker 1 may steal some of it
+        self.send_and_expect(self.pg1, pkts, self.pg0, worker=0)
+        self.assertGreater(frames("own")[1], 0)
+        self.assertEqual(frames("stolen-remote").sum(), 0)
+
+        # without crypto on worker 0, worker 1 steals all its frames
+        self.vapi.cli("set sw_scheduler worker 0 crypto off")
+        own, local = frames("own")[1], frames("stolen-local")[2]
+        self.send_and_expect(self.pg1, pkts, self.pg0, worker=0)
+        self.assertEqual(frames("own")[1], own)
+        self.assertGreater(frames("stolen-local")[2], local)
+        self.assertEqual(frames("stolen-remote").sum(), 0)
+
+        # and counts them as remote once it is on another numa node
+        self.vapi.cli("set sw_scheduler worker 1 numa 1")
+        local = frames("stolen-local")[2]
+        self.send_and_expect(self.pg1, pkts, self.pg0, worker=0)
+        self.assertEqual(frames("stolen-local")[2], local)
+        self.assertGreater(frames("stolen-remote")[2], 0)
+
+        self.vapi.cli("set sw_scheduler worker 1 numa 0")
+        self.vapi.cli("set sw_scheduler worker 0 crypto on")
+        self.p_sync.spd.remove_vpp_config()
+        self.p_sync.sa.remove_vpp_config()
+        self.p_async.spd.remove_vpp_config()
+        self.p_async.sa.remove_vpp_config()
+        self.vapi.ipsec_set_async_mode(async_enable=False)
+
+    def test_async_stats(self):
+        """Async queue depth and latency stats, dispatch budget"""
+        self.vapi.ipsec_set_async_mode(async_enable=True)
+
+        pkts = [
+            (
+                Ether(src=self.pg1.remote_mac, dst=self.pg1.local_mac)
+                / IP(src=self.pg1.remote_ip4, dst=self.p_async.remote_tun_if_host)
+                / UDP(sport=4444, dport=4444)
+                / Raw(b"0x0" * 200)
+            )
+        ]
+        pkts *= 257
+
+        names = [
+            "frames-submitted",
+            "elts-submitted",
+            "frames-completed",
+            "elts-completed",
+            "depth-hist",
+            "latency-hist",
+        ]
+        base = {}
+
+        def counter(name):
+            return self.statistics["/crypto/async/%s" % name].sum() - base[name]
+
+        # polling, no budget: everything submitted comes back
+        for n in names:
+            base[n] = self.statistics["/crypto/async/%s" % n].sum()
+        self.send_and_expect(self.pg1, pkts, self.pg0, worker=0)
+        n_frames = counter("frames-submitted")
+        self.assertGreater(n_frames, 0)
+        self.assertEqual(counter("elts-submitted"), len(pkts))
+        self.assertEqual(counter("frames-completed"), n_frames)
+        self.assertEqual(counter("elts-completed"), len(pkts))
+        # one depth sample per submit, one latency sample per completion
+        self.assertEqual(counter("depth-hist"), n_frames)
+        self.assertEqual(counter("latency-hist"), n_frames)
+
+        stats = self.vapi.cli("show crypto async stats")
+        self.logger.info(stats)
+        self.assertIn("queue depth (elts):", stats)
+        self.assertIn("in flight: 0 elts", stats)
+
+        # a budget that runs out on every call, in interrupt mode: the
+        # node has to re-arm itself to collect what it left behind
+        self.vapi.cli("set crypto async dispatch budget 1")
+        self.vapi.cli("set crypto async dispatch interrupt")
+        self.assertIn("budget: 1us", self.vapi.cli("show crypto async status"))
+
+        for n in names:
+            base[n] = self.statistics["/crypto/async/%s" % n].sum()
+        self.send_and_expect(self.pg1, pkts, self.pg0, worker=0)
+        n_frames = counter("frames-submitted")
+        self.assertGreater(n_frames, 0)
+        self.assertEqual(counter("elts-submitted"), len(pkts))
+        self.assertEqual(counter("frames-completed"), n_frames)
+        self.assertEqual(counter("elts-completed"), len(pkts))
+        self.assertEqual(counter("latency-hist"), n_frames)
+        self.assertIn("in flight: 0 elts", self.vapi.cli("show crypto async stats"))
+
+        self.vapi.cli("set crypto async dispatch budget 0")
+        self.vapi.cli("set crypto async dispatch polling")
+        self.p_sync.spd.remove_vpp_config()
+        self.p_sync.sa.remove_vpp_config()
+        self.p_async.spd.remove_vpp_config()
+        self.p_async.sa.remove_vpp_config()
+        self.vapi.ipsec_set_async_mode(async_enable=False)
+
 
 class TestIpsecEspHandoff(
     TemplateIpsecEsp, IpsecTun6HandoffTests, IpsecTun4HandoffTests
@@ -488,6 +488,84 @@ class TestLB(VppTestCase):
             )
             self.vapi.cli("test lb flowtable flush")
 
+    def test_lb_sticky_grow(self):
+        """Load Balancer sticky table growth"""
+        try:
+            self.vapi.cli("lb conf buckets 16 max-buckets 64")
+            self.vapi.cli("lb vip 90.0.0.0/8 encap gre4")
+            for asid in self.ass:
+                self.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u" % (asid))
+
+            # 100 flows overflow the 16 buckets, the main thread allocates
+            # the grown table and the worker takes it on a later frame
+            for i in range(2):
+                self.pg0.add_stream(self.generatePackets(self.pg0, isv4=True))
+                self.pg_enable_capture(self.pg_interfaces)
+                self.pg_start()
+                self.checkCapture(encap="gre4", isv4=True)
+
+            self.assertGreater(self.statistics["/lb/sticky/full"][:, 0].sum(), 0)
+            self.assertGreater(self.statistics["/lb/sticky/grown"][:, 0].sum(), 0)
+            self.assertGreater(self.statistics["/lb/sticky/buckets"][0, 0], 16)
+            self.assertIn("as 10.0.0.", self.vapi.cli("show lb sticky max 10"))
+
+            # the bindings are also streamed over the API, a batch at a time
+            bindings = []
+            thread_index, cursor = 0, 0
+            while True:
+                rv, details = self.vapi.lb_sticky_get(
+                    thread_index=thread_index, cursor=cursor
+                )
+                bindings += details
+                if rv.retval != -165:
+                    break
+                thread_index, cursor = rv.thread_index, rv.cursor
+            self.assertEqual(rv.retval, 0)
+            self.assertGreater(len(bindings), 0)
+            ass = ["10.0.0.%u" % asid for asid in self.ass]
+            for b in bindings:
+                self.assertIn(str(b.app_srv), ass)
+
+        finally:
+            for asid in self.ass:
+                self.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u del" % (asid))
+            self.vapi.cli("lb vip 90.0.0.0/8 encap gre4 del")
+            self.vapi.cli("test lb flowtable flush")
+            self.vapi.cli("lb conf buckets 1024 max-buckets 0")
+
+    def test_lb_as_del_flush(self):
+        """Load Balancer AS delete with flush after flow table swap"""
+        try:
+            self.vapi.cli("lb vip 90.0.0.0/8 encap gre4")
+            for asid in self.ass:
+                self.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u" % (asid))
+
+            self.pg0.add_stream(self.generatePackets(self.pg0, isv4=True))
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            self.checkCapture(encap="gre4", isv4=True)
+            self.assertIn("as 10.0.0.0 used", self.vapi.cli("show lb sticky"))
+
+            # The new flow table is rebuilt and swapped by a process, the
+            # sticky entries of the AS are only flushed after the swap
+            self.vapi.cli("lb as 90.0.0.0/8 10.0.0.0 del flush")
+            self.sleep(0.5, "waiting for the flow table swap")
+            self.assertNotIn("as 10.0.0.0 ", self.vapi.cli("show lb sticky"))
+
+            self.pg0.add_stream(self.generatePackets(self.pg0, isv4=True))
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            out = self.pg1.get_capture(len(self.packets))
+            for p in out:
+                self.assertNotEqual(p[IP].dst, "10.0.0.0")
+            self.assertNotIn("as 10.0.0.0 ", self.vapi.cli("show lb sticky"))
+
+        finally:
+            for asid in self.ass[1:]:
+                self.vapi.cli("lb as 90.0.0.0/8 10.0.0.%u del" % (asid))
+            self.vapi.cli("lb vip 90.0.0.0/8 encap gre4 del")
+            self.vapi.cli("test lb flowtable flush")
+
     def test_lb_ip6_nat6_port(self):
         """Load Balancer IP6 NAT6 on per-port-vip case"""
         try:
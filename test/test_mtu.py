@@ -131,6 +131,11 @@ class TestMTU(VppTestCase):
         reass_pkt = reassemble4(rx)
         self.validate(reass_pkt, p4_reply)
 
+        # The first fragment reuses the original buffer, only the
+        # following two are copied
+        self.assert_error_counter_equal("/err/ip4-frag/bytes_referenced", 552)
+        self.assert_error_counter_equal("/err/ip4-frag/bytes_copied", 968)
+
         """
         # Now what happens with a 9K frame
         p_payload = UDP(sport=1234, dport=1234) / self.payload(
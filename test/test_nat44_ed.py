@@ -1,5 +1,7 @@
 #!/usr/bin/env python3
 
+import socket
+import struct
 import unittest
 from io import BytesIO
 from random import randint, choice
@@ -21,6 +23,22 @@ from vpp_ip_route import VppIpRoute, VppRoutePath
 from vpp_papi import VppEnum
 from util import StatsDiff
 
+# the 40 byte RSS key most NICs default to
+RSS_DEFAULT_KEY = bytes.fromhex(
+    "6d5a56da255b0ec24167253d43a38fb0d0ca2bcbae7b30b477cb2da38030f20c"
+    "6a42b73bbeac01fa"
+)
+
+
+def toeplitz_hash(data, key=RSS_DEFAULT_KEY):
+    k = int.from_bytes(key, "big")
+    n = len(key) * 8
+    h = 0
+    for i in range(len(data) * 8):
+        if data[i // 8] & (0x80 >> (i % 8)):
+            h ^= (k >> (n - 32 - i)) & 0xFFFFFFFF
+    return h
+
 
 class TestNAT44ED(VppTestCase):
     """NAT44ED Test Case"""
@@ -2779,6 +2797,69 @@ class TestNAT44EDMW(TestNAT44ED):
             len(recvd_tcp_ports) + len(recvd_udp_ports) + len(recvd_icmp_ids),
         )
 
+    def test_rss_port_selection(self):
+        """NAT44ED RSS aware outside port selection"""
+        n_flows = 32
+        # worker polling each outside rx queue, pg has none to read
+        queue_workers = [2, 0, 3, 1]
+        same_worker = "/err/nat44-out2in-worker-handoff/same worker"
+        do_handoff = "/err/nat44-out2in-worker-handoff/do handoff"
+
+        def rss_worker(src, dst, sport, dport):
+            # default key, 128 entries spread round-robin over the queues
+            data = socket.inet_aton(src) + socket.inet_aton(dst)
+            data += struct.pack("!HH", sport, dport)
+            queue = (toeplitz_hash(data) & 127) % len(queue_workers)
+            return queue_workers[queue]
+
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+        self.vapi.cli(
+            "set nat44 rss-port-selection queue-workers %s"
+            % ",".join(str(w) for w in queue_workers)
+        )
+
+        for worker in range(self.vpp_worker_count):
+            pkts = []
+            for i in range(n_flows):
+                sport = 1024 + worker * n_flows + i
+                pkts.append(
+                    Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+                    / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+                    / TCP(sport=sport, dport=20)
+                )
+                pkts.append(
+                    Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+                    / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+                    / UDP(sport=sport, dport=20)
+                )
+            capture = self.send_and_expect(self.pg0, pkts, self.pg1, worker=worker)
+
+            # the NIC hashes the return flow of every port to this worker
+            o2i = []
+            for p in capture:
+                l4 = p[TCP] if TCP in p else p[UDP]
+                self.assertEqual(
+                    rss_worker(p[IP].dst, p[IP].src, l4.dport, l4.sport), worker
+                )
+                o2i.append(
+                    Ether(dst=self.pg1.local_mac, src=self.pg1.remote_mac)
+                    / IP(src=p[IP].dst, dst=p[IP].src)
+                    / l4.__class__(sport=l4.dport, dport=l4.sport)
+                )
+
+            # and the session is found there, without handoff
+            same = self.statistics.get_err_counter(same_worker)
+            handoff = self.statistics.get_err_counter(do_handoff)
+            self.send_and_expect(self.pg1, o2i, self.pg0, worker=worker)
+            self.assertEqual(
+                self.statistics.get_err_counter(same_worker) - same, len(o2i)
+            )
+            self.assertEqual(self.statistics.get_err_counter(do_handoff), handoff)
+
+        self.vapi.cli("set nat44 rss-port-selection disable")
+
     def test_frag_in_order(self):
         """NAT44ED translate fragments arriving in order"""
 
@@ -4893,5 +4974,73 @@ class TestNAT44EDMW(TestNAT44ED):
         self.assertGreaterEqual(err, sessions_per_batch)
 
 
+class TestNAT44EDClockAging(TestNAT44ED):
+    """NAT44ED Clock Aging Test Case"""
+
+    def plugin_enable(self, max_sessions=None):
+        max_sessions = max_sessions or self.max_sessions
+        self.vapi.cli("nat44 plugin enable sessions %d clock-aging" % max_sessions)
+
+    def send_udp_sessions(self, sport, count):
+        pkts = [
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4, ttl=64)
+            / UDP(sport=sport + i, dport=80)
+            for i in range(count)
+        ]
+        self.pg0.add_stream(pkts)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        self.pg1.get_capture(len(pkts))
+
+    def test_clock_aging_sweep(self):
+        """NAT44ED clock aging expires idle sessions"""
+
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+
+        self.vapi.nat_set_timeouts(
+            udp=2, tcp_established=7440, tcp_transitory=240, icmp=60
+        )
+
+        self.send_udp_sessions(7000, 10)
+        self.assertEqual(self.statistics["/nat44-ed/total-sessions"][:, 0].sum(), 10)
+
+        # keep half of the sessions active
+        self.virtual_sleep(1)
+        self.send_udp_sessions(7000, 5)
+
+        self.virtual_sleep(1.5, "wait for timeouts")
+        self.assertEqual(
+            self.statistics["/nat44-ed/aging/expired-sessions"][:, 0].sum(), 5
+        )
+        self.assertEqual(self.statistics["/nat44-ed/total-sessions"][:, 0].sum(), 5)
+        sessions = self.vapi.nat44_user_session_dump(self.pg0.remote_ip4, 0)
+        self.assertEqual(
+            sorted(s.inside_port for s in sessions), list(range(7000, 7005))
+        )
+
+    def test_clock_aging_table_full(self):
+        """NAT44ED clock aging recycles expired sessions when table is full"""
+
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+
+        self.vapi.nat_set_timeouts(
+            udp=1, tcp_established=7440, tcp_transitory=240, icmp=60
+        )
+
+        self.send_udp_sessions(7000, self.max_sessions)
+        # expired sessions are reused before the background sweep reaches them
+        self.virtual_sleep(1.05, "wait for timeouts")
+        self.send_udp_sessions(9000, self.max_sessions)
+        self.assertEqual(
+            self.statistics["/nat44-ed/total-sessions"][:, 0].sum(),
+            self.max_sessions,
+        )
+
+
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
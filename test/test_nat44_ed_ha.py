@@ -0,0 +1,359 @@
+#!/usr/bin/env python3
+"""NAT44 ED session state synchronization (HA) tests"""
+
+import unittest
+from scapy.all import (
+    bind_layers,
+    Packet,
+    ByteEnumField,
+    ByteField,
+    ShortField,
+    IPField,
+    IntField,
+    XByteField,
+    FlagsField,
+    FieldLenField,
+    PacketListField,
+)
+from scapy.layers.inet import Ether, IP, UDP
+from scapy.data import IP_PROTOS
+from framework import VppTestCase, VppTestRunner
+from vpp_papi import VppEnum
+
+
+# NAT44-ED HA protocol event data
+class HAEvent(Packet):
+    name = "Event"
+    fields_desc = [
+        ByteEnumField("event_type", None, {1: "add", 2: "del", 3: "refresh"}),
+        ByteField("proto", IP_PROTOS.udp),
+        ByteField("tcp_state", 0),
+        ByteField("pad", 0),
+        IntField("flags", 0),
+        IPField("i2o_saddr", None),
+        IPField("i2o_daddr", None),
+        ShortField("i2o_sport", None),
+        ShortField("i2o_dport", None),
+        IntField("i2o_fib_index", 0),
+        IPField("o2i_saddr", None),
+        IPField("o2i_daddr", None),
+        ShortField("o2i_sport", None),
+        ShortField("o2i_dport", None),
+        IntField("o2i_fib_index", 0),
+    ]
+
+    def extract_padding(self, s):
+        return "", s
+
+
+# NAT44-ED HA protocol header
+class HANAT44EDStateSync(Packet):
+    name = "HA NAT44-ED state sync"
+    fields_desc = [
+        XByteField("version", 1),
+        FlagsField("flags", 0, 8, ["JOIN", "ACK"]),
+        FieldLenField("count", None, count_of="events"),
+        IntField("sequence_number", 0),
+        IntField("thread_index", 0),
+        PacketListField("events", [], HAEvent, count_from=lambda pkt: pkt.count),
+    ]
+
+
+class TestNAT44EDHA(VppTestCase):
+    """NAT44 ED HA Test Case"""
+
+    nat_addr = "10.0.10.3"
+    ha_port = 12345
+    peer_port = 12346
+    server_port = 80
+
+    @classmethod
+    def setUpClass(cls):
+        super().setUpClass()
+        cls.create_pg_interfaces(range(3))
+        cls.interfaces = list(cls.pg_interfaces)
+        bind_layers(UDP, HANAT44EDStateSync, sport=cls.ha_port)
+
+    @classmethod
+    def tearDownClass(cls):
+        super().tearDownClass()
+
+    def setUp(self):
+        super().setUp()
+        for i in self.interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+        self.vapi.nat44_ed_plugin_enable_disable(sessions=1024, enable=1)
+        flags = VppEnum.vl_api_nat_config_flags_t
+        self.vapi.nat44_add_del_address_range(
+            first_ip_address=self.nat_addr,
+            last_ip_address=self.nat_addr,
+            vrf_id=0xFFFFFFFF,
+            is_add=1,
+            flags=0,
+        )
+        self.vapi.nat44_interface_add_del_feature(
+            flags=flags.NAT_IS_INSIDE, sw_if_index=self.pg0.sw_if_index, is_add=1
+        )
+        self.vapi.nat44_interface_add_del_feature(
+            flags=flags.NAT_IS_OUTSIDE, sw_if_index=self.pg1.sw_if_index, is_add=1
+        )
+        self.vapi.cli(
+            "nat44 ha listener %s:%d path-mtu 512" % (self.pg2.local_ip4, self.ha_port)
+        )
+
+    def tearDown(self):
+        if not self.vpp_dead:
+            self.logger.debug(self.vapi.cli("show nat44 ha"))
+            self.logger.debug(self.vapi.cli("show nat44 sessions"))
+        super().tearDown()
+        if not self.vpp_dead:
+            self.vapi.nat44_ed_plugin_enable_disable(enable=0)
+            for i in self.pg_interfaces:
+                i.unconfig_ip4()
+                i.admin_down()
+
+    def stat(self, name):
+        return self.statistics["/nat44-ed/ha/" + name][:, 0].sum()
+
+    def ha_packet(self, **kwargs):
+        return (
+            Ether(dst=self.pg2.local_mac, src=self.pg2.remote_mac)
+            / IP(src=self.pg2.remote_ip4, dst=self.pg2.local_ip4)
+            / UDP(sport=self.peer_port, dport=self.ha_port)
+            / HANAT44EDStateSync(**kwargs)
+        )
+
+    def set_failover(self, extra=""):
+        """configure the failover and answer its join"""
+        self.pg_enable_capture(self.pg_interfaces)
+        self.vapi.cli(
+            "nat44 ha failover %s:%d %s" % (self.pg2.remote_ip4, self.peer_port, extra)
+        )
+        p = self.pg2.get_capture(1)[0]
+        self.assert_packet_checksums_valid(p)
+        self.assertEqual(p[IP].src, self.pg2.local_ip4)
+        self.assertEqual(p[IP].dst, self.pg2.remote_ip4)
+        self.assertEqual(p[UDP].dport, self.peer_port)
+        self.assertEqual(p[HANAT44EDStateSync].flags, "JOIN")
+        self.assertEqual(p[HANAT44EDStateSync].count, 0)
+        return p
+
+    def create_sessions(self, sports):
+        pkts = [
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+            / UDP(sport=sport, dport=self.server_port)
+            for sport in sports
+        ]
+        return self.send_and_expect(self.pg0, pkts, self.pg1)
+
+    def get_ha_message(self):
+        self.vapi.cli("nat44 ha flush")
+        p = self.pg2.get_capture(1)[0]
+        self.assert_packet_checksums_valid(p)
+        return p[HANAT44EDStateSync]
+
+    def test_ha_send(self):
+        """NAT44ED send HA session events (active)"""
+        self.set_failover("refresh-interval 2")
+        self.pg2.add_stream(self.ha_packet(flags="JOIN+ACK"))
+        self.pg_start()
+
+        # create sessions
+        sports = [5000, 5001]
+        capture = self.create_sessions(sports)
+        outside = {p[UDP].sport for p in capture}
+
+        hanat = self.get_ha_message()
+        self.assertEqual(hanat.version, 1)
+        self.assertEqual(hanat.count, 2)
+        self.assertEqual(self.stat("add-event-send"), 2)
+        for event in hanat.events:
+            self.assertEqual(event.event_type, 1)
+            self.assertEqual(event.proto, IP_PROTOS.udp)
+            self.assertEqual(event.i2o_saddr, self.pg0.remote_ip4)
+            self.assertEqual(event.i2o_daddr, self.pg1.remote_ip4)
+            self.assertIn(event.i2o_sport, sports)
+            self.assertEqual(event.i2o_dport, self.server_port)
+            self.assertEqual(event.o2i_saddr, self.pg1.remote_ip4)
+            self.assertEqual(event.o2i_daddr, self.nat_addr)
+            self.assertEqual(event.o2i_sport, self.server_port)
+            self.assertIn(event.o2i_dport, outside)
+        seq = hanat.sequence_number
+
+        # delete one session
+        self.pg_enable_capture(self.pg_interfaces)
+        self.vapi.nat44_del_session(
+            address=self.pg0.remote_ip4,
+            port=sports[0],
+            protocol=IP_PROTOS.udp,
+            flags=(
+                VppEnum.vl_api_nat_config_flags_t.NAT_IS_INSIDE
+                | VppEnum.vl_api_nat_config_flags_t.NAT_IS_EXT_HOST_VALID
+            ),
+            ext_host_address=self.pg1.remote_ip4,
+            ext_host_port=self.server_port,
+        )
+        hanat = self.get_ha_message()
+        self.assertEqual(hanat.count, 1)
+        self.assertEqual(hanat.sequence_number, seq + 1)
+        self.assertEqual(hanat.events[0].event_type, 2)
+        self.assertEqual(hanat.events[0].i2o_sport, sports[0])
+        self.assertEqual(self.stat("del-event-send"), 1)
+
+        # session refresh after refresh-interval
+        self.virtual_sleep(3)
+        self.create_sessions(sports[1:])
+        hanat = self.get_ha_message()
+        self.assertEqual(hanat.count, 1)
+        self.assertEqual(hanat.events[0].event_type, 3)
+        self.assertEqual(hanat.events[0].i2o_sport, sports[1])
+        self.assertEqual(self.stat("refresh-event-send"), 1)
+        self.assertEqual(self.stat("ring-full-drop"), 0)
+
+    def test_ha_recv(self):
+        """NAT44ED receive HA session events (passive)"""
+        in_port, out_port = 5000, 6000
+        event = HAEvent(
+            event_type="add",
+            i2o_saddr=self.pg0.remote_ip4,
+            i2o_daddr=self.pg1.remote_ip4,
+            i2o_sport=in_port,
+            i2o_dport=self.server_port,
+            o2i_saddr=self.pg1.remote_ip4,
+            o2i_daddr=self.nat_addr,
+            o2i_sport=self.server_port,
+            o2i_dport=out_port,
+        )
+        self.pg2.add_stream(self.ha_packet(sequence_number=1, events=[event]))
+        self.pg_start()
+        self.assertEqual(self.stat("add-event-recv"), 1)
+        self.assertEqual(self.stat("recv-event-failed"), 0)
+
+        # return traffic is translated using the synchronized session
+        p = (
+            Ether(dst=self.pg1.local_mac, src=self.pg1.remote_mac)
+            / IP(src=self.pg1.remote_ip4, dst=self.nat_addr)
+            / UDP(sport=self.server_port, dport=out_port)
+        )
+        rx = self.send_and_expect(self.pg1, [p], self.pg0)[0]
+        self.assert_packet_checksums_valid(rx)
+        self.assertEqual(rx[IP].dst, self.pg0.remote_ip4)
+        self.assertEqual(rx[UDP].dport, in_port)
+
+        # and so is the inside traffic
+        p = (
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+            / UDP(sport=in_port, dport=self.server_port)
+        )
+        rx = self.send_and_expect(self.pg0, [p], self.pg1)[0]
+        self.assert_packet_checksums_valid(rx)
+        self.assertEqual(rx[IP].src, self.nat_addr)
+        self.assertEqual(rx[UDP].sport, out_port)
+
+        # refresh of a known session does not create a new one
+        event.event_type = "refresh"
+        self.pg2.add_stream(self.ha_packet(sequence_number=2, events=[event]))
+        self.pg_start()
+        self.assertEqual(self.stat("refresh-event-recv"), 1)
+        sessions = self.vapi.nat44_user_session_dump(self.pg0.remote_ip4, 0)
+        self.assertEqual(len(sessions), 1)
+
+        # delete, with a lost message in between
+        event.event_type = "del"
+        self.pg2.add_stream(self.ha_packet(sequence_number=4, events=[event]))
+        self.pg_start()
+        self.assertEqual(self.stat("del-event-recv"), 1)
+        self.assertEqual(self.stat("seq-gap"), 1)
+        sessions = self.vapi.nat44_user_session_dump(self.pg0.remote_ip4, 0)
+        self.assertEqual(len(sessions), 0)
+
+    def test_ha_recv_collision(self):
+        """NAT44ED HA add colliding with a local session"""
+        capture = self.create_sessions([5000])
+        out_port = capture[0][UDP].sport
+
+        # same outside tuple as the local session, different inside port
+        event = HAEvent(
+            event_type="add",
+            i2o_saddr=self.pg0.remote_ip4,
+            i2o_daddr=self.pg1.remote_ip4,
+            i2o_sport=5001,
+            i2o_dport=self.server_port,
+            o2i_saddr=self.pg1.remote_ip4,
+            o2i_daddr=self.nat_addr,
+            o2i_sport=self.server_port,
+            o2i_dport=out_port,
+        )
+        self.pg2.add_stream(self.ha_packet(sequence_number=1, events=[event]))
+        self.pg_start()
+        self.assertEqual(self.stat("add-event-recv"), 1)
+        self.assertEqual(self.stat("recv-event-failed"), 1)
+
+        # the local session still translates both ways
+        p = (
+            Ether(dst=self.pg1.local_mac, src=self.pg1.remote_mac)
+            / IP(src=self.pg1.remote_ip4, dst=self.nat_addr)
+            / UDP(sport=self.server_port, dport=out_port)
+        )
+        rx = self.send_and_expect(self.pg1, [p], self.pg0)[0]
+        self.assertEqual(rx[IP].dst, self.pg0.remote_ip4)
+        self.assertEqual(rx[UDP].dport, 5000)
+        capture = self.create_sessions([5000])
+        self.assertEqual(capture[0][UDP].sport, out_port)
+
+        # the colliding inside tuple got no session
+        sessions = self.vapi.nat44_user_session_v3_dump(
+            ip_address=self.pg0.remote_ip4, vrf_id=0
+        )
+        self.assertEqual(len(sessions), 1)
+
+    def test_ha_join_resync(self):
+        """NAT44ED HA bulk resync on peer join"""
+        sports = [5000, 5001, 5002]
+        self.create_sessions(sports)
+
+        self.set_failover()
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg2.add_stream(
+            [self.ha_packet(flags="JOIN+ACK"), self.ha_packet(flags="JOIN")]
+        )
+        self.pg_start()
+        self.vapi.cli("nat44 ha flush")
+        capture = self.pg2.get_capture(2)
+        join = [p for p in capture if p[HANAT44EDStateSync].count == 0]
+        events = [p for p in capture if p[HANAT44EDStateSync].count > 0]
+        self.assertEqual(len(join), 1)
+        self.assertEqual(join[0][HANAT44EDStateSync].flags, "JOIN+ACK")
+        self.assertEqual(join[0][UDP].dport, self.peer_port)
+        self.assert_packet_checksums_valid(join[0])
+        hanat = events[0][HANAT44EDStateSync]
+        self.assertEqual(hanat.count, len(sports))
+        self.assertEqual(
+            sorted(e.i2o_sport for e in hanat.events),
+            sports,
+        )
+        self.assertEqual(self.stat("resync-event-send"), len(sports))
+
+    def test_ha_rate_limit(self):
+        """NAT44ED HA message rate limit"""
+        # one event per message, at most one message per second
+        self.vapi.cli(
+            "nat44 ha listener %s:%d path-mtu 80" % (self.pg2.local_ip4, self.ha_port)
+        )
+        self.set_failover("rate 1")
+        self.pg2.add_stream(self.ha_packet(flags="JOIN+ACK"))
+        self.pg_start()
+
+        self.create_sessions([5000, 5001, 5002])
+        self.vapi.cli("nat44 ha flush")
+        self.sleep(0.1)
+        self.assertLess(self.stat("msg-send"), 3)
+        self.assertGreater(self.stat("rate-limited"), 0)
+
+
+if __name__ == "__main__":
+    unittest.main(testRunner=VppTestRunner)
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""NAT44 ED port block allocation tests"""
+
+import unittest
+from scapy.data import IP_PROTOS
+from scapy.layers.inet import Ether, IP, UDP
+from scapy.packet import Raw
+from syslog_rfc5424_parser import SyslogMessage, ParseError
+from syslog_rfc5424_parser.constants import SyslogSeverity
+from framework import VppTestCase, VppTestRunner
+from vpp_papi import VppEnum
+
+
+class TestNAT44EDPortBlock(VppTestCase):
+    """NAT44 ED Port Block Test Case"""
+
+    nat_addr = "10.0.10.3"
+    block_size = 16
+    blocks_per_user = 2
+    server_port = 80
+
+    @classmethod
+    def setUpClass(cls):
+        super().setUpClass()
+        cls.create_pg_interfaces(range(3))
+        cls.interfaces = list(cls.pg_interfaces)
+
+    @classmethod
+    def tearDownClass(cls):
+        super().tearDownClass()
+
+    def setUp(self):
+        super().setUp()
+        for i in self.interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+        self.vapi.cli(
+            "nat44 plugin enable sessions 1024 port-block-size %d "
+            "port-blocks-per-user %d" % (self.block_size, self.blocks_per_user)
+        )
+        flags = VppEnum.vl_api_nat_config_flags_t
+        self.vapi.nat44_add_del_address_range(
+            first_ip_address=self.nat_addr,
+            last_ip_address=self.nat_addr,
+            vrf_id=0xFFFFFFFF,
+            is_add=1,
+            flags=0,
+        )
+        self.vapi.nat44_interface_add_del_feature(
+            flags=flags.NAT_IS_INSIDE, sw_if_index=self.pg0.sw_if_index, is_add=1
+        )
+        self.vapi.nat44_interface_add_del_feature(
+            flags=flags.NAT_IS_OUTSIDE, sw_if_index=self.pg1.sw_if_index, is_add=1
+        )
+
+    def tearDown(self):
+        if not self.vpp_dead:
+            self.logger.debug(self.vapi.cli("show nat44 port-blocks"))
+        super().tearDown()
+        if not self.vpp_dead:
+            self.vapi.nat44_ed_plugin_enable_disable(enable=0)
+            for i in self.pg_interfaces:
+                i.unconfig_ip4()
+                i.admin_down()
+
+    def stat(self, name):
+        return self.statistics["/nat44-ed/port-block/" + name][:, 0].sum()
+
+    def udp_packets(self, sports):
+        return [
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+            / UDP(sport=sport, dport=self.server_port)
+            for sport in sports
+        ]
+
+    def verify_syslog_pb(self, data, msgid, start_port):
+        message = data.decode("utf-8")
+        try:
+            message = SyslogMessage.parse(message)
+        except ParseError as e:
+            self.logger.error(e)
+            raise
+        else:
+            self.assertEqual(message.severity, SyslogSeverity.info)
+            self.assertEqual(message.appname, "NAT")
+            self.assertEqual(message.msgid, msgid)
+            sd_params = message.sd.get("npbmap")
+            self.assertTrue(sd_params is not None)
+            self.assertEqual(sd_params.get("IATYP"), "IPv4")
+            self.assertEqual(sd_params.get("ISADDR"), self.pg0.remote_ip4)
+            self.assertEqual(sd_params.get("XATYP"), "IPv4")
+            self.assertEqual(sd_params.get("XSADDR"), self.nat_addr)
+            self.assertEqual(sd_params.get("XSPORT"), "%d" % start_port)
+            self.assertEqual(
+                sd_params.get("XEPORT"), "%d" % (start_port + self.block_size - 1)
+            )
+            self.assertEqual(sd_params.get("SVLAN"), "0")
+
+    def test_port_block_alloc(self):
+        """NAT44ED port block allocation"""
+        sports = range(7000, 7000 + self.block_size + 4)
+        capture = self.send_and_expect(self.pg0, self.udp_packets(sports), self.pg1)
+
+        ports = [p[UDP].sport for p in capture]
+        self.assertEqual(len(set(ports)), len(ports))
+        blocks = {(port - 1024) // self.block_size for port in ports}
+        self.assertEqual(len(blocks), 2)
+        for p in capture:
+            self.assertEqual(p[IP].src, self.nat_addr)
+        self.assertEqual(self.stat("allocated"), 2)
+
+        # the subscriber is out of blocks
+        self.send_and_expect(self.pg0, self.udp_packets(range(8000, 8012)), self.pg1)
+        self.send_and_assert_no_replies(self.pg0, self.udp_packets([9000]))
+        self.assertEqual(self.stat("allocated"), 2)
+
+    def test_port_block_release(self):
+        """NAT44ED port block release"""
+        self.send_and_expect(self.pg0, self.udp_packets([7000, 7001]), self.pg1)
+        self.assertEqual(self.stat("allocated"), 1)
+
+        flags = VppEnum.vl_api_nat_config_flags_t
+        for sport in [7000, 7001]:
+            self.assertEqual(self.stat("released"), 0)
+            self.vapi.nat44_del_session(
+                address=self.pg0.remote_ip4,
+                port=sport,
+                protocol=IP_PROTOS.udp,
+                flags=flags.NAT_IS_INSIDE | flags.NAT_IS_EXT_HOST_VALID,
+                ext_host_address=self.pg1.remote_ip4,
+                ext_host_port=self.server_port,
+            )
+        self.assertEqual(self.stat("released"), 1)
+
+    # put zzz in front of syslog test name so that it runs as a last test
+    # setting syslog sender cannot be undone and if it is set, it messes
+    # with self.send_and_assert_no_replies functionality
+    def test_zzz_syslog_port_block(self):
+        """NAT44ED syslog port block allocation and release"""
+        self.vapi.syslog_set_filter(
+            VppEnum.vl_api_syslog_severity_t.SYSLOG_API_SEVERITY_INFO
+        )
+        self.vapi.syslog_set_sender(self.pg2.local_ip4, self.pg2.remote_ip4)
+
+        capture = self.send_and_expect(
+            self.pg0, self.udp_packets([7000, 7001]), self.pg1
+        )
+        start_port = capture[0][UDP].sport // self.block_size * self.block_size
+
+        # one record for the block, none per session
+        capture = self.pg2.get_capture(1)
+        self.verify_syslog_pb(capture[0][Raw].load, "PBADD", start_port)
+
+        # deleting the address releases the block
+        self.pg_enable_capture(self.pg_interfaces)
+        self.vapi.nat44_add_del_address_range(
+            first_ip_address=self.nat_addr,
+            last_ip_address=self.nat_addr,
+            vrf_id=0xFFFFFFFF,
+            is_add=0,
+            flags=0,
+        )
+        capture = self.pg2.get_capture(1)
+        self.verify_syslog_pb(capture[0][Raw].load, "PBDEL", start_port)
+
+
+if __name__ == "__main__":
+    unittest.main(testRunner=VppTestRunner)
@@ -1135,6 +1135,17 @@ class TestIPv4MWReassembly(VppTestCase):
         for send_if in self.send_ifs:
             send_if.assert_nothing_captured()
 
+    def test_worker_conflict_shared_contexts(self):
+        """1st and FO=0 fragments on different workers, shared contexts"""
+
+        # workers add fragments to each other's reassemblies instead of
+        # handing them off whenever the owner is idle
+        self.vapi.cli("set ip4-full-reassembly shared-contexts enable")
+        try:
+            self.test_worker_conflict()
+        finally:
+            self.vapi.cli("set ip4-full-reassembly shared-contexts disable")
+
 
 class TestIPv6Reassembly(VppTestCase):
     """IPv6 Reassembly"""
@@ -1967,6 +1978,17 @@ class TestIPv6MWReassembly(VppTestCase):
         for send_if in self.send_ifs:
             send_if.assert_nothing_captured()
 
+    def test_worker_conflict_shared_contexts(self):
+        """1st and FO=0 fragments on different workers, shared contexts"""
+
+        # workers add fragments to each other's reassemblies instead of
+        # handing them off whenever the owner is idle
+        self.vapi.cli("set ip6-full-reassembly shared-contexts enable")
+        try:
+            self.test_worker_conflict()
+        finally:
+            self.vapi.cli("set ip6-full-reassembly shared-contexts disable")
+
 
 class TestIPv6SVReassembly(VppTestCase):
     """IPv6 Shallow Virtual Reassembly"""
@@ -218,6 +218,7 @@ class VppIpsecSA(VppObject):
         udp_src=None,
         udp_dst=None,
         hop_limit=None,
+        anti_replay_window_size=None,
     ):
         e = VppEnum.vl_api_ipsec_sad_flags_t
         self.test = test
@@ -255,6 +256,7 @@ class VppIpsecSA(VppObject):
         self.hop_limit = 255
         if hop_limit:
             self.hop_limit = hop_limit
+        self.anti_replay_window_size = anti_replay_window_size
 
     def tunnel_encode(self):
         return {
@@ -290,7 +292,11 @@ class VppIpsecSA(VppObject):
             entry["udp_src_port"] = self.udp_src
         if self.udp_dst:
             entry["udp_dst_port"] = self.udp_dst
-        r = self.test.vapi.ipsec_sad_entry_add(entry=entry)
+        if self.anti_replay_window_size:
+            entry["anti_replay_window_size"] = self.anti_replay_window_size
+            r = self.test.vapi.ipsec_sad_entry_add_v2(entry=entry)
+        else:
+            r = self.test.vapi.ipsec_sad_entry_add(entry=entry)
         self.stat_index = r.stat_index
         self.test.registry.register(self, self.test.logger)
         return self
@@ -358,8 +364,8 @@ class VppIpsecSA(VppObject):
             # +1 to skip main thread
             return c[worker + 1][self.stat_index]
 
-    def get_lost(self, worker=None):
-        c = self.test.statistics.get_counter("/net/ipsec/sa/lost")
+    def get_simple_counter(self, name, worker=None):
+        c = self.test.statistics.get_counter(name)
         if worker is None:
             total = 0
             for t in c:
@@ -369,6 +375,15 @@ class VppIpsecSA(VppObject):
             # +1 to skip main thread
             return c[worker + 1][self.stat_index]
 
+    def get_lost(self, worker=None):
+        return self.get_simple_counter("/net/ipsec/sa/lost", worker)
+
+    def get_replay_duplicate(self, worker=None):
+        return self.get_simple_counter("/net/ipsec/sa/replay-duplicate", worker)
+
+    def get_replay_out_of_window(self, worker=None):
+        return self.get_simple_counter("/net/ipsec/sa/replay-out-of-window", worker)
+
 
 class VppIpsecTunProtect(VppObject):
     """